@@ -0,0 +1,44 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <memory_resource>
+
+using namespace std;
+
+/*
+ * Scratch memory for solver hot paths. Each thread owns a ScratchArena whose pool recycles blocks
+ * freed and reallocated inside search loops, and a solve that builds up memory it drops all at once
+ * puts a monotonic buffer on top of the pool for its lifetime. Both only reach the global heap while
+ * the pool is warming up, so repeated solves on one thread stop allocating.
+ */
+
+const size_t ARENA_LARGEST_POOL_BLOCK   = 1 << 20;
+const size_t ARENA_MONOTONIC_INITIAL    = 16 << 10;
+
+struct ScratchArena
+{
+    pmr::unsynchronized_pool_resource pool;
+
+    ScratchArena() : pool(pmr::pool_options{ 0, ARENA_LARGEST_POOL_BLOCK }) {}
+
+    pmr::memory_resource* Pool() { return &pool; }
+};
+
+ScratchArena& GetThreadArena();
+
+/*
+ * Global allocation counters, fed by replacements of operator new and delete, covering every thread.
+ * ResetAllocStats starts a measurement window: counts go to zero and the peak is measured from the
+ * bytes live at the reset.
+ */
+
+struct AllocStats
+{
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t peakBytes;
+};
+
+void ResetAllocStats();
+AllocStats GetAllocStats();
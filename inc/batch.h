@@ -0,0 +1,135 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <condition_variable>
+
+using namespace std;
+
+/*
+ * Batch mode: solve every instance in a user supplied file instead of running the self-tests. Input
+ * files are line oriented, one instance per line, with blank lines and lines starting with '#'
+ * skipped. Values are separated by spaces or tabs.
+ *
+ *   minmax     A list of unsigned values.                  Output: "min max"
+ *   restmap    A pairwise distance multiset, any order.    Output: the points, ascending from 0.
+ *   reversal   A permutation of 1..n.                      Output: the reversal count, then each
+ *                                                          reversal as begin,end positions in the
+ *                                                          framed permutation.
+ *   motif      The motif length k, then the sequences.     Output: consensus score, then the motif
+ *                                                          offset in each sequence.
+ *
+ * Every instance produces exactly one output line, in input order. Instances that can't be parsed or
+ * solved produce "error <code>" instead.
+ *
+ * restmap and motif instances go through the process result cache (see resultcache.h) when the driver
+ * opened one.
+ */
+
+enum BatchProblem
+{
+    BATCH_MINMAX,
+    BATCH_RESTMAP,
+    BATCH_REVERSAL,
+    BATCH_MOTIF,
+    BATCH_PROBLEM_COUNT
+};
+
+struct BatchOptions
+{
+    BatchProblem problem;
+    uint32_t numSolvers;        // Zero for one per worker thread.
+    uint32_t maxInFlight;       // Instances read but not yet written. Zero for four per solver.
+    size_t ioBufferBytes;
+
+    BatchOptions(const BatchProblem problem) : problem(problem), numSolvers(0), maxInFlight(0), ioBufferBytes(1 << 20) {}
+};
+
+struct BatchStats
+{
+    uint64_t instances;
+    uint64_t failed;
+    uint32_t peakInFlight;
+};
+
+bool ParseBatchProblem(const char* name, BatchProblem& problem);
+const char* GetBatchProblemName(const BatchProblem problem);
+ResultCode RunBatch(const char* inPath, const char* outPath, const BatchOptions& options, BatchStats& stats);
+ResultCode SolveBatchInstance(const BatchProblem problem, const string& line, string& out);
+ResultCode ReadBatchInstances(const char* path, vector<string>& instances);
+
+/*
+ * Blocking FIFO with a fixed capacity, the hand-off between pipeline stages. Push waits while the
+ * queue is full and Pop while it is empty; TryPush fails instead of waiting. Close wakes everyone:
+ * pushes fail from then on, and pops drain what is left before failing.
+ */
+
+template<typename T>
+struct BoundedQueue
+{
+    mutex lock;
+    condition_variable notFull;
+    condition_variable notEmpty;
+    vector<T> slots;
+    size_t head;
+    size_t count;
+    bool closed;
+
+    BoundedQueue(const size_t capacity) : slots(capacity), head(0), count(0), closed(false) {}
+
+    bool Push(T&& item)
+    {
+        unique_lock<mutex> guard(lock);
+        notFull.wait(guard, [this] { return count < slots.size() || closed; });
+
+        if (closed) return false;
+
+        slots[(head + count) % slots.size()] = move(item);
+        count++;
+
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * TryPush - Push without waiting. The item is only moved from when it was queued.
+     *
+     * @return False if the queue is full or closed.
+     */
+
+    bool TryPush(T& item)
+    {
+        lock_guard<mutex> guard(lock);
+        if (count == slots.size() || closed) return false;
+
+        slots[(head + count) % slots.size()] = move(item);
+        count++;
+
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& item)
+    {
+        unique_lock<mutex> guard(lock);
+        notEmpty.wait(guard, [this] { return count > 0 || closed; });
+
+        if (count == 0) return false;
+
+        item = move(slots[head]);
+        head = (head + 1) % slots.size();
+        count--;
+
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
@@ -11,12 +11,17 @@
 #include <unordered_map>
 #include <algorithm>
 #include <set>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
+#define NOMINMAX
 #include <Windows.h>
 
 enum ResultCode
 {
     OK                          = 0,
     INVALID_INPUT               = 1,
-    UNABLE_TO_FIND_SOLUTION     = 2
+    UNABLE_TO_FIND_SOLUTION     = 2,
+    IO_ERROR                    = 3
 };
\ No newline at end of file
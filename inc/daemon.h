@@ -0,0 +1,93 @@
+#pragma once
+
+#include "problems.h"
+
+/*
+ * Solver daemon. A long running process that listens on a Unix domain socket (AF_UNIX over Winsock)
+ * and answers framed requests from any number of clients, so solver threads, their scratch arenas and
+ * any precomputed tables stay warm between calls instead of being rebuilt per process.
+ *
+ * Every frame is a fixed header followed by its variable length fields. Integers are little endian.
+ *
+ *   Request:   DaemonRequestHeader, name (nameLen bytes), payload (payloadLen bytes)
+ *   Response:  DaemonResponseHeader, payload (payloadLen bytes)
+ *
+ * The name selects what to run:
+ *
+ *   minmax, restmap, reversal, motif   Solve the payload, one instance in the batch format of that
+ *                                      type (see batch.h). The response payload is the output line.
+ *   A problems registry name           Run that problem's self-tests. The payload is ignored; the
+ *                                      response payload is the pass, fail and error counts followed
+ *                                      by a line per failed test.
+ *   ping                               Responds "pong".
+ *   shutdown                           Responds "bye" and stops the daemon.
+ *
+ * A client may pipeline requests on one connection. Requests are solved concurrently, so responses can
+ * come back in a different order; requestId matches them up. A malformed frame closes the connection.
+ */
+
+const char DAEMON_REQUEST_MAGIC[4]      = { 'B', 'P', 'R', 'Q' };
+const char DAEMON_RESPONSE_MAGIC[4]     = { 'B', 'P', 'R', 'S' };
+const uint32_t DAEMON_MAX_NAME_LEN      = 256;
+const uint32_t DAEMON_MAX_PAYLOAD_LEN   = 64 << 20;
+
+struct DaemonRequestHeader
+{
+    char magic[4];
+    uint32_t nameLen;
+    uint32_t payloadLen;
+    uint32_t reserved;
+    uint64_t requestId;
+};
+
+struct DaemonResponseHeader
+{
+    char magic[4];
+    int32_t result;             // ResultCode.
+    uint32_t payloadLen;
+    uint32_t reserved;
+    uint64_t requestId;
+};
+
+struct DaemonOptions
+{
+    string socketPath;
+    uint32_t numSolvers;                        // Zero for one per worker thread.
+    uint32_t maxQueued;                         // Requests waiting for a solver. Zero for 64 per solver.
+    const map<string, pfnProblem>* problems;    // Self-test registry, or null for none.
+
+    DaemonOptions() : numSolvers(0), maxQueued(0), problems(nullptr) {}
+};
+
+ResultCode RunDaemon(const DaemonOptions& options, const atomic<bool>* stop = nullptr);
+
+/*
+ * Load generator. Each client thread opens its own connection and keeps up to pipelineDepth requests
+ * outstanding, cycling through the given instances, and times every request from send to response.
+ */
+
+struct LoadGenOptions
+{
+    string socketPath;
+    string name;                    // Request name, usually a batch type.
+    vector<string> instances;
+    uint32_t numClients;
+    uint32_t requestsPerClient;
+    uint32_t pipelineDepth;
+
+    LoadGenOptions() : numClients(4), requestsPerClient(1000), pipelineDepth(1) {}
+};
+
+struct LoadGenStats
+{
+    uint64_t requests;
+    uint64_t errors;                // Responses with a result other than OK.
+    double seconds;
+    double p50Us;
+    double p90Us;
+    double p99Us;
+    double p999Us;
+    double maxUs;
+};
+
+ResultCode RunLoadGenerator(const LoadGenOptions& options, LoadGenStats& stats);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <string_view>
+
+using namespace std;
+
+/*
+ * Multichromosomal signed genomes with linear and circular chromosomes. genes holds every
+ * chromosome's signed gene ids (1 based, negative on the reverse strand) back to back; chromosome c
+ * is genes[chromStarts[c]..chromStarts[c + 1]) and circular[c] says whether its ends are joined.
+ */
+
+struct Genome
+{
+    string name;
+    vector<int32_t> genes;
+    vector<uint32_t> chromStarts;
+    vector<uint8_t> circular;
+
+    Genome() : chromStarts(1, 0) {}
+
+    uint32_t NumChromosomes() const { return (uint32_t)circular.size(); }
+
+    void Clear()
+    {
+        name.clear();
+        genes.clear();
+        chromStarts.assign(1, 0);
+        circular.clear();
+    }
+
+    /**
+     * EndChromosome - Close the chromosome made of the genes added since the last one ended. Does
+     * nothing if there are none.
+     */
+
+    void EndChromosome(const bool isCircular)
+    {
+        if (genes.size() == chromStarts.back()) return;
+
+        chromStarts.push_back((uint32_t)genes.size());
+        circular.push_back(isCircular ? 1 : 0);
+    }
+};
+
+/*
+ * DCJ distance d = N - (C + I / 2) for genomes with the same N genes, where C counts cycles and I odd
+ * (AB) paths of their adjacency graph.
+ */
+
+struct DcjResult
+{
+    uint32_t genes;
+    uint32_t cycles;
+    uint32_t oddPaths;
+    uint32_t evenPaths;
+    uint32_t distance;
+};
+
+ResultCode DcjDistance(const Genome& a, const Genome& b, DcjResult& result);
+
+/*
+ * Gene name dictionary in flat arrays: names back to back in one string, and an open addressing table
+ * whose slots pack a name's hash above its id, so a probe is one load and most never compare
+ * characters. Ids are 1 based in order of first appearance; an empty slot is 0.
+ */
+
+struct GeneDictionary
+{
+    string nameData;
+    vector<uint32_t> nameOffsets;
+    vector<uint64_t> slots;
+
+    GeneDictionary();
+
+    uint32_t Size() const { return (uint32_t)nameOffsets.size() - 1; }
+    string_view Name(const uint32_t id) const { return string_view(nameData).substr(nameOffsets[id - 1], nameOffsets[id] - nameOffsets[id - 1]); }
+
+    uint32_t GetId(const char* name, const size_t len);
+    void Grow();
+};
+
+/*
+ * Streaming reader for gene order files. A genome starts with a '>' name line and is followed by its
+ * chromosomes, whitespace separated genes ending in '|' (or '$') for a linear chromosome or ')' for a
+ * circular one. A line break also ends a linear chromosome, and lines starting with '#' are comments.
+ * '>' and '#' only have a meaning in the first column; elsewhere they are part of a gene name. Genes
+ * are names with an optional '-' or '+' strand prefix; names map to ids in order of first appearance,
+ * shared by every genome the reader returns.
+ */
+
+struct GeneOrderReader
+{
+    HANDLE file;
+    vector<char> buffer;
+    size_t pos;
+    size_t len;
+    bool atEof;
+    bool readError;
+
+    GeneDictionary genes;
+    string token;
+
+    GeneOrderReader();
+    ~GeneOrderReader();
+
+    ResultCode Open(const char* path, const size_t bufferBytes = 1 << 20);
+    ResultCode Next(Genome& genome);
+    void Close();
+
+    // Parser internals.
+
+    bool Refill();
+    int Peek() { return pos < len || Refill() ? (unsigned char)buffer[pos] : -1; }
+    void SkipLine();
+};
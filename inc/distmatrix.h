@@ -0,0 +1,75 @@
+#pragma once
+
+#include "reversal.h"
+
+/*
+ * All-pairs rearrangement distances over a batch of framed permutations of the same length. The
+ * batch is stored as flat arrays rather than a vector per permutation: values[i * stride + p] is the
+ * value at position p of permutation i, and positions[i * stride + v] the position of value v in it,
+ * with stride = n + 2.
+ */
+
+struct PermutationBatch
+{
+    uint32_t count;
+    uint32_t n;
+    vector<uint32_t> values;
+    vector<uint32_t> positions;
+
+    PermutationBatch(const uint32_t n) : count(0), n(n) {}
+
+    uint32_t Stride() const { return n + 2; }
+    const uint32_t* Values(const uint32_t i) const { return values.data() + (size_t)i * Stride(); }
+    const uint32_t* Positions(const uint32_t i) const { return positions.data() + (size_t)i * Stride(); }
+
+    ResultCode Add(const vector<uint32_t>& perm);
+};
+
+/*
+ * Distance matrix file. A header is followed by two count x count row-major uint32_t matrices at the
+ * offsets it gives: breakpoint distances, then greedy reversal distances. Both are written in full
+ * (symmetric, zero diagonal) so readers can map the file and index it directly. The reversal entry
+ * for i < j is the number of reversals BreakPointReversal uses to turn permutation i into j, mirrored
+ * to [j][i].
+ */
+
+const char DIST_MATRIX_MAGIC[4]     = { 'R', 'D', 'M', 'X' };
+const uint32_t DIST_MATRIX_VERSION  = 1;
+
+struct DistMatrixFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t n;
+    uint64_t breakpointOffset;  // Byte offsets from the start of the file.
+    uint64_t reversalOffset;
+};
+
+/*
+ * Mapping of a distance matrix file, for writing it in place or reading it back.
+ */
+
+struct DistMatrixFile
+{
+    HANDLE file;
+    HANDLE mapping;
+    uint8_t* view;
+    uint64_t fileSize;
+    uint32_t count;
+    uint32_t* breakpoints;
+    uint32_t* reversals;
+
+    DistMatrixFile();
+    ~DistMatrixFile();
+
+    ResultCode Create(const char* path, const uint32_t count, const uint32_t n);
+    ResultCode Open(const char* path);
+    void Close();
+
+    uint32_t Breakpoints(const uint32_t i, const uint32_t j) const { return breakpoints[(size_t)i * count + j]; }
+    uint32_t Reversals(const uint32_t i, const uint32_t j) const { return reversals[(size_t)i * count + j]; }
+};
+
+ResultCode ComputeDistanceMatrix(const PermutationBatch& batch, uint32_t* breakpoints, uint32_t* reversals);
+ResultCode WriteDistanceMatrix(const PermutationBatch& batch, const char* path);
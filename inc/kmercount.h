@@ -0,0 +1,88 @@
+#pragma once
+
+#include "seqgen.h"
+
+#include <functional>
+
+/*
+ * Parallel k-mer counting over 2-bit packed sequences. For every distinct k-mer the counter keeps the
+ * total number of occurrences and the number of sequences it occurs in, so over-represented words can
+ * seed the motif engines with a strong starting solution.
+ *
+ * Counts go into a lock-free open-addressing table: a slot is claimed by compare-and-swap on its key
+ * and its counters are atomic adds. The table has a fixed size, so inputs with more distinct k-mers
+ * than fit are counted in passes over hash partitions: pass p only inserts the k-mers whose hash has
+ * prefix p, and a pass that fills the table is split into two narrower ones and redone. Memory stays
+ * bounded by maxSlots regardless of input size, at the cost of rescanning the input once per pass.
+ *
+ * Presence is counted exactly. Sequences up to KMER_CHUNK_LEN k-mers are handled whole by one thread,
+ * which sorts its k-mers so each distinct one is added once with its multiplicity. Longer sequences
+ * are split over all threads one sequence at a time, and a slot counts the sequence when it is first
+ * stamped with its index.
+ *
+ * k is limited to 31 so a key with all bits set can mark an empty slot.
+ */
+
+const uint32_t MAX_COUNTED_KMER     = 31;
+const uint32_t KMER_CHUNK_LEN       = 1 << 16;
+const uint64_t KMER_DEFAULT_SLOTS   = 1 << 24;
+
+/*
+ * One packed sequence: 2 bits per base, first base in the highest bits of words[0], as in
+ * PackedSeqSet and PackBases.
+ */
+
+struct PackedSeqRef
+{
+    const uint64_t* words;
+    uint64_t len;
+};
+
+struct KmerCount
+{
+    uint64_t kmer;
+    uint64_t total;
+    uint32_t seqCount;
+};
+
+struct KmerCountStats
+{
+    uint64_t totalKmers;
+    uint64_t distinctKmers;
+    uint32_t passes;
+    uint32_t splits;
+    uint64_t slots;
+};
+
+void GetPackedSeqRefs(const PackedSeqSet& set, vector<PackedSeqRef>& refs);
+void PackSequences(const vector<string>& seqs, vector<uint64_t>& words, vector<PackedSeqRef>& refs);
+
+ResultCode CountKmers(
+    const vector<PackedSeqRef>& seqs,
+    const uint32_t k,
+    const function<void(const KmerCount*, const size_t)>& emit,
+    const uint64_t maxSlots = KMER_DEFAULT_SLOTS,
+    KmerCountStats* stats = nullptr
+);
+
+ResultCode GetTopKmers(
+    const vector<PackedSeqRef>& seqs,
+    const uint32_t k,
+    const uint32_t numTop,
+    vector<KmerCount>& top,
+    const uint64_t maxSlots = KMER_DEFAULT_SLOTS
+);
+
+ResultCode GetKmerSeedOffsets(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numSeeds,
+    vector<vector<uint32_t>>& seedOffsets
+);
+
+ResultCode FindMotifSeeded(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numCandidates,
+    vector<uint32_t>& offsets
+);
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "commoninc.h"
+
+using namespace std;
+
+ResultCode GetMinMax(const vector<uint32_t>& list, uint32_t& min, uint32_t& max);
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <intrin.h>
+
+using namespace std;
+
+/*
+ * Shared motif finding interface. Sequences are stored as ACGT strings; the heuristic engines
+ * convert them once into 2-bit base codes (A = 0, C = 1, G = 2, T = 3) so the complement of a
+ * code is simply 3 - code.
+ */
+
+const uint8_t INVALID_BASE = 4;
+
+/**
+ * BaseToCode - Map an A/C/G/T character (either case) to its 2-bit code.
+ *
+ * @param  base [in] Nucleotide character.
+ * @return      Base code 0-3, or INVALID_BASE for anything else.
+ */
+
+inline uint8_t BaseToCode(char base)
+{
+    switch (base)
+    {
+    case 'A': case 'a': return 0;
+    case 'C': case 'c': return 1;
+    case 'G': case 'g': return 2;
+    case 'T': case 't': return 3;
+    default: return INVALID_BASE;
+    }
+}
+
+inline char CodeToBase(uint8_t code) { return "ACGT"[code & 3]; }
+
+/*
+ * Packed k-mers. Up to 32 bases fit in a uint64_t with the first base in the highest bits, so
+ * numeric order of packed values matches lexicographic order of the k-mers.
+ */
+
+const uint32_t MAX_PACKED_KMER = 32;
+
+inline uint64_t KmerMask(uint32_t k) { return k >= 32 ? ~0ULL : (1ULL << (2 * k)) - 1; }
+
+/**
+ * PackedMismatches - Hamming distance between two packed k-mers of the same length.
+ */
+
+inline uint32_t PackedMismatches(uint64_t a, uint64_t b)
+{
+    uint64_t diff = a ^ b;
+    return (uint32_t)__popcnt64((diff | (diff >> 1)) & 0x5555555555555555ULL);
+}
+
+/**
+ * PackKmer - Pack the k bases starting at str into a uint64_t.
+ *
+ * @return False if the window contains a non-ACGT character.
+ */
+
+inline bool PackKmer(const char* str, uint32_t k, uint64_t& kmer)
+{
+    kmer = 0;
+
+    for (uint32_t i = 0; i < k; i++)
+    {
+        uint8_t code = BaseToCode(str[i]);
+        if (code == INVALID_BASE) return false;
+        kmer = (kmer << 2) | code;
+    }
+
+    return true;
+}
+
+inline string UnpackKmer(uint64_t kmer, uint32_t k)
+{
+    string str(k, 'A');
+    for (uint32_t i = 0; i < k; i++) str[k - 1 - i] = CodeToBase((uint8_t)(kmer >> (2 * i)));
+    return str;
+}
+
+ResultCode GenerateMotifSequences(
+    const uint32_t nSeq,
+    const uint32_t seqLen,
+    const uint32_t motifLen,
+    vector<string>& seqs,
+    string& motif,
+    vector<uint32_t>& offsets,
+    const uint32_t numMismatches = 0
+);
+
+uint32_t GetConsensus(
+    const vector<string>& seqs,
+    const uint32_t prefixLen,
+    const vector<uint32_t>& offsets,
+    const uint32_t motifLen
+);
+
+ResultCode FindMotif(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    vector<uint32_t>& offsets,
+    const vector<uint32_t>* incumbent = nullptr
+);
+
+ResultCode RandomizedMotifSearch(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numRestarts,
+    vector<uint32_t>& offsets,
+    const vector<vector<uint32_t>>* seedOffsets = nullptr
+);
+
+ResultCode GibbsSampler(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numRestarts,
+    const uint32_t numIters,
+    vector<uint32_t>& offsets,
+    const vector<vector<uint32_t>>* seedOffsets = nullptr
+);
+
+ResultCode FindPlantedMotifs(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t maxMismatches,
+    vector<string>& motifs
+);
+
+/*
+ * Incremental motif search. The state from one FindMotifIncremental call (sequences, optimal offsets,
+ * their profile and per-sequence bound tables) is kept, and can be saved to a file, so the next call on
+ * a slightly different sequence set only builds tables for the new sequences and starts the search from
+ * the old optimum carried over to the new set.
+ */
+
+struct MotifSeqTable
+{
+    vector<uint8_t> codes;      // Per base: 0-3 for ACGT, INVALID_BASE for anything else.
+    vector<uint8_t> colMask;    // Per motif column: bit b set if base b appears there at some offset.
+};
+
+struct MotifSearchState
+{
+    uint32_t motifLen;
+    uint32_t score;
+    vector<string> seqs;
+    vector<uint32_t> offsets;
+    vector<uint32_t> profile;   // 4 x motifLen base counts at the offsets, one row per base code.
+    vector<MotifSeqTable> tables;
+
+    MotifSearchState() : motifLen(0), score(0) {}
+
+    void Clear();
+    ResultCode Save(const char* path) const;
+    ResultCode Load(const char* path);
+};
+
+struct MotifIncrementalStats
+{
+    uint32_t keptSeqs;
+    uint32_t addedSeqs;
+    uint32_t removedSeqs;
+    uint32_t warmScore;         // Score of the carried over solution the search started from.
+    uint64_t nodes;             // Search nodes visited.
+};
+
+ResultCode FindMotifIncremental(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    MotifSearchState& state,
+    vector<uint32_t>& offsets,
+    MotifIncrementalStats* stats = nullptr
+);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "commoninc.h"
+
+using namespace std;
+
+/*
+ * Permutation stored as an implicit treap. A node's key is its in-order position, so reversing a
+ * range is two splits, a lazy flip of the middle tree and two merges, all O(log n) expected. Node v
+ * holds value v, and parent links give the position of a value by walking up to the root.
+ *
+ * Each value also carries a strip mark used by reversal sorting. Forward and backward marks swap under
+ * a flip, and each subtree keeps the smallest value per mark, so queries like "smallest value in a
+ * decreasing strip" are answered at the root.
+ * A flip is applied to a node's own fields immediately and left pending for its children.
+ *
+ * A signed permutation keeps each sign as a mark, forward for positive and backward for negative, so
+ * a reversal negates the values it moves through the same lazy flip.
+ */
+
+const uint32_t PERM_TREE_NONE = ~0u;
+
+enum StripMark : uint8_t
+{
+    STRIP_NONE,
+    STRIP_SINGLE,
+    STRIP_FORWARD,
+    STRIP_BACKWARD
+};
+
+struct PermTreeNode
+{
+    uint32_t left;
+    uint32_t right;
+    uint32_t parent;
+    uint32_t size;
+    uint32_t priority;
+    uint32_t minMarked[3];      // Smallest value in the subtree per mark, STRIP_SINGLE onwards.
+    uint8_t flip;
+    uint8_t mark;
+};
+
+struct PermTree
+{
+    vector<PermTreeNode> nodes;
+    vector<uint32_t> path;
+    uint32_t root;
+
+    PermTree(const vector<uint32_t>& perm);
+    PermTree(const vector<int32_t>& perm);
+
+    uint32_t Size() const { return root == PERM_TREE_NONE ? 0 : nodes[root].size; }
+
+    void Reverse(const uint32_t begin, const uint32_t end);
+    uint32_t PositionOf(const uint32_t value);
+    uint32_t At(const uint32_t pos);
+    bool IsNegative(const uint32_t value);
+
+    void SetMark(const uint32_t value, const StripMark mark);
+    void SetMarks(const vector<StripMark>& marks);
+    uint32_t MinMarked(const StripMark mark) const { return root == PERM_TREE_NONE ? PERM_TREE_NONE : nodes[root].minMarked[mark - 1]; }
+
+    void Flatten(vector<uint32_t>& perm);
+    void Flatten(vector<int32_t>& perm);
+
+    // Treap internals.
+
+    void Build(const uint32_t* values, const uint32_t count);
+    void Apply(const uint32_t x);
+    void Push(const uint32_t x);
+    void Pull(const uint32_t x);
+    void PullAll();
+    void PushPath(const uint32_t x);
+    void Split(const uint32_t t, const uint32_t k, uint32_t& a, uint32_t& b);
+    uint32_t Merge(const uint32_t a, const uint32_t b);
+};
@@ -19,9 +19,28 @@ struct TestResult
     string testMsg;
 };
 
+typedef void (*pfnProblem)(vector<TestResult>& testResults);
+
 void GetMinMax(vector<TestResult> &testResults);
 void HonestProfessors(vector<TestResult>& testResults);
 
 void RestrictionMapping(vector<TestResult>& testResults);
 void MotifFinding(vector<TestResult>& testResults);
-void ReversalDistance(vector<TestResult>& testResults);
\ No newline at end of file
+void RandomizedMotifFinding(vector<TestResult>& testResults);
+void PlantedMotifFinding(vector<TestResult>& testResults);
+void SequenceGeneration(vector<TestResult>& testResults);
+void SequenceFileReading(vector<TestResult>& testResults);
+void PwmScanning(vector<TestResult>& testResults);
+void ReversalDistance(vector<TestResult>& testResults);
+void SignedReversalSorting(vector<TestResult>& testResults);
+void PermutationTree(vector<TestResult>& testResults);
+void RearrangementMatrix(vector<TestResult>& testResults);
+void ExactReversal(vector<TestResult>& testResults);
+void DoubleCutJoin(vector<TestResult>& testResults);
+void BatchMode(vector<TestResult>& testResults);
+void SolverDaemon(vector<TestResult>& testResults);
+void ResultCaching(vector<TestResult>& testResults);
+void DoubleDigest(vector<TestResult>& testResults);
+void TestReporting(vector<TestResult>& testResults);
+void KmerCounting(vector<TestResult>& testResults);
+void IncrementalMotif(vector<TestResult>& testResults);
\ No newline at end of file
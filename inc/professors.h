@@ -0,0 +1,150 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <condition_variable>
+#include <future>
+
+using namespace std;
+
+/*
+ * Honest/deceitful professors puzzle. Over half of PROFCNT professors are honest; an honest professor
+ * answers truthfully whether another is honest, a deceitful one answers at random.
+ */
+
+const uint32_t PROFCNT = 100;
+
+struct Professors
+{
+    bool honest[PROFCNT];
+    uint32_t queryCnt;
+
+    Professors() : queryCnt(0)
+    {
+        memset(honest, false, PROFCNT * sizeof(bool));
+        uint32_t honestCnt = (PROFCNT / 2) + rand() % (PROFCNT / 2);
+
+        while (honestCnt > 0)
+        {
+            uint32_t curIdx = rand() % PROFCNT;
+            if (!honest[curIdx])
+            {
+                honest[curIdx] = true;
+                honestCnt--;
+            }
+        }
+    }
+
+    
+    /**
+     * GetQueryCnt - Return how many times this professor set has been queried.
+     * @return Number of times the set has been queried.
+     */
+    
+    uint32_t GetQueryCnt() { return queryCnt; }
+
+    /**
+     * QueryHonesty - Check if professor a things professor b is honest. If a is honest,
+     * returns if b is actually honest. If b is dishonest, returns random true/false.
+     *
+     * @param  a Professor to query.
+     * @param  b Professor to query about.
+     * @return   Whether professor a considers professor b honest.
+     */
+    
+    bool QueryHonesty(uint32_t a, uint32_t b)
+    {
+        queryCnt++;
+        if (honest[a]) return honest[b];
+        else return rand() % 2 == 0;
+    }
+};
+
+/*
+ * Asynchronous oracle. In real use a honesty query is a remote lookup with a round trip latency, so
+ * queries are sent in batches and each batch answers through a future. The queries of one elimination
+ * round don't depend on each other, so a round can have all its batches in flight at once and pays about
+ * one round trip instead of one per query.
+ */
+
+struct HonestyQuery
+{
+    uint32_t asker;
+    uint32_t subject;
+};
+
+struct HonestyOracle
+{
+    virtual ~HonestyOracle() {}
+
+    /**
+     * QueryBatch - Submit a batch of queries.
+     *
+     * @param  queries [in] Queries to answer.
+     * @return              Future for the answers, in query order.
+     */
+
+    virtual future<vector<bool>> QueryBatch(const vector<HonestyQuery>& queries) = 0;
+    virtual uint32_t GetQueryCnt() const = 0;
+};
+
+/*
+ * Latency model for SimulatedOracle. A batch costs callUs for the round trip plus queryUs for each query
+ * in it, and the server works on at most maxInFlight batches at a time (zero for no limit); the rest
+ * queue.
+ */
+
+struct OracleLatency
+{
+    const char* name;
+    uint32_t callUs;
+    uint32_t queryUs;
+    uint32_t maxInFlight;
+};
+
+/*
+ * Local stand-in for a remote oracle over a Professors set. Answers are decided on the caller's thread
+ * when a batch is submitted, so a seeded run gets the same answers whatever the timing; the latency
+ * model only delays their delivery. A model without latency answers through a ready future.
+ */
+
+struct SimulatedOracle : HonestyOracle
+{
+    Professors& profs;
+    OracleLatency latency;
+    mutex lock;
+    condition_variable slotFree;
+    uint32_t inFlight;
+
+    SimulatedOracle(Professors& profs, const OracleLatency& latency) : profs(profs), latency(latency), inFlight(0) {}
+
+    future<vector<bool>> QueryBatch(const vector<HonestyQuery>& queries) override;
+    uint32_t GetQueryCnt() const override { return profs.queryCnt; }
+};
+
+/*
+ * How an algorithm sends a round of independent queries: at most maxBatch queries per batch (zero puts
+ * the whole round in one batch), and either every batch in flight at once or each one waited on before
+ * the next is sent. { 1, false } is the one query at a time behaviour of the synchronous API.
+ */
+
+struct OracleRoundPolicy
+{
+    uint32_t maxBatch;
+    bool concurrent;
+};
+
+struct OracleRunStats
+{
+    uint32_t queries;
+    uint32_t batches;
+    uint32_t rounds;
+};
+
+void QueryRound(
+    HonestyOracle& oracle,
+    const vector<HonestyQuery>& queries,
+    const OracleRoundPolicy& policy,
+    vector<bool>& answers,
+    OracleRunStats* stats = nullptr
+);
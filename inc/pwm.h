@@ -0,0 +1,42 @@
+#pragma once
+
+#include "motif.h"
+
+/*
+ * Position weight matrix scanning. A PWM holds a log-odds score per motif column and base; the
+ * score of a window is the sum of its columns' scores. Scans report every window, on either
+ * strand, scoring at or above a threshold.
+ */
+
+struct Pwm
+{
+    uint32_t motifLen;
+    vector<float> scores;       // scores[col * 4 + base], natural log odds against background.
+
+    float Score(uint32_t col, uint8_t base) const { return scores[col * 4 + base]; }
+    float MaxScore() const;
+    float MinScore() const;
+};
+
+struct PwmHit
+{
+    uint64_t pos;               // Leftmost forward-strand coordinate of the window.
+    float score;
+    uint8_t strand;             // 0 forward, 1 reverse complement.
+};
+
+ResultCode BuildPwm(
+    const vector<string>& seqs,
+    const vector<uint32_t>& offsets,
+    const uint32_t motifLen,
+    Pwm& pwm
+);
+
+ResultCode ScanPwm(
+    const Pwm& pwm,
+    const char* seq,
+    const size_t seqLen,
+    const float threshold,
+    const bool bothStrands,
+    vector<PwmHit>& hits
+);
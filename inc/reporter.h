@@ -0,0 +1,126 @@
+#pragma once
+
+#include "problems.h"
+
+/*
+ * Streaming test result reporter. Results are folded in as they arrive instead of being kept until
+ * the end of the run: passes only bump per-name counters, and failures keep a fixed-size record plus
+ * their message. Names are interned, and a trailing case index ("HonestProfs[12]") is stored as a
+ * number, so a suite with a million numbered cases keeps one copy of its name.
+ *
+ * With a report file open, every failure is written as a JSON line when it arrives, and every problem
+ * adds a summary line when it ends:
+ *
+ *   {"problem":"GetMinMax","test":"MinMax::RandomList[3]","code":"FAIL","msg":"..."}
+ *   {"problem":"GetMinMax","pass":104,"fail":1,"error":0,"ms":812}
+ *
+ * A full run of the test driver is bracketed by a run line and an end line, so a report can be checked
+ * for completeness and reports from the shards of one run can be merged:
+ *
+ *   {"seed":1234,"shard":0,"shards":4}
+ *   {"end":2}
+ *
+ * A reporter is used from one thread.
+ */
+
+const uint32_t TEST_NO_INDEX = UINT32_MAX;
+
+struct TestRecord
+{
+    uint32_t nameId;
+    uint32_t caseIndex;     // TEST_NO_INDEX for unnumbered tests.
+    uint32_t msgId;         // Into TestReporter::messages.
+    uint32_t code;          // TestResultCode.
+};
+
+struct TestNameCounts
+{
+    uint64_t counts[3];     // By TestResultCode.
+};
+
+struct TestReporter
+{
+    vector<string> names;
+    unordered_map<string, uint32_t> nameIds;
+    unordered_map<const char*, uint32_t> literalIds;
+    vector<TestNameCounts> nameCounts;
+    vector<TestRecord> failures;
+    vector<string> messages;
+    uint64_t totals[3];
+
+    // Current problem.
+
+    string problem;
+    uint64_t problemCounts[3];
+    long long problemStart;
+
+    // JSON lines output.
+
+    HANDLE file;
+    string outBuf;
+    bool writeError;
+    uint32_t problemsEnded;
+
+    TestReporter();
+    ~TestReporter();
+
+    ResultCode Open(const char* path);
+    ResultCode Close();
+
+    uint32_t Intern(const string& name);
+    uint32_t InternLiteral(const char* name);
+    string GetTestName(const uint32_t nameId, const uint32_t caseIndex) const;
+
+    void BeginRun(const uint64_t seed, const uint32_t shardIndex, const uint32_t shardCount);
+    void EndRun();
+
+    void BeginProblem(const string& name);
+    void EndProblem(const long long elapsedMs = -1);
+
+    void AddPass(const uint32_t nameId);
+    void AddPassCount(const uint64_t count);
+    void Add(const uint32_t nameId, const uint32_t caseIndex, const TestResultCode code, const string& msg);
+    void Add(const TestResult& result);
+
+    uint64_t GetCount(const TestResultCode code) const { return totals[code]; }
+    void PrintSummary() const;
+};
+
+void SetActiveReporter(TestReporter* reporter);
+TestReporter* GetActiveReporter();
+
+void ReportTestCase(
+    vector<TestResult>& testResults,
+    const char* name,
+    const uint32_t caseIndex,
+    const TestResultCode code,
+    const string& msg = string()
+);
+
+void AppendJsonString(string& out, const string& str);
+
+/*
+ * Sharding. A run of the test driver can be split over independent processes with --shard i/N: every
+ * process gets the same seed and the same problem list, and runs only its slice. Problems that split
+ * their own cases ask ShardOwnsCase for each one; every other problem runs whole on one shard. Each
+ * owned case reseeds rand() from (seed, name, case index), so a case generates the same input in any
+ * shard layout, including an unsharded run.
+ *
+ * Each shard writes its own --report file; MergeTestReports checks the set is one complete run and
+ * folds it into a reporter as if it had run in one process.
+ */
+
+struct TestShard
+{
+    uint32_t index;
+    uint32_t count;
+    uint64_t seed;
+};
+
+void SetTestShard(const TestShard& shard);
+const TestShard& GetTestShard();
+
+uint64_t GetCaseSeed(const char* name, const uint32_t caseIndex);
+bool ShardOwnsCase(const char* name, const uint32_t caseIndex);
+
+ResultCode MergeTestReports(const vector<string>& paths, TestReporter& merged, string& error);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "commoninc.h"
+
+using namespace std;
+
+/*
+ * Restriction mapping (turnpike) kernels. Distance lists are sorted ascending; point sets are sorted
+ * and start at 0.
+ */
+
+ResultCode GetPairwiseDistances(const vector<uint32_t>& points, vector<uint32_t>& distances);
+ResultCode ComputePDBacktracking(const vector<uint32_t>& distList, vector<uint32_t>& pd);
+
+/*
+ * Double digest mapping. Enzyme A, enzyme B and both together cut the same molecule; given the three
+ * multisets of fragment lengths, find orders of the A and B fragments whose combined cuts produce the
+ * A+B fragments. The search is parallel tempering over fragment orders: each chain swaps adjacent
+ * fragments under Metropolis acceptance at its own temperature, chains run concurrently between
+ * exchange rounds, and neighbouring temperatures trade states at each round.
+ */
+
+struct DoubleDigestOptions
+{
+    uint32_t numChains;             // Zero for two per worker thread, at least four.
+    uint32_t movesPerRound;         // Moves per chain between exchanges.
+    uint32_t maxRounds;
+    float minTemp;
+    float maxTemp;
+
+    DoubleDigestOptions() : numChains(0), movesPerRound(2000), maxRounds(5000), minTemp(0.5f), maxTemp(8.0f) {}
+};
+
+struct DoubleDigestStats
+{
+    uint32_t rounds;
+    uint64_t moves;
+    uint64_t exchanges;             // Accepted state exchanges.
+    uint32_t bestCost;              // Zero when solved.
+};
+
+ResultCode GetDigestFragments(const vector<uint32_t>& cuts, const uint32_t length, vector<uint32_t>& fragments);
+
+ResultCode SolveDoubleDigest(
+    const vector<uint32_t>& fragsA,
+    const vector<uint32_t>& fragsB,
+    const vector<uint32_t>& fragsAB,
+    vector<uint32_t>& orderA,
+    vector<uint32_t>& orderB,
+    const DoubleDigestOptions& options = DoubleDigestOptions(),
+    DoubleDigestStats* stats = nullptr
+);
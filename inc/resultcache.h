@@ -0,0 +1,83 @@
+#pragma once
+
+#include "commoninc.h"
+
+using namespace std;
+
+/*
+ * Content-addressed result cache shared by every process that opens the same file. Instances are
+ * keyed by the SHA-256 of their canonical form, so inputs that only differ in presentation share an
+ * entry:
+ *
+ *   Partial digest     The sorted distance multiset.           Value: the point set.
+ *   Motif              The sorted sequence set plus k.         Value: offsets in sorted sequence order.
+ *
+ * The file is mapped whole and laid out as a header, a fixed open-addressing index and an append-only
+ * data area. Entries are never changed or removed. Writers serialize on a byte-range lock beyond the
+ * end of the file plus a mutex for threads sharing the handle; each one appends its values, fills in
+ * an empty index slot and publishes it last by storing the value offset. Readers take no lock: a slot
+ * with a nonzero offset is complete, and a slot with a zero offset ends the probe.
+ *
+ * Only solved instances are stored. Once the index or the data area is full, stores fail and lookups
+ * keep working.
+ */
+
+const uint32_t RESULT_CACHE_VERSION         = 1;
+const uint32_t RESULT_CACHE_DEFAULT_SLOTS   = 1 << 16;
+const uint64_t RESULT_CACHE_DEFAULT_DATA    = 64 << 20;
+
+enum ResultKind
+{
+    RESULT_KIND_PARTIAL_DIGEST  = 1,
+    RESULT_KIND_MOTIF           = 2
+};
+
+struct ResultKey
+{
+    uint8_t hash[32];
+    uint32_t kind;
+};
+
+struct ResultCacheHeader;
+struct ResultCacheSlot;
+
+struct ResultCache
+{
+    HANDLE file;
+    HANDLE mapping;
+    uint8_t* view;
+    ResultCacheHeader* header;
+    ResultCacheSlot* slots;
+    uint64_t mapBytes;
+    mutex writeLock;
+    atomic<uint64_t> hits;
+    atomic<uint64_t> misses;
+
+    ResultCache();
+    ~ResultCache();
+
+    ResultCode Open(
+        const char* path,
+        const uint32_t slotCount = RESULT_CACHE_DEFAULT_SLOTS,
+        const uint64_t dataBytes = RESULT_CACHE_DEFAULT_DATA
+    );
+
+    void Close();
+    bool IsOpen() const { return view != nullptr; }
+    bool Lookup(const ResultKey& key, vector<uint32_t>& values);
+    ResultCode Store(const ResultKey& key, const vector<uint32_t>& values);
+    uint64_t GetEntryCount() const;
+};
+
+ResultCache& GetProcessResultCache();
+
+void GetPartialDigestKey(const vector<uint32_t>& distList, ResultKey& key);
+void GetMotifKey(const vector<string>& seqs, const uint32_t motifLen, ResultKey& key, vector<uint32_t>& order);
+
+/*
+ * Cached entry points. They behave exactly like the solvers they wrap and go straight to them when
+ * the cache isn't open.
+ */
+
+ResultCode CachedComputePDBacktracking(ResultCache& cache, const vector<uint32_t>& distList, vector<uint32_t>& pd);
+ResultCode CachedFindMotif(ResultCache& cache, const vector<string>& seqs, const uint32_t motifLen, vector<uint32_t>& offsets);
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "commoninc.h"
+
+#include <intrin.h>
+
+using namespace std;
+
+/*
+ * Genome rearrangement by reversals. Permutations are framed: perm[0] = 0 and perm[n + 1] = n + 1
+ * around the n elements being sorted, and the frame never moves. A reversal flips perm[begin..end]
+ * (inclusive positions). There is a breakpoint between positions i and i + 1 whenever
+ * |perm[i + 1] - perm[i]| != 1.
+ */
+
+struct Reversal
+{
+    uint32_t begin;
+    uint32_t end;
+};
+
+/*
+ * Strip - Maximal run of positions [beginIdx, endIdx] with no breakpoint inside it.
+ */
+
+struct Strip
+{
+    uint32_t beginIdx;
+    uint32_t endIdx;
+    bool decreasing;
+
+    Strip(uint32_t begin, uint32_t end, bool decreasing) : beginIdx(begin), endIdx(end), decreasing(decreasing) {};
+};
+
+bool IsFramedPermutation(const vector<uint32_t>& perm);
+uint32_t CountBreakpoints(const vector<uint32_t>& perm);
+void ApplyReversals(vector<uint32_t>& perm, const vector<Reversal>& reversals);
+ResultCode GetStrips(const vector<uint32_t>& perm, vector<Strip>& strips);
+
+/*
+ * Two level bitset with a summary word per 64 words, so finding the next set bit skips empty
+ * stretches 4096 bits at a time.
+ */
+
+const size_t BITSET_NONE = ~(size_t)0;
+
+struct IndexBitset
+{
+    vector<uint64_t> words;
+    vector<uint64_t> summary;
+
+    IndexBitset() {}
+    IndexBitset(size_t size) { Reset(size); }
+
+    /**
+     * Reset - Clear to size bits, keeping the allocation.
+     */
+
+    void Reset(size_t size)
+    {
+        words.assign((size + 63) / 64, 0);
+        summary.assign((size + 4095) / 4096, 0);
+    }
+
+    bool Test(size_t i) const { return ((words[i >> 6] >> (i & 63)) & 1) != 0; }
+
+    void Flip(size_t i)
+    {
+        uint64_t& word      = words[i >> 6];
+        const uint64_t bit  = 1ULL << (i & 63);
+        word ^= bit;
+
+        // The summary only changes when a word becomes empty or stops being empty.
+
+        if (word == 0 || word == bit) summary[i >> 12] ^= 1ULL << ((i >> 6) & 63);
+    }
+
+    void Set(size_t i, bool value)
+    {
+        if (Test(i) != value) Flip(i);
+    }
+
+    /**
+     * FindNext - First set index at or after i, or BITSET_NONE.
+     */
+
+    size_t FindNext(size_t i) const
+    {
+        size_t w = i >> 6;
+        if (w >= words.size()) return BITSET_NONE;
+
+        unsigned long bit;
+        uint64_t bits = words[w] & (~0ULL << (i & 63));
+
+        if (_BitScanForward64(&bit, bits)) return (w << 6) + bit;
+
+        w++;
+        size_t s = w >> 6;
+        if (s >= summary.size()) return BITSET_NONE;
+
+        uint64_t summaryBits = summary[s] & (~0ULL << (w & 63));
+
+        while (!_BitScanForward64(&bit, summaryBits))
+        {
+            if (++s >= summary.size()) return BITSET_NONE;
+            summaryBits = summary[s];
+        }
+
+        w = (s << 6) + bit;
+        _BitScanForward64(&bit, words[w]);
+
+        return (w << 6) + bit;
+    }
+};
+
+/*
+ * Sorting can keep the permutation in a plain vector, where a reversal costs its length, or in a
+ * PermTree, where it costs O(log n) with a larger constant and building it costs O(n). The tree wins
+ * on long reversals, as in shuffled permutations, and loses on short ones whatever the size, as in
+ * a large permutation scrambled by short reversals. AUTO sorts on the vector and watches the reversal
+ * lengths of each PERM_AUTO_WINDOW reversals, moving to the tree when the remaining work looks
+ * cheaper there. Costs are in vector elements moved, measured with the Reversal::Shuffled and
+ * Reversal::Scrambled benchmarks: a tree reversal costs about as much as moving
+ * PERM_TREE_REVERSAL_COST elements, and building and flattening the tree PERM_TREE_SETUP_COST per
+ * element. Near that length, as in Reversal::Scrambled, both sorters take about as long. AUTO still
+ * loses to the tree when a few very long reversals finish the sort before the windows pay for the
+ * switch.
+ */
+
+enum PermStorage
+{
+    PERM_STORAGE_AUTO,
+    PERM_STORAGE_VECTOR,
+    PERM_STORAGE_TREE
+};
+
+const uint32_t PERM_AUTO_WINDOW         = 256;
+const uint64_t PERM_TREE_REVERSAL_COST  = 4096;
+const uint64_t PERM_TREE_SETUP_COST     = 128;
+
+ResultCode BreakPointReversal(vector<uint32_t>& perm, vector<Reversal>& reversals, const PermStorage storage = PERM_STORAGE_AUTO);
+
+/*
+ * Buffers for the vector sorter, kept by callers that sort many permutations so each sort reuses the
+ * previous allocation. decreasing holds a bit per value lying in a decreasing strip.
+ */
+
+struct ReversalScratch
+{
+    vector<uint32_t> pos;
+    IndexBitset decreasing;
+    vector<Reversal> reversals;
+};
+
+ResultCode BreakPointReversal(vector<uint32_t>& perm, ReversalScratch& scratch);
+
+/*
+ * Signed permutations use the same framing. A reversal of [begin, end] also flips the sign of each
+ * element it moves.
+ */
+
+bool IsFramedSignedPermutation(const vector<int32_t>& perm);
+void ApplySignedReversals(vector<int32_t>& perm, const vector<Reversal>& reversals);
+
+ResultCode SignedReversalDistance(const vector<int32_t>& perm, uint32_t& distance, vector<Reversal>* scenario = nullptr);
+
+/*
+ * Exact unsigned reversal distance for small permutations, by bidirectional search over packed
+ * states, and whole distance tables indexed by permutation rank for use as test oracles.
+ */
+
+const uint32_t EXACT_REVERSAL_MAX_N = 14;
+const uint32_t REVERSAL_TABLE_MAX_N = 11;
+
+ResultCode ExactReversalDistance(const vector<uint32_t>& perm, uint32_t& distance);
+ResultCode ComputeReversalDistanceTable(const uint32_t n, vector<uint8_t>& table);
+uint64_t RankPermutation(const vector<uint32_t>& perm);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "motif.h"
+
+/*
+ * Synthetic sequence workload generator. Every sequence is derived from its own generator stream
+ * (seed + 1 + index), so output is identical regardless of thread count or batch size. Bases are
+ * drawn 32 at a time from a single 64-bit generator call.
+ */
+
+struct SeqGenParams
+{
+    uint32_t nSeq;
+    uint32_t seqLen;
+    uint32_t motifLen;          // Zero for no planted motif.
+    uint32_t numMismatches;     // Bases mutated in each planted copy.
+    uint64_t seed;
+};
+
+/*
+ * Sequences stored back to back in one flat ACGT buffer, seqLen characters each.
+ */
+
+struct SeqSet
+{
+    uint32_t nSeq;
+    uint32_t seqLen;
+    vector<char> bases;
+    string motif;
+    vector<uint32_t> offsets;
+
+    const char* Seq(uint32_t i) const { return &bases[(size_t)i * seqLen]; }
+};
+
+/*
+ * Sequences packed 2 bits per base, each padded to a whole number of words. The first base of a
+ * word sits in its highest bits, so a full word is a packed 32-mer.
+ */
+
+struct PackedSeqSet
+{
+    uint32_t nSeq;
+    uint32_t seqLen;
+    uint32_t wordsPerSeq;
+    vector<uint64_t> words;
+    string motif;
+    vector<uint32_t> offsets;
+
+    const uint64_t* Seq(uint32_t i) const { return &words[(size_t)i * wordsPerSeq]; }
+
+    uint8_t Base(uint32_t i, uint32_t pos) const
+    {
+        return (uint8_t)((Seq(i)[pos >> 5] >> (62 - 2 * (pos & 31))) & 3);
+    }
+};
+
+enum SeqFileFormat
+{
+    SEQ_FILE_FASTA,
+    SEQ_FILE_PACKED
+};
+
+/*
+ * Packed sequence file layout: this header, then nSeq records of a uint32_t planted offset, a
+ * uint32_t pad and wordsPerSeq packed words.
+ */
+
+const char PACKED_SEQ_MAGIC[4]      = { 'B', 'P', 'S', 'Q' };
+const uint32_t PACKED_SEQ_VERSION   = 1;
+
+struct PackedSeqFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t nSeq;
+    uint32_t seqLen;
+    uint32_t wordsPerSeq;
+    uint32_t motifLen;
+    uint64_t motif;             // Packed motif, or zero if longer than MAX_PACKED_KMER.
+};
+
+static_assert(offsetof(PackedSeqFileHeader, motif) == 24, "Packed file header layout changed.");
+static_assert(sizeof(PackedSeqFileHeader) == 32, "Packed file header layout changed.");
+
+ResultCode GenerateSequenceSet(const SeqGenParams& params, SeqSet& seqSet);
+ResultCode GeneratePackedSequenceSet(const SeqGenParams& params, PackedSeqSet& seqSet);
+
+ResultCode WriteSequenceFile(
+    const SeqGenParams& params,
+    const char* path,
+    const SeqFileFormat format,
+    const uint32_t lineWidth = 80
+);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "motif.h"
+
+#include <string_view>
+
+/*
+ * Memory-mapped FASTA/FASTQ input. The file is mapped one window at a time and record boundaries
+ * in each window are indexed in parallel, so records are handed out as views into the mapping
+ * without copying. Windows always end on a record boundary; a record cut off by the end of a window
+ * starts the next one, and a window grows if a single record doesn't fit.
+ */
+
+enum SeqFileType
+{
+    SEQ_TYPE_UNKNOWN,
+    SEQ_TYPE_FASTA,
+    SEQ_TYPE_FASTQ
+};
+
+/*
+ * View of one record in the current window. seq (and qual for FASTQ) are raw spans of the file, so
+ * wrapped FASTA sequences still contain line breaks; use CopyBases/PackBases to get contiguous bases.
+ */
+
+struct SeqRecordView
+{
+    string_view name;
+    string_view seq;
+    string_view qual;
+};
+
+struct SeqFileReader
+{
+    HANDLE file;
+    HANDLE mapping;
+    const char* view;
+    uint64_t fileSize;
+    uint64_t fileOffset;
+    size_t windowBytes;
+    uint32_t granularity;
+    SeqFileType type;
+
+    // Per-chunk index scratch, reused across windows.
+
+    vector<vector<size_t>> chunkStarts;
+    vector<vector<SeqRecordView>> chunkRecords;
+    vector<size_t> chunkNext;
+    vector<uint8_t> chunkStatus;
+
+    SeqFileReader();
+    ~SeqFileReader();
+
+    ResultCode Open(const char* path, const size_t windowBytes = 256 << 20);
+    ResultCode NextWindow(vector<SeqRecordView>& records);
+    void Close();
+};
+
+size_t CountBases(const SeqRecordView& rec);
+size_t CopyBases(const SeqRecordView& rec, char* out);
+size_t PackBases(const SeqRecordView& rec, uint64_t* words);
+
+ResultCode LoadSequenceFile(const char* path, vector<string>& seqs, vector<string>* names = nullptr);
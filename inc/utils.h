@@ -1,3 +1,91 @@
 #pragma once
 
-long long GetMilliseconds();
\ No newline at end of file
+long long GetMilliseconds();
+long long GetNanoseconds();
+uint32_t GetWorkerCount();
+bool HasAvx2();
+
+std::string GetTempFilePath(const char* name);
+bool ReadFileToString(const std::string& path, std::string& contents);
+bool WriteStringToFile(const std::string& path, const std::string& contents);
+bool WriteAll(HANDLE file, const char* data, size_t len);
+
+/**
+ * Rng - Small xorshift64* generator. Parallel searches give each worker thread its own
+ * instance so they don't serialize on the shared rand() state.
+ */
+
+struct Rng
+{
+    uint64_t state;
+
+    /**
+     * Rng - Seed through a splitmix64 step so adjacent seeds (seed, seed + 1, ...) give
+     * unrelated streams.
+     */
+
+    Rng(uint64_t seed)
+    {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        state = z ^ (z >> 31);
+
+        if (state == 0) state = 0x2545F4914F6CDD1DULL;
+    }
+
+    uint64_t Next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    /**
+     * NextBounded - Uniform value in [0, bound) using a multiply-shift instead of a modulo.
+     */
+
+    uint32_t NextBounded(uint32_t bound) { return (uint32_t)(((Next() >> 32) * bound) >> 32); }
+
+    /**
+     * NextFloat - Uniform value in [0, 1).
+     */
+
+    float NextFloat() { return (float)(Next() >> 40) * (1.0f / 16777216.0f); }
+};
+
+/**
+ * ParallelFor - Split [0, count) into contiguous chunks, one per worker thread, and run
+ * fn(begin, end, threadIdx) on each. Runs inline when only one worker is available.
+ *
+ * @param count [in] Number of work items.
+ * @param fn    [in] Chunk routine.
+ */
+
+template<typename Fn>
+void ParallelFor(const uint32_t count, Fn fn)
+{
+    uint32_t numThreads = GetWorkerCount();
+    if (numThreads > count) numThreads = count;
+
+    if (numThreads <= 1)
+    {
+        if (count > 0) fn(0u, count, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    const uint32_t chunk = (count + numThreads - 1) / numThreads;
+
+    for (uint32_t t = 0; t < numThreads; t++)
+    {
+        uint32_t begin  = t * chunk;
+        uint32_t end    = begin + chunk > count ? count : begin + chunk;
+        if (begin >= end) break;
+
+        workers.push_back(std::thread(fn, begin, end, t));
+    }
+
+    for (auto& worker : workers) worker.join();
+}
@@ -0,0 +1,116 @@
+#include "problems.h"
+#include "arena.h"
+
+#include <malloc.h>
+#include <new>
+
+/**
+ * GetThreadArena - The calling thread's scratch arena, created on first use.
+ */
+
+ScratchArena& GetThreadArena()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+/*
+ * Counters behind the operator new and delete replacements below. Sizes come from the CRT's block
+ * size query on both allocation and release, so live bytes balance exactly. They are constant
+ * initialized, so allocations made during static initialization are counted too.
+ */
+
+static atomic<uint64_t> allocCount(0);
+static atomic<uint64_t> allocBytes(0);
+static atomic<int64_t> liveBytes(0);
+static atomic<int64_t> peakLiveBytes(0);
+static atomic<int64_t> baseLiveBytes(0);
+
+static inline void RecordAlloc(const size_t size)
+{
+    allocCount.fetch_add(1, memory_order_relaxed);
+    allocBytes.fetch_add(size, memory_order_relaxed);
+
+    const int64_t live  = liveBytes.fetch_add((int64_t)size, memory_order_relaxed) + (int64_t)size;
+    int64_t peak        = peakLiveBytes.load(memory_order_relaxed);
+
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+}
+
+static inline void RecordFree(const size_t size)
+{
+    liveBytes.fetch_sub((int64_t)size, memory_order_relaxed);
+}
+
+/**
+ * ResetAllocStats - Zero the allocation counts and restart peak tracking from the bytes live now.
+ */
+
+void ResetAllocStats()
+{
+    const int64_t live = liveBytes.load(memory_order_relaxed);
+
+    allocCount      = 0;
+    allocBytes      = 0;
+    baseLiveBytes   = live;
+    peakLiveBytes   = live;
+}
+
+/**
+ * GetAllocStats - Allocations and bytes since the last reset, and the most bytes live at once above
+ * those live at the reset.
+ */
+
+AllocStats GetAllocStats()
+{
+    const int64_t peak = peakLiveBytes.load(memory_order_relaxed) - baseLiveBytes.load(memory_order_relaxed);
+    return { allocCount.load(memory_order_relaxed), allocBytes.load(memory_order_relaxed), peak > 0 ? (uint64_t)peak : 0 };
+}
+
+static void* CountedNew(const size_t size)
+{
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr) throw bad_alloc();
+
+    RecordAlloc(_msize(p));
+    return p;
+}
+
+static void CountedDelete(void* p)
+{
+    if (p == nullptr) return;
+
+    RecordFree(_msize(p));
+    free(p);
+}
+
+static void* CountedAlignedNew(const size_t size, const align_val_t align)
+{
+    void* p = _aligned_malloc(size ? size : 1, (size_t)align);
+    if (p == nullptr) throw bad_alloc();
+
+    RecordAlloc(_aligned_msize(p, (size_t)align, 0));
+    return p;
+}
+
+static void CountedAlignedDelete(void* p, const align_val_t align)
+{
+    if (p == nullptr) return;
+
+    RecordFree(_aligned_msize(p, (size_t)align, 0));
+    _aligned_free(p);
+}
+
+void* operator new(size_t size) { return CountedNew(size); }
+void* operator new[](size_t size) { return CountedNew(size); }
+void operator delete(void* p) noexcept { CountedDelete(p); }
+void operator delete[](void* p) noexcept { CountedDelete(p); }
+void operator delete(void* p, size_t) noexcept { CountedDelete(p); }
+void operator delete[](void* p, size_t) noexcept { CountedDelete(p); }
+
+void* operator new(size_t size, align_val_t align) { return CountedAlignedNew(size, align); }
+void* operator new[](size_t size, align_val_t align) { return CountedAlignedNew(size, align); }
+void operator delete(void* p, align_val_t align) noexcept { CountedAlignedDelete(p, align); }
+void operator delete[](void* p, align_val_t align) noexcept { CountedAlignedDelete(p, align); }
+void operator delete(void* p, size_t, align_val_t align) noexcept { CountedAlignedDelete(p, align); }
+void operator delete[](void* p, size_t, align_val_t align) noexcept { CountedAlignedDelete(p, align); }
@@ -0,0 +1,799 @@
+#include "problems.h"
+#include "batch.h"
+#include "minmax.h"
+#include "restmap.h"
+#include "reversal.h"
+#include "motif.h"
+#include "resultcache.h"
+
+static const char* batchProblemNames[BATCH_PROBLEM_COUNT] = { "minmax", "restmap", "reversal", "motif" };
+
+/*
+ * One parsed instance on its way from the reader to a solver. Only the fields of the batch's problem
+ * type are used: values for lists, distances and permutations, k and seqs for motifs.
+ */
+
+struct BatchInstance
+{
+    uint64_t index;
+    ResultCode parseResult;
+    vector<uint32_t> values;
+    uint32_t k;
+    vector<string> seqs;
+};
+
+/*
+ * One solved instance's output line (without the newline) on its way to the writer.
+ */
+
+struct BatchOutput
+{
+    uint64_t index;
+    bool failed;
+    string text;
+};
+
+typedef ResultCode (*pfnBatchParse)(const string& line, BatchInstance& inst);
+typedef ResultCode (*pfnBatchSolve)(BatchInstance& inst, string& out);
+
+/**
+ * ParseBatchProblem - Look up a batch problem type by its command line name.
+ *
+ * @return false if the name is unknown.
+ */
+
+bool ParseBatchProblem(const char* name, BatchProblem& problem)
+{
+    for (uint32_t i = 0; i < BATCH_PROBLEM_COUNT; i++)
+    {
+        if (strcmp(name, batchProblemNames[i]) == 0)
+        {
+            problem = (BatchProblem)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* GetBatchProblemName(const BatchProblem problem)
+{
+    return problem < BATCH_PROBLEM_COUNT ? batchProblemNames[problem] : "unknown";
+}
+
+static const char* GetResultCodeName(const ResultCode res)
+{
+    switch (res)
+    {
+    case OK:                        return "OK";
+    case INVALID_INPUT:             return "INVALID_INPUT";
+    case UNABLE_TO_FIND_SOLUTION:   return "UNABLE_TO_FIND_SOLUTION";
+    case IO_ERROR:                  return "IO_ERROR";
+    default:                        return "UNKNOWN";
+    }
+}
+
+/*
+ * Buffered line reader over a Win32 file handle. Lines may be longer than the buffer; a trailing '\r'
+ * is dropped so CRLF files read the same as LF ones.
+ */
+
+struct BatchLineReader
+{
+    HANDLE file;
+    vector<char> buffer;
+    size_t pos;
+    size_t len;
+    bool atEof;
+    bool readError;
+
+    BatchLineReader() : file(INVALID_HANDLE_VALUE), pos(0), len(0), atEof(true), readError(false) {}
+    ~BatchLineReader() { if (file != INVALID_HANDLE_VALUE) CloseHandle(file); }
+
+    ResultCode Open(const char* path, const size_t bufferBytes)
+    {
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+        buffer.resize(max(bufferBytes, (size_t)64));
+        atEof = false;
+
+        return OK;
+    }
+
+    bool Refill()
+    {
+        if (atEof) return false;
+
+        DWORD bytesRead = 0;
+        const bool readOk = ReadFile(file, buffer.data(), (DWORD)buffer.size(), &bytesRead, NULL) != FALSE;
+
+        if (!readOk || bytesRead == 0)
+        {
+            readError   = !readOk;
+            atEof       = true;
+            return false;
+        }
+
+        pos = 0;
+        len = bytesRead;
+
+        return true;
+    }
+
+    /**
+     * Next - Read the next line into line, reusing its allocation.
+     *
+     * @return false once the file is exhausted.
+     */
+
+    bool Next(string& line)
+    {
+        line.clear();
+
+        if (pos == len && !Refill()) return false;
+
+        while (true)
+        {
+            const char* start   = buffer.data() + pos;
+            const char* newline = (const char*)memchr(start, '\n', len - pos);
+
+            if (newline != nullptr)
+            {
+                line.append(start, newline - start);
+                pos += newline - start + 1;
+                break;
+            }
+
+            line.append(start, len - pos);
+            pos = len;
+
+            if (!Refill()) break;
+        }
+
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    }
+};
+
+static inline bool IsBatchSpace(const char c) { return c == ' ' || c == '\t'; }
+
+static bool IsSkippedLine(const string& line)
+{
+    for (auto c : line)
+        if (!IsBatchSpace(c)) return c == '#';
+
+    return true;
+}
+
+/**
+ * NextToken - Find the next whitespace separated token at or after pos.
+ *
+ * @return false if there are no more tokens.
+ */
+
+static bool NextToken(const string& line, size_t& pos, size_t& begin, size_t& end)
+{
+    while (pos < line.size() && IsBatchSpace(line[pos])) pos++;
+    if (pos == line.size()) return false;
+
+    begin = pos;
+    while (pos < line.size() && !IsBatchSpace(line[pos])) pos++;
+    end = pos;
+
+    return true;
+}
+
+static bool ParseUint(const string& line, const size_t begin, const size_t end, uint32_t& val)
+{
+    uint64_t acc = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        if (line[i] < '0' || line[i] > '9') return false;
+
+        acc = acc * 10 + (line[i] - '0');
+        if (acc > UINT32_MAX) return false;
+    }
+
+    val = (uint32_t)acc;
+    return end > begin;
+}
+
+static ResultCode ParseValues(const string& line, BatchInstance& inst)
+{
+    size_t pos = 0, begin, end;
+    uint32_t val;
+
+    while (NextToken(line, pos, begin, end))
+    {
+        if (!ParseUint(line, begin, end, val)) return INVALID_INPUT;
+        inst.values.push_back(val);
+    }
+
+    return inst.values.empty() ? INVALID_INPUT : OK;
+}
+
+static ResultCode ParseMotif(const string& line, BatchInstance& inst)
+{
+    size_t pos = 0, begin, end;
+
+    if (!NextToken(line, pos, begin, end) || !ParseUint(line, begin, end, inst.k)) return INVALID_INPUT;
+
+    while (NextToken(line, pos, begin, end)) inst.seqs.emplace_back(line, begin, end - begin);
+
+    if (inst.seqs.empty() || inst.k == 0) return INVALID_INPUT;
+
+    for (auto& seq : inst.seqs)
+    {
+        if (seq.size() != inst.seqs[0].size() || seq.size() < inst.k) return INVALID_INPUT;
+
+        for (auto base : seq)
+            if (BaseToCode(base) == INVALID_BASE) return INVALID_INPUT;
+    }
+
+    return OK;
+}
+
+static void AppendUint(string& out, const uint32_t val)
+{
+    char digits[10];
+    uint32_t cnt    = 0;
+    uint32_t rest   = val;
+
+    do
+    {
+        digits[cnt++]   = (char)('0' + rest % 10);
+        rest            /= 10;
+    }
+    while (rest > 0);
+
+    while (cnt > 0) out += digits[--cnt];
+}
+
+static void AppendList(string& out, const vector<uint32_t>& vals)
+{
+    for (size_t i = 0; i < vals.size(); i++)
+    {
+        if (i > 0) out += ' ';
+        AppendUint(out, vals[i]);
+    }
+}
+
+static ResultCode SolveMinMax(BatchInstance& inst, string& out)
+{
+    uint32_t min, max;
+
+    ResultCode res = GetMinMax(inst.values, min, max);
+    if (res != OK) return res;
+
+    AppendUint(out, min);
+    out += ' ';
+    AppendUint(out, max);
+
+    return OK;
+}
+
+static ResultCode SolveRestMap(BatchInstance& inst, string& out)
+{
+    vector<uint32_t> points;
+    sort(inst.values.begin(), inst.values.end());
+
+    ResultCode res = CachedComputePDBacktracking(GetProcessResultCache(), inst.values, points);
+    if (res != OK) return res;
+
+    AppendList(out, points);
+    return OK;
+}
+
+static ResultCode SolveReversal(BatchInstance& inst, string& out)
+{
+    const uint32_t n = (uint32_t)inst.values.size();
+
+    vector<uint32_t> perm(n + 2);
+    vector<Reversal> reversals;
+
+    perm[0]     = 0;
+    perm[n + 1] = n + 1;
+    copy(inst.values.begin(), inst.values.end(), perm.begin() + 1);
+
+    if (!IsFramedPermutation(perm)) return INVALID_INPUT;
+
+    ResultCode res = BreakPointReversal(perm, reversals);
+    if (res != OK) return res;
+
+    AppendUint(out, (uint32_t)reversals.size());
+
+    for (auto& rev : reversals)
+    {
+        out += ' ';
+        AppendUint(out, rev.begin);
+        out += ',';
+        AppendUint(out, rev.end);
+    }
+
+    return OK;
+}
+
+static ResultCode SolveMotif(BatchInstance& inst, string& out)
+{
+    vector<uint32_t> offsets;
+
+    ResultCode res = CachedFindMotif(GetProcessResultCache(), inst.seqs, inst.k, offsets);
+    if (res != OK) return res;
+
+    AppendUint(out, GetConsensus(inst.seqs, (uint32_t)inst.seqs.size(), offsets, inst.k));
+    out += ' ';
+    AppendList(out, offsets);
+
+    return OK;
+}
+
+static const pfnBatchParse batchParsers[BATCH_PROBLEM_COUNT]    = { ParseValues, ParseValues, ParseValues, ParseMotif };
+static const pfnBatchSolve batchSolvers[BATCH_PROBLEM_COUNT]    = { SolveMinMax, SolveRestMap, SolveReversal, SolveMotif };
+
+/**
+ * SolveBatchInstance - Parse and solve a single instance line outside a batch run, for callers that
+ * receive instances one at a time.
+ *
+ * @param  problem  [in]        Problem type.
+ * @param  line     [in]        Instance in the problem type's batch format.
+ * @param  out      [in/out]    Output line, appended to.
+ *
+ * @return          INVALID_INPUT for an unknown type or a malformed instance, otherwise the solver's
+ *                  result.
+ */
+
+ResultCode SolveBatchInstance(const BatchProblem problem, const string& line, string& out)
+{
+    if (problem >= BATCH_PROBLEM_COUNT) return INVALID_INPUT;
+
+    BatchInstance inst;
+    inst.index  = 0;
+    inst.k      = 0;
+
+    ResultCode res = batchParsers[problem](line, inst);
+    return res == OK ? batchSolvers[problem](inst, out) : res;
+}
+
+/**
+ * ReadBatchInstances - Load every instance line of a batch input file into memory, skipping blank and
+ * comment lines. For small instance sets that get replayed, such as load generation.
+ *
+ * @param  path         [in]    Input file.
+ * @param  instances    [out]   Instance lines, appended to.
+ *
+ * @return              IO_ERROR if the file can't be read.
+ */
+
+ResultCode ReadBatchInstances(const char* path, vector<string>& instances)
+{
+    BatchLineReader reader;
+    if (reader.Open(path, 1 << 16) != OK) return IO_ERROR;
+
+    string line;
+    while (reader.Next(line))
+        if (!IsSkippedLine(line)) instances.push_back(line);
+
+    return reader.readError ? IO_ERROR : OK;
+}
+
+/**
+ * RunBatch - Solve every instance in an input file and write one output line per instance, in input
+ * order. Runs as a three stage pipeline:
+ *
+ *   reader     Reads and parses lines on its own thread.
+ *   solvers    A pool of threads solving parsed instances as they arrive.
+ *   writer     The calling thread, putting solved instances back in input order and writing them.
+ *
+ * The reader may only run maxInFlight instances ahead of the writer, which bounds the instances held
+ * in the queues, in the solvers and in the writer's reorder buffer together, so memory stays flat
+ * however large the file is. The reorder buffer is a ring of maxInFlight slots for that reason.
+ *
+ * @param  inPath   [in]    Instance file. See batch.h for the formats.
+ * @param  outPath  [in]    Output file, overwritten.
+ * @param  options  [in]    Problem type and pipeline sizes.
+ * @param  stats    [out]   Instance and failure counts, and the most instances in flight at once.
+ *
+ * @return          INVALID_INPUT for an unknown problem type. IO_ERROR if a file can't be opened, read or
+ *                  written. OK otherwise, even if some instances failed.
+ */
+
+ResultCode RunBatch(const char* inPath, const char* outPath, const BatchOptions& options, BatchStats& stats)
+{
+    stats = { 0, 0, 0 };
+
+    if (options.problem >= BATCH_PROBLEM_COUNT) return INVALID_INPUT;
+
+    BatchLineReader reader;
+    if (reader.Open(inPath, options.ioBufferBytes) != OK) return IO_ERROR;
+
+    HANDLE outFile = CreateFileA(outPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (outFile == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    const pfnBatchParse parse   = batchParsers[options.problem];
+    const pfnBatchSolve solve   = batchSolvers[options.problem];
+    const uint32_t numSolvers   = options.numSolvers ? options.numSolvers : GetWorkerCount();
+    const uint32_t window       = options.maxInFlight ? options.maxInFlight : 4 * numSolvers;
+
+    BoundedQueue<BatchInstance> work(window);
+    BoundedQueue<BatchOutput> done(window);
+
+    mutex windowLock;
+    condition_variable windowOpen;
+    uint64_t nextToWrite = 0;
+
+    thread readerThread([&]()
+    {
+        string line;
+        uint64_t index = 0;
+
+        while (reader.Next(line))
+        {
+            if (IsSkippedLine(line)) continue;
+
+            {
+                unique_lock<mutex> guard(windowLock);
+                windowOpen.wait(guard, [&] { return index < nextToWrite + window; });
+
+                stats.peakInFlight = max(stats.peakInFlight, (uint32_t)(index - nextToWrite + 1));
+            }
+
+            BatchInstance inst;
+            inst.index          = index++;
+            inst.k              = 0;
+            inst.parseResult    = parse(line, inst);
+
+            work.Push(move(inst));
+        }
+
+        work.Close();
+    });
+
+    atomic<uint32_t> solversLeft(numSolvers);
+    vector<thread> solvers;
+
+    for (uint32_t t = 0; t < numSolvers; t++)
+    {
+        solvers.push_back(thread([&]()
+        {
+            BatchInstance inst;
+
+            while (work.Pop(inst))
+            {
+                BatchOutput out;
+                out.index = inst.index;
+
+                ResultCode res = inst.parseResult == OK ? solve(inst, out.text) : inst.parseResult;
+                out.failed = res != OK;
+
+                if (out.failed) out.text = string("error ") + GetResultCodeName(res);
+
+                done.Push(move(out));
+            }
+
+            if (--solversLeft == 0) done.Close();
+        }));
+    }
+
+    vector<BatchOutput> pending(window);
+    vector<uint8_t> ready(window, 0);
+    string outBuf;
+    uint64_t next   = 0;
+    bool writeOk    = true;
+
+    BatchOutput out;
+
+    while (done.Pop(out))
+    {
+        const size_t slot   = out.index % window;
+        pending[slot]       = move(out);
+        ready[slot]         = 1;
+
+        const uint64_t first = next;
+
+        while (ready[next % window])
+        {
+            BatchOutput& cur = pending[next % window];
+
+            outBuf += cur.text;
+            outBuf += '\n';
+
+            stats.instances++;
+            if (cur.failed) stats.failed++;
+
+            ready[next % window] = 0;
+            next++;
+        }
+
+        if (next != first)
+        {
+            lock_guard<mutex> guard(windowLock);
+            nextToWrite = next;
+            windowOpen.notify_one();
+        }
+
+        if (outBuf.size() >= options.ioBufferBytes)
+        {
+            writeOk = writeOk && WriteAll(outFile, outBuf.data(), outBuf.size());
+            outBuf.clear();
+        }
+    }
+
+    readerThread.join();
+    for (auto& solver : solvers) solver.join();
+
+    writeOk = writeOk && WriteAll(outFile, outBuf.data(), outBuf.size());
+    CloseHandle(outFile);
+
+    return writeOk && !reader.readError ? OK : IO_ERROR;
+}
+
+static bool ReadLines(const string& path, vector<string>& lines)
+{
+    BatchLineReader reader;
+    if (reader.Open(path.c_str(), 1 << 16) != OK) return false;
+
+    string line;
+    while (reader.Next(line)) lines.push_back(line);
+
+    return !reader.readError;
+}
+
+static void Shuffle(uint32_t* vals, const uint32_t count)
+{
+    for (uint32_t i = count; i > 1; i--) swap(vals[i - 1], vals[rand() % i]);
+}
+
+static void SplitUints(const string& line, vector<uint32_t>& vals)
+{
+    size_t pos = 0, begin, end;
+    uint32_t val;
+
+    vals.clear();
+    while (NextToken(line, pos, begin, end) && ParseUint(line, begin, end, val)) vals.push_back(val);
+}
+
+/**
+ * RunBatchTest - Write input lines to a file, run a batch over it with more solvers than instances in
+ * the window allows to finish in order, and check every output line.
+ *
+ * @param  testResults  [in/out]    Result list to append to.
+ * @param  name         [in]        Test name.
+ * @param  problem      [in]        Batch problem type.
+ * @param  input        [in]        File contents.
+ * @param  expectLines  [in]        Number of instances in the input.
+ * @param  check        [in]        check(instance, output line) says whether the line is right.
+ */
+
+template<typename Check>
+static void RunBatchTest(
+    vector<TestResult>& testResults,
+    const string& name,
+    const BatchProblem problem,
+    const string& input,
+    const uint32_t expectLines,
+    Check check
+)
+{
+    const string inPath     = GetTempFilePath("batch_test_in.txt");
+    const string outPath    = GetTempFilePath("batch_test_out.txt");
+
+    BatchOptions options(problem);
+    options.numSolvers      = 4;
+    options.maxInFlight     = 8;
+    options.ioBufferBytes   = 1 << 12;
+
+    BatchStats stats;
+    vector<string> lines;
+
+    const bool written      = WriteStringToFile(inPath, input);
+    long long t1            = GetMilliseconds();
+    const ResultCode res    = written ? RunBatch(inPath.c_str(), outPath.c_str(), options, stats) : IO_ERROR;
+    long long t2            = GetMilliseconds();
+
+    if (res != OK || !ReadLines(outPath, lines))
+    {
+        testResults.push_back({ name, FAIL, "Batch run failed." });
+    }
+    else if (lines.size() != expectLines || stats.instances != expectLines)
+    {
+        testResults.push_back({ name, FAIL, "Expected " + to_string(expectLines) + " output lines, got " + to_string(lines.size()) + "." });
+    }
+    else if (stats.peakInFlight > options.maxInFlight)
+    {
+        testResults.push_back({ name, FAIL, "Reader ran " + to_string(stats.peakInFlight) + " instances ahead of the writer." });
+    }
+    else
+    {
+        uint32_t bad = 0;
+        for (uint32_t i = 0; i < expectLines && bad == 0; i++) bad = check(i, lines[i]) ? 0 : i + 1;
+
+        if (bad == 0) testResults.push_back({ name, PASS, to_string(expectLines) + " instances, T = " + to_string((float)(t2 - t1) / 1000.0f) + " sec." });
+        else testResults.push_back({ name, FAIL, "Wrong output for instance " + to_string(bad - 1) + ": " + lines[bad - 1] });
+    }
+
+    DeleteFileA(inPath.c_str());
+    DeleteFileA(outPath.c_str());
+}
+
+static void TestMinMaxBatch(vector<TestResult>& testResults, const uint32_t numInstances, const string& name)
+{
+    vector<pair<uint32_t, uint32_t>> expected;
+    string input = "# min max batch\n\n";
+
+    for (uint32_t i = 0; i < numInstances; i++)
+    {
+        const uint32_t len = 1 + rand() % 64;
+        uint32_t lo = ~0u, hi = 0;
+
+        for (uint32_t j = 0; j < len; j++)
+        {
+            const uint32_t val = (uint32_t)rand() * (uint32_t)rand();
+            lo = min(lo, val);
+            hi = max(hi, val);
+
+            input += to_string(val) + (j + 1 < len ? " " : "\r\n");
+        }
+
+        expected.push_back({ lo, hi });
+    }
+
+    input += "12 x 7\n";
+
+    RunBatchTest(testResults, name, BATCH_MINMAX, input, numInstances + 1, [&](uint32_t i, const string& line)
+    {
+        if (i == numInstances) return line == "error INVALID_INPUT";
+        return line == to_string(expected[i].first) + " " + to_string(expected[i].second);
+    });
+}
+
+static void TestRestMapBatch(vector<TestResult>& testResults)
+{
+    const uint32_t numInstances = 60;
+
+    vector<vector<uint32_t>> expected;
+    string input;
+
+    for (uint32_t i = 0; i < numInstances; i++)
+    {
+        set<uint32_t> pointSet = { 0 };
+        const uint32_t size = 2 + rand() % 24;
+
+        while (pointSet.size() < size) pointSet.insert(rand() % 10000);
+
+        vector<uint32_t> points(pointSet.begin(), pointSet.end());
+        vector<uint32_t> dist;
+        GetPairwiseDistances(points, dist);
+
+        Shuffle(dist.data(), (uint32_t)dist.size());
+
+        for (size_t j = 0; j < dist.size(); j++) input += to_string(dist[j]) + (j + 1 < dist.size() ? " " : "\n");
+        expected.push_back(points);
+    }
+
+    input += "3 5\n";
+
+    RunBatchTest(testResults, "Batch::RestrictionMapping", BATCH_RESTMAP, input, numInstances + 1, [&](uint32_t i, const string& line)
+    {
+        if (i == numInstances) return line == "error INVALID_INPUT";
+
+        // A solution may come back reflected; both have the same distances.
+
+        vector<uint32_t> points, dist;
+        SplitUints(line, points);
+        GetPairwiseDistances(points, dist);
+
+        vector<uint32_t> expectDist;
+        GetPairwiseDistances(expected[i], expectDist);
+
+        return dist == expectDist;
+    });
+}
+
+static void TestReversalBatch(vector<TestResult>& testResults)
+{
+    const uint32_t numInstances = 200;
+
+    vector<vector<uint32_t>> perms;
+    string input;
+
+    for (uint32_t i = 0; i < numInstances; i++)
+    {
+        const uint32_t n = 1 + rand() % 300;
+        vector<uint32_t> perm(n + 2);
+
+        for (uint32_t j = 0; j < n + 2; j++) perm[j] = j;
+        Shuffle(&perm[1], n);
+
+        for (uint32_t j = 1; j <= n; j++) input += to_string(perm[j]) + (j < n ? " " : "\n");
+        perms.push_back(perm);
+    }
+
+    input += "1 2 2\n";
+
+    RunBatchTest(testResults, "Batch::ReversalSorting", BATCH_REVERSAL, input, numInstances + 1, [&](uint32_t i, const string& line)
+    {
+        if (i == numInstances) return line == "error INVALID_INPUT";
+
+        // Apply the reported reversals and check they sort the permutation.
+
+        vector<Reversal> reversals;
+        size_t pos = 0, begin, end;
+        uint32_t count;
+
+        if (!NextToken(line, pos, begin, end) || !ParseUint(line, begin, end, count)) return false;
+
+        while (NextToken(line, pos, begin, end))
+        {
+            const size_t comma = line.find(',', begin);
+            Reversal rev;
+
+            if (comma >= end || !ParseUint(line, begin, comma, rev.begin) || !ParseUint(line, comma + 1, end, rev.end)) return false;
+            reversals.push_back(rev);
+        }
+
+        vector<uint32_t> perm = perms[i];
+        ApplyReversals(perm, reversals);
+
+        return reversals.size() == count && CountBreakpoints(perm) == 0;
+    });
+}
+
+static void TestMotifBatch(vector<TestResult>& testResults)
+{
+    const uint32_t numInstances = 24;
+    const uint32_t nSeq         = 5;
+    const uint32_t seqLen       = 14;
+    const uint32_t motifLen     = 4;
+
+    vector<vector<string>> instances;
+    string input;
+
+    for (uint32_t i = 0; i < numInstances; i++)
+    {
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> offsets;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, offsets);
+
+        input += to_string(motifLen);
+        for (auto& seq : seqs) input += "\t" + seq;
+        input += "\n";
+
+        instances.push_back(seqs);
+    }
+
+    input += "3 ACGT ACG\n";
+
+    RunBatchTest(testResults, "Batch::MotifFinding", BATCH_MOTIF, input, numInstances + 1, [&](uint32_t i, const string& line)
+    {
+        if (i == numInstances) return line == "error INVALID_INPUT";
+
+        vector<uint32_t> vals;
+        SplitUints(line, vals);
+
+        if (vals.size() != nSeq + 1 || vals[0] != nSeq * motifLen) return false;
+
+        vector<uint32_t> offsets(vals.begin() + 1, vals.end());
+        return GetConsensus(instances[i], nSeq, offsets, motifLen) == vals[0];
+    });
+}
+
+/**
+ * BatchMode - Tests for batch mode. Runs each problem type's format through the pipeline with more
+ * solvers than cores and a small window so instances finish out of order, including a malformed
+ * instance at the end, then a larger min/max file to check the reader stays within the window.
+ *
+ * @param testResults Result list to append results to.
+ */
+
+void BatchMode(vector<TestResult>& testResults)
+{
+    TestMinMaxBatch(testResults, 500, "Batch::MinMax");
+    TestRestMapBatch(testResults);
+    TestReversalBatch(testResults);
+    TestMotifBatch(testResults);
+    TestMinMaxBatch(testResults, 50000, "Batch::LargeFile");
+}
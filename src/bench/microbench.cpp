@@ -0,0 +1,540 @@
+#include "commoninc.h"
+#include "utils.h"
+#include "minmax.h"
+#include "restmap.h"
+#include "motif.h"
+#include "reversal.h"
+#include "professors.h"
+
+#include <cmath>
+#include <functional>
+#include <memory>
+
+using namespace std;
+
+/*
+ * Kernel microbenchmarks, built as their own executable (Microbenchmarks.vcxproj) so timing runs don't
+ * drag in the self-tests. Every kernel runs in isolation at a few input sizes. A case is timed as a
+ * number of samples, each long enough to swamp timer resolution, and reported by its median time per
+ * operation with the median absolute deviation as the noise estimate, so one preempted sample doesn't
+ * move the result.
+ *
+ * Usage: Microbenchmarks [options]
+ *   --filter <text>       Only run cases whose name contains text.
+ *   --samples <n>         Samples per case. Defaults to BENCH_DEFAULT_SAMPLES.
+ *   --min-sample-ms <ms>  Minimum duration of one sample. Defaults to BENCH_DEFAULT_MIN_SAMPLE_MS.
+ *   --json <path>         Write results as JSON.
+ *   --compare <path>      Compare against a baseline JSON file; exit code 1 if any case regressed.
+ *   --threshold <pct>     Slowdown that counts as a regression. Defaults to BENCH_DEFAULT_THRESHOLD.
+ *   --input <path>        Compare results from a JSON file instead of running the benchmarks.
+ *
+ * The checked-in baseline is src/bench/baseline.json. Refresh it with --json on the reference machine
+ * whenever a change is meant to move the numbers.
+ */
+
+const uint32_t BENCH_DEFAULT_SAMPLES        = 15;
+const uint32_t BENCH_DEFAULT_MIN_SAMPLE_MS  = 20;
+const double BENCH_DEFAULT_THRESHOLD        = 10.0;
+const uint32_t BENCH_MAX_CALIBRATION_ROUNDS = 40;
+
+/*
+ * Kernel results are folded into this so the optimizer can't discard the work being timed.
+ */
+
+static volatile uint64_t benchSink;
+
+/*
+ * One kernel at one size. op runs a single operation over items input elements and returns a value
+ * for the sink. Setup state is owned by op's captures.
+ */
+
+struct BenchCase
+{
+    string kernel;
+    uint32_t size;
+    uint64_t items;
+    function<uint64_t()> op;
+
+    string Name() const { return kernel + "/" + to_string(size); }
+};
+
+struct BenchDef
+{
+    const char* kernel;
+    vector<uint32_t> sizes;
+    BenchCase (*setup)(const uint32_t size);
+};
+
+struct BenchResult
+{
+    string name;
+    string kernel;
+    uint32_t size;
+    uint64_t items;
+    uint64_t opsPerSample;
+    uint32_t samples;
+    double medianNs;            // Per operation.
+    double madNs;
+    double minNs;
+    double meanNs;
+    double itemsPerSec;
+};
+
+struct BenchOptions
+{
+    string filter;
+    uint32_t samples;
+    uint32_t minSampleMs;
+    string jsonPath;
+    string comparePath;
+    string inputPath;
+    double threshold;
+
+    BenchOptions() : samples(BENCH_DEFAULT_SAMPLES), minSampleMs(BENCH_DEFAULT_MIN_SAMPLE_MS), threshold(BENCH_DEFAULT_THRESHOLD) {}
+};
+
+static BenchCase SetupMinMax(const uint32_t size)
+{
+    auto list = make_shared<vector<uint32_t>>(size);
+    Rng rng(size);
+
+    for (auto& val : *list) val = (uint32_t)rng.Next();
+
+    return { "GetMinMax", size, size, [list]()
+    {
+        uint32_t min, max;
+        GetMinMax(*list, min, max);
+        return (uint64_t)min + max;
+    } };
+}
+
+static BenchCase SetupPairwiseDistances(const uint32_t size)
+{
+    auto points     = make_shared<vector<uint32_t>>();
+    auto distances  = make_shared<vector<uint32_t>>();
+    Rng rng(size);
+
+    set<uint32_t> pointSet = { 0 };
+    while (pointSet.size() < size) pointSet.insert(rng.NextBounded(1000000));
+
+    points->assign(pointSet.begin(), pointSet.end());
+
+    return { "GetPairwiseDistances", size, (uint64_t)size * (size - 1) / 2, [points, distances]()
+    {
+        distances->clear();
+        GetPairwiseDistances(*points, *distances);
+        return (uint64_t)distances->back();
+    } };
+}
+
+/*
+ * GetConsensus cases are sized by motif length: the lengths up to 32 run the specialized kernels, the
+ * largest the runtime length path. Each operation scores the next of a fixed set of random offset
+ * vectors.
+ */
+
+static BenchCase SetupConsensus(const uint32_t size)
+{
+    const uint32_t nSeq         = 32;
+    const uint32_t seqLen       = 512;
+    const uint32_t numOffsets   = 64;
+
+    auto seqs       = make_shared<vector<string>>();
+    auto offsets    = make_shared<vector<vector<uint32_t>>>(numOffsets, vector<uint32_t>(nSeq));
+    auto next       = make_shared<uint32_t>(0);
+    Rng rng(size);
+
+    string motif;
+    vector<uint32_t> planted;
+    GenerateMotifSequences(nSeq, seqLen, size, *seqs, motif, planted);
+
+    for (auto& offs : *offsets)
+        for (auto& off : offs) off = rng.NextBounded(seqLen - size + 1);
+
+    return { "GetConsensus", size, (uint64_t)nSeq * size, [=]()
+    {
+        const vector<uint32_t>& offs = (*offsets)[(*next)++ % numOffsets];
+        return (uint64_t)GetConsensus(*seqs, nSeq, offs, size);
+    } };
+}
+
+/*
+ * GetStrips runs on an identity permutation scrambled by short random reversals, which leaves a mix of
+ * long increasing and decreasing strips and singletons rather than the all-singleton shape of a
+ * uniformly random permutation.
+ */
+
+static BenchCase SetupStrips(const uint32_t size)
+{
+    const uint32_t maxReversalLen = 64;
+
+    auto perm   = make_shared<vector<uint32_t>>(size + 2);
+    auto strips = make_shared<vector<Strip>>();
+    Rng rng(size);
+
+    for (uint32_t i = 0; i < size + 2; i++) (*perm)[i] = i;
+
+    for (uint32_t i = 0; i < size / 8; i++)
+    {
+        const uint32_t begin    = 1 + rng.NextBounded(size);
+        const uint32_t end      = min(size, begin + rng.NextBounded(maxReversalLen));
+        reverse(perm->begin() + begin, perm->begin() + end + 1);
+    }
+
+    return { "GetStrips", size, (uint64_t)size + 2, [perm, strips]()
+    {
+        strips->clear();
+        GetStrips(*perm, *strips);
+        return (uint64_t)strips->size();
+    } };
+}
+
+/*
+ * QueryHonesty cases are sized by queries per operation, over a fixed list of random professor pairs.
+ */
+
+static BenchCase SetupQueryHonesty(const uint32_t size)
+{
+    auto profs      = make_shared<Professors>();
+    auto queries    = make_shared<vector<pair<uint8_t, uint8_t>>>(size);
+    Rng rng(size);
+
+    for (auto& query : *queries) query = { (uint8_t)rng.NextBounded(PROFCNT), (uint8_t)rng.NextBounded(PROFCNT) };
+
+    return { "QueryHonesty", size, size, [profs, queries]()
+    {
+        uint64_t honestCnt = 0;
+        for (auto& query : *queries) honestCnt += profs->QueryHonesty(query.first, query.second);
+        return honestCnt;
+    } };
+}
+
+static const BenchDef benchmarks[] =
+{
+    { "GetMinMax",              { 1 << 10, 1 << 16, 1 << 20 },  SetupMinMax },
+    { "GetPairwiseDistances",   { 16, 64, 256 },                SetupPairwiseDistances },
+    { "GetConsensus",           { 8, 16, 32, 40 },              SetupConsensus },
+    { "GetStrips",              { 1 << 10, 1 << 16, 1 << 20 },  SetupStrips },
+    { "QueryHonesty",           { 1 << 12, 1 << 16 },           SetupQueryHonesty },
+};
+
+/**
+ * TimeOps - Run an operation count times back to back.
+ *
+ * @return Elapsed nanoseconds.
+ */
+
+static long long TimeOps(const BenchCase& bench, const uint64_t count)
+{
+    uint64_t acc = 0;
+
+    long long t1 = GetNanoseconds();
+    for (uint64_t i = 0; i < count; i++) acc += bench.op();
+    long long t2 = GetNanoseconds();
+
+    benchSink = benchSink + acc;
+    return t2 - t1;
+}
+
+static double Median(vector<double> vals)
+{
+    sort(vals.begin(), vals.end());
+    const size_t mid = vals.size() / 2;
+    return vals.size() % 2 ? vals[mid] : (vals[mid - 1] + vals[mid]) / 2.0;
+}
+
+/**
+ * RunBenchCase - Time one case. Grows the operations per sample until a sample takes at least the
+ * minimum sample time, which doubles as warm-up, then collects the samples.
+ *
+ * @param  bench    [in]    Case to run.
+ * @param  options  [in]    Sample count and minimum sample time.
+ *
+ * @return          Per-operation statistics.
+ */
+
+static BenchResult RunBenchCase(const BenchCase& bench, const BenchOptions& options)
+{
+    const long long minSampleNs = (long long)options.minSampleMs * 1000000LL;
+    uint64_t ops                = 1;
+
+    for (uint32_t round = 0; round < BENCH_MAX_CALIBRATION_ROUNDS; round++)
+    {
+        const long long ns = TimeOps(bench, ops);
+        if (ns >= minSampleNs) break;
+
+        // Aim a little past the target so the next round usually lands; never grow more than 10x.
+
+        const double scale = ns > 0 ? min(10.0, 1.2 * (double)minSampleNs / (double)ns) : 10.0;
+        ops = max(ops + 1, (uint64_t)((double)ops * scale));
+    }
+
+    vector<double> perOp(options.samples);
+    for (auto& sample : perOp) sample = (double)TimeOps(bench, ops) / (double)ops;
+
+    BenchResult result;
+
+    result.name         = bench.Name();
+    result.kernel       = bench.kernel;
+    result.size         = bench.size;
+    result.items        = bench.items;
+    result.opsPerSample = ops;
+    result.samples      = options.samples;
+    result.medianNs     = Median(perOp);
+    result.minNs        = *min_element(perOp.begin(), perOp.end());
+    result.meanNs       = 0;
+
+    vector<double> deviations(perOp.size());
+
+    for (size_t i = 0; i < perOp.size(); i++)
+    {
+        result.meanNs   += perOp[i] / perOp.size();
+        deviations[i]   = fabs(perOp[i] - result.medianNs);
+    }
+
+    result.madNs        = Median(deviations);
+    result.itemsPerSec  = result.medianNs > 0 ? (double)bench.items * 1e9 / result.medianNs : 0;
+
+    return result;
+}
+
+/**
+ * WriteBenchFile - Write results as a JSON document with run settings and one object per case.
+ *
+ * @return IO_ERROR if the file can't be written, OK otherwise.
+ */
+
+static ResultCode WriteBenchFile(const string& path, const vector<BenchResult>& results, const BenchOptions& options)
+{
+    string json = "{\n";
+    char line[512];
+
+    snprintf(line, sizeof(line), "  \"samples\": %u,\n  \"minSampleMs\": %u,\n  \"benchmarks\": [\n", options.samples, options.minSampleMs);
+    json += line;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& res = results[i];
+
+        snprintf(
+            line,
+            sizeof(line),
+            "    { \"name\": \"%s\", \"kernel\": \"%s\", \"size\": %u, \"items\": %llu, \"opsPerSample\": %llu, "
+            "\"medianNs\": %.3f, \"madNs\": %.3f, \"minNs\": %.3f, \"meanNs\": %.3f, \"itemsPerSec\": %.1f }%s\n",
+            res.name.c_str(),
+            res.kernel.c_str(),
+            res.size,
+            (unsigned long long)res.items,
+            (unsigned long long)res.opsPerSample,
+            res.medianNs,
+            res.madNs,
+            res.minNs,
+            res.meanNs,
+            res.itemsPerSec,
+            i + 1 < results.size() ? "," : ""
+        );
+
+        json += line;
+    }
+
+    json += "  ]\n}\n";
+
+    return WriteStringToFile(path, json) ? OK : IO_ERROR;
+}
+
+/**
+ * ReadBenchFile - Read the case names and median times back from a file WriteBenchFile wrote. This is
+ * not a general JSON parser; it relies on every case object carrying "name" before "medianNs".
+ *
+ * @param  path     [in]        JSON results file.
+ * @param  medians  [in/out]    Case name and median nanoseconds per operation, in file order.
+ *
+ * @return          IO_ERROR if the file can't be read, INVALID_INPUT if a case has no median. OK otherwise.
+ */
+
+static ResultCode ReadBenchFile(const string& path, vector<pair<string, double>>& medians)
+{
+    string text;
+    if (!ReadFileToString(path, text)) return IO_ERROR;
+
+    const string nameKey    = "\"name\"";
+    const string medianKey  = "\"medianNs\"";
+    size_t pos              = text.find(nameKey);
+
+    while (pos != string::npos)
+    {
+        const size_t colon  = text.find(':', pos + nameKey.size());
+        const size_t open   = colon == string::npos ? string::npos : text.find('"', colon);
+        const size_t close  = open == string::npos ? string::npos : text.find('"', open + 1);
+        if (close == string::npos) return INVALID_INPUT;
+
+        const size_t next   = text.find(nameKey, close);
+        const size_t median = text.find(medianKey, close);
+        if (median == string::npos || median > next) return INVALID_INPUT;
+
+        const size_t valPos = text.find(':', median + medianKey.size());
+        if (valPos == string::npos) return INVALID_INPUT;
+
+        medians.push_back({ text.substr(open + 1, close - open - 1), strtod(text.c_str() + valPos + 1, nullptr) });
+        pos = next;
+    }
+
+    return OK;
+}
+
+/**
+ * CompareToBaseline - Print each case's change against the baseline and flag those slower by more
+ * than the threshold. Cases the baseline doesn't have are listed as new; baseline cases that weren't
+ * run are ignored so filtered runs can be compared too.
+ *
+ * @return Number of regressions.
+ */
+
+static uint32_t CompareToBaseline(
+    const vector<pair<string, double>>& current,
+    const vector<pair<string, double>>& baseline,
+    const double threshold
+)
+{
+    map<string, double> baseMedians(baseline.begin(), baseline.end());
+    uint32_t regressions = 0;
+
+    printf("\n%-32s %14s %14s %9s\n", "Benchmark", "base ns/op", "ns/op", "change");
+
+    for (auto& cur : current)
+    {
+        auto it = baseMedians.find(cur.first);
+
+        if (it == baseMedians.end())
+        {
+            printf("%-32s %14s %14.1f %9s  new\n", cur.first.c_str(), "-", cur.second, "-");
+            continue;
+        }
+
+        const double change     = it->second > 0 ? (cur.second / it->second - 1.0) * 100.0 : 0;
+        const bool regressed    = change > threshold;
+
+        printf("%-32s %14.1f %14.1f %+8.1f%%%s\n", cur.first.c_str(), it->second, cur.second, change, regressed ? "  REGRESSION" : "");
+        if (regressed) regressions++;
+    }
+
+    printf("\n%u regression(s) beyond %.1f%%.\n", regressions, threshold);
+    return regressions;
+}
+
+static void PrintUsage()
+{
+    printf(
+        "Usage: Microbenchmarks [--filter <text>] [--samples <n>] [--min-sample-ms <ms>] [--json <path>]\n"
+        "                       [--compare <baseline.json> [--threshold <pct>] [--input <results.json>]]\n\n"
+        "Kernels:"
+    );
+
+    for (auto& def : benchmarks) printf(" %s", def.kernel);
+    printf("\n");
+}
+
+static bool ParseArgs(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const string arg    = argv[i];
+        const char* val     = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (val == nullptr) return false;
+
+        if (arg == "--filter") options.filter = val;
+        else if (arg == "--samples") options.samples = (uint32_t)strtoul(val, nullptr, 10);
+        else if (arg == "--min-sample-ms") options.minSampleMs = (uint32_t)strtoul(val, nullptr, 10);
+        else if (arg == "--json") options.jsonPath = val;
+        else if (arg == "--compare") options.comparePath = val;
+        else if (arg == "--threshold") options.threshold = strtod(val, nullptr);
+        else if (arg == "--input") options.inputPath = val;
+        else return false;
+
+        i++;
+    }
+
+    if (options.samples == 0) return false;
+    if (!options.inputPath.empty() && options.comparePath.empty()) return false;
+
+    return true;
+}
+
+/**
+ * main - Run the benchmarks, or load earlier results, then optionally save them and compare them to a
+ * baseline.
+ *
+ * @return Zero on success, one if the comparison found regressions, two on bad arguments or I/O errors.
+ */
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    vector<pair<string, double>> current;
+
+    if (options.inputPath.empty())
+    {
+        vector<BenchResult> results;
+
+        printf("%-32s %14s %8s %14s %16s\n", "Benchmark", "median ns/op", "MAD %", "min ns/op", "items/sec");
+
+        for (auto& def : benchmarks)
+        {
+            for (auto size : def.sizes)
+            {
+                const string name = string(def.kernel) + "/" + to_string(size);
+                if (!options.filter.empty() && name.find(options.filter) == string::npos) continue;
+
+                // Same inputs every run, including the ones built with rand().
+
+                srand(size);
+
+                const BenchCase bench   = def.setup(size);
+                const BenchResult res   = RunBenchCase(bench, options);
+
+                printf(
+                    "%-32s %14.1f %7.2f%% %14.1f %16.4g\n",
+                    res.name.c_str(),
+                    res.medianNs,
+                    res.medianNs > 0 ? 100.0 * res.madNs / res.medianNs : 0,
+                    res.minNs,
+                    res.itemsPerSec
+                );
+
+                results.push_back(res);
+                current.push_back({ res.name, res.medianNs });
+            }
+        }
+
+        if (!options.jsonPath.empty() && WriteBenchFile(options.jsonPath, results, options) != OK)
+        {
+            printf("Unable to write %s\n", options.jsonPath.c_str());
+            return 2;
+        }
+    }
+    else if (ReadBenchFile(options.inputPath, current) != OK)
+    {
+        printf("Unable to read results from %s\n", options.inputPath.c_str());
+        return 2;
+    }
+
+    if (options.comparePath.empty()) return 0;
+
+    vector<pair<string, double>> baseline;
+
+    if (ReadBenchFile(options.comparePath, baseline) != OK)
+    {
+        printf("Unable to read baseline %s\n", options.comparePath.c_str());
+        return 2;
+    }
+
+    return CompareToBaseline(current, baseline, options.threshold) > 0 ? 1 : 0;
+}
@@ -0,0 +1,562 @@
+#include "problems.h"
+#include "motif.h"
+#include "reporter.h"
+
+#include <math.h>
+
+/*
+ * Randomized motif finders. Both engines work on 2-bit encoded copies of the input sequences and
+ * score profiles through log-probability tables, so evaluating every offset of a sequence is a
+ * tight add-only loop. Restarts are independent, so they are spread across worker threads with each
+ * thread owning its own generator and scratch buffers.
+ */
+
+struct EncodedSeqs
+{
+    vector<uint8_t> codes;
+    vector<uint32_t> starts;
+    vector<uint32_t> numOffsets;
+    uint32_t motifLen;
+
+    uint32_t Count() const { return (uint32_t)starts.size(); }
+    const uint8_t* Seq(uint32_t i) const { return &codes[starts[i]]; }
+};
+
+/**
+ * EncodeSequences - Convert ACGT strings to contiguous 2-bit codes. Unknown characters are coded
+ * as A so they can't index outside the profile tables.
+ *
+ * @param  seqs     [in]        Input sequences.
+ * @param  motifLen [in]        Motif length being searched for.
+ * @param  enc      [in/out]    Encoded sequences.
+ *
+ * @return          INVALID_INPUT if any sequence is shorter than the motif. OK otherwise.
+ */
+
+static ResultCode EncodeSequences(const vector<string>& seqs, const uint32_t motifLen, EncodedSeqs& enc)
+{
+    if (seqs.size() == 0 || motifLen == 0) return INVALID_INPUT;
+
+    size_t total = 0;
+    for (auto& seq : seqs)
+    {
+        if (seq.length() < motifLen) return INVALID_INPUT;
+        total += seq.length();
+    }
+
+    enc.codes.resize(total);
+    enc.starts.resize(seqs.size());
+    enc.numOffsets.resize(seqs.size());
+    enc.motifLen = motifLen;
+
+    uint32_t pos = 0;
+
+    for (uint32_t i = 0; i < seqs.size(); i++)
+    {
+        enc.starts[i]       = pos;
+        enc.numOffsets[i]   = (uint32_t)seqs[i].length() - motifLen + 1;
+
+        for (char base : seqs[i])
+        {
+            uint8_t code = BaseToCode(base);
+            enc.codes[pos++] = code == INVALID_BASE ? 0 : code;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * ScanProfile - Score every offset of a sequence against a log-probability profile. The loop runs
+ * column-outer/offset-inner so each pass is a branch-free select-and-add over contiguous memory,
+ * which the compiler turns into packed compares and blends.
+ *
+ * @param seq           [in]        Encoded sequence.
+ * @param numOffsets    [in]        Number of offsets to score.
+ * @param logProb       [in]        Profile table, base-major (logProb[base * motifLen + col]).
+ * @param motifLen      [in]        Motif length.
+ * @param scores        [in/out]    Log-probability of the k-mer at each offset.
+ */
+
+static void ScanProfile(
+    const uint8_t* seq,
+    const uint32_t numOffsets,
+    const float* logProb,
+    const uint32_t motifLen,
+    float* scores
+)
+{
+    for (uint32_t o = 0; o < numOffsets; o++) scores[o] = 0.0f;
+
+    for (uint32_t j = 0; j < motifLen; j++)
+    {
+        const uint8_t* col  = seq + j;
+        const float a       = logProb[0 * motifLen + j];
+        const float c       = logProb[1 * motifLen + j];
+        const float g       = logProb[2 * motifLen + j];
+        const float t       = logProb[3 * motifLen + j];
+
+        for (uint32_t o = 0; o < numOffsets; o++)
+        {
+            const uint8_t code  = col[o];
+            const float lo      = (code & 1) ? c : a;
+            const float hi      = (code & 1) ? t : g;
+            scores[o] += (code & 2) ? hi : lo;
+        }
+    }
+}
+
+/**
+ * BuildLogProfile - Turn per-column base counts into log-probabilities with pseudocounts.
+ *
+ * @param counts    [in]        Base counts, base-major like the profile table.
+ * @param numSeqs   [in]        Number of k-mers the counts were taken from.
+ * @param motifLen  [in]        Motif length.
+ * @param logProb   [in/out]    Profile table to fill.
+ */
+
+static void BuildLogProfile(const uint32_t* counts, const uint32_t numSeqs, const uint32_t motifLen, float* logProb)
+{
+    const float pseudo  = 1.0f;
+    const float denom   = logf((float)numSeqs + 4.0f * pseudo);
+
+    for (uint32_t i = 0; i < 4 * motifLen; i++)
+        logProb[i] = logf((float)counts[i] + pseudo) - denom;
+}
+
+/**
+ * AddKmerCounts - Add (sign = 1) or remove (sign = -1) the k-mer at an offset from the count table.
+ */
+
+static void AddKmerCounts(const uint8_t* kmer, const uint32_t motifLen, const int32_t sign, uint32_t* counts)
+{
+    for (uint32_t j = 0; j < motifLen; j++)
+        counts[kmer[j] * motifLen + j] += sign;
+}
+
+/**
+ * CountConsensus - Consensus score from a count table. Matches GetConsensus for the same offsets.
+ */
+
+static uint32_t CountConsensus(const uint32_t* counts, const uint32_t motifLen)
+{
+    uint32_t consensus = 0;
+
+    for (uint32_t j = 0; j < motifLen; j++)
+    {
+        uint32_t best = counts[j];
+        for (uint32_t b = 1; b < 4; b++)
+            if (counts[b * motifLen + j] > best) best = counts[b * motifLen + j];
+
+        consensus += best;
+    }
+
+    return consensus;
+}
+
+/*
+ * Per-thread scratch. Sized once per worker so restarts don't allocate.
+ */
+
+struct MotifScratch
+{
+    vector<uint32_t> offsets;
+    vector<uint32_t> nextOffsets;
+    vector<uint32_t> counts;
+    vector<float> logProb;
+    vector<float> scores;
+    vector<uint32_t> bestOffsets;
+    uint32_t bestScore;
+
+    MotifScratch(const EncodedSeqs& enc) : bestScore(0)
+    {
+        uint32_t maxOffsets = 0;
+        for (auto n : enc.numOffsets) if (n > maxOffsets) maxOffsets = n;
+
+        offsets.resize(enc.Count());
+        nextOffsets.resize(enc.Count());
+        bestOffsets.resize(enc.Count(), 0);
+        counts.resize(4 * enc.motifLen);
+        logProb.resize(4 * enc.motifLen);
+        scores.resize(maxOffsets);
+    }
+
+    void BuildCounts(const EncodedSeqs& enc, const vector<uint32_t>& offs)
+    {
+        fill(counts.begin(), counts.end(), 0);
+        for (uint32_t i = 0; i < enc.Count(); i++)
+            AddKmerCounts(enc.Seq(i) + offs[i], enc.motifLen, 1, &counts[0]);
+    }
+
+    void RandomOffsets(const EncodedSeqs& enc, Rng& rng)
+    {
+        for (uint32_t i = 0; i < enc.Count(); i++) offsets[i] = rng.NextBounded(enc.numOffsets[i]);
+    }
+
+    void StartOffsets(const EncodedSeqs& enc, const vector<uint32_t>* seed, Rng& rng)
+    {
+        if (seed) offsets = *seed;
+        else RandomOffsets(enc, rng);
+    }
+};
+
+/**
+ * RandomizedRestart - One restart of randomized motif search. Start from random (or seed) offsets,
+ * build a profile from them, move every sequence to its most probable k-mer under that profile, and
+ * repeat while the consensus score keeps improving.
+ */
+
+static void RandomizedRestart(const EncodedSeqs& enc, const vector<uint32_t>* seed, Rng& rng, MotifScratch& s)
+{
+    const uint32_t k = enc.motifLen;
+
+    s.StartOffsets(enc, seed, rng);
+    s.BuildCounts(enc, s.offsets);
+    uint32_t curScore = CountConsensus(&s.counts[0], k);
+
+    while (1)
+    {
+        BuildLogProfile(&s.counts[0], enc.Count(), k, &s.logProb[0]);
+
+        for (uint32_t i = 0; i < enc.Count(); i++)
+        {
+            ScanProfile(enc.Seq(i), enc.numOffsets[i], &s.logProb[0], k, &s.scores[0]);
+            s.nextOffsets[i] = (uint32_t)(max_element(s.scores.begin(), s.scores.begin() + enc.numOffsets[i]) - s.scores.begin());
+        }
+
+        s.BuildCounts(enc, s.nextOffsets);
+        uint32_t nextScore = CountConsensus(&s.counts[0], k);
+
+        if (nextScore <= curScore) break;
+
+        curScore = nextScore;
+        s.offsets.swap(s.nextOffsets);
+    }
+
+    if (curScore > s.bestScore)
+    {
+        s.bestScore = curScore;
+        s.bestOffsets = s.offsets;
+    }
+}
+
+/**
+ * GibbsRestart - One restart of Gibbs sampling. Each iteration drops a random sequence from the
+ * profile, scores all of its offsets against the remaining ones, and resamples its offset in
+ * proportion to the profile probability of each k-mer.
+ */
+
+static void GibbsRestart(
+    const EncodedSeqs& enc,
+    const uint32_t numIters,
+    const vector<uint32_t>* seed,
+    Rng& rng,
+    MotifScratch& s
+)
+{
+    const uint32_t k = enc.motifLen;
+    const uint32_t n = enc.Count();
+
+    s.StartOffsets(enc, seed, rng);
+    s.BuildCounts(enc, s.offsets);
+
+    uint32_t bestScore = CountConsensus(&s.counts[0], k);
+    s.nextOffsets = s.offsets;
+
+    for (uint32_t iter = 0; iter < numIters; iter++)
+    {
+        const uint32_t i        = rng.NextBounded(n);
+        const uint8_t* seq      = enc.Seq(i);
+        const uint32_t numOffs  = enc.numOffsets[i];
+
+        AddKmerCounts(seq + s.offsets[i], k, -1, &s.counts[0]);
+        BuildLogProfile(&s.counts[0], n - 1, k, &s.logProb[0]);
+        ScanProfile(seq, numOffs, &s.logProb[0], k, &s.scores[0]);
+
+        const float maxScore = *max_element(s.scores.begin(), s.scores.begin() + numOffs);
+        float total = 0.0f;
+
+        for (uint32_t o = 0; o < numOffs; o++)
+        {
+            s.scores[o] = expf(s.scores[o] - maxScore);
+            total += s.scores[o];
+        }
+
+        float target    = rng.NextFloat() * total;
+        uint32_t pick   = numOffs - 1;
+
+        for (uint32_t o = 0; o < numOffs; o++)
+        {
+            target -= s.scores[o];
+            if (target < 0.0f)
+            {
+                pick = o;
+                break;
+            }
+        }
+
+        s.offsets[i] = pick;
+        AddKmerCounts(seq + pick, k, 1, &s.counts[0]);
+
+        uint32_t curScore = CountConsensus(&s.counts[0], k);
+
+        if (curScore > bestScore)
+        {
+            bestScore = curScore;
+            s.nextOffsets = s.offsets;
+        }
+    }
+
+    if (bestScore > s.bestScore)
+    {
+        s.bestScore = bestScore;
+        s.bestOffsets = s.nextOffsets;
+    }
+}
+
+/**
+ * RunRestarts - Spread independent restarts over worker threads and keep the best result. Seeds
+ * for the per-thread generators are drawn from rand() so runs stay reproducible under srand().
+ * Restart r starts from seedOffsets[r] while there are seed offset sets left, and from random
+ * offsets after that.
+ *
+ * @param enc           [in]    Encoded sequences.
+ * @param numRestarts   [in]    Total restarts across all threads.
+ * @param seedOffsets   [in]    Optional starting offset sets, e.g. from top k-mer candidates.
+ * @param restart       [in]    Restart routine run against a seed, a thread's generator and scratch.
+ * @param offsets       [out]   Best offsets found.
+ */
+
+template<typename RestartFn>
+static void RunRestarts(
+    const EncodedSeqs& enc,
+    const uint32_t numRestarts,
+    const vector<vector<uint32_t>>* seedOffsets,
+    RestartFn restart,
+    vector<uint32_t>& offsets
+)
+{
+    const uint32_t numSeeds = seedOffsets ? (uint32_t)seedOffsets->size() : 0;
+
+    const uint32_t numThreads = min(GetWorkerCount(), max(numRestarts, 1u));
+    const uint64_t seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+
+    vector<MotifScratch> scratch(numThreads, MotifScratch(enc));
+    vector<thread> workers;
+
+    for (uint32_t t = 0; t < numThreads; t++)
+    {
+        workers.push_back(thread([&, t]()
+        {
+            Rng rng(seed + t);
+            for (uint32_t r = t; r < numRestarts; r += numThreads)
+                restart(r < numSeeds ? &(*seedOffsets)[r] : nullptr, rng, scratch[t]);
+        }));
+    }
+
+    for (auto& worker : workers) worker.join();
+
+    uint32_t best = 0;
+    for (uint32_t t = 1; t < numThreads; t++)
+        if (scratch[t].bestScore > scratch[best].bestScore) best = t;
+
+    offsets = scratch[best].bestOffsets;
+}
+
+/**
+ * CheckSeedOffsets - Check that every seed offset set has one in-range offset per sequence.
+ */
+
+static bool CheckSeedOffsets(const EncodedSeqs& enc, const vector<vector<uint32_t>>* seedOffsets)
+{
+    if (!seedOffsets) return true;
+
+    for (auto& seed : *seedOffsets)
+    {
+        if (seed.size() != enc.Count()) return false;
+        for (uint32_t i = 0; i < enc.Count(); i++) if (seed[i] >= enc.numOffsets[i]) return false;
+    }
+
+    return true;
+}
+
+/**
+ * RandomizedMotifSearch - Heuristic motif search by repeated randomized profile refinement.
+ *
+ * @param  seqs         [in]    Sequences to search for a motif.
+ * @param  motifLen     [in]    Length of desired motif.
+ * @param  numRestarts  [in]    Number of starting points to try.
+ * @param  offsets      [out]   Best offsets found into each input sequence.
+ * @param  seedOffsets  [in]    Optional offset sets used as the first starting points instead of random ones.
+ *
+ * @return              INVALID_INPUT if no sequences, a sequence is shorter than the motif or a seed offset
+ *                      set doesn't fit the sequences. OK otherwise.
+ */
+
+ResultCode RandomizedMotifSearch(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numRestarts,
+    vector<uint32_t>& offsets,
+    const vector<vector<uint32_t>>* seedOffsets
+)
+{
+    EncodedSeqs enc;
+    if (EncodeSequences(seqs, motifLen, enc) != OK) return INVALID_INPUT;
+    if (!CheckSeedOffsets(enc, seedOffsets)) return INVALID_INPUT;
+
+    RunRestarts(enc, numRestarts, seedOffsets,
+        [&](const vector<uint32_t>* seed, Rng& rng, MotifScratch& s) { RandomizedRestart(enc, seed, rng, s); }, offsets);
+
+    return OK;
+}
+
+/**
+ * GibbsSampler - Heuristic motif search by Gibbs sampling with Laplace pseudocounts.
+ *
+ * @param  seqs         [in]    Sequences to search for a motif.
+ * @param  motifLen     [in]    Length of desired motif.
+ * @param  numRestarts  [in]    Number of independent sampling chains.
+ * @param  numIters     [in]    Resampling steps per chain.
+ * @param  offsets      [out]   Best offsets found into each input sequence.
+ * @param  seedOffsets  [in]    Optional offset sets used as the first chains' starting points.
+ *
+ * @return              INVALID_INPUT if fewer than two sequences, a sequence is shorter than the motif or a
+ *                      seed offset set doesn't fit the sequences. OK otherwise.
+ */
+
+ResultCode GibbsSampler(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numRestarts,
+    const uint32_t numIters,
+    vector<uint32_t>& offsets,
+    const vector<vector<uint32_t>>* seedOffsets
+)
+{
+    if (seqs.size() < 2) return INVALID_INPUT;
+
+    EncodedSeqs enc;
+    if (EncodeSequences(seqs, motifLen, enc) != OK) return INVALID_INPUT;
+    if (!CheckSeedOffsets(enc, seedOffsets)) return INVALID_INPUT;
+
+    RunRestarts(enc, numRestarts, seedOffsets,
+        [&](const vector<uint32_t>* seed, Rng& rng, MotifScratch& s) { GibbsRestart(enc, numIters, seed, rng, s); }, offsets);
+
+    return OK;
+}
+
+/**
+ * TestSmallInstances - Compare both heuristics against the exact branch-and-bound FindMotif on
+ * instances small enough to search exhaustively. Passes if a heuristic reaches the optimal
+ * consensus score.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestSmallInstances(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 10;
+    const uint32_t nSeq     = 5;
+    const uint32_t seqLen   = 14;
+    const uint32_t motifLen = 4;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        if (!ShardOwnsCase("RandMotif::SmallInstance", i)) continue;
+
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
+
+        vector<uint32_t> exactOffsets;
+        vector<uint32_t> randOffsets;
+        vector<uint32_t> gibbsOffsets;
+
+        FindMotif(seqs, motifLen, exactOffsets);
+        RandomizedMotifSearch(seqs, motifLen, 2000, randOffsets);
+        GibbsSampler(seqs, motifLen, 200, 200, gibbsOffsets);
+
+        const uint32_t exactScore   = GetConsensus(seqs, nSeq, exactOffsets, motifLen);
+        const uint32_t randScore    = GetConsensus(seqs, nSeq, randOffsets, motifLen);
+        const uint32_t gibbsScore   = GetConsensus(seqs, nSeq, gibbsOffsets, motifLen);
+
+        if (randScore == exactScore && gibbsScore == exactScore)
+        {
+            ReportTestCase(testResults, "RandMotif::SmallInstance", i, PASS);
+        }
+        else
+        {
+            const string scoreStr = "exact = " + to_string(exactScore) + ", randomized = " + to_string(randScore) +
+                                    ", gibbs = " + to_string(gibbsScore);
+
+            ReportTestCase(testResults, "RandMotif::SmallInstance", i, FAIL, "Heuristic missed optimum: " + scoreStr);
+        }
+    }
+}
+
+/**
+ * TestPlantedRecovery - Plant motifs in larger sequence sets and time how quickly each heuristic
+ * recovers them. Passes if the planted consensus score is reached; the recovery rate (fraction of
+ * sequences whose planted offset was found) and run time are reported in the message.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestPlantedRecovery(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 5;
+    const uint32_t nSeq     = 20;
+    const uint32_t seqLen   = 300;
+    const uint32_t motifLen = 12;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        if (!ShardOwnsCase("RandMotif::Planted", i)) continue;
+
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
+
+        for (uint32_t engine = 0; engine < 2; engine++)
+        {
+            vector<uint32_t> found;
+
+            long long t1 = GetMilliseconds();
+
+            if (engine == 0) RandomizedMotifSearch(seqs, motifLen, 1000, found);
+            else GibbsSampler(seqs, motifLen, 50, 2000, found);
+
+            long long t2 = GetMilliseconds();
+            float sec    = ((float)t2 - (float)t1) / 1000.0f;
+
+            uint32_t recovered = 0;
+            for (uint32_t j = 0; j < nSeq; j++) if (found[j] == planted[j]) recovered++;
+
+            const uint32_t score    = GetConsensus(seqs, nSeq, found, motifLen);
+            const string name       = string(engine == 0 ? "RandMotif::Randomized" : "RandMotif::Gibbs") + "[" + to_string(i) + "]";
+            const string msg        = "Recovered " + to_string(recovered) + "/" + to_string(nSeq) + ", T = " + to_string(sec) + "sec.";
+
+            if (score == nSeq * motifLen)
+                testResults.push_back({ name, PASS, msg });
+            else
+                testResults.push_back({ name, FAIL, "Planted motif not found. Score = " + to_string(score) + ". " + msg });
+        }
+    }
+}
+
+/**
+ * RandomizedMotifFinding - Tests for the randomized motif search and Gibbs sampling engines.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void RandomizedMotifFinding(vector<TestResult>& testResults)
+{
+    TestSmallInstances(testResults);
+    TestPlantedRecovery(testResults);
+}
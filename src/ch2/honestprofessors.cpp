@@ -1,53 +1,110 @@
 #include "problems.h"
+#include "professors.h"
+#include "reporter.h"
 
-const uint32_t PROFCNT = 100;
 const uint32_t INVALID = ~0;
 
-struct Professors
+/**
+ * SimulatedOracle::QueryBatch - Answer the batch now and deliver the answers after the modelled latency.
+ *
+ * @param  queries [in] Queries to answer.
+ * @return              Future for the answers, in query order.
+ */
+
+future<vector<bool>> SimulatedOracle::QueryBatch(const vector<HonestyQuery>& queries)
 {
-    bool honest[PROFCNT];
-    uint32_t queryCnt;
+    vector<bool> answers(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) answers[i] = profs.QueryHonesty(queries[i].asker, queries[i].subject);
+
+    const uint32_t costUs = latency.callUs + latency.queryUs * (uint32_t)queries.size();
 
-    Professors() : queryCnt(0)
+    if (costUs == 0)
     {
-        memset(honest, false, PROFCNT * sizeof(bool));
-        uint32_t honestCnt = (PROFCNT / 2) + rand() % (PROFCNT / 2);
+        promise<vector<bool>> ready;
+        ready.set_value(move(answers));
+        return ready.get_future();
+    }
 
-        while (honestCnt > 0)
+    return async(launch::async, [this, costUs](vector<bool> answers)
+    {
+        if (latency.maxInFlight > 0)
         {
-            uint32_t curIdx = rand() % PROFCNT;
-            if (!honest[curIdx])
-            {
-                honest[curIdx] = true;
-                honestCnt--;
-            }
+            unique_lock<mutex> guard(lock);
+            slotFree.wait(guard, [this] { return inFlight < latency.maxInFlight; });
+            inFlight++;
+        }
+
+        this_thread::sleep_for(chrono::microseconds(costUs));
+
+        if (latency.maxInFlight > 0)
+        {
+            lock_guard<mutex> guard(lock);
+            inFlight--;
+            slotFree.notify_one();
+        }
+
+        return answers;
+    }, move(answers));
+}
+
+/**
+ * QueryRound - Send a round of independent queries to the oracle and collect the answers.
+ *
+ * @param oracle  [in] Oracle to query.
+ * @param queries [in] Queries of the round. None may depend on the answer to another.
+ * @param policy  [in] Batch size and whether batches are in flight together.
+ * @param answers [out] Answers, in query order.
+ * @param stats   [in/out] Optional query, batch and round counters to add to.
+ */
+
+void QueryRound(
+    HonestyOracle& oracle,
+    const vector<HonestyQuery>& queries,
+    const OracleRoundPolicy& policy,
+    vector<bool>& answers,
+    OracleRunStats* stats)
+{
+    const size_t batchLen = policy.maxBatch == 0 ? max<size_t>(queries.size(), 1) : policy.maxBatch;
+
+    vector<future<vector<bool>>> pending;
+    vector<size_t> pendingBegin;
+    uint32_t numBatches = 0;
+
+    answers.resize(queries.size());
+
+    auto collect = [&answers](future<vector<bool>>& result, const size_t begin)
+    {
+        vector<bool> batchAnswers = result.get();
+        for (size_t i = 0; i < batchAnswers.size(); i++) answers[begin + i] = batchAnswers[i];
+    };
+
+    for (size_t begin = 0; begin < queries.size(); begin += batchLen)
+    {
+        const size_t end = min(begin + batchLen, queries.size());
+
+        future<vector<bool>> result = oracle.QueryBatch(vector<HonestyQuery>(queries.begin() + begin, queries.begin() + end));
+        numBatches++;
+
+        if (policy.concurrent)
+        {
+            pending.push_back(move(result));
+            pendingBegin.push_back(begin);
+        }
+        else
+        {
+            collect(result, begin);
         }
     }
 
-    
-    /**
-     * GetQueryCnt - Return how many times this professor set has been queried.
-     * @return Number of times the set has been queried.
-     */
-    
-    uint32_t GetQueryCnt() { return queryCnt; }
-
-    /**
-     * QueryHonesty - Check if professor a things professor b is honest. If a is honest,
-     * returns if b is actually honest. If b is dishonest, returns random true/false.
-     *
-     * @param  a Professor to query.
-     * @param  b Professor to query about.
-     * @return   Whether professor a considers professor b honest.
-     */
-    
-    bool QueryHonesty(uint32_t a, uint32_t b)
+    for (size_t i = 0; i < pending.size(); i++) collect(pending[i], pendingBegin[i]);
+
+    if (stats)
     {
-        queryCnt++;
-        if (honest[a]) return honest[b];
-        else return rand() % 2 == 0;
+        stats->queries  += (uint32_t)queries.size();
+        stats->batches  += numBatches;
+        stats->rounds++;
     }
-};
+}
 
 /**
  * DetermineHonestProfessors - Given a group of honest/dishonest professors that can
@@ -60,33 +117,50 @@ struct Professors
  * most honest professors to begin, each step of this process will remove dishonest professors
  * until only one or two honest professors remain.
  *
+ * The pair queries of one step don't depend on each other, and neither do the final queries
+ * of the honest professor, so each goes to the oracle as one round.
+ *
  * This algorithm doesn't satisfy the < 198 query max condition. I'll have to keep thinking
  * to come up with a better algorithm.
  *
- * @param profs  [in] List of professors that can query each other's honesty.
+ * @param oracle [in] Oracle answering the professors' queries about each other.
+ * @param policy [in] How each round of queries is batched and sent.
  * @param honest [in/out] List of whether each professor is honest as determined by this algorihtm.
+ * @param stats  [in/out] Optional query, batch and round counters to add to.
  */
 
-static void DetermineHonestProfessors(Professors& profs, bool honest[PROFCNT])
+static void DetermineHonestProfessors(
+    HonestyOracle& oracle,
+    const OracleRoundPolicy& policy,
+    bool honest[PROFCNT],
+    OracleRunStats* stats = nullptr)
 {
     memset(honest, false, PROFCNT * sizeof(bool));
 
     vector<pair<uint32_t, uint32_t>> pairs;
     for (uint32_t i = 0; i < PROFCNT / 2; i++) pairs.push_back({ 2 * i, 2 * i + 1 });
 
+    vector<HonestyQuery> queries;
+    vector<bool> answers;
     uint32_t honestProf = INVALID;
 
     while (1)
     {
         vector<uint32_t> honestCandidates;
 
+        queries.resize(0);
         for (auto& pair : pairs)
         {
-            bool b1 = profs.QueryHonesty(pair.first, pair.second);
-            bool b2 = profs.QueryHonesty(pair.second, pair.first);
+            queries.push_back({ pair.first, pair.second });
+            queries.push_back({ pair.second, pair.first });
+        }
+
+        QueryRound(oracle, queries, policy, answers, stats);
 
-            if (b1 && b2)
-                honestCandidates.push_back(rand() % 2 == 0 ? pair.first : pair.second);
+        for (size_t i = 0; i < pairs.size(); i++)
+        {
+            if (answers[2 * i] && answers[2 * i + 1])
+                honestCandidates.push_back(rand() % 2 == 0 ? pairs[i].first : pairs[i].second);
         }
 
         if (honestCandidates.size() <= 2)
@@ -102,16 +176,119 @@ static void DetermineHonestProfessors(Professors& profs, bool honest[PROFCNT])
             pairs.push_back({ honestCandidates[2 * i], honestCandidates[2 * i + 1] });
     }
 
-    for (uint32_t i = 0; i < PROFCNT; i++)
-        if (i != PROFCNT)
-            honest[i] = profs.QueryHonesty(honestProf, i);
+    queries.resize(0);
+    for (uint32_t i = 0; i < PROFCNT; i++) queries.push_back({ honestProf, i });
+
+    QueryRound(oracle, queries, policy, answers, stats);
+
+    for (uint32_t i = 0; i < PROFCNT; i++) honest[i] = answers[i];
+}
+
+/**
+ * TestOracleLatency - Run the identification against simulated oracles with different latency models,
+ * sending each round one query at a time, with every query in flight, in batches of 16, and as one
+ * batch. Every policy sees the same professors and the same random stream, so they must agree on the
+ * answer, the query count and the round count; the wall times are reported.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestOracleLatency(vector<TestResult>& testResults)
+{
+    const uint32_t numInstances = 2;
+
+    const OracleLatency models[] =
+    {
+        { "Local",      0,      0,  0 },
+        { "RoundTrip",  1000,   0,  0 },
+        { "PerQuery",   200,    20, 4 },
+    };
+
+    const OracleRoundPolicy policies[] =
+    {
+        { 1,    false },
+        { 1,    true },
+        { 16,   true },
+        { 0,    true },
+    };
+
+    const char* policyNames[] = { "serial", "concurrent", "batch16", "perRound" };
+    const uint32_t numPolicies = sizeof(policies) / sizeof(policies[0]);
+
+    for (auto& model : models)
+    {
+        const string name = string("HonestProfs::Oracle") + model.name;
+
+        vector<OracleRunStats> stats(numPolicies);
+        vector<long long> elapsedUs(numPolicies, 0);
+        vector<string> outcomes(numPolicies);
+        bool agree = true;
+
+        for (uint32_t inst = 0; inst < numInstances; inst++)
+        {
+            const unsigned int instSeed = rand();
+            bool reference[PROFCNT];
+            OracleRunStats refStats = { 0, 0, 0 };
+
+            srand(instSeed);
+            const Professors instance;
+
+            for (uint32_t p = 0; p < numPolicies; p++)
+            {
+                Professors profs = instance;
+                SimulatedOracle oracle(profs, model);
+                OracleRunStats runStats = { 0, 0, 0 };
+                bool honest[PROFCNT];
+
+                srand(instSeed + 1);
+
+                long long t1 = GetNanoseconds();
+                DetermineHonestProfessors(oracle, policies[p], honest, &runStats);
+                long long t2 = GetNanoseconds();
+
+                elapsedUs[p]        += (t2 - t1) / 1000;
+                stats[p].queries    += runStats.queries;
+                stats[p].batches    += runStats.batches;
+                stats[p].rounds     += runStats.rounds;
+
+                if (p == 0)
+                {
+                    memcpy(reference, honest, sizeof(reference));
+                    refStats = runStats;
+                }
+
+                if (memcmp(reference, honest, sizeof(reference)) != 0 || runStats.queries != oracle.GetQueryCnt() ||
+                    runStats.queries != refStats.queries || runStats.rounds != refStats.rounds)
+                {
+                    agree = false;
+                }
+            }
+        }
+
+        string msg;
+        char buf[128];
+
+        for (uint32_t p = 0; p < numPolicies; p++)
+        {
+            snprintf(buf, sizeof(buf), "%s%s %.1f ms (%u batches)", p == 0 ? "" : ", ", policyNames[p],
+                elapsedUs[p] / 1000.0 / numInstances, stats[p].batches / numInstances);
+            msg += buf;
+        }
+
+        snprintf(buf, sizeof(buf), "; %u queries in %u rounds per instance.", stats[0].queries / numInstances, stats[0].rounds / numInstances);
+        msg += buf;
+
+        if (agree) testResults.push_back({ name, PASS, msg });
+        else testResults.push_back({ name, FAIL, "Query policies disagree on the answer or the query count. " + msg });
+    }
 }
 
 /**
  * HonestProfessors - Honest/deceitful professor problem test. Randomly generate 100 professors with
  * different honesties/dishonesties, then run the solution algorithm. Test passes if algorithm
  * correctly determines the honest professors in 198 queries or less. Fails if result is incorrect
- * or uses too many queries.
+ * or uses too many queries. Then reports wall time against query count for the simulated oracle latency
+ * models (see TestOracleLatency).
  *
  * @param testResults [in/out] Test result list to append to.
  */
@@ -120,13 +297,14 @@ void HonestProfessors(vector<TestResult>& testResults)
 {
     const uint32_t numIters = 1000;
 
-    srand((uint32_t)time(NULL));
-
     for (uint32_t i = 0; i < numIters; i++)
     {
+        if (!ShardOwnsCase("HonestProfs", i)) continue;
+
         Professors profs;
+        SimulatedOracle oracle(profs, { "Local", 0, 0, 0 });
         bool honestResults[100];
-        DetermineHonestProfessors(profs, honestResults);
+        DetermineHonestProfessors(oracle, { 0, true }, honestResults);
 
         bool correctAnswer      = true;
         bool belowMaxQueries    = true;
@@ -143,10 +321,12 @@ void HonestProfessors(vector<TestResult>& testResults)
         if (profs.GetQueryCnt() > 198) belowMaxQueries = false;
 
         if (correctAnswer && belowMaxQueries)
-            testResults.push_back({ "HonestProfs[" + to_string(i) + "]", PASS, "" });
+            ReportTestCase(testResults, "HonestProfs", i, PASS);
         else if (!correctAnswer)
-            testResults.push_back({ "HonestProfs[" + to_string(i) + "]", FAIL, "Algorithm produced incorrect result." });
+            ReportTestCase(testResults, "HonestProfs", i, FAIL, "Algorithm produced incorrect result.");
         else
-            testResults.push_back({ "HonestProfs[" + to_string(i) + "]", FAIL, "Algorithm used too many queries." });
+            ReportTestCase(testResults, "HonestProfs", i, FAIL, "Algorithm used too many queries.");
     }
-}
\ No newline at end of file
+
+    if (ShardOwnsCase("HonestProfs::Oracle", TEST_NO_INDEX)) TestOracleLatency(testResults);
+}
@@ -1,4 +1,6 @@
 #include "problems.h"
+#include "minmax.h"
+#include "reporter.h"
 
 using namespace std;
 
@@ -18,7 +20,7 @@ using namespace std;
  * lists.
  */
 
-static ResultCode GetMinMax(const vector<uint32_t> &list, uint32_t &min, uint32_t &max)
+ResultCode GetMinMax(const vector<uint32_t> &list, uint32_t &min, uint32_t &max)
 {
     if (list.size() == 0) return INVALID_INPUT;
 
@@ -158,7 +160,7 @@ static void TestRandomLists(vector<TestResult> & testResults)
 
     for (uint32_t i = 0; i < numIters; i++)
     {
-        string iterStr = to_string(i);
+        if (!ShardOwnsCase("MinMax::RandomList", i)) continue;
 
         uint32_t curLen = rand() % maxLen;
         vector<uint32_t> list(curLen);
@@ -168,7 +170,7 @@ static void TestRandomLists(vector<TestResult> & testResults)
         resBF   = GetMinMaxBruteForce(list, minBF, maxBF);
 
         if (min == minBF && max == maxBF)
-            testResults.push_back({ "MinMax::RandomList[" + iterStr + "]", PASS, "" });
+            ReportTestCase(testResults, "MinMax::RandomList", i, PASS);
         else
         {
             const string minStr     = to_string(min);
@@ -176,12 +178,12 @@ static void TestRandomLists(vector<TestResult> & testResults)
             const string minBFStr   = to_string(minBF);
             const string maxBFStr   = to_string(maxBF);
 
-            testResults.push_back(
-                {
-                    "MinMax::RandomList[" + iterStr + "]",
-                    FAIL,
-                    "Expected {min, max} = {" + minBFStr + ", " + maxBFStr + "}, found {" + minStr + ", " + maxStr + "}"
-                }
+            ReportTestCase(
+                testResults,
+                "MinMax::RandomList",
+                i,
+                FAIL,
+                "Expected {min, max} = {" + minBFStr + ", " + maxBFStr + "}, found {" + minStr + ", " + maxStr + "}"
             );
         }
     }
@@ -196,7 +198,7 @@ static void TestRandomLists(vector<TestResult> & testResults)
 
 void GetMinMax(vector<TestResult>& testResults)
 {
-    TestLengthZeroList(testResults);
-    TestLengthOneList(testResults);
+    if (ShardOwnsCase("MinMax::LengthZeroList", TEST_NO_INDEX)) TestLengthZeroList(testResults);
+    if (ShardOwnsCase("MinMax::LengthOneList", TEST_NO_INDEX)) TestLengthOneList(testResults);
     TestRandomLists(testResults);
 }
\ No newline at end of file
@@ -0,0 +1,500 @@
+#include "problems.h"
+#include "restmap.h"
+
+#include <cmath>
+
+/*
+ * Double digest search state. A chain holds one candidate order per enzyme together with the interior
+ * cut positions those orders imply, and the signed difference between the fragment length histogram
+ * of the combined cuts and the A+B histogram. The cost is the L1 norm of that difference, so a map
+ * that reproduces the A+B fragments exactly has cost zero.
+ *
+ * Swapping fragments i and i + 1 of one enzyme moves a single cut, from c to c - x[i] + x[i + 1], and
+ * the cut stays between the same two neighbouring cuts of that enzyme. Only the combined fragments
+ * on either side of the old and new positions change: at most three histogram entries on removal and
+ * three on insertion, each an O(1) cost update. The other enzyme's neighbouring cuts come from a
+ * binary search over its cut list, which is sorted by construction.
+ */
+
+const uint32_t DIGEST_MAX_OPS       = 6;
+const uint32_t DIGEST_STOP_CHECK    = 256;      // Moves between checks for another chain's solution.
+
+struct DigestOp
+{
+    uint32_t len;
+    int32_t delta;
+};
+
+struct DigestChain
+{
+    vector<uint32_t> frags[2];
+    vector<uint32_t> cuts[2];
+    vector<int32_t> diff;
+    uint32_t length;
+    uint32_t cost;
+    uint64_t moves;
+    Rng rng;
+
+    DigestChain(const uint64_t seed) : length(0), cost(0), moves(0), rng(seed) {}
+
+    void BuildCuts(const uint32_t e)
+    {
+        cuts[e].resize(frags[e].size() - 1);
+
+        uint32_t pos = 0;
+        for (uint32_t i = 0; i + 1 < frags[e].size(); i++) cuts[e][i] = pos += frags[e][i];
+    }
+
+    /**
+     * Init - Start from random orders of both enzymes' fragments.
+     */
+
+    void Init(const vector<uint32_t>& fragsA, const vector<uint32_t>& fragsB, const vector<int32_t>& target)
+    {
+        frags[0] = fragsA;
+        frags[1] = fragsB;
+
+        for (uint32_t e = 0; e < 2; e++)
+        {
+            for (uint32_t i = (uint32_t)frags[e].size(); i > 1; i--) swap(frags[e][i - 1], frags[e][rng.NextBounded(i)]);
+            BuildCuts(e);
+        }
+
+        length = 0;
+        for (auto frag : fragsA) length += frag;
+
+        vector<uint32_t> merged(cuts[0]);
+        merged.insert(merged.end(), cuts[1].begin(), cuts[1].end());
+
+        vector<uint32_t> combined;
+        GetDigestFragments(merged, length, combined);
+
+        diff = target;
+        for (auto frag : combined) diff[frag]++;
+
+        cost = 0;
+        for (auto d : diff) cost += (uint32_t)abs(d);
+    }
+
+    static uint32_t PrevCut(const vector<uint32_t>& cuts, const uint32_t pos)
+    {
+        auto it = lower_bound(cuts.begin(), cuts.end(), pos);
+        return it == cuts.begin() ? 0 : *(it - 1);
+    }
+
+    uint32_t NextCut(const vector<uint32_t>& cuts, const uint32_t pos) const
+    {
+        auto it = upper_bound(cuts.begin(), cuts.end(), pos);
+        return it == cuts.end() ? length : *it;
+    }
+
+    /**
+     * Move - Propose swapping fragments i and i + 1 of enzyme e and accept or reject it.
+     *
+     * @param  e            [in] Enzyme, 0 for A and 1 for B.
+     * @param  i            [in] First fragment of the swapped pair.
+     * @param  acceptProb   [in] Acceptance probability for each cost increase, indexed by the increase.
+     */
+
+    void Move(const uint32_t e, const uint32_t i, const float* acceptProb)
+    {
+        vector<uint32_t>& x = frags[e];
+        if (x[i] == x[i + 1]) return;
+
+        const vector<uint32_t>& own     = cuts[e];
+        const vector<uint32_t>& other   = cuts[1 - e];
+
+        const uint32_t oldCut   = own[i];
+        const uint32_t newCut   = oldCut - x[i] + x[i + 1];
+        const uint32_t ownPrev  = i > 0 ? own[i - 1] : 0;
+        const uint32_t ownNext  = i + 1 < own.size() ? own[i + 1] : length;
+
+        DigestOp ops[DIGEST_MAX_OPS];
+        uint32_t numOps = 0;
+
+        // A cut shared with the other enzyme stays in the combined map whichever way it moves.
+
+        if (!binary_search(other.begin(), other.end(), oldCut))
+        {
+            const uint32_t left     = max(ownPrev, PrevCut(other, oldCut));
+            const uint32_t right    = min(ownNext, NextCut(other, oldCut));
+
+            ops[numOps++] = { oldCut - left, -1 };
+            ops[numOps++] = { right - oldCut, -1 };
+            ops[numOps++] = { right - left, 1 };
+        }
+
+        if (!binary_search(other.begin(), other.end(), newCut))
+        {
+            const uint32_t left     = max(ownPrev, PrevCut(other, newCut));
+            const uint32_t right    = min(ownNext, NextCut(other, newCut));
+
+            ops[numOps++] = { right - left, -1 };
+            ops[numOps++] = { newCut - left, 1 };
+            ops[numOps++] = { right - newCut, 1 };
+        }
+
+        int32_t delta = 0;
+
+        for (uint32_t k = 0; k < numOps; k++)
+        {
+            int32_t& d  = diff[ops[k].len];
+            delta       += abs(d + ops[k].delta) - abs(d);
+            d           += ops[k].delta;
+        }
+
+        if (delta <= 0 || rng.NextFloat() < acceptProb[delta])
+        {
+            swap(x[i], x[i + 1]);
+            cuts[e][i]  = newCut;
+            cost        = (uint32_t)((int32_t)cost + delta);
+            return;
+        }
+
+        for (uint32_t k = numOps; k > 0; k--) diff[ops[k - 1].len] -= ops[k - 1].delta;
+    }
+
+    /**
+     * Run - Make up to numMoves moves at one temperature, stopping early once this chain or another
+     * one reaches cost zero.
+     */
+
+    void Run(const uint32_t numMoves, const float beta, const atomic<bool>& solved)
+    {
+        float acceptProb[2 * DIGEST_MAX_OPS + 1];
+        for (uint32_t d = 0; d <= 2 * DIGEST_MAX_OPS; d++) acceptProb[d] = expf(-(float)d * beta);
+
+        const uint32_t numCutsA = (uint32_t)cuts[0].size();
+        const uint32_t numCuts  = numCutsA + (uint32_t)cuts[1].size();
+
+        for (uint32_t m = 0; m < numMoves && cost > 0 && numCuts > 0; m++)
+        {
+            if (m % DIGEST_STOP_CHECK == 0 && solved) break;
+
+            // Each cut is one adjacent pair of fragments, so pairs are picked uniformly across both enzymes.
+
+            const uint32_t pick = rng.NextBounded(numCuts);
+
+            if (pick < numCutsA) Move(0, pick, acceptProb);
+            else Move(1, pick - numCutsA, acceptProb);
+
+            moves++;
+        }
+    }
+};
+
+/**
+ * GetDigestFragments - Fragment lengths left by cutting a molecule at the given positions.
+ *
+ * @param  cuts         [in]        Cut positions, any order. Repeated positions count once.
+ * @param  length       [in]        Molecule length.
+ * @param  fragments    [in/out]    Sorted fragment lengths. Assumed empty on input.
+ *
+ * @return              INVALID_INPUT if a cut isn't strictly inside the molecule.
+ */
+
+ResultCode GetDigestFragments(const vector<uint32_t>& cuts, const uint32_t length, vector<uint32_t>& fragments)
+{
+    assert(fragments.size() == 0);
+
+    vector<uint32_t> sorted(cuts);
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+    if (length == 0 || (!sorted.empty() && (sorted[0] == 0 || sorted.back() >= length))) return INVALID_INPUT;
+
+    uint32_t prev = 0;
+
+    for (auto cut : sorted)
+    {
+        fragments.push_back(cut - prev);
+        prev = cut;
+    }
+
+    fragments.push_back(length - prev);
+    sort(fragments.begin(), fragments.end());
+
+    return OK;
+}
+
+/**
+ * SolveDoubleDigest - Double digest mapping by parallel tempering. Chains sit on a geometric
+ * temperature ladder between minTemp and maxTemp and run movesPerRound moves each per round, spread
+ * over worker threads. Between rounds, neighbouring temperatures offer to trade chains with the usual
+ * replica exchange acceptance, alternating even and odd pairs, so good maps found by hot chains drift
+ * down to the cold end. Chain seeds are drawn from rand() so runs are reproducible under srand().
+ *
+ * @param  fragsA   [in]        Enzyme A fragment lengths, any order.
+ * @param  fragsB   [in]        Enzyme B fragment lengths, any order.
+ * @param  fragsAB  [in]        Fragment lengths with both enzymes, any order.
+ * @param  orderA   [out]       Enzyme A fragments in map order.
+ * @param  orderB   [out]       Enzyme B fragments in map order.
+ * @param  options  [in]        Chain count, round length and budget, temperature range.
+ * @param  stats    [out]       Optional search statistics.
+ *
+ * @return          INVALID_INPUT for empty lists, zero length fragments or totals that differ.
+ *                  UNABLE_TO_FIND_SOLUTION if the budget runs out; the orders are then the lowest cost
+ *                  map seen. OK otherwise.
+ */
+
+ResultCode SolveDoubleDigest(
+    const vector<uint32_t>& fragsA,
+    const vector<uint32_t>& fragsB,
+    const vector<uint32_t>& fragsAB,
+    vector<uint32_t>& orderA,
+    vector<uint32_t>& orderB,
+    const DoubleDigestOptions& options,
+    DoubleDigestStats* stats
+)
+{
+    if (fragsA.empty() || fragsB.empty() || fragsAB.empty()) return INVALID_INPUT;
+    if (options.minTemp <= 0 || options.maxTemp < options.minTemp) return INVALID_INPUT;
+
+    uint64_t sums[3] = { 0, 0, 0 };
+    const vector<uint32_t>* lists[3] = { &fragsA, &fragsB, &fragsAB };
+
+    for (uint32_t l = 0; l < 3; l++)
+    {
+        for (auto frag : *lists[l])
+        {
+            if (frag == 0) return INVALID_INPUT;
+            sums[l] += frag;
+        }
+    }
+
+    if (sums[0] != sums[1] || sums[0] != sums[2] || sums[0] > UINT32_MAX) return INVALID_INPUT;
+
+    const uint32_t length = (uint32_t)sums[0];
+
+    vector<int32_t> target(length + 1, 0);
+    for (auto frag : fragsAB) target[frag]--;
+
+    const uint32_t numChains = options.numChains ? options.numChains : max(4u, 2 * GetWorkerCount());
+    const uint64_t seed      = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+
+    vector<DigestChain> chains;
+    vector<float> betas(numChains);
+    vector<uint32_t> chainAt(numChains);
+
+    for (uint32_t c = 0; c < numChains; c++)
+    {
+        chains.emplace_back(seed + c);
+        chains[c].Init(fragsA, fragsB, target);
+
+        const float frac = numChains > 1 ? (float)c / (float)(numChains - 1) : 0.0f;
+        betas[c]    = 1.0f / (options.minTemp * powf(options.maxTemp / options.minTemp, frac));
+        chainAt[c]  = c;
+    }
+
+    Rng rng(seed ^ 0xD1B54A32D192ED03ULL);
+    atomic<bool> solved(false);
+
+    uint32_t bestCost   = UINT32_MAX;
+    uint32_t round      = 0;
+    uint64_t exchanges  = 0;
+
+    vector<uint32_t> tempOf(numChains);
+
+    // A chain's best state is only kept at round boundaries; that's also where the result is read.
+
+    vector<uint32_t> bestA, bestB;
+
+    for (; round < options.maxRounds; round++)
+    {
+        for (uint32_t k = 0; k < numChains; k++) tempOf[chainAt[k]] = k;
+
+        ParallelFor(numChains, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t c = begin; c < end; c++)
+            {
+                chains[c].Run(options.movesPerRound, betas[tempOf[c]], solved);
+                if (chains[c].cost == 0) solved = true;
+            }
+        });
+
+        for (uint32_t c = 0; c < numChains; c++)
+        {
+            if (chains[c].cost < bestCost)
+            {
+                bestCost    = chains[c].cost;
+                bestA       = chains[c].frags[0];
+                bestB       = chains[c].frags[1];
+            }
+        }
+
+        if (bestCost == 0) break;
+
+        for (uint32_t k = round % 2; k + 1 < numChains; k += 2)
+        {
+            const float exponent = (betas[k] - betas[k + 1]) * ((float)chains[chainAt[k]].cost - (float)chains[chainAt[k + 1]].cost);
+
+            if (exponent >= 0 || rng.NextFloat() < expf(exponent))
+            {
+                swap(chainAt[k], chainAt[k + 1]);
+                exchanges++;
+            }
+        }
+    }
+
+    orderA = bestA;
+    orderB = bestB;
+
+    if (stats != nullptr)
+    {
+        stats->rounds       = min(round + 1, options.maxRounds);
+        stats->moves        = 0;
+        stats->exchanges    = exchanges;
+        stats->bestCost     = bestCost;
+
+        for (auto& chain : chains) stats->moves += chain.moves;
+    }
+
+    return bestCost == 0 ? OK : UNABLE_TO_FIND_SOLUTION;
+}
+
+/**
+ * IsDoubleDigestMap - Check that orders of A and B fragments reproduce the A+B fragments.
+ */
+
+static bool IsDoubleDigestMap(
+    const vector<uint32_t>& fragsA,
+    const vector<uint32_t>& fragsB,
+    const vector<uint32_t>& fragsAB,
+    const vector<uint32_t>& orderA,
+    const vector<uint32_t>& orderB
+)
+{
+    vector<uint32_t> sortedA(orderA), sortedB(orderB), expectA(fragsA), expectB(fragsB), expectAB(fragsAB);
+
+    sort(sortedA.begin(), sortedA.end());
+    sort(sortedB.begin(), sortedB.end());
+    sort(expectA.begin(), expectA.end());
+    sort(expectB.begin(), expectB.end());
+    sort(expectAB.begin(), expectAB.end());
+
+    if (sortedA != expectA || sortedB != expectB) return false;
+
+    vector<uint32_t> cuts;
+    uint32_t length = 0;
+
+    for (uint32_t i = 0; i < orderA.size(); i++)
+    {
+        length += orderA[i];
+        if (i + 1 < orderA.size()) cuts.push_back(length);
+    }
+
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i + 1 < orderB.size(); i++) cuts.push_back(pos += orderB[i]);
+
+    vector<uint32_t> combined;
+    return GetDigestFragments(cuts, length, combined) == OK && combined == expectAB;
+}
+
+/**
+ * GenerateDoubleDigest - Random double digest instance: distinct cut sites for each enzyme on a
+ * molecule of the given length, and the three fragment lists they produce.
+ */
+
+static void GenerateDoubleDigest(
+    const uint32_t length,
+    const uint32_t numFragsA,
+    const uint32_t numFragsB,
+    vector<uint32_t>& fragsA,
+    vector<uint32_t>& fragsB,
+    vector<uint32_t>& fragsAB
+)
+{
+    set<uint32_t> sitesA, sitesB;
+
+    while (sitesA.size() + 1 < numFragsA) sitesA.insert(1 + rand() % (length - 1));
+    while (sitesB.size() + 1 < numFragsB) sitesB.insert(1 + rand() % (length - 1));
+
+    vector<uint32_t> cutsA(sitesA.begin(), sitesA.end());
+    vector<uint32_t> cutsB(sitesB.begin(), sitesB.end());
+    vector<uint32_t> cutsAB(cutsA);
+    cutsAB.insert(cutsAB.end(), cutsB.begin(), cutsB.end());
+
+    fragsA.clear();
+    fragsB.clear();
+    fragsAB.clear();
+
+    GetDigestFragments(cutsA, length, fragsA);
+    GetDigestFragments(cutsB, length, fragsB);
+    GetDigestFragments(cutsAB, length, fragsAB);
+}
+
+/**
+ * DoubleDigest - Test routine for the double digest solver. Solves random instances of growing size
+ * and checks each returned map against the A+B fragments (not against the generating map, since
+ * double digests usually have several solutions), reporting time to solution. Also checks input
+ * validation and that an inconsistent digest runs out of budget instead of claiming a map.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+void DoubleDigest(vector<TestResult>& testResults)
+{
+    vector<uint32_t> frags;
+
+    if (GetDigestFragments({ 7, 3, 7 }, 10, frags) == OK && frags == vector<uint32_t>({ 3, 3, 4 }))
+        testResults.push_back({ "DoubleDigest::Fragments", PASS, "" });
+    else
+        testResults.push_back({ "DoubleDigest::Fragments", FAIL, "Wrong fragments for cuts 3 and 7 on length 10." });
+
+    struct { uint32_t length, numFragsA, numFragsB; } sizes[] =
+    {
+        { 1000, 4, 5 },
+        { 2000, 6, 7 },
+        { 5000, 8, 9 },
+        { 10000, 10, 11 }
+    };
+
+    const uint32_t numIters = 3;
+
+    for (auto& size : sizes)
+    {
+        for (uint32_t i = 0; i < numIters; i++)
+        {
+            vector<uint32_t> fragsA, fragsB, fragsAB, orderA, orderB;
+            GenerateDoubleDigest(size.length, size.numFragsA, size.numFragsB, fragsA, fragsB, fragsAB);
+
+            DoubleDigestStats stats;
+
+            long long t1    = GetMilliseconds();
+            ResultCode res  = SolveDoubleDigest(fragsA, fragsB, fragsAB, orderA, orderB, DoubleDigestOptions(), &stats);
+            long long t2    = GetMilliseconds();
+
+            const string testName = "DoubleDigest::Random[" + to_string(size.numFragsA) + "x" + to_string(size.numFragsB) + "][" + to_string(i) + "]";
+
+            char msg[128];
+            snprintf(msg, sizeof(msg), "T = %f sec, %u rounds, %llu moves.", ((float)t2 - (float)t1) / 1000.0f, stats.rounds, (unsigned long long)stats.moves);
+
+            if (res == OK && IsDoubleDigestMap(fragsA, fragsB, fragsAB, orderA, orderB))
+                testResults.push_back({ testName, PASS, msg });
+            else
+                testResults.push_back({ testName, FAIL, "No valid map found, best cost " + to_string(stats.bestCost) + ". " + msg });
+        }
+    }
+
+    // Two A fragments always leave at least two A+B fragments, so a single one can't be mapped.
+
+    vector<uint32_t> orderA, orderB;
+    DoubleDigestOptions small;
+    small.maxRounds = 20;
+
+    DoubleDigestStats stats;
+    ResultCode res = SolveDoubleDigest({ 3, 7 }, { 4, 6 }, { 10 }, orderA, orderB, small, &stats);
+
+    if (res == UNABLE_TO_FIND_SOLUTION && stats.bestCost > 0 && orderA.size() == 2 && orderB.size() == 2)
+        testResults.push_back({ "DoubleDigest::Inconsistent", PASS, "" });
+    else
+        testResults.push_back({ "DoubleDigest::Inconsistent", FAIL, "Inconsistent digest wasn't reported." });
+
+    const bool rejected =
+        SolveDoubleDigest({ 3, 7 }, { 4, 5 }, { 3, 1, 6 }, orderA, orderB) == INVALID_INPUT &&
+        SolveDoubleDigest({ 3, 0, 7 }, { 4, 6 }, { 3, 1, 6 }, orderA, orderB) == INVALID_INPUT &&
+        SolveDoubleDigest({}, { 4, 6 }, { 3, 1, 6 }, orderA, orderB) == INVALID_INPUT;
+
+    if (rejected) testResults.push_back({ "DoubleDigest::InvalidInput", PASS, "" });
+    else testResults.push_back({ "DoubleDigest::InvalidInput", FAIL, "Invalid digests weren't rejected." });
+}
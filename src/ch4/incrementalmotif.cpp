@@ -0,0 +1,637 @@
+#include "problems.h"
+#include "motif.h"
+#include "utils.h"
+#include "reporter.h"
+
+/*
+ * Incremental branch and bound motif search. The search is the same as FindMotif's, with two changes
+ * that make re-solving a slightly changed sequence set cheap:
+ *
+ *   - It starts from an incumbent: the previous optimal offsets for the sequences that are still there,
+ *     plus the best match to the previous profile for each new sequence. Any branch that can't beat
+ *     the carried over score is pruned from the start.
+ *   - Prefix counts are kept incrementally from per-sequence code tables, and the bound uses each
+ *     sequence's column masks: a remaining sequence can only add to a base's count in a column if that
+ *     base appears there at some offset. Tables are built once per sequence and carried over.
+ */
+
+static const uint32_t MOTIF_STATE_VERSION   = 2;
+static const char MOTIF_STATE_MAGIC[4]      = { 'B', 'P', 'M', 'S' };
+
+struct MotifStateHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t motifLen;
+    uint32_t nSeq;
+    uint32_t score;
+    uint32_t pad;
+};
+
+/**
+ * ConsensusCode - Base code as GetConsensus counts it: only upper case ACGT count towards a column.
+ */
+
+static inline uint8_t ConsensusCode(char base)
+{
+    switch (base)
+    {
+    case 'A': return 0;
+    case 'C': return 1;
+    case 'G': return 2;
+    case 'T': return 3;
+    default: return INVALID_BASE;
+    }
+}
+
+static void EncodeSeqCodes(const string& seq, MotifSeqTable& table)
+{
+    table.codes.resize(seq.length());
+    for (size_t i = 0; i < seq.length(); i++) table.codes[i] = ConsensusCode(seq[i]);
+}
+
+/**
+ * BuildSeqTable - Code table and column masks for one sequence.
+ */
+
+static void BuildSeqTable(const string& seq, const uint32_t motifLen, MotifSeqTable& table)
+{
+    EncodeSeqCodes(seq, table);
+
+    table.colMask.assign(motifLen, 0);
+
+    for (size_t o = 0; o + motifLen <= seq.length(); o++)
+    {
+        for (uint32_t c = 0; c < motifLen; c++)
+        {
+            const uint8_t code = table.codes[o + c];
+            if (code != INVALID_BASE) table.colMask[c] |= (uint8_t)(1 << code);
+        }
+    }
+}
+
+/*
+ * Search scratch. counts has a fifth row soaking up non-ACGT bases; avail[d] holds, per base and
+ * column, how many of the sequences from depth d on can still add to that count.
+ */
+
+struct IncrementalSearch
+{
+    const uint32_t k;
+    const uint32_t n;
+    vector<const MotifSeqTable*> tables;
+    vector<uint32_t> numOffsets;
+    vector<uint32_t> counts;
+    vector<uint32_t> avail;
+    uint64_t nodes;
+
+    IncrementalSearch(const vector<MotifSeqTable>& seqTables, const uint32_t motifLen) :
+        k(motifLen), n((uint32_t)seqTables.size()), tables(n), numOffsets(n), counts((INVALID_BASE + 1) * motifLen, 0),
+        avail((size_t)(n + 1) * 4 * motifLen, 0), nodes(0)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            tables[i]       = &seqTables[i];
+            numOffsets[i]   = (uint32_t)seqTables[i].codes.size() - k + 1;
+        }
+
+        for (uint32_t d = n; d-- > 0;)
+        {
+            uint32_t* row           = &avail[(size_t)d * 4 * k];
+            const uint32_t* next    = row + 4 * k;
+
+            for (uint32_t b = 0; b < 4; b++)
+                for (uint32_t c = 0; c < k; c++)
+                    row[b * k + c] = next[b * k + c] + ((tables[d]->colMask[c] >> b) & 1);
+        }
+    }
+
+    void AddWindow(uint32_t seq, uint32_t offset, int32_t delta)
+    {
+        const uint8_t* window = &tables[seq]->codes[offset];
+        for (uint32_t c = 0; c < k; c++) counts[window[c] * k + c] += delta;
+    }
+
+    uint32_t Score() const
+    {
+        uint32_t score = 0;
+
+        for (uint32_t c = 0; c < k; c++)
+            score += max(max(counts[c], counts[k + c]), max(counts[2 * k + c], counts[3 * k + c]));
+
+        return score;
+    }
+
+    uint32_t Bound(uint32_t depth) const
+    {
+        const uint32_t* row = &avail[(size_t)depth * 4 * k];
+        uint32_t bound      = 0;
+
+        for (uint32_t c = 0; c < k; c++)
+        {
+            uint32_t best = 0;
+            for (uint32_t b = 0; b < 4; b++) best = max(best, counts[b * k + c] + row[b * k + c]);
+            bound += best;
+        }
+
+        return bound;
+    }
+
+    /**
+     * Run - Depth first search over one offset per sequence, keeping offsets (initially the incumbent)
+     * unless something strictly better turns up.
+     */
+
+    uint32_t Run(vector<uint32_t>& offsets, uint32_t bestScore)
+    {
+        vector<uint32_t> cur(n, 0);
+        vector<uint32_t> next(n, 0);
+        uint32_t depth = 0;
+
+        while (1)
+        {
+            if (next[depth] >= numOffsets[depth])
+            {
+                next[depth] = 0;
+                if (depth == 0) break;
+
+                depth--;
+                AddWindow(depth, cur[depth], -1);
+                continue;
+            }
+
+            cur[depth] = next[depth]++;
+            AddWindow(depth, cur[depth], 1);
+            nodes++;
+
+            if (depth + 1 == n)
+            {
+                const uint32_t score = Score();
+
+                if (score > bestScore)
+                {
+                    bestScore   = score;
+                    offsets     = cur;
+                }
+
+                AddWindow(depth, cur[depth], -1);
+            }
+            else if (Bound(depth + 1) > bestScore)
+                depth++;
+            else
+                AddWindow(depth, cur[depth], -1);
+        }
+
+        return bestScore;
+    }
+};
+
+/**
+ * GetProfileOffset - Offset of a sequence's window that agrees most with a profile's counts.
+ */
+
+static uint32_t GetProfileOffset(const MotifSeqTable& table, const vector<uint32_t>& profile, const uint32_t motifLen)
+{
+    uint32_t best       = 0;
+    uint32_t bestScore  = 0;
+
+    for (uint32_t o = 0; o + motifLen <= table.codes.size(); o++)
+    {
+        uint32_t score = 0;
+
+        for (uint32_t c = 0; c < motifLen; c++)
+        {
+            const uint8_t code = table.codes[o + c];
+            if (code != INVALID_BASE) score += profile[code * motifLen + c];
+        }
+
+        if (score > bestScore)
+        {
+            bestScore   = score;
+            best        = o;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * UpdateProfile - Recount a state's profile from its tables and offsets.
+ *
+ * @return Consensus score of the offsets.
+ */
+
+static uint32_t UpdateProfile(MotifSearchState& state)
+{
+    const uint32_t motifLen = state.motifLen;
+    uint32_t score          = 0;
+
+    state.profile.assign(state.seqs.empty() ? 0 : 4 * (size_t)motifLen, 0);
+
+    for (uint32_t i = 0; i < state.seqs.size(); i++)
+    {
+        for (uint32_t c = 0; c < motifLen; c++)
+        {
+            const uint8_t code = state.tables[i].codes[state.offsets[i] + c];
+            if (code != INVALID_BASE) state.profile[code * motifLen + c]++;
+        }
+    }
+
+    for (uint32_t c = 0; c < motifLen && !state.profile.empty(); c++)
+    {
+        const uint32_t* col = &state.profile[c];
+        score += max(max(col[0], col[motifLen]), max(col[2 * motifLen], col[3 * motifLen]));
+    }
+
+    return score;
+}
+
+/**
+ * Clear - Forget the previous solution.
+ */
+
+void MotifSearchState::Clear()
+{
+    motifLen    = 0;
+    score       = 0;
+
+    seqs.clear();
+    offsets.clear();
+    profile.clear();
+    tables.clear();
+}
+
+static void AppendBytes(string& out, const void* data, size_t len)
+{
+    out.append((const char*)data, len);
+}
+
+/**
+ * Save - Write the state to a file: a MotifStateHeader, then per sequence its length, offset and bases.
+ * Everything else is derived from those on load, so a damaged file can't hand the search a column mask
+ * that prunes the optimum.
+ *
+ * @param  path [in]    File to write, overwritten.
+ *
+ * @return      IO_ERROR if the file can't be written. OK otherwise.
+ */
+
+ResultCode MotifSearchState::Save(const char* path) const
+{
+    MotifStateHeader header = {};
+
+    memcpy(header.magic, MOTIF_STATE_MAGIC, sizeof(header.magic));
+    header.version  = MOTIF_STATE_VERSION;
+    header.motifLen = motifLen;
+    header.nSeq     = (uint32_t)seqs.size();
+    header.score    = score;
+
+    string out;
+    AppendBytes(out, &header, sizeof(header));
+
+    for (uint32_t i = 0; i < seqs.size(); i++)
+    {
+        const uint32_t len = (uint32_t)seqs[i].length();
+
+        AppendBytes(out, &len, sizeof(len));
+        AppendBytes(out, &offsets[i], sizeof(uint32_t));
+        AppendBytes(out, seqs[i].data(), len);
+    }
+
+    return WriteStringToFile(path, out) ? OK : IO_ERROR;
+}
+
+/**
+ * Load - Read a state written by Save, replacing this one. Code tables and column masks are rebuilt
+ * from the bases, and the profile from the offsets; a score that doesn't match them is rejected.
+ *
+ * @param  path [in]    File to read.
+ *
+ * @return      IO_ERROR if the file can't be read, INVALID_INPUT if it isn't a valid state file. OK otherwise.
+ */
+
+ResultCode MotifSearchState::Load(const char* path)
+{
+    Clear();
+
+    string contents;
+    if (!ReadFileToString(path, contents)) return IO_ERROR;
+
+    size_t pos = 0;
+
+    auto take = [&](void* dst, size_t len)
+    {
+        if (contents.size() - pos < len) return false;
+
+        memcpy(dst, &contents[pos], len);
+        pos += len;
+        return true;
+    };
+
+    MotifStateHeader header;
+
+    if (!take(&header, sizeof(header)) || memcmp(header.magic, MOTIF_STATE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MOTIF_STATE_VERSION || header.motifLen == 0)
+        return INVALID_INPUT;
+
+    // Every sequence takes at least its length, its offset and motifLen bases, which bounds nSeq by the
+    // rest of the file before anything is allocated for it.
+
+    const size_t minSeqBytes = 2 * sizeof(uint32_t) + (size_t)header.motifLen;
+
+    if (header.nSeq > (contents.size() - pos) / minSeqBytes) return INVALID_INPUT;
+
+    seqs.resize(header.nSeq);
+    offsets.resize(header.nSeq);
+    tables.resize(header.nSeq);
+
+    for (uint32_t i = 0; i < header.nSeq; i++)
+    {
+        uint32_t len;
+        if (!take(&len, sizeof(len)) || !take(&offsets[i], sizeof(uint32_t)) || len < header.motifLen ||
+            offsets[i] > len - header.motifLen || contents.size() - pos < len)
+        {
+            Clear();
+            return INVALID_INPUT;
+        }
+
+        seqs[i].assign(&contents[pos], len);
+        pos += len;
+
+        BuildSeqTable(seqs[i], header.motifLen, tables[i]);
+    }
+
+    motifLen    = header.motifLen;
+    score       = UpdateProfile(*this);
+
+    if (pos != contents.size() || score != header.score)
+    {
+        Clear();
+        return INVALID_INPUT;
+    }
+
+    return OK;
+}
+
+/**
+ * FindMotifIncremental - FindMotif that reuses the previous call's work. Sequences are matched to the
+ * previous set by content, in any order; matched sequences keep their tables and their optimal offsets
+ * seed the search, and new sequences get tables built and a starting offset from the previous profile.
+ * The result is optimal for the new set like a cold FindMotif, and the state is updated to it.
+ *
+ * @param  seqs     [in]        Sequences to search for a motif.
+ * @param  motifLen [in]        Length of desired motif. A different length than the state's starts cold.
+ * @param  state    [in/out]    Previous solution, empty for a cold search. Updated to this one.
+ * @param  offsets  [out]       A set of offsets into each input sequence that produces the best motif match.
+ * @param  stats    [out]       Optional counts of kept, added and removed sequences and search effort.
+ *
+ * @return          INVALID_INPUT if there are no sequences, the motif length is zero or a sequence is shorter
+ *                  than the motif. OK otherwise.
+ */
+
+ResultCode FindMotifIncremental(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    MotifSearchState& state,
+    vector<uint32_t>& offsets,
+    MotifIncrementalStats* stats
+)
+{
+    if (seqs.empty() || motifLen == 0) return INVALID_INPUT;
+    for (auto& seq : seqs) if (seq.length() < motifLen) return INVALID_INPUT;
+
+    if (state.motifLen != motifLen) state.Clear();
+
+    // Match sequences to the previous set. Duplicates are matched one for one.
+
+    unordered_map<string, vector<uint32_t>> previous;
+    for (uint32_t i = state.seqs.size(); i-- > 0;) previous[state.seqs[i]].push_back(i);
+
+    const uint32_t n = (uint32_t)seqs.size();
+
+    vector<MotifSeqTable> tables(n);
+    vector<uint32_t> incumbent(n, 0);
+    MotifIncrementalStats localStats = {};
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        auto it = previous.find(seqs[i]);
+
+        if (it != previous.end() && !it->second.empty())
+        {
+            const uint32_t prev = it->second.back();
+            it->second.pop_back();
+
+            tables[i]       = move(state.tables[prev]);
+            incumbent[i]    = state.offsets[prev];
+            localStats.keptSeqs++;
+        }
+        else
+        {
+            BuildSeqTable(seqs[i], motifLen, tables[i]);
+            if (!state.profile.empty()) incumbent[i] = GetProfileOffset(tables[i], state.profile, motifLen);
+            localStats.addedSeqs++;
+        }
+    }
+
+    localStats.removedSeqs = (uint32_t)state.seqs.size() - localStats.keptSeqs;
+
+    // Score the carried over solution and search from it.
+
+    IncrementalSearch search(tables, motifLen);
+
+    for (uint32_t i = 0; i < n; i++) search.AddWindow(i, incumbent[i], 1);
+    localStats.warmScore = search.Score();
+    for (uint32_t i = 0; i < n; i++) search.AddWindow(i, incumbent[i], -1);
+
+    offsets = incumbent;
+    const uint32_t score = search.Run(offsets, localStats.warmScore);
+
+    localStats.nodes = search.nodes;
+
+    // Keep this solution for the next call.
+
+    state.motifLen  = motifLen;
+    state.score     = score;
+    state.seqs      = seqs;
+    state.offsets   = offsets;
+    state.tables    = move(tables);
+
+    UpdateProfile(state);
+
+    if (stats) *stats = localStats;
+
+    return OK;
+}
+
+/**
+ * CheckAgainstCold - Run FindMotifIncremental against the state and compare its score with a cold
+ * FindMotif and with the score its own offsets give. Node counts of the warm and a cold incremental
+ * search are reported.
+ */
+
+static void CheckAgainstCold(
+    vector<TestResult>& testResults,
+    const char* name,
+    const uint32_t caseIndex,
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    MotifSearchState& state
+)
+{
+    vector<uint32_t> warmOffsets;
+    vector<uint32_t> coldOffsets;
+    vector<uint32_t> exactOffsets;
+    MotifSearchState coldState;
+    MotifIncrementalStats warmStats;
+    MotifIncrementalStats coldStats;
+
+    FindMotifIncremental(seqs, motifLen, state, warmOffsets, &warmStats);
+    FindMotifIncremental(seqs, motifLen, coldState, coldOffsets, &coldStats);
+    FindMotif(seqs, motifLen, exactOffsets);
+
+    const uint32_t nSeq         = (uint32_t)seqs.size();
+    const uint32_t warmScore    = GetConsensus(seqs, nSeq, warmOffsets, motifLen);
+    const uint32_t coldScore    = GetConsensus(seqs, nSeq, coldOffsets, motifLen);
+    const uint32_t exactScore   = GetConsensus(seqs, nSeq, exactOffsets, motifLen);
+
+    const string msg = "kept " + to_string(warmStats.keptSeqs) + ", added " + to_string(warmStats.addedSeqs) + ", removed " +
+                       to_string(warmStats.removedSeqs) + ", start " + to_string(warmStats.warmScore) + "/" + to_string(exactScore) +
+                       ", nodes " + to_string(warmStats.nodes) + " vs " + to_string(coldStats.nodes) + " cold.";
+
+    if (warmScore == exactScore && coldScore == exactScore && state.score == exactScore)
+        ReportTestCase(testResults, name, caseIndex, PASS, msg);
+    else
+        ReportTestCase(testResults, name, caseIndex, FAIL, "Score " + to_string(warmScore) + ", cold " + to_string(coldScore) +
+                       ", FindMotif " + to_string(exactScore) + ". " + msg);
+}
+
+/**
+ * TestAppendRemove - Solve a planted set, then re-solve after appending sequences, after removing one
+ * and after shuffling the order, checking each against a cold search.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestAppendRemove(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 5;
+    const uint32_t nSeq     = 8;
+    const uint32_t seqLen   = 20;
+    const uint32_t motifLen = 6;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted, 1);
+
+        MotifSearchState state;
+        vector<uint32_t> offsets;
+
+        vector<string> subset(seqs.begin(), seqs.begin() + nSeq - 2);
+        FindMotifIncremental(subset, motifLen, state, offsets);
+
+        CheckAgainstCold(testResults, "IncrMotif::Append", i, seqs, motifLen, state);
+
+        seqs.erase(seqs.begin() + rand() % nSeq);
+        CheckAgainstCold(testResults, "IncrMotif::Remove", i, seqs, motifLen, state);
+
+        for (uint32_t j = (uint32_t)seqs.size(); j > 1; j--) swap(seqs[j - 1], seqs[rand() % j]);
+        CheckAgainstCold(testResults, "IncrMotif::Reorder", i, seqs, motifLen, state);
+    }
+}
+
+/**
+ * TestSaveLoad - A state saved and loaded again must resume exactly like the one kept in memory, and
+ * damaged state files must be refused.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestSaveLoad(vector<TestResult>& testResults)
+{
+    const uint32_t motifLen = 5;
+
+    vector<string> seqs;
+    string motif;
+    vector<uint32_t> planted;
+
+    GenerateMotifSequences(7, 18, motifLen, seqs, motif, planted, 1);
+    seqs[3][5] = 'N';
+
+    const string path = GetTempFilePath("incrmotif_state.bin");
+
+    MotifSearchState state;
+    MotifSearchState loaded;
+    vector<uint32_t> offsets;
+    vector<uint32_t> loadedOffsets;
+
+    vector<string> subset(seqs.begin(), seqs.end() - 1);
+    FindMotifIncremental(subset, motifLen, state, offsets);
+
+    if (state.Save(path.c_str()) != OK || loaded.Load(path.c_str()) != OK)
+    {
+        testResults.push_back({ "IncrMotif::SaveLoad", EXECUTION_ERROR, "Unable to save/load " + path });
+        return;
+    }
+
+    DeleteFileA(path.c_str());
+
+    bool match = loaded.score == state.score && loaded.seqs == state.seqs && loaded.offsets == state.offsets &&
+                 loaded.profile == state.profile;
+
+    for (uint32_t i = 0; match && i < state.tables.size(); i++)
+        match = loaded.tables[i].codes == state.tables[i].codes && loaded.tables[i].colMask == state.tables[i].colMask;
+
+    FindMotifIncremental(seqs, motifLen, state, offsets);
+    FindMotifIncremental(seqs, motifLen, loaded, loadedOffsets);
+
+    if (match && offsets == loadedOffsets)
+        testResults.push_back({ "IncrMotif::SaveLoad", PASS, "" });
+    else
+        testResults.push_back({ "IncrMotif::SaveLoad", FAIL, "Loaded state differs from the saved one." });
+
+    CheckAgainstCold(testResults, "IncrMotif::Loaded", TEST_NO_INDEX, seqs, motifLen, loaded);
+
+    // Damaged files are refused: a sequence count far beyond the file, and a score the offsets don't give.
+
+    bool refused = true;
+
+    for (uint32_t c = 0; c < 2 && refused; c++)
+    {
+        MotifStateHeader header;
+        string contents;
+
+        refused = state.Save(path.c_str()) == OK && ReadFileToString(path, contents) && contents.size() >= sizeof(header);
+        if (refused) memcpy(&header, contents.data(), sizeof(header));
+
+        if (c == 0) header.nSeq = ~0u;
+        else header.score++;
+
+        if (refused) memcpy(&contents[0], &header, sizeof(header));
+
+        refused = refused && WriteStringToFile(path, contents);
+
+        refused = refused && loaded.Load(path.c_str()) == INVALID_INPUT && loaded.seqs.empty();
+    }
+
+    DeleteFileA(path.c_str());
+
+    if (refused) testResults.push_back({ "IncrMotif::DamagedState", PASS, "" });
+    else testResults.push_back({ "IncrMotif::DamagedState", FAIL, "A damaged state file was accepted." });
+}
+
+/**
+ * IncrementalMotif - Tests for incremental motif search.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void IncrementalMotif(vector<TestResult>& testResults)
+{
+    TestAppendRemove(testResults);
+    TestSaveLoad(testResults);
+}
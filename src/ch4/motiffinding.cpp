@@ -1,8 +1,16 @@
 #include "problems.h"
+#include "motif.h"
+#include "arena.h"
+#include "reporter.h"
+
+#include <array>
+#include <utility>
 
 /**
  * GenerateMotifSequences - Create a list of N random ACTG sequences of length L with a random motif of
- * length K <= L with the motif randomly embedded at different locations in the generated sequences.
+ * length K <= L with the motif randomly embedded at different locations in the generated sequences. If a
+ * mismatch count D is given, each embedded copy has exactly D randomly chosen bases changed, as in the
+ * planted (L, D) motif problem.
  *
  * @param  nSeq     [in]            Number of sequences to generate.
  * @param  seqLen   [in]            Length of the generated sequences.
@@ -10,20 +18,24 @@
  * @param  seqs     [in/out]        List of sequences to populate in this function.
  * @param  motif    [in/out]        Motif generated by this function.
  * @param  offsets  [description]   Offset of motif in each generated sequence.
+ * @param  numMismatches [in]       Number of bases to mutate in each embedded copy. Defaults to zero.
  *
- * @return           INVALID_INPUT if motif length greater than sequence length. Otherwise OK after sequences generated.
+ * @return           INVALID_INPUT if motif length greater than sequence length or more mismatches
+ *                   than motif bases. Otherwise OK after sequences generated.
  */
 
-static ResultCode GenerateMotifSequences(
+ResultCode GenerateMotifSequences(
     const uint32_t nSeq,
     const uint32_t seqLen,
     const uint32_t motifLen,
     vector<string>& seqs,
     string& motif,
-    vector<uint32_t> &offsets
+    vector<uint32_t> &offsets,
+    const uint32_t numMismatches
 )
 {
     if (motifLen > seqLen) return INVALID_INPUT;
+    if (numMismatches > motifLen) return INVALID_INPUT;
 
     const char bases[4] = { 'A', 'C', 'T', 'G' };
     
@@ -31,61 +43,99 @@ static ResultCode GenerateMotifSequences(
 
     const uint32_t offsetRange = seqLen - motifLen;
 
+    // Build each sequence in place in the output list rather than growing and copying a local string.
+
+    seqs.reserve(seqs.size() + nSeq);
+    offsets.reserve(offsets.size() + nSeq);
+
+    vector<uint32_t> positions(motifLen);
+
     for (uint32_t i = 0; i < nSeq; i++)
     {
-        string curSeq = "";
-        for (uint32_t j = 0; j < seqLen; j++) curSeq += bases[rand() % 4];
+        seqs.emplace_back(seqLen, 'A');
+        string& curSeq = seqs.back();
+
+        for (uint32_t j = 0; j < seqLen; j++) curSeq[j] = bases[rand() % 4];
+
+        const uint32_t offset = rand() % (offsetRange + 1);
+        offsets.push_back(offset);
+        memcpy(&curSeq[0] + offset, &motif[0], motifLen);
 
-        offsets.push_back(rand() % offsetRange);
-        memcpy(&curSeq[0] + offsets[i], &motif[0], motifLen);
-        seqs.push_back(curSeq);
+        // Mutate D distinct positions of the embedded copy, each to a different base.
+
+        for (uint32_t j = 0; j < motifLen; j++) positions[j] = j;
+
+        for (uint32_t j = 0; j < numMismatches; j++)
+        {
+            swap(positions[j], positions[j + rand() % (motifLen - j)]);
+
+            char& base      = curSeq[offset + positions[j]];
+            uint32_t idx    = (uint32_t)(find(bases, bases + 4, base) - bases);
+            base            = bases[(idx + 1 + rand() % 3) % 4];
+        }
     }
 
     return OK;
 }
 
+/*
+ * Search stack entry. Children are visited in offset order, so the next unsearched child is a counter
+ * rather than a flag per child.
+ */
+
 struct SearchNode
 {
     uint32_t offsetVal;
     uint32_t prefixScore;
-    vector<bool> childOffsetSearched;
-    
-    SearchNode(uint32_t curOFfset, uint32_t numChildren) : prefixScore(0), offsetVal(curOFfset) 
-    { 
-        childOffsetSearched.resize(numChildren, false); 
+    uint32_t nextChild;
+
+    SearchNode(uint32_t curOffset) : offsetVal(curOffset), prefixScore(0), nextChild(0) {}
+};
+
+/*
+ * Motif length specialization. GetConsensus and the FindMotif search are instantiated for each motif
+ * length from MOTIF_FIXED_MIN_LEN to MOTIF_FIXED_MAX_LEN, so count tables live on the stack and the
+ * per-column loops have constant trip counts the compiler can unroll. Other lengths use the runtime
+ * length versions.
+ */
+
+const uint32_t MOTIF_FIXED_MIN_LEN = 4;
+const uint32_t MOTIF_FIXED_MAX_LEN = 32;
+
+struct ConsensusCodeTable
+{
+    uint8_t codes[256];
+
+    ConsensusCodeTable()
+    {
+        memset(codes, INVALID_BASE, sizeof(codes));
+        codes['A'] = 0;
+        codes['C'] = 1;
+        codes['G'] = 2;
+        codes['T'] = 3;
     }
 };
 
+static const ConsensusCodeTable consensusCodes;
+
 /**
- * GetConsensus - Given a list of sequences, a motif length K to search for, and offsets into input
- * sequences, compute a "consensus" score. For each index 0 <= n <= k, count the occurrences
- * of A/C/T/G across the sequences at their input offsets. Whichever base has the highest count, add its count
- * to the total score. Sum across motif length. A prefix length P can be used to score from the first P offsets. 
- * This can be used to compute a bound on the highest possible score for all remaining offsets, which can be used
- * to rule certain search branches.
- *
- * High scores mean highly similar substrings for the current offsets, 
- * low scores mean disimilar substrings.
- *
- * @param  seqs         [in] List of sequences to search for motif.
- * @param  prefixLen    [in] How many of the input sequences to use for scoring if checking a prefix.
- * @param  offsets      [in] Offset into each sequence for consensus score computation.
- * @param  motifLen     [in] Length of the motif we're searching for.
- *
- * @return              Consensus score at current offsets.
+ * GetConsensusRuntime - Consensus score for a motif length only known at runtime. See GetConsensus.
+ * The count table comes from the thread's scratch pool.
  */
 
-uint32_t GetConsensus(
+static uint32_t GetConsensusRuntime(
     const vector<string>& seqs,
     const uint32_t prefixLen,
-    const vector<uint32_t>& offsets,
+    const uint32_t* offsets,
     const uint32_t motifLen
 )
 {
-    vector<uint32_t> aScore(motifLen, 0);
-    vector<uint32_t> tScore(motifLen, 0);
-    vector<uint32_t> cScore(motifLen, 0);
-    vector<uint32_t> gScore(motifLen, 0);
+    pmr::vector<uint32_t> counts(4 * (size_t)motifLen, 0, GetThreadArena().Pool());
+
+    uint32_t* aScore = &counts[0];
+    uint32_t* tScore = aScore + motifLen;
+    uint32_t* cScore = tScore + motifLen;
+    uint32_t* gScore = cScore + motifLen;
 
     uint32_t consensus = 0;
 
@@ -137,45 +187,135 @@ uint32_t GetConsensus(
 }
 
 /**
- * FindMotif - Search for a motif (common substring) of length K in a list of sequences of length L >= K.
+ * GetConsensusFixed - Consensus score for a compile-time motif length K. Counts sit in a stack array
+ * with a fifth row soaking up non-ACGT characters, so counting is branch free.
+ */
+
+template<uint32_t K>
+static uint32_t GetConsensusFixed(
+    const vector<string>& seqs,
+    const uint32_t prefixLen,
+    const uint32_t* offsets,
+    const uint32_t
+)
+{
+    uint32_t counts[INVALID_BASE + 1][K] = {};
+
+    for (uint32_t i = 0; i < prefixLen; i++)
+    {
+        const uint8_t* window = (const uint8_t*)seqs[i].data() + offsets[i];
+        for (uint32_t j = 0; j < K; j++) counts[consensusCodes.codes[window[j]]][j]++;
+    }
+
+    uint32_t consensus = 0;
+
+    for (uint32_t j = 0; j < K; j++)
+        consensus += max(max(counts[0][j], counts[1][j]), max(counts[2][j], counts[3][j]));
+
+    return consensus;
+}
+
+typedef uint32_t(*ConsensusKernel)(const vector<string>&, const uint32_t, const uint32_t*, const uint32_t);
+
+template<uint32_t... Ks>
+static constexpr array<ConsensusKernel, sizeof...(Ks)> MakeConsensusKernels(integer_sequence<uint32_t, Ks...>)
+{
+    return {{ &GetConsensusFixed<MOTIF_FIXED_MIN_LEN + Ks>... }};
+}
+
+static const auto consensusKernels = MakeConsensusKernels(
+    make_integer_sequence<uint32_t, MOTIF_FIXED_MAX_LEN - MOTIF_FIXED_MIN_LEN + 1>());
+
+/**
+ * GetConsensus - Given a list of sequences, a motif length K to search for, and offsets into input
+ * sequences, compute a "consensus" score. For each index 0 <= n <= k, count the occurrences
+ * of A/C/T/G across the sequences at their input offsets. Whichever base has the highest count, add its count
+ * to the total score. Sum across motif length. A prefix length P can be used to score from the first P offsets. 
+ * This can be used to compute a bound on the highest possible score for all remaining offsets, which can be used
+ * to rule certain search branches.
  *
- * @param  seqs     [in]    Sequences to search for a motif.
- * @param  motifLen [in]    Length of desired motif.
- * @param  offsets  [out]   A set of offsets into each input sequence that produces the best motif match.
+ * High scores mean highly similar substrings for the current offsets, 
+ * low scores mean disimilar substrings.
+ *
+ * @param  seqs         [in] List of sequences to search for motif.
+ * @param  prefixLen    [in] How many of the input sequences to use for scoring if checking a prefix.
+ * @param  offsets      [in] Offset into each sequence for consensus score computation.
+ * @param  motifLen     [in] Length of the motif we're searching for.
  *
- * @return          INVALID_INPUT of desired motif length greater than input sequence lengths. OK otherwise.
+ * @return              Consensus score at current offsets.
  */
 
-ResultCode FindMotif(const vector<string>& seqs, const uint32_t motifLen, vector<uint32_t>& offsets)
+uint32_t GetConsensus(
+    const vector<string>& seqs,
+    const uint32_t prefixLen,
+    const vector<uint32_t>& offsets,
+    const uint32_t motifLen
+)
 {
-    if (motifLen > seqs[0].length()) return INVALID_INPUT;
+    if (prefixLen == 0) return 0;
+
+    if (motifLen >= MOTIF_FIXED_MIN_LEN && motifLen <= MOTIF_FIXED_MAX_LEN)
+        return consensusKernels[motifLen - MOTIF_FIXED_MIN_LEN](seqs, prefixLen, &offsets[0], motifLen);
+
+    return GetConsensusRuntime(seqs, prefixLen, &offsets[0], motifLen);
+}
+
+/**
+ * FindMotifSearch - Branch and bound search behind FindMotif. K is the motif length when specialized,
+ * or zero to use the runtime length. An incumbent, if given, is the starting best solution, so every
+ * branch that can't beat it is pruned from the start.
+ */
 
-    vector<SearchNode> stack;
+template<uint32_t K>
+static void FindMotifSearch(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t* incumbent,
+    vector<uint32_t>& offsets
+)
+{
+    pmr::memory_resource* mem = GetThreadArena().Pool();
+    pmr::vector<SearchNode> stack(mem);
 
     const uint32_t seqLen       = seqs[0].length();
     const uint32_t offsetRange  = seqLen - motifLen;
+    const uint32_t nSeq         = (uint32_t)seqs.size();
+
+    auto consensus = [&](uint32_t prefixLen, const uint32_t* curOffsets)
+    {
+        if constexpr (K != 0) return GetConsensusFixed<K>(seqs, prefixLen, curOffsets, K);
+        else return GetConsensusRuntime(seqs, prefixLen, curOffsets, motifLen);
+    };
 
-    offsets.resize(seqs.size(), 0);
+    offsets.resize(nSeq, 0);
     uint32_t bestScore = 0;
 
-    for (uint32_t i = 0; i < seqLen; i++)
+    if (incumbent)
     {
-        stack.push_back(SearchNode(i, offsetRange));
+        memcpy(&offsets[0], incumbent, nSeq * sizeof(uint32_t));
+        bestScore = consensus(nSeq, incumbent);
+    }
+
+    pmr::vector<uint32_t> curOffsets(nSeq, 0, mem);
+    stack.reserve(nSeq);
+
+    for (uint32_t i = 0; i <= offsetRange; i++)
+    {
+        stack.push_back(SearchNode(i));
 
         while (!stack.empty())
         {
             // We searched down into a leaf. Get its consensus score.
 
-            if (stack.size() == seqs.size())
+            if (stack.size() == nSeq)
             {
-                vector<uint32_t> curOffsets(seqs.size(), 0);
                 for (uint32_t j = 0; j < stack.size(); j++) curOffsets[j] = stack[j].offsetVal;
-                uint32_t curScore = GetConsensus(seqs, seqs.size(), curOffsets, motifLen);
+                uint32_t curScore = consensus(nSeq, &curOffsets[0]);
 
                 if (curScore > bestScore)
                 {
                     bestScore = curScore;
-                    memcpy(&offsets[0], &curOffsets[0], seqs.size() * sizeof(uint32_t));
+                    memcpy(&offsets[0], &curOffsets[0], nSeq * sizeof(uint32_t));
                 }
 
                 stack.pop_back();
@@ -189,59 +329,208 @@ ResultCode FindMotif(const vector<string>& seqs, const uint32_t motifLen, vector
 
             if (cur.prefixScore == 0)
             {
-                vector<uint32_t> curOffsets(stack.size(), 0);
                 for (uint32_t j = 0; j < stack.size(); j++) curOffsets[j] = stack[j].offsetVal;
-                cur.prefixScore = GetConsensus(seqs, stack.size(), curOffsets, motifLen);
+                cur.prefixScore = consensus((uint32_t)stack.size(), &curOffsets[0]);
             }
 
-            uint32_t childScoreBound = (seqs.size() - stack.size()) * motifLen;
+            uint32_t childScoreBound = (nSeq - (uint32_t)stack.size()) * motifLen;
 
             if (cur.prefixScore + childScoreBound > bestScore)
             {
-                bool allChildrenSearched = true;
-
-                for (uint32_t j = 0; j < cur.childOffsetSearched.size(); j++)
-                {
-                    if (!cur.childOffsetSearched[j])
-                    {
-                        cur.childOffsetSearched[j] = true;
-                        stack.push_back(SearchNode(j, offsetRange));
-                        allChildrenSearched = false;
-                        break;
-                    }
-                }
-
-                if (allChildrenSearched) stack.pop_back();
+                if (cur.nextChild <= offsetRange) stack.push_back(SearchNode(cur.nextChild++));
+                else stack.pop_back();
             }
             else
                 stack.pop_back();
         }
     }
+}
+
+typedef void(*SearchKernel)(const vector<string>&, const uint32_t, const uint32_t*, vector<uint32_t>&);
+
+template<uint32_t... Ks>
+static constexpr array<SearchKernel, sizeof...(Ks)> MakeSearchKernels(integer_sequence<uint32_t, Ks...>)
+{
+    return {{ &FindMotifSearch<MOTIF_FIXED_MIN_LEN + Ks>... }};
+}
+
+static const auto searchKernels = MakeSearchKernels(
+    make_integer_sequence<uint32_t, MOTIF_FIXED_MAX_LEN - MOTIF_FIXED_MIN_LEN + 1>());
+
+/**
+ * FindMotif - Search for a motif (common substring) of length K in a list of sequences of length L >= K.
+ *
+ * @param  seqs      [in]    Sequences to search for a motif.
+ * @param  motifLen  [in]    Length of desired motif.
+ * @param  offsets   [out]   A set of offsets into each input sequence that produces the best motif match.
+ * @param  incumbent [in]    Optional known solution (e.g. from a k-mer candidate) to start the bound from.
+ *                           The result is still optimal; it is the incumbent unless something beats it.
+ *
+ * @return          INVALID_INPUT of desired motif length greater than input sequence lengths or an incumbent
+ *                  offset out of range. OK otherwise.
+ */
+
+ResultCode FindMotif(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    vector<uint32_t>& offsets,
+    const vector<uint32_t>* incumbent
+)
+{
+    if (motifLen > seqs[0].length()) return INVALID_INPUT;
+
+    const uint32_t* start = nullptr;
+
+    if (incumbent)
+    {
+        if (incumbent->size() != seqs.size()) return INVALID_INPUT;
+        for (auto off : *incumbent) if (off > seqs[0].length() - motifLen) return INVALID_INPUT;
+
+        start = &(*incumbent)[0];
+    }
+
+    if (motifLen >= MOTIF_FIXED_MIN_LEN && motifLen <= MOTIF_FIXED_MAX_LEN)
+        searchKernels[motifLen - MOTIF_FIXED_MIN_LEN](seqs, motifLen, start, offsets);
+    else
+        FindMotifSearch<0>(seqs, motifLen, start, offsets);
 
     return OK;
 }
 
 /**
- * MotifFinding - Test routine for motif finding algorithm above.
+ * TestSpecializedKernels - Check the fixed length consensus kernels against the runtime length version
+ * for every specialized length, and that FindMotif's specialized and runtime searches agree.
  *
  * @param testResults List of test results to append to.
  */
 
-void MotifFinding(vector<TestResult>& testResults)
+static void TestSpecializedKernels(vector<TestResult>& testResults)
+{
+    const uint32_t nSeq     = 20;
+    const uint32_t seqLen   = 64;
+
+    bool match = true;
+
+    for (uint32_t k = 1; k <= MOTIF_FIXED_MAX_LEN + 4 && match; k++)
+    {
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> offsets;
+
+        GenerateMotifSequences(nSeq, seqLen, k, seqs, motif, offsets, k / 4);
+        seqs[0][offsets[0]] = 'N';
+
+        for (uint32_t trial = 0; trial < 50 && match; trial++)
+        {
+            vector<uint32_t> curOffsets(nSeq);
+            for (auto& off : curOffsets) off = rand() % (seqLen - k + 1);
+            if (trial == 0) curOffsets = offsets;
+
+            for (uint32_t prefixLen = 0; prefixLen <= nSeq && match; prefixLen += 5)
+                match = GetConsensus(seqs, prefixLen, curOffsets, k) == GetConsensusRuntime(seqs, prefixLen, &curOffsets[0], k);
+        }
+    }
+
+    if (match) testResults.push_back({ "Motif::SpecializedConsensus", PASS, "" });
+    else testResults.push_back({ "Motif::SpecializedConsensus", FAIL, "Fixed length consensus differs from runtime length version." });
+
+    vector<string> seqs;
+    string motif;
+    vector<uint32_t> planted;
+
+    GenerateMotifSequences(6, 24, 8, seqs, motif, planted, 2);
+
+    vector<uint32_t> fixedOffsets;
+    vector<uint32_t> runtimeOffsets;
+
+    long long t1    = GetMilliseconds();
+    FindMotif(seqs, 8, fixedOffsets);
+    long long t2    = GetMilliseconds();
+    FindMotifSearch<0>(seqs, 8, nullptr, runtimeOffsets);
+    long long t3    = GetMilliseconds();
+
+    const string timing = "T fixed = " + to_string((float)(t2 - t1) / 1000.0f) + " sec, T runtime = " + to_string((float)(t3 - t2) / 1000.0f) + " sec.";
+
+    if (fixedOffsets == runtimeOffsets) testResults.push_back({ "Motif::SpecializedSearch", PASS, timing });
+    else testResults.push_back({ "Motif::SpecializedSearch", FAIL, "Fixed and runtime length searches returned different offsets." });
+}
+
+/**
+ * TestAllocations - Check repeated searches are served by the thread's scratch arena. The first search
+ * warms the pool up; the ones after it should not reach the heap at all. Uses a motif length outside
+ * the specialized range so the runtime consensus path is covered too.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestAllocations(vector<TestResult>& testResults)
 {
-    const uint32_t nSeq     = 10;
-    const uint32_t seqLen   = 100;
-    const uint32_t motifLen = 6;
+    const uint32_t nSeq     = 5;
+    const uint32_t seqLen   = 12;
+    const uint32_t motifLen = MOTIF_FIXED_MIN_LEN - 1;
+    const uint32_t numRuns  = 10;
 
-    vector<string> seq;
+    vector<string> seqs;
     string motif;
-    vector<uint32_t> offsets;
+    vector<uint32_t> planted;
 
-    GenerateMotifSequences(nSeq, seqLen, motifLen, seq, motif, offsets);
+    GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
 
     vector<uint32_t> resultOffsets;
+    FindMotif(seqs, motifLen, resultOffsets);
 
-    FindMotif(seq, motifLen, resultOffsets);
+    const uint64_t allocsBefore = GetAllocStats().allocations;
 
-    __debugbreak();
-}
\ No newline at end of file
+    for (uint32_t i = 0; i < numRuns; i++) FindMotif(seqs, motifLen, resultOffsets);
+
+    const uint64_t allocs   = GetAllocStats().allocations - allocsBefore;
+    const string msg        = to_string(allocs) + " allocations in " + to_string(numRuns) + " searches.";
+
+    if (allocs == 0) testResults.push_back({ "Motif::Allocations", PASS, msg });
+    else testResults.push_back({ "Motif::Allocations", FAIL, msg });
+}
+
+/**
+ * MotifFinding - Test routine for motif finding algorithm above. Plants a motif in a small set of
+ * sequences and checks the branch-and-bound search reaches the planted consensus score. Sizes are kept
+ * small since the search is exhaustive in the worst case.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+void MotifFinding(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 10;
+    const uint32_t nSeq     = 5;
+    const uint32_t seqLen   = 16;
+    const uint32_t motifLen = 5;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        if (!ShardOwnsCase("Motif::Planted", i)) continue;
+
+        vector<string> seq;
+        string motif;
+        vector<uint32_t> offsets;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seq, motif, offsets);
+
+        vector<uint32_t> resultOffsets;
+
+        long long t1    = GetMilliseconds();
+        FindMotif(seq, motifLen, resultOffsets);
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const uint32_t score    = GetConsensus(seq, nSeq, resultOffsets, motifLen);
+        const string testStr    = to_string(i);
+
+        if (score == nSeq * motifLen)
+            testResults.push_back({ "Motif::Planted[" + testStr + "]", PASS, "T = " + to_string(sec) + "sec." });
+        else
+            testResults.push_back({ "Motif::Planted[" + testStr + "]", FAIL, "Planted motif not found. Score = " + to_string(score) });
+    }
+
+    if (ShardOwnsCase("Motif::Specialized", TEST_NO_INDEX)) TestSpecializedKernels(testResults);
+    if (ShardOwnsCase("Motif::Allocations", TEST_NO_INDEX)) TestAllocations(testResults);
+}
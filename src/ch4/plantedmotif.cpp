@@ -0,0 +1,428 @@
+#include "problems.h"
+#include "motif.h"
+#include "reporter.h"
+
+#include <memory>
+
+/*
+ * Planted (L, D) motif search. Find every L-mer that occurs in each input sequence with at most D
+ * mismatches. Candidates start as the D-neighbourhood of every L-mer in the first sequence and are
+ * narrowed sequence by sequence. While the candidate set is dense it lives in a bitset indexed by
+ * packed L-mer value (4^L bits); once it is small enough that checking each candidate directly is
+ * cheaper than enumerating another sequence's neighbourhoods, it is extracted into a sorted array
+ * and filtered with packed Hamming distance checks.
+ */
+
+static const uint32_t PLANTED_MAX_BITSET_LEN = 15;
+
+typedef unique_ptr<atomic<uint64_t>[]> AtomicBitset;
+
+/**
+ * VisitNeighbours - Call visit() on every k-mer within d mismatches of kmer, each exactly once.
+ * Mutations are applied at increasing positions, and XOR with 1, 2 or 3 yields the three other
+ * bases at a position.
+ */
+
+template<typename Fn>
+static void VisitNeighbours(const uint64_t kmer, const uint32_t startPos, const uint32_t k, const uint32_t d, Fn& visit)
+{
+    visit(kmer);
+    if (d == 0) return;
+
+    for (uint32_t pos = startPos; pos < k; pos++)
+        for (uint64_t b = 1; b < 4; b++)
+            VisitNeighbours(kmer ^ (b << (2 * pos)), pos + 1, k, d - 1, visit);
+}
+
+/**
+ * NeighbourhoodSize - Number of k-mers within d mismatches of a k-mer, sum(C(k, i) * 3^i) for i <= d.
+ */
+
+static uint64_t NeighbourhoodSize(const uint32_t k, const uint32_t d)
+{
+    uint64_t total  = 0;
+    uint64_t choose = 1;
+    uint64_t pow3   = 1;
+
+    for (uint32_t i = 0; i <= d; i++)
+    {
+        total   += choose * pow3;
+        choose  = choose * (k - i) / (i + 1);
+        pow3    *= 3;
+    }
+
+    return total;
+}
+
+/**
+ * GetPackedKmers - Sorted, de-duplicated packed k-mers of a sequence. Windows containing non-ACGT
+ * characters are skipped.
+ *
+ * @param seq   [in]        Input sequence.
+ * @param k     [in]        K-mer length.
+ * @param kmers [in/out]    Packed k-mers. Assumed empty on input.
+ */
+
+static void GetPackedKmers(const string& seq, const uint32_t k, vector<uint64_t>& kmers)
+{
+    const uint64_t mask = KmerMask(k);
+    uint64_t kmer       = 0;
+    uint32_t validLen   = 0;
+
+    for (char base : seq)
+    {
+        uint8_t code = BaseToCode(base);
+
+        if (code == INVALID_BASE)
+        {
+            validLen = 0;
+            continue;
+        }
+
+        kmer = ((kmer << 2) | code) & mask;
+        if (++validLen >= k) kmers.push_back(kmer);
+    }
+
+    sort(kmers.begin(), kmers.end());
+    kmers.erase(unique(kmers.begin(), kmers.end()), kmers.end());
+}
+
+/**
+ * MarkNeighbourhoods - Clear a bitset and set the bit of every k-mer within d mismatches of any
+ * input k-mer. If a filter bitset is given, only neighbours already set in the filter are marked,
+ * which turns most of the random writes into plain reads once the candidate set has thinned out.
+ * Input k-mers are split across threads; bits are set with relaxed atomic ORs.
+ */
+
+static void MarkNeighbourhoods(
+    const vector<uint64_t>& kmers,
+    const uint32_t k,
+    const uint32_t d,
+    const uint32_t numWords,
+    const atomic<uint64_t>* filter,
+    atomic<uint64_t>* bits
+)
+{
+    ParallelFor(numWords, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t w = begin; w < end; w++) bits[w].store(0, memory_order_relaxed);
+    });
+
+    ParallelFor((uint32_t)kmers.size(), [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        auto mark = [&](uint64_t v)
+        {
+            const uint64_t bit = 1ULL << (v & 63);
+            if (filter && (filter[v >> 6].load(memory_order_relaxed) & bit) == 0) return;
+
+            atomic<uint64_t>& word = bits[v >> 6];
+            if ((word.load(memory_order_relaxed) & bit) == 0) word.fetch_or(bit, memory_order_relaxed);
+        };
+
+        for (uint32_t i = begin; i < end; i++) VisitNeighbours(kmers[i], 0, k, d, mark);
+    });
+}
+
+/**
+ * CountBits - Population count of a bitset, word-parallel across threads.
+ */
+
+static uint64_t CountBits(const uint32_t numWords, const atomic<uint64_t>* bits)
+{
+    atomic<uint64_t> total(0);
+
+    ParallelFor(numWords, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        uint64_t cnt = 0;
+        for (uint32_t w = begin; w < end; w++) cnt += __popcnt64(bits[w].load(memory_order_relaxed));
+        total += cnt;
+    });
+
+    return total;
+}
+
+/**
+ * FilterCandidates - Keep only candidates within d mismatches of at least one k-mer of a sequence.
+ *
+ * @param kmers         [in]        Packed k-mers of the sequence.
+ * @param d             [in]        Max mismatches.
+ * @param candidates    [in/out]    Sorted candidate list, compacted in place.
+ */
+
+static void FilterCandidates(const vector<uint64_t>& kmers, const uint32_t d, vector<uint64_t>& candidates)
+{
+    vector<uint8_t> keep(candidates.size(), 0);
+
+    ParallelFor((uint32_t)candidates.size(), [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            for (auto kmer : kmers)
+            {
+                if (PackedMismatches(candidates[i], kmer) <= d)
+                {
+                    keep[i] = 1;
+                    break;
+                }
+            }
+        }
+    });
+
+    size_t cnt = 0;
+    for (size_t i = 0; i < candidates.size(); i++)
+        if (keep[i]) candidates[cnt++] = candidates[i];
+
+    candidates.resize(cnt);
+}
+
+/**
+ * FindPlantedMotifs - Find all L-mers that appear in every input sequence with at most D mismatches.
+ *
+ * @param  seqs             [in]        Sequences to search.
+ * @param  motifLen         [in]        Motif length L, at most MAX_PACKED_KMER.
+ * @param  maxMismatches    [in]        Max mismatches D, less than L.
+ * @param  motifs           [in/out]    Lexicographically sorted motifs found. Assumed empty on input.
+ *
+ * @return                  INVALID_INPUT for empty input or out of range (L, D). UNABLE_TO_FIND_SOLUTION
+ *                          if no L-mer qualifies. OK otherwise.
+ */
+
+ResultCode FindPlantedMotifs(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t maxMismatches,
+    vector<string>& motifs
+)
+{
+    assert(motifs.size() == 0);
+
+    if (seqs.size() == 0) return INVALID_INPUT;
+    if (motifLen == 0 || motifLen > MAX_PACKED_KMER || maxMismatches >= motifLen) return INVALID_INPUT;
+
+    const uint32_t nSeq = (uint32_t)seqs.size();
+
+    vector<vector<uint64_t>> kmers(nSeq);
+
+    ParallelFor(nSeq, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++) GetPackedKmers(seqs[i], motifLen, kmers[i]);
+    });
+
+    for (auto& seqKmers : kmers)
+        if (seqKmers.size() == 0) return UNABLE_TO_FIND_SOLUTION;
+
+    const uint64_t nbrSize = NeighbourhoodSize(motifLen, maxMismatches);
+
+    vector<uint64_t> candidates;
+    uint32_t nextSeq = 1;
+
+    if (motifLen <= PLANTED_MAX_BITSET_LEN)
+    {
+        const uint64_t numBits  = 1ULL << (2 * motifLen);
+        const uint32_t numWords = (uint32_t)((numBits + 63) / 64);
+
+        AtomicBitset cand(new atomic<uint64_t>[numWords]);
+        AtomicBitset seen(new atomic<uint64_t>[numWords]);
+
+        MarkNeighbourhoods(kmers[0], motifLen, maxMismatches, numWords, nullptr, cand.get());
+        uint64_t candCnt = CountBits(numWords, cand.get());
+
+        // Keep intersecting bitsets while enumerating a sequence's neighbourhoods is cheaper than
+        // checking every remaining candidate against its k-mers.
+
+        while (nextSeq < nSeq && candCnt > nbrSize + numWords / kmers[nextSeq].size())
+        {
+            MarkNeighbourhoods(kmers[nextSeq], motifLen, maxMismatches, numWords, cand.get(), seen.get());
+            swap(cand, seen);
+            candCnt = CountBits(numWords, cand.get());
+            nextSeq++;
+        }
+
+        candidates.reserve((size_t)candCnt);
+
+        for (uint32_t w = 0; w < numWords; w++)
+        {
+            uint64_t word = cand[w].load(memory_order_relaxed);
+
+            while (word != 0)
+            {
+                unsigned long bit;
+                _BitScanForward64(&bit, word);
+                candidates.push_back(((uint64_t)w << 6) | bit);
+                word &= word - 1;
+            }
+        }
+    }
+    else
+    {
+        // L-mer space too large for a bitset. Build the first sequence's neighbourhoods as a sorted
+        // array instead, with each thread enumerating its share of k-mers into a private list.
+
+        const uint32_t numThreads = GetWorkerCount();
+        vector<vector<uint64_t>> partial(numThreads);
+
+        ParallelFor((uint32_t)kmers[0].size(), [&](uint32_t begin, uint32_t end, uint32_t t)
+        {
+            auto add = [&](uint64_t v) { partial[t].push_back(v); };
+            for (uint32_t i = begin; i < end; i++) VisitNeighbours(kmers[0][i], 0, motifLen, maxMismatches, add);
+        });
+
+        for (auto& list : partial)
+        {
+            candidates.insert(candidates.end(), list.begin(), list.end());
+            vector<uint64_t>().swap(list);
+        }
+
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    for (uint32_t i = nextSeq; i < nSeq && candidates.size() > 0; i++)
+        FilterCandidates(kmers[i], maxMismatches, candidates);
+
+    for (auto cand : candidates) motifs.push_back(UnpackKmer(cand, motifLen));
+
+    return motifs.size() > 0 ? OK : UNABLE_TO_FIND_SOLUTION;
+}
+
+/**
+ * MinMismatches - Fewest mismatches between a motif and any same-length substring of seq. Plain
+ * string comparison, used to check FindPlantedMotifs independently of the packed representation.
+ */
+
+static uint32_t MinMismatches(const string& seq, const string& motif)
+{
+    uint32_t best = (uint32_t)motif.length();
+
+    for (size_t o = 0; o + motif.length() <= seq.length(); o++)
+    {
+        uint32_t cnt = 0;
+        for (size_t j = 0; j < motif.length() && cnt < best; j++) if (seq[o + j] != motif[j]) cnt++;
+        if (cnt < best) best = cnt;
+    }
+
+    return best;
+}
+
+/**
+ * TestBruteForce - On tiny instances, enumerate every possible L-mer and check FindPlantedMotifs
+ * returns exactly the set that occurs within D mismatches in every sequence.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestBruteForce(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 10;
+    const uint32_t nSeq     = 4;
+    const uint32_t seqLen   = 20;
+    const uint32_t motifLen = 5;
+    const uint32_t d        = 1;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        if (!ShardOwnsCase("PlantedMotif::BruteForce", i)) continue;
+
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> offsets;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, offsets, d);
+
+        vector<string> found;
+        FindPlantedMotifs(seqs, motifLen, d, found);
+
+        vector<string> expected;
+
+        for (uint64_t kmer = 0; kmer < (1ULL << (2 * motifLen)); kmer++)
+        {
+            string cand = UnpackKmer(kmer, motifLen);
+            bool inAll  = true;
+
+            for (auto& seq : seqs)
+            {
+                if (MinMismatches(seq, cand) > d)
+                {
+                    inAll = false;
+                    break;
+                }
+            }
+
+            if (inAll) expected.push_back(cand);
+        }
+
+        if (found == expected)
+            ReportTestCase(testResults, "PlantedMotif::BruteForce", i, PASS);
+        else
+            ReportTestCase(
+                testResults,
+                "PlantedMotif::BruteForce",
+                i,
+                FAIL,
+                "Expected " + to_string(expected.size()) + " motifs, found " + to_string(found.size())
+            );
+    }
+}
+
+/**
+ * TestChallengeSizes - Plant mutated motifs at increasing (L, D) up to the (15, 4) challenge size and
+ * check the planted motif is among those recovered. Reports motif count, time and input throughput.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestChallengeSizes(vector<TestResult>& testResults)
+{
+    struct Config { uint32_t nSeq, seqLen, motifLen, d; };
+
+    const Config configs[] =
+    {
+        { 10, 200, 8, 1 },
+        { 10, 300, 10, 2 },
+        { 20, 600, 12, 3 },
+        { 20, 600, 15, 4 },
+        { 10, 200, 18, 3 },
+    };
+
+    for (uint32_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+    {
+        if (!ShardOwnsCase("PlantedMotif::Challenge", c)) continue;
+
+        const Config& cfg = configs[c];
+
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> offsets;
+
+        GenerateMotifSequences(cfg.nSeq, cfg.seqLen, cfg.motifLen, seqs, motif, offsets, cfg.d);
+
+        vector<string> found;
+
+        long long t1    = GetMilliseconds();
+        ResultCode res  = FindPlantedMotifs(seqs, cfg.motifLen, cfg.d, found);
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const string name   = "PlantedMotif::(" + to_string(cfg.motifLen) + "," + to_string(cfg.d) + ")";
+        const float kbps    = sec > 0.0f ? (float)(cfg.nSeq * cfg.seqLen) / sec / 1000.0f : 0.0f;
+        const string msg    = "Motifs = " + to_string(found.size()) + ", T = " + to_string(sec) + "sec, " +
+                              to_string(kbps) + " Kbases/sec.";
+
+        if (res == OK && find(found.begin(), found.end(), motif) != found.end())
+            testResults.push_back({ name, PASS, msg });
+        else
+            testResults.push_back({ name, FAIL, "Planted motif " + motif + " not recovered. " + msg });
+    }
+}
+
+/**
+ * PlantedMotifFinding - Tests for the planted (L, D) motif solver.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void PlantedMotifFinding(vector<TestResult>& testResults)
+{
+    TestBruteForce(testResults);
+    TestChallengeSizes(testResults);
+}
@@ -0,0 +1,667 @@
+#include "problems.h"
+#include "pwm.h"
+#include "seqgen.h"
+
+#include <math.h>
+#include <intrin.h>
+
+/*
+ * PWM scanning engine. The sequence is split into chunks that are encoded to base codes and scanned
+ * on worker threads. With AVX2, each column's scores are quantized to int8 and looked up for 32
+ * windows at once with a byte shuffle, accumulating in int16 lanes. The quantized scan is only a
+ * filter: windows that pass are rescored exactly in float, and the filter threshold is lowered by
+ * the worst case rounding error so no true hit is dropped. Scanning a block of windows stops early
+ * once no lane can reach the threshold even with the best remaining columns.
+ */
+
+static const size_t PWM_CHUNK_BASES     = 1 << 20;
+static const uint32_t PWM_SIMD_MAX_LEN  = 64;
+static const uint32_t PWM_SIMD_WIDTH    = 32;
+static const uint8_t PWM_CODE_N         = 4;
+
+/*
+ * One strand's scoring tables. Code 4 (N or any non-ACGT character) scores as the column's worst base.
+ */
+
+struct PwmKernel
+{
+    uint32_t k;
+    vector<float> table;            // table[col * 8 + code]
+    vector<float> suffixMax;        // Best achievable score from column j to the end.
+    vector<int8_t> qTable;          // Quantized table, 32 bytes per column laid out for a byte shuffle.
+    vector<int16_t> qSuffixMax;
+    int32_t qThreshold;
+    float threshold;
+};
+
+struct PwmEncodeTable
+{
+    uint8_t codes[256];
+
+    PwmEncodeTable()
+    {
+        for (uint32_t c = 0; c < 256; c++)
+        {
+            uint8_t code = BaseToCode((char)c);
+            codes[c] = code == INVALID_BASE ? PWM_CODE_N : code;
+        }
+    }
+};
+
+static const PwmEncodeTable encodeTable;
+
+float Pwm::MaxScore() const
+{
+    float total = 0.0f;
+    for (uint32_t j = 0; j < motifLen; j++) total += max(max(Score(j, 0), Score(j, 1)), max(Score(j, 2), Score(j, 3)));
+    return total;
+}
+
+float Pwm::MinScore() const
+{
+    float total = 0.0f;
+    for (uint32_t j = 0; j < motifLen; j++) total += min(min(Score(j, 0), Score(j, 1)), min(Score(j, 2), Score(j, 3)));
+    return total;
+}
+
+/**
+ * BuildPwm - Build a log-odds matrix from motif instances, e.g. the offsets FindMotif returns. Column
+ * probabilities use Laplace pseudocounts and are scored against a uniform background.
+ *
+ * @param  seqs     [in]        Sequences containing the motif instances.
+ * @param  offsets  [in]        Offset of the instance in each sequence.
+ * @param  motifLen [in]        Motif length.
+ * @param  pwm      [in/out]    Resulting matrix.
+ *
+ * @return          INVALID_INPUT if there are no instances, counts don't match or an instance runs past
+ *                  its sequence. OK otherwise.
+ */
+
+ResultCode BuildPwm(
+    const vector<string>& seqs,
+    const vector<uint32_t>& offsets,
+    const uint32_t motifLen,
+    Pwm& pwm
+)
+{
+    if (seqs.size() == 0 || seqs.size() != offsets.size() || motifLen == 0) return INVALID_INPUT;
+
+    vector<uint32_t> counts(4 * motifLen, 0);
+
+    for (uint32_t i = 0; i < seqs.size(); i++)
+    {
+        if ((size_t)offsets[i] + motifLen > seqs[i].length()) return INVALID_INPUT;
+
+        for (uint32_t j = 0; j < motifLen; j++)
+        {
+            uint8_t code = BaseToCode(seqs[i][offsets[i] + j]);
+            if (code != INVALID_BASE) counts[j * 4 + code]++;
+        }
+    }
+
+    pwm.motifLen = motifLen;
+    pwm.scores.resize(4 * motifLen);
+
+    for (uint32_t j = 0; j < motifLen; j++)
+    {
+        float total = 4.0f;
+        for (uint32_t b = 0; b < 4; b++) total += (float)counts[j * 4 + b];
+
+        for (uint32_t b = 0; b < 4; b++)
+            pwm.scores[j * 4 + b] = logf(((float)counts[j * 4 + b] + 1.0f) / total / 0.25f);
+    }
+
+    return OK;
+}
+
+/**
+ * BuildKernel - Scoring tables for one strand. The reverse strand kernel scores the reverse
+ * complement of each forward window: column j is the PWM's column k - 1 - j with complemented bases.
+ *
+ * @param pwm       [in]        Matrix to scan with.
+ * @param reverse   [in]        Build the reverse complement kernel.
+ * @param scale     [in]        Quantization scale, shared by both strands.
+ * @param threshold [in]        Score threshold.
+ * @param kernel    [in/out]    Kernel to fill.
+ */
+
+static void BuildKernel(const Pwm& pwm, const bool reverse, const float scale, const float threshold, PwmKernel& kernel)
+{
+    const uint32_t k = pwm.motifLen;
+
+    kernel.k            = k;
+    kernel.threshold    = threshold;
+    kernel.table.assign(k * 8, 0.0f);
+    kernel.qTable.assign(k * PWM_SIMD_WIDTH, 0);
+    kernel.suffixMax.assign(k + 1, 0.0f);
+    kernel.qSuffixMax.assign(k + 1, 0);
+
+    for (uint32_t j = 0; j < k; j++)
+    {
+        float worst = 0.0f;
+        float best  = 0.0f;
+        int8_t qBest = 0;
+
+        for (uint32_t b = 0; b < 4; b++)
+        {
+            const float score   = reverse ? pwm.Score(k - 1 - j, 3 - b) : pwm.Score(j, b);
+            const int8_t q      = (int8_t)lrintf(score * scale);
+
+            kernel.table[j * 8 + b] = score;
+            kernel.qTable[j * PWM_SIMD_WIDTH + b] = kernel.qTable[j * PWM_SIMD_WIDTH + 16 + b] = q;
+
+            if (b == 0 || score < worst) worst = score;
+            if (b == 0 || score > best) best = score;
+            if (b == 0 || q > qBest) qBest = q;
+        }
+
+        kernel.table[j * 8 + PWM_CODE_N] = worst;
+        kernel.qTable[j * PWM_SIMD_WIDTH + PWM_CODE_N] = kernel.qTable[j * PWM_SIMD_WIDTH + 16 + PWM_CODE_N] = (int8_t)lrintf(worst * scale);
+
+        kernel.suffixMax[j]     = best;
+        kernel.qSuffixMax[j]    = qBest;
+    }
+
+    for (int32_t j = (int32_t)k - 1; j >= 0; j--)
+    {
+        kernel.suffixMax[j]     += kernel.suffixMax[j + 1];
+        kernel.qSuffixMax[j]    += kernel.qSuffixMax[j + 1];
+    }
+
+    // Each column can round by half a unit, so lower the quantized threshold by k / 2 (plus one for
+    // float slop) to keep every window whose exact score reaches the threshold.
+
+    const float qThreshold = floorf(threshold * scale - 0.5f * k) - 1.0f;
+    kernel.qThreshold = (int32_t)max(-65536.0f, min(65536.0f, qThreshold));
+}
+
+/**
+ * GetPassBound - Broadcast a "score must be greater than" bound for the 16-bit lanes. A quantized window
+ * sum stays within +/-(64 * 128), so saturating the bound keeps every comparison exact: a bound below the
+ * lowest reachable sum passes every window, one above the highest passes none.
+ */
+
+static inline __m256i GetPassBound(const int32_t bound)
+{
+    return _mm256_set1_epi16((int16_t)max(-32768, min(32767, bound)));
+}
+
+static inline float ScoreWindow(const PwmKernel& kernel, const uint8_t* codes)
+{
+    float score = 0.0f;
+    for (uint32_t j = 0; j < kernel.k; j++) score += kernel.table[j * 8 + codes[j]];
+    return score;
+}
+
+/**
+ * ScanChunkScalar - Score windows one at a time, abandoning a window once the best remaining columns
+ * can't lift it to the threshold.
+ */
+
+static void ScanChunkScalar(
+    const PwmKernel& kernel,
+    const uint8_t* codes,
+    const size_t numOffsets,
+    const uint64_t basePos,
+    const uint8_t strand,
+    vector<PwmHit>& hits
+)
+{
+    for (size_t o = 0; o < numOffsets; o++)
+    {
+        float score = 0.0f;
+        uint32_t j  = 0;
+
+        for (; j < kernel.k; j++)
+        {
+            score += kernel.table[j * 8 + codes[o + j]];
+            if (score + kernel.suffixMax[j + 1] < kernel.threshold) break;
+        }
+
+        if (j == kernel.k && score >= kernel.threshold) hits.push_back({ basePos + o, score, strand });
+    }
+}
+
+/**
+ * ScanChunkAvx2 - Quantized scan of 32 windows per step. Codes must be readable 32 bytes past the last
+ * window's end.
+ */
+
+static void ScanChunkAvx2(
+    const PwmKernel& kernel,
+    const uint8_t* codes,
+    const size_t numOffsets,
+    const uint64_t basePos,
+    const uint8_t strand,
+    vector<PwmHit>& hits
+)
+{
+    const uint32_t k        = kernel.k;
+    const __m256i passBound = GetPassBound(kernel.qThreshold - 1);
+
+    for (size_t o = 0; o < numOffsets; o += PWM_SIMD_WIDTH)
+    {
+        __m256i accLo   = _mm256_setzero_si256();
+        __m256i accHi   = _mm256_setzero_si256();
+        bool alive      = true;
+
+        for (uint32_t j = 0; j < k; j++)
+        {
+            const __m256i window    = _mm256_loadu_si256((const __m256i*)(codes + o + j));
+            const __m256i table     = _mm256_loadu_si256((const __m256i*)&kernel.qTable[j * PWM_SIMD_WIDTH]);
+            const __m256i scores    = _mm256_shuffle_epi8(table, window);
+
+            accLo = _mm256_add_epi16(accLo, _mm256_cvtepi8_epi16(_mm256_castsi256_si128(scores)));
+            accHi = _mm256_add_epi16(accHi, _mm256_cvtepi8_epi16(_mm256_extracti128_si256(scores, 1)));
+
+            // Every 4 columns, drop the block if no lane can still reach the threshold.
+
+            if ((j & 3) == 3 && j + 1 < k)
+            {
+                const __m256i bound = GetPassBound(kernel.qThreshold - kernel.qSuffixMax[j + 1] - 1);
+                const __m256i live  = _mm256_or_si256(_mm256_cmpgt_epi16(accLo, bound), _mm256_cmpgt_epi16(accHi, bound));
+
+                if (_mm256_testz_si256(live, live))
+                {
+                    alive = false;
+                    break;
+                }
+            }
+        }
+
+        if (!alive) continue;
+
+        const uint32_t maskLo   = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(accLo, passBound));
+        const uint32_t maskHi   = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi16(accHi, passBound));
+        uint64_t mask           = ((uint64_t)maskHi << 32) | maskLo;
+
+        while (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanForward64(&bit, mask);
+            mask &= ~(3ULL << bit);
+
+            const size_t win = o + bit / 2;
+            if (win >= numOffsets) break;
+
+            const float score = ScoreWindow(kernel, codes + win);
+            if (score >= kernel.threshold) hits.push_back({ basePos + win, score, strand });
+        }
+    }
+}
+
+/**
+ * GetQuantScale - Quantization scale mapping the largest magnitude score in the matrix to 127.
+ */
+
+static float GetQuantScale(const Pwm& pwm)
+{
+    float maxAbs = 0.0f;
+    for (auto score : pwm.scores) maxAbs = max(maxAbs, fabsf(score));
+
+    return maxAbs > 0.0f ? 127.0f / maxAbs : 1.0f;
+}
+
+/**
+ * ScanPwm - Report every window of a sequence scoring at or above a threshold, on the forward strand
+ * and optionally the reverse complement. The sequence is scanned in chunks across worker threads.
+ * Non-ACGT characters score as the worst base of their column.
+ *
+ * @param  pwm          [in]        Matrix to scan with.
+ * @param  seq          [in]        Sequence characters.
+ * @param  seqLen       [in]        Sequence length.
+ * @param  threshold    [in]        Minimum log-odds score to report.
+ * @param  bothStrands  [in]        Also scan the reverse complement.
+ * @param  hits         [in/out]    Hits sorted by position, forward strand first. Assumed empty on input.
+ *
+ * @return              INVALID_INPUT for an empty or malformed PWM. OK otherwise.
+ */
+
+ResultCode ScanPwm(
+    const Pwm& pwm,
+    const char* seq,
+    const size_t seqLen,
+    const float threshold,
+    const bool bothStrands,
+    vector<PwmHit>& hits
+)
+{
+    assert(hits.size() == 0);
+
+    const uint32_t k = pwm.motifLen;
+
+    if (k == 0 || pwm.scores.size() != 4 * k) return INVALID_INPUT;
+    if (seqLen < k) return OK;
+
+    const float scale = GetQuantScale(pwm);
+
+    PwmKernel kernels[2];
+    BuildKernel(pwm, false, scale, threshold, kernels[0]);
+    if (bothStrands) BuildKernel(pwm, true, scale, threshold, kernels[1]);
+
+    const bool useSimd          = HasAvx2() && k <= PWM_SIMD_MAX_LEN;
+    const size_t numOffsets     = seqLen - k + 1;
+    const uint32_t numChunks    = (uint32_t)((numOffsets + PWM_CHUNK_BASES - 1) / PWM_CHUNK_BASES);
+    const uint32_t numStrands   = bothStrands ? 2 : 1;
+
+    vector<vector<PwmHit>> chunkHits(numChunks);
+
+    ParallelFor(numChunks, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        vector<uint8_t> codes(PWM_CHUNK_BASES + k - 1 + PWM_SIMD_WIDTH);
+        vector<PwmHit> strandHits[2];
+
+        for (uint32_t c = begin; c < end; c++)
+        {
+            const size_t start      = (size_t)c * PWM_CHUNK_BASES;
+            const size_t chunkOffs  = min(PWM_CHUNK_BASES, numOffsets - start);
+            const size_t chunkBases = chunkOffs + k - 1;
+
+            for (size_t i = 0; i < chunkBases; i++) codes[i] = encodeTable.codes[(uint8_t)seq[start + i]];
+            memset(&codes[chunkBases], PWM_CODE_N, codes.size() - chunkBases);
+
+            for (uint32_t s = 0; s < numStrands; s++)
+            {
+                strandHits[s].clear();
+
+                if (useSimd) ScanChunkAvx2(kernels[s], &codes[0], chunkOffs, start, (uint8_t)s, strandHits[s]);
+                else ScanChunkScalar(kernels[s], &codes[0], chunkOffs, start, (uint8_t)s, strandHits[s]);
+            }
+
+            chunkHits[c].resize(strandHits[0].size() + strandHits[1].size());
+
+            merge(
+                strandHits[0].begin(), strandHits[0].end(),
+                strandHits[1].begin(), strandHits[1].end(),
+                chunkHits[c].begin(),
+                [](const PwmHit& a, const PwmHit& b) { return a.pos < b.pos || (a.pos == b.pos && a.strand < b.strand); }
+            );
+        }
+    });
+
+    size_t total = 0;
+    for (auto& list : chunkHits) total += list.size();
+
+    hits.reserve(total);
+    for (auto& list : chunkHits) hits.insert(hits.end(), list.begin(), list.end());
+
+    return OK;
+}
+
+/**
+ * ReferenceScan - Test helper. Score every window on both strands directly from the PWM, without
+ * kernels, quantization or early exit.
+ */
+
+static void ReferenceScan(const Pwm& pwm, const string& seq, const float threshold, vector<PwmHit>& hits)
+{
+    const uint32_t k = pwm.motifLen;
+
+    auto scoreBase = [&](uint32_t col, char c, bool reverse)
+    {
+        uint8_t code = BaseToCode(c);
+
+        if (code == INVALID_BASE)
+            return min(min(pwm.Score(col, 0), pwm.Score(col, 1)), min(pwm.Score(col, 2), pwm.Score(col, 3)));
+
+        return pwm.Score(col, reverse ? 3 - code : code);
+    };
+
+    for (size_t o = 0; o + k <= seq.length(); o++)
+    {
+        for (uint8_t strand = 0; strand < 2; strand++)
+        {
+            float score = 0.0f;
+
+            for (uint32_t j = 0; j < k; j++)
+                score += strand == 0 ? scoreBase(j, seq[o + j], false) : scoreBase(k - 1 - j, seq[o + j], true);
+
+            if (score >= threshold) hits.push_back({ o, score, strand });
+        }
+    }
+}
+
+static string ReverseComplement(const string& seq)
+{
+    string rc(seq.rbegin(), seq.rend());
+    for (auto& c : rc) c = CodeToBase(3 - BaseToCode(c));
+    return rc;
+}
+
+/**
+ * TestAgainstReference - Scan a random sequence with Ns and planted forward and reverse complement
+ * motif copies, and compare hits with the reference scan at several thresholds.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestAgainstReference(vector<TestResult>& testResults)
+{
+    const SeqGenParams motifParams  = { 40, 60, 12, 2, 21 };
+    const SeqGenParams genomeParams = { 1, 200000, 0, 0, 22 };
+
+    SeqSet instances;
+    SeqSet genome;
+    GenerateSequenceSet(motifParams, instances);
+    GenerateSequenceSet(genomeParams, genome);
+
+    vector<string> seqs;
+    for (uint32_t i = 0; i < motifParams.nSeq; i++) seqs.push_back(string(instances.Seq(i), motifParams.seqLen));
+
+    Pwm pwm;
+    BuildPwm(seqs, instances.offsets, motifParams.motifLen, pwm);
+
+    string seq(genome.Seq(0), genomeParams.seqLen);
+    const string motifRc = ReverseComplement(instances.motif);
+
+    Rng rng(23);
+    vector<uint64_t> planted;
+
+    const uint32_t numPlanted   = 100;
+    const uint32_t spacing      = genomeParams.seqLen / numPlanted;
+
+    for (uint32_t i = 0; i < 200; i++) seq[rng.NextBounded(genomeParams.seqLen)] = 'N';
+
+    for (uint32_t i = 0; i < numPlanted; i++)
+    {
+        const uint64_t pos = (uint64_t)i * spacing + rng.NextBounded(spacing - motifParams.motifLen);
+        seq.replace(pos, motifParams.motifLen, i % 2 == 0 ? instances.motif : motifRc);
+        planted.push_back(pos);
+    }
+
+    const float fractions[] = { 0.9f, 0.6f, 0.3f, 0.0f };
+
+    for (float frac : fractions)
+    {
+        const float threshold   = pwm.MinScore() + frac * (pwm.MaxScore() - pwm.MinScore());
+        const string name       = "PwmScan::Reference[" + to_string(frac) + "]";
+
+        vector<PwmHit> hits;
+        vector<PwmHit> expected;
+
+        ScanPwm(pwm, seq.c_str(), seq.length(), threshold, true, hits);
+        ReferenceScan(pwm, seq, threshold, expected);
+
+        // Windows within float rounding of the threshold may land on either side of it.
+
+        auto nearThreshold = [&](const PwmHit& h) { return fabsf(h.score - threshold) < 1e-3f; };
+        hits.erase(remove_if(hits.begin(), hits.end(), nearThreshold), hits.end());
+        expected.erase(remove_if(expected.begin(), expected.end(), nearThreshold), expected.end());
+
+        string err = hits.size() == expected.size() ? "" :
+            "Found " + to_string(hits.size()) + " hits, expected " + to_string(expected.size());
+
+        for (size_t i = 0; i < hits.size() && err.empty(); i++)
+        {
+            if (hits[i].pos != expected[i].pos || hits[i].strand != expected[i].strand || fabsf(hits[i].score - expected[i].score) > 1e-3f)
+                err = "Hit " + to_string(i) + " differs from reference.";
+        }
+
+        if (frac == 0.9f)
+        {
+            for (size_t i = 0; i < planted.size() && err.empty(); i++)
+            {
+                auto match = [&](const PwmHit& h) { return h.pos == planted[i] && h.strand == (i % 2); };
+                if (none_of(hits.begin(), hits.end(), match)) err = "Planted copy at " + to_string(planted[i]) + " not found.";
+            }
+        }
+
+        if (err.empty()) testResults.push_back({ name, PASS, to_string(hits.size()) + " hits." });
+        else testResults.push_back({ name, FAIL, err });
+    }
+}
+
+/**
+ * TestExtremeThresholds - Run the scalar and AVX2 chunk scans side by side at thresholds outside the
+ * quantized range. Every window must pass a threshold at or below the lowest possible score, including
+ * -INFINITY, and none may pass one above the highest.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestExtremeThresholds(vector<TestResult>& testResults)
+{
+    const SeqGenParams motifParams  = { 20, 40, 8, 2, 24 };
+    const size_t seqLen             = 1000;
+
+    SeqSet instances;
+    GenerateSequenceSet(motifParams, instances);
+
+    vector<string> seqs;
+    for (uint32_t i = 0; i < motifParams.nSeq; i++) seqs.push_back(string(instances.Seq(i), motifParams.seqLen));
+
+    Pwm pwm;
+    BuildPwm(seqs, instances.offsets, motifParams.motifLen, pwm);
+
+    const uint32_t k            = pwm.motifLen;
+    const size_t numOffsets     = seqLen - k + 1;
+    const float scale           = GetQuantScale(pwm);
+
+    Rng rng(25);
+    vector<uint8_t> codes(seqLen + PWM_SIMD_WIDTH, PWM_CODE_N);
+    for (size_t i = 0; i < seqLen; i++) codes[i] = (uint8_t)rng.NextBounded(5);
+
+    const float thresholds[]    = { pwm.MinScore() - 1.0f, -100.0f, -1000.0f, -1e6f, -INFINITY, pwm.MaxScore() + 1.0f, 1e6f, INFINITY };
+    const char* names[]         = { "BelowMin", "-100", "-1000", "-1e6", "-Inf", "AboveMax", "1e6", "Inf" };
+
+    for (uint32_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++)
+    {
+        const string name = string("PwmScan::Threshold[") + names[t] + "]";
+
+        PwmKernel kernel;
+        BuildKernel(pwm, false, scale, thresholds[t], kernel);
+
+        size_t expected = 0;
+        for (size_t o = 0; o < numOffsets; o++) expected += ScoreWindow(kernel, &codes[o]) >= thresholds[t];
+
+        if ((thresholds[t] < pwm.MinScore() && expected != numOffsets) || (thresholds[t] > pwm.MaxScore() && expected != 0))
+        {
+            testResults.push_back({ name, FAIL, "Reference count " + to_string(expected) + " is off for an out of range threshold." });
+            continue;
+        }
+
+        vector<PwmHit> scalarHits;
+        vector<PwmHit> simdHits;
+        ScanChunkScalar(kernel, &codes[0], numOffsets, 0, 0, scalarHits);
+
+        if (HasAvx2()) ScanChunkAvx2(kernel, &codes[0], numOffsets, 0, 0, simdHits);
+        else simdHits = scalarHits;
+
+        if (scalarHits.size() == expected && simdHits.size() == expected)
+            testResults.push_back({ name, PASS, to_string(expected) + " hits." });
+        else
+            testResults.push_back({ name, FAIL, "Scalar found " + to_string(scalarHits.size()) + " hits, AVX2 " +
+                to_string(simdHits.size()) + ", expected " + to_string(expected) + "." });
+    }
+}
+
+/**
+ * TestFindMotifPipeline - Build a PWM from FindMotif's offsets and check scanning each input sequence
+ * finds the window FindMotif chose.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestFindMotifPipeline(vector<TestResult>& testResults)
+{
+    const uint32_t nSeq     = 5;
+    const uint32_t seqLen   = 16;
+    const uint32_t motifLen = 5;
+
+    vector<string> seqs;
+    string motif;
+    vector<uint32_t> planted;
+    vector<uint32_t> offsets;
+
+    GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
+    FindMotif(seqs, motifLen, offsets);
+
+    Pwm pwm;
+    BuildPwm(seqs, offsets, motifLen, pwm);
+
+    bool found = true;
+
+    for (uint32_t i = 0; i < nSeq && found; i++)
+    {
+        float threshold = 0.0f;
+        for (uint32_t j = 0; j < motifLen; j++) threshold += pwm.Score(j, BaseToCode(seqs[i][offsets[i] + j]));
+
+        vector<PwmHit> hits;
+        ScanPwm(pwm, seqs[i].c_str(), seqLen, threshold - 1e-3f, false, hits);
+
+        found = any_of(hits.begin(), hits.end(), [&](const PwmHit& h) { return h.pos == offsets[i]; });
+    }
+
+    if (found) testResults.push_back({ "PwmScan::FindMotifPipeline", PASS, "" });
+    else testResults.push_back({ "PwmScan::FindMotifPipeline", FAIL, "FindMotif instance not reported by scan." });
+}
+
+/**
+ * TestThroughput - Scan a long random sequence on both strands and report bases per second.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    const SeqGenParams motifParams  = { 40, 60, 16, 2, 31 };
+    const SeqGenParams genomeParams = { 1, 64 << 20, 0, 0, 32 };
+
+    SeqSet instances;
+    SeqSet genome;
+    GenerateSequenceSet(motifParams, instances);
+    GenerateSequenceSet(genomeParams, genome);
+
+    vector<string> seqs;
+    for (uint32_t i = 0; i < motifParams.nSeq; i++) seqs.push_back(string(instances.Seq(i), motifParams.seqLen));
+
+    Pwm pwm;
+    BuildPwm(seqs, instances.offsets, motifParams.motifLen, pwm);
+
+    vector<PwmHit> hits;
+    const float threshold = 0.8f * pwm.MaxScore();
+
+    long long t1    = GetMilliseconds();
+    ScanPwm(pwm, genome.Seq(0), genomeParams.seqLen, threshold, true, hits);
+    long long t2    = GetMilliseconds();
+    float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+    const float mbps    = sec > 0.0f ? (float)genomeParams.seqLen / 1e6f / sec : 0.0f;
+    const string path   = HasAvx2() ? "AVX2" : "scalar";
+
+    testResults.push_back({ "PwmScan::Throughput", PASS, path + ", " + to_string(mbps) + " Mbases/sec, " + to_string(hits.size()) + " hits." });
+}
+
+/**
+ * PwmScanning - Tests for the PWM scanning engine.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void PwmScanning(vector<TestResult>& testResults)
+{
+    TestAgainstReference(testResults);
+    TestExtremeThresholds(testResults);
+    TestFindMotifPipeline(testResults);
+    TestThroughput(testResults);
+}
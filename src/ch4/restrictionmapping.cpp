@@ -1,4 +1,6 @@
 #include "problems.h"
+#include "arena.h"
+#include "restmap.h"
 
 /**
  * GetPairwiseDistances - Given a list of points, return the sorted list of distances between each pair
@@ -8,7 +10,7 @@
  * @param distances [in/out] List of sorted pairwise distances computed by this function. Assumed empty on input.
  */
 
-static ResultCode GetPairwiseDistances(const vector<uint32_t>& points, vector<uint32_t>& distances)
+ResultCode GetPairwiseDistances(const vector<uint32_t>& points, vector<uint32_t>& distances)
 {
     assert(distances.size() == 0);
     distances.resize(points.size() * (points.size() - 1) / 2);
@@ -72,9 +74,11 @@ static ResultCode ComputePDBF(const vector<uint32_t>& distList, vector<uint32_t>
 
     for (uint32_t i = 0; i < n - 2; i++) comboIdcs[distList.size() - 2 - i] = true;
 
+    vector<uint32_t> candidate(n);
+    vector<uint32_t> distances;
+
     do
     {
-        vector<uint32_t> candidate(n);
         candidate[0]        = 0;
         candidate[n - 1]    = distList[distList.size() - 1];
 
@@ -83,7 +87,7 @@ static ResultCode ComputePDBF(const vector<uint32_t>& distList, vector<uint32_t>
         for (uint32_t i = 0; i < comboIdcs.size(); i++)
             if (comboIdcs[i]) candidate[candIdx++] = distList[i];
 
-        vector<uint32_t> distances;
+        distances.clear();
         GetPairwiseDistances(candidate, distances);
 
         if (memcmp(&distances[0], &distList[0], distList.size() * sizeof(uint32_t)) == 0)
@@ -104,15 +108,6 @@ static ResultCode ComputePDBF(const vector<uint32_t>& distList, vector<uint32_t>
     return UNABLE_TO_FIND_SOLUTION;
 }
 
-/* 
- * Performance optimization. For recursive restriction mapping algorithm below, every time a distance
- * grabbed from the remaining distance list, at most, N new distances can be generated, where N is the
- * size of the final solution (N points generates N * (N - 1) distances). Allocate room for these
- * distances up front and don't dynamically allocate new memory for new distances on-the-fly.
- */
-
-static uint32_t solutionSize;
-
 /**
  * SearchDistListResursive - This algorithm iteratively grabs the largest unused distance D from 
  * the input list L and computes points that are D from the left/or right ends of PD
@@ -125,113 +120,144 @@ static uint32_t solutionSize;
  * point from the solution and add the distances it generated back to the input list, then try
  * a new distance. Algorithm terminates successfully if remaining distance list is empty.
  *
- * @param pd    [in/out] Current intermediate solution point set.
- * @param dist  [in/out] Remaining distances
+ * Performance optimization. Every time a distance is grabbed from the remaining distance list, at most
+ * N new distances can be generated, where N is the size of the final solution (N points generates
+ * N * (N - 1) distances). The caller allocates N slots per recursion depth up front, and each level
+ * uses the slice for its depth instead of allocating new memory for new distances on-the-fly.
+ *
+ * @param pd      [in/out] Current intermediate solution point set.
+ * @param dist    [in/out] Remaining distances
+ * @param scratch [in/out] New distance slots, stride per recursion depth.
+ * @param stride  [in] Slots per depth, the size of the final solution.
  */
 
-static bool SearchDistListRecursive(set<uint32_t>& pd, unordered_map<uint32_t, uint32_t> &dist)
+static bool SearchDistListRecursive(
+    pmr::set<uint32_t>& pd,
+    pmr::unordered_map<uint32_t, uint32_t>& dist,
+    uint32_t* scratch,
+    const uint32_t stride
+);
+
+/**
+ * TryPoint - Place a candidate point for SearchDistListRecursive. Takes the distances from the point to
+ * every current solution point out of the remaining list, then recurses. If any of those distances is
+ * no longer available, or the recursion fails, puts everything back.
+ *
+ * @param pd          [in/out] Current intermediate solution point set.
+ * @param dist        [in/out] Remaining distances and their counts.
+ * @param point       [in] Candidate point.
+ * @param newDistList [in/out] Slots for the distances taken at this depth.
+ * @param scratch     [in/out] Scratch for deeper recursions.
+ * @param stride      [in] Slots per recursion depth.
+ *
+ * @return            True if the recursion found a solution.
+ */
+
+static bool TryPoint(
+    pmr::set<uint32_t>& pd,
+    pmr::unordered_map<uint32_t, uint32_t>& dist,
+    const uint32_t point,
+    uint32_t* newDistList,
+    uint32_t* scratch,
+    const uint32_t stride
+)
 {
-    bool empty = true;
+    uint32_t newDistCnt = 0;
+    bool valid          = true;
 
-    for (auto& pair : dist)
+    for (auto& pt : pd)
     {
-        if (pair.second != 0)
+        const uint32_t newDist = pt > point ? pt - point : point - pt;
+        auto it = dist.find(newDist);
+
+        if (it == dist.end() || it->second == 0)
         {
-            empty = false;
+            valid = false;
             break;
         }
-    }
 
-    if (empty) return true;
-
-    const uint32_t maxDist = *pd.rbegin();
-
-    vector<uint32_t> newDistList(solutionSize);
+        it->second--;
+        newDistList[newDistCnt++] = newDist;
+    }
 
-    for (auto &pair : dist)
+    if (valid)
     {
-        uint32_t curMax     = pair.first;
-        uint32_t left       = curMax;
-        uint32_t right      = maxDist - curMax;
+        pd.insert(point);
+        if (SearchDistListRecursive(pd, dist, scratch, stride)) return true;
+        pd.erase(point);
+    }
 
-        bool leftValid      = true;
-        bool rightValid     = true;
+    for (uint32_t i = 0; i < newDistCnt; i++) dist[newDistList[i]]++;
 
-        uint32_t newDistCnt = 0;
+    return false;
+}
 
-        for (auto& pt : pd)
-        {
-            uint32_t newDist = pt > left ? pt - left : left - pt;
-            if (dist.count(newDist) == 0)
-            {
-                leftValid = false;
-                break;
-            }
-            newDistList[newDistCnt++] = newDist;
-        }
+static bool SearchDistListRecursive(
+    pmr::set<uint32_t>& pd,
+    pmr::unordered_map<uint32_t, uint32_t>& dist,
+    uint32_t* scratch,
+    const uint32_t stride
+)
+{
+    bool empty          = true;
+    uint32_t curMax     = 0;
 
-        if (leftValid)
+    for (auto& pair : dist)
+    {
+        if (pair.second != 0)
         {
-            pd.insert(left);
-            for (uint32_t i = 0; i < newDistCnt; i++) dist[newDistList[i]]--;
-            if (SearchDistListRecursive(pd, dist)) return true;
-            else
-            {
-                pd.erase(left);
-                for (uint32_t i = 0; i < newDistCnt; i++) dist[newDistList[i]]++;
-                leftValid = false;
-            }
+            empty   = false;
+            curMax  = max(curMax, pair.first);
         }
+    }
 
-        if (!leftValid)
-        {
-            newDistCnt = 0;
+    if (empty) return true;
 
-            for (auto& pt : pd)
-            {
-                uint32_t newDist = pt > right ? pt - right : right - pt;
-                if (dist.count(newDist) == 0)
-                {
-                    rightValid = false;
-                    break;
-                }
-                newDistList[newDistCnt++] = newDist;
-            }
+    const uint32_t maxDist  = *pd.rbegin();
+    uint32_t* newDistList   = scratch + (pd.size() - 2) * stride;
 
-            if (rightValid)
-            {
-                pd.insert(right);
-                for (uint32_t i = 0; i < newDistCnt; i++) dist[newDistList[i]]--;
-                if (SearchDistListRecursive(pd, dist)) return true;
-                else
-                {
-                    pd.erase(right);
-                    for (uint32_t i = 0; i < newDistCnt; i++) dist[newDistList[i]]++;
-                }
-            }
-        }
-    }
+    // The largest remaining distance must be from one of the end points.
 
-    return false;
+    const uint32_t left     = curMax;
+    const uint32_t right    = maxDist - curMax;
+
+    if (TryPoint(pd, dist, left, newDistList, scratch, stride)) return true;
+
+    return right != left && TryPoint(pd, dist, right, newDistList, scratch, stride);
 }
 
 /**
  * ComputePDBackTracking - Driver routine for recursive method above. Simply copies the input distances into a map
  * and initializes the solution point set with  {0, max}, then passes them to the recursive search.
+ * The distance map and recursion scratch live in a monotonic buffer dropped with the solve, and the
+ * point set, which churns as the search backtracks, in the thread's pool.
  *
  * @param  distSetIn    [in] Input set of pairwise distances between points. Assumed to be sorted in ascending order.
  * @param  pd           [in/out] The computed set of points PD from L. Assumed empty on input.
  *
- * @return              INVALID_INPUT if no distances input. OK if solution found, UNABLE_TO_FIND_SOLUTION otherwise.
+ * @return              INVALID_INPUT if no distances input or the count can't be that of a point set's
+ *                      pairwise distances. OK if solution found, UNABLE_TO_FIND_SOLUTION otherwise.
  */
 
-static ResultCode ComputePDBacktracking(const vector<uint32_t>& distList, vector<uint32_t>& pd)
+ResultCode ComputePDBacktracking(const vector<uint32_t>& distList, vector<uint32_t>& pd)
 {
     assert(pd.size() == 0);
     if (distList.size() == 0) return INVALID_INPUT;
 
-    unordered_map<uint32_t, uint32_t> distSet;
-    set<uint32_t> pdSet;
+    // N points have N * (N - 1) / 2 distances, and distinct points no zero distances.
+
+    uint32_t solutionSize = 2;
+
+    while ((uint64_t)solutionSize * (solutionSize - 1) / 2 < distList.size()) solutionSize++;
+
+    if ((uint64_t)solutionSize * (solutionSize - 1) / 2 != distList.size()) return INVALID_INPUT;
+    if (distList[0] == 0) return INVALID_INPUT;
+
+    pmr::memory_resource* pool = GetThreadArena().Pool();
+    pmr::monotonic_buffer_resource solveMem(ARENA_MONOTONIC_INITIAL, pool);
+
+    pmr::unordered_map<uint32_t, uint32_t> distSet(&solveMem);
+    pmr::set<uint32_t> pdSet(pool);
 
     const uint32_t maxDist = distList[distList.size() - 1];
     pdSet.insert(0);
@@ -243,12 +269,11 @@ static ResultCode ComputePDBacktracking(const vector<uint32_t>& distList, vector
         else distSet[distList[i]]++;
     }
 
-    uint32_t i = 2;
-
-    while (i * (i - 1) / 2 != (uint32_t)distList.size()) solutionSize = ++i;
+    pmr::vector<uint32_t> scratch((size_t)solutionSize * solutionSize, 0, &solveMem);
 
-    if (SearchDistListRecursive(pdSet, distSet))
+    if (SearchDistListRecursive(pdSet, distSet, scratch.data(), solutionSize))
     {
+        pd.reserve(pdSet.size());
         for (auto& pt : pdSet) pd.push_back(pt);
         sort(pd.begin(), pd.end());
 
@@ -258,6 +283,49 @@ static ResultCode ComputePDBacktracking(const vector<uint32_t>& distList, vector
     return UNABLE_TO_FIND_SOLUTION;
 }
 
+/**
+ * TestAllocations - Check repeated backtracking solves are served by the thread's scratch arena. After a
+ * warm-up solve, the only heap traffic left should be none at all: the solution vector is reused and
+ * the search's sets, maps and scratch come from the pool.
+ *
+ * @param testResults Result list to append results to.
+ */
+
+static void TestAllocations(vector<TestResult>& testResults)
+{
+    const uint32_t numPoints    = 64;
+    const uint32_t maxVal       = 10000;
+    const uint32_t numRuns      = 10;
+
+    set<uint32_t> pointSet;
+    pointSet.insert(0);
+
+    while (pointSet.size() < numPoints) pointSet.insert(rand() % maxVal);
+
+    vector<uint32_t> points(pointSet.begin(), pointSet.end());
+    vector<uint32_t> dist;
+    GetPairwiseDistances(points, dist);
+
+    vector<uint32_t> pd;
+    ComputePDBacktracking(dist, pd);
+
+    const uint64_t allocsBefore = GetAllocStats().allocations;
+
+    bool solved = true;
+
+    for (uint32_t i = 0; i < numRuns; i++)
+    {
+        pd.clear();
+        solved = solved && ComputePDBacktracking(dist, pd) == OK;
+    }
+
+    const uint64_t allocs   = GetAllocStats().allocations - allocsBefore;
+    const string msg        = to_string(allocs) + " allocations in " + to_string(numRuns) + " solves.";
+
+    if (solved && allocs == 0) testResults.push_back({ "RestMap::Allocations", PASS, msg });
+    else testResults.push_back({ "RestMap::Allocations", FAIL, solved ? msg : "Backtracking algorithm couldn't find solution." });
+}
+
 /**
  * RestrictionMapping - Restriction mapping problems. The restriction mapping/turnpike problem asks, given
  * a list of pairwise distances between points, can we reconstruct the original set of points.
@@ -306,31 +374,25 @@ void RestrictionMapping(vector<TestResult>& testResults)
             long long t2BT      = GetMilliseconds();
             float btSec         = ((float)t2BT - (float)t1BT) / 1000.0f;
 
-            string testStr      = to_string(testCase);
-            string sizeStr      = to_string(i);
-            string btTStr       = to_string(btSec);
+            string testName = "RestMap::RandomList[" + to_string(testCase) + "] Point Set Size =" + to_string(i);
 
             if (resBT == UNABLE_TO_FIND_SOLUTION)
             {
-                testResults.push_back({ "RestMap::RandomList[" + testStr + "] Point Set Size =" + sizeStr, FAIL, "Backtracking algorithm couldn't find solution." });
+                testResults.push_back({ move(testName), FAIL, "Backtracking algorithm couldn't find solution." });
                 continue;
             }
 
             if (memcmp(&solutionBT[0], &points[0], i * sizeof(uint32_t) != 0))
             {
-                testResults.push_back({ "RestMap::RandomList[" + testStr + "] Point Set Size =" + sizeStr, FAIL, "Backtracking algorithm found wrong solution." });
+                testResults.push_back({ move(testName), FAIL, "Backtracking algorithm found wrong solution." });
                 continue;
             }
 
-            testResults.push_back(
-                {
-                    "RestMap::RandomList[" + testStr + "] Point Set Size =" + sizeStr,
-                    PASS,
-                    "BT = " + btTStr + "sec."
-                }
-            );
+            testResults.push_back({ move(testName), PASS, "BT = " + to_string(btSec) + "sec." });
 
             testCase++;
         }
     }
+
+    TestAllocations(testResults);
 }
\ No newline at end of file
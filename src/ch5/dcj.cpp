@@ -0,0 +1,766 @@
+#include "problems.h"
+#include "dcj.h"
+
+/*
+ * Adjacency graph in flat arrays. Gene g has extremities tail 2(g - 1) and head 2(g - 1) + 1, and
+ * adj[e] is the extremity e is joined to in a genome, or DCJ_TELOMERE at a linear chromosome end.
+ * Each extremity lies on exactly one adjacency of each genome, so components of the graph are walked
+ * by alternating between the two arrays.
+ */
+
+static const uint32_t DCJ_TELOMERE  = ~0u;
+static const uint32_t DCJ_UNSET     = ~0u - 1;
+
+static inline uint32_t LeftExtremity(const int32_t gene) { return gene > 0 ? 2 * (gene - 1) : 2 * (-gene - 1) + 1; }
+static inline uint32_t RightExtremity(const int32_t gene) { return gene > 0 ? 2 * (gene - 1) + 1 : 2 * (-gene - 1); }
+
+/**
+ * BuildAdjacencies - Fill a genome's adjacency array.
+ *
+ * @param  genome   [in]    Genome.
+ * @param  numGenes [in]    Gene ids must lie in 1..numGenes.
+ * @param  adj      [out]   2 * numGenes extremity partners.
+ *
+ * @return          INVALID_INPUT unless every gene 1..numGenes appears exactly once. OK otherwise.
+ */
+
+static ResultCode BuildAdjacencies(const Genome& genome, const uint32_t numGenes, vector<uint32_t>& adj)
+{
+    if (genome.genes.size() != numGenes) return INVALID_INPUT;
+
+    adj.assign(2 * (size_t)numGenes, DCJ_UNSET);
+
+    for (uint32_t c = 0; c < genome.NumChromosomes(); c++)
+    {
+        const uint32_t begin    = genome.chromStarts[c];
+        const uint32_t end      = genome.chromStarts[c + 1];
+        uint32_t prevRight      = DCJ_TELOMERE;
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const int32_t gene = genome.genes[i];
+            if (gene == 0 || (uint32_t)abs(gene) > numGenes) return INVALID_INPUT;
+
+            const uint32_t left     = LeftExtremity(gene);
+            const uint32_t right    = RightExtremity(gene);
+
+            // A gene's extremities are only ever set by placing the gene or its neighbours, so a
+            // left extremity that is already set means the gene was placed before.
+
+            if (adj[left] != DCJ_UNSET) return INVALID_INPUT;
+
+            adj[left] = prevRight;
+            if (prevRight != DCJ_TELOMERE) adj[prevRight] = left;
+
+            adj[right]  = DCJ_TELOMERE;
+            prevRight   = right;
+        }
+
+        if (genome.circular[c])
+        {
+            const uint32_t first = LeftExtremity(genome.genes[begin]);
+
+            adj[first]      = prevRight;
+            adj[prevRight]  = first;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * DcjDistance - DCJ distance between two genomes with the same genes in O(n). Paths are walked from
+ * telomeres of a (ending in b they are odd), then from the remaining telomeres of b, and whatever is
+ * left lies on cycles.
+ *
+ * @param  a        [in]    First genome.
+ * @param  b        [in]    Second genome.
+ * @param  result   [out]   Gene, cycle and path counts and the distance.
+ *
+ * @return          INVALID_INPUT unless both genomes hold genes 1..N exactly once each. OK otherwise.
+ */
+
+ResultCode DcjDistance(const Genome& a, const Genome& b, DcjResult& result)
+{
+    const uint32_t numGenes = (uint32_t)a.genes.size();
+
+    vector<uint32_t> adjA;
+    vector<uint32_t> adjB;
+
+    if (BuildAdjacencies(a, numGenes, adjA) != OK || BuildAdjacencies(b, numGenes, adjB) != OK) return INVALID_INPUT;
+
+    const uint32_t numExt = 2 * numGenes;
+    vector<uint8_t> visited(numExt, 0);
+
+    result = { numGenes, 0, 0, 0, 0 };
+
+    // Paths. From a telomere of one genome, alternate through the other genome's adjacencies and
+    // this genome's until either array reaches a telomere.
+
+    const vector<uint32_t>* sides[2] = { &adjA, &adjB };
+
+    for (uint32_t s = 0; s < 2; s++)
+    {
+        const vector<uint32_t>& own     = *sides[s];
+        const vector<uint32_t>& other   = *sides[1 - s];
+
+        for (uint32_t e = 0; e < numExt; e++)
+        {
+            if (own[e] != DCJ_TELOMERE || visited[e]) continue;
+
+            uint32_t cur = e;
+            visited[cur] = 1;
+
+            while (true)
+            {
+                const uint32_t f = other[cur];
+
+                // Paths ending in the other genome were all found from a's side.
+
+                if (f == DCJ_TELOMERE)
+                {
+                    result.oddPaths++;
+                    break;
+                }
+
+                visited[f] = 1;
+                cur = own[f];
+
+                if (cur == DCJ_TELOMERE)
+                {
+                    result.evenPaths++;
+                    break;
+                }
+
+                visited[cur] = 1;
+            }
+        }
+    }
+
+    for (uint32_t e = 0; e < numExt; e++)
+    {
+        if (visited[e]) continue;
+
+        uint32_t cur = e;
+
+        do
+        {
+            const uint32_t f = adjA[cur];
+
+            visited[cur]    = 1;
+            visited[f]      = 1;
+            cur             = adjB[f];
+        } while (cur != e);
+
+        result.cycles++;
+    }
+
+    result.distance = numGenes - (result.cycles + result.oddPaths / 2);
+
+    return OK;
+}
+
+GeneDictionary::GeneDictionary() :
+    nameOffsets(1, 0),
+    slots(1024, 0)
+{
+}
+
+/**
+ * GetId - Id of a gene name, adding the name if it is new.
+ *
+ * @param  name [in] Name characters.
+ * @param  len  [in] Name length.
+ *
+ * @return      1 based gene id.
+ */
+
+uint32_t GeneDictionary::GetId(const char* name, const size_t len)
+{
+    // FNV-1a.
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+
+    const size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+
+    for (; slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        if ((uint32_t)(slots[slot] >> 32) != hash) continue;
+
+        const uint32_t id = (uint32_t)slots[slot];
+        if (nameOffsets[id] - nameOffsets[id - 1] == len && memcmp(nameData.data() + nameOffsets[id - 1], name, len) == 0) return id;
+    }
+
+    nameData.append(name, len);
+    nameOffsets.push_back((uint32_t)nameData.size());
+
+    const uint32_t id = Size();
+    slots[slot] = ((uint64_t)hash << 32) | id;
+
+    if (2 * (size_t)id > slots.size()) Grow();
+
+    return id;
+}
+
+/**
+ * Grow - Double the table and reinsert every slot by its stored hash.
+ */
+
+void GeneDictionary::Grow()
+{
+    vector<uint64_t> old = move(slots);
+    slots.assign(2 * old.size(), 0);
+
+    const size_t mask = slots.size() - 1;
+
+    for (auto entry : old)
+    {
+        if (entry == 0) continue;
+
+        size_t slot = (entry >> 32) & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+
+        slots[slot] = entry;
+    }
+}
+
+GeneOrderReader::GeneOrderReader() :
+    file(INVALID_HANDLE_VALUE),
+    pos(0),
+    len(0),
+    atEof(true),
+    readError(false)
+{
+}
+
+GeneOrderReader::~GeneOrderReader()
+{
+    Close();
+}
+
+/**
+ * Open - Open a gene order file for streaming. The gene dictionary is kept from earlier files.
+ *
+ * @param  path         [in] File to read.
+ * @param  bufferBytes  [in] Read buffer size.
+ *
+ * @return              IO_ERROR if the file can't be opened. OK otherwise.
+ */
+
+ResultCode GeneOrderReader::Open(const char* path, const size_t bufferBytes)
+{
+    Close();
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    buffer.resize(max(bufferBytes, (size_t)64));
+
+    pos         = 0;
+    len         = 0;
+    atEof       = false;
+    readError   = false;
+
+    return OK;
+}
+
+void GeneOrderReader::Close()
+{
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+    file        = INVALID_HANDLE_VALUE;
+    pos         = 0;
+    len         = 0;
+    atEof       = true;
+    readError   = false;
+}
+
+/**
+ * Refill - Read the next block of the file into the buffer.
+ *
+ * @return false at the end of the file or on a read error, which also sets readError.
+ */
+
+bool GeneOrderReader::Refill()
+{
+    if (atEof) return false;
+
+    DWORD bytesRead = 0;
+    const bool readOk = ReadFile(file, buffer.data(), (DWORD)buffer.size(), &bytesRead, NULL) != FALSE;
+
+    if (!readOk || bytesRead == 0)
+    {
+        readError   = !readOk;
+        atEof       = true;
+        return false;
+    }
+
+    pos = 0;
+    len = bytesRead;
+
+    return true;
+}
+
+void GeneOrderReader::SkipLine()
+{
+    int c;
+    while ((c = Peek()) >= 0 && c != '\n') pos++;
+}
+
+static inline bool IsGeneOrderSpace(const int c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline bool IsGeneOrderDelimiter(const int c) { return c < 0 || IsGeneOrderSpace(c) || c == '|' || c == '$' || c == ')'; }
+
+/**
+ * Next - Read the next genome.
+ *
+ * @param  genome   [out]   Genome read. Left with no chromosomes and an empty name once the file is
+ *                          exhausted.
+ *
+ * @return          INVALID_INPUT for a strand sign without a gene name. IO_ERROR if the file can't be
+ *                  read, rather than returning a genome cut short. OK otherwise.
+ */
+
+ResultCode GeneOrderReader::Next(Genome& genome)
+{
+    genome.Clear();
+
+    // Every genome after the first starts at the '>' that ended the previous one, so each call starts
+    // at the beginning of a line.
+
+    bool started    = false;
+    bool lineStart  = true;
+    int c;
+
+    while ((c = Peek()) >= 0)
+    {
+        if (c == '>' && lineStart)
+        {
+            if (started) break;
+
+            pos++;
+            started = true;
+
+            while ((c = Peek()) >= 0 && c != '\n')
+            {
+                if (c != '\r') genome.name.push_back((char)c);
+                pos++;
+            }
+
+            lineStart = false;
+            continue;
+        }
+
+        if (c == '#' && lineStart)
+        {
+            SkipLine();
+            continue;
+        }
+
+        pos++;
+        lineStart = c == '\n';
+
+        if (c == '\n' || c == '|' || c == '$') genome.EndChromosome(false);
+        else if (c == ')') genome.EndChromosome(true);
+        else if (!IsGeneOrderSpace(c))
+        {
+            const bool reverse = c == '-';
+
+            token.clear();
+            if (c != '-' && c != '+') token.push_back((char)c);
+
+            // Copy the rest of the name a buffer's worth at a time; only names cut off by the end of
+            // the buffer take more than one pass.
+
+            while (true)
+            {
+                size_t end = pos;
+                while (end < len && !IsGeneOrderDelimiter((unsigned char)buffer[end])) end++;
+
+                token.append(buffer.data() + pos, end - pos);
+                pos = end;
+
+                if (pos < len || !Refill()) break;
+            }
+
+            if (token.empty()) return INVALID_INPUT;
+
+            const int32_t id = (int32_t)genes.GetId(token.data(), token.size());
+            genome.genes.push_back(reverse ? -id : id);
+            started = true;
+        }
+    }
+
+    if (readError) return IO_ERROR;
+
+    genome.EndChromosome(false);
+
+    return OK;
+}
+
+/**
+ * GenomeFromAdjacencies - Test helper. Rebuild a genome from its adjacency array: linear chromosomes
+ * are read from each unvisited telomere, and the genes left over form circular chromosomes.
+ */
+
+static void GenomeFromAdjacencies(const vector<uint32_t>& adj, Genome& genome)
+{
+    genome.Clear();
+
+    const uint32_t numExt = (uint32_t)adj.size();
+    vector<uint8_t> visited(numExt, 0);
+
+    // Enter a gene at extremity e, add it with the strand that implies, and return the extremity
+    // joined to its other end.
+
+    auto addGene = [&](uint32_t e)
+    {
+        const int32_t gene  = (int32_t)(e >> 1) + 1;
+        const uint32_t exit = e ^ 1;
+
+        genome.genes.push_back((e & 1) ? -gene : gene);
+        visited[e] = visited[exit] = 1;
+
+        return adj[exit];
+    };
+
+    for (uint32_t e = 0; e < numExt; e++)
+    {
+        if (adj[e] != DCJ_TELOMERE || visited[e]) continue;
+
+        for (uint32_t cur = e; cur != DCJ_TELOMERE; ) cur = addGene(cur);
+        genome.EndChromosome(false);
+    }
+
+    for (uint32_t e = 0; e < numExt; e++)
+    {
+        if (visited[e]) continue;
+
+        for (uint32_t cur = e; !visited[cur]; ) cur = addGene(cur);
+        genome.EndChromosome(true);
+    }
+}
+
+/**
+ * RandomDcj - Test helper. Apply one random DCJ to an adjacency array: join two telomeres, reconnect
+ * an adjacency with a telomere, recombine two adjacencies, or occasionally cut an adjacency.
+ */
+
+static void RandomDcj(vector<uint32_t>& adj, Rng& rng)
+{
+    const uint32_t numExt = (uint32_t)adj.size();
+
+    const uint32_t u = rng.NextBounded(numExt);
+    const uint32_t pu = adj[u];
+
+    if (pu != DCJ_TELOMERE && rng.NextBounded(16) == 0)
+    {
+        adj[u] = adj[pu] = DCJ_TELOMERE;
+        return;
+    }
+
+    uint32_t v;
+    do v = rng.NextBounded(numExt); while (v == u || v == pu);
+
+    const uint32_t pv = adj[v];
+
+    adj[u] = v;
+    adj[v] = u;
+
+    if (pu != DCJ_TELOMERE && pv != DCJ_TELOMERE)
+    {
+        adj[pu] = pv;
+        adj[pv] = pu;
+    }
+    else if (pu != DCJ_TELOMERE) adj[pu] = DCJ_TELOMERE;
+    else if (pv != DCJ_TELOMERE) adj[pv] = DCJ_TELOMERE;
+}
+
+/**
+ * GenomeText - Test helper. Write genomes in gene order format, naming gene g "g<g>".
+ */
+
+static void GenomeText(const Genome& genome, string& text)
+{
+    text += ">" + genome.name + "\n";
+
+    for (uint32_t c = 0; c < genome.NumChromosomes(); c++)
+    {
+        for (uint32_t i = genome.chromStarts[c]; i < genome.chromStarts[c + 1]; i++)
+            text += (genome.genes[i] < 0 ? "-g" : "g") + to_string(abs(genome.genes[i])) + " ";
+
+        text += genome.circular[c] ? ")\n" : "|\n";
+    }
+}
+
+/**
+ * TestExamples - Read small genomes in every chromosome style from a file with a tiny buffer and
+ * check their distances from the first one: one reversal, one fission, one DCJ merging the circular
+ * chromosome into the linear one, one linearization, and a genome with a repeated gene.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestExamples(vector<TestResult>& testResults)
+{
+    const string text =
+        "# Examples\n"
+        ">base\n"
+        "a b c d |\n"
+        "e f g )\n"
+        ">reversal\n"
+        "a -c -b d |\r\n"
+        "e f g )\n"
+        ">fission\n"
+        "a b $ c d $\n"
+        "e f g )\n"
+        ">integration\n"
+        "a b g e f c d\n"
+        ">linearized\n"
+        "+a +b +c +d |\n"
+        "e f g |\n"
+        ">repeat\n"
+        "a b c d | e f a )\n";
+
+    const uint32_t expected[] = { 0, 1, 1, 1, 1 };
+
+    const string path = GetTempFilePath("dcj_examples.txt");
+    string err;
+
+    if (!WriteStringToFile(path, text)) err = "Failed to write test file.";
+
+    GeneOrderReader reader;
+    vector<Genome> genomes;
+
+    if (err.empty() && reader.Open(path.c_str(), 16) != OK) err = "Failed to open test file.";
+
+    while (err.empty())
+    {
+        Genome genome;
+
+        if (reader.Next(genome) != OK) err = "Read failed.";
+        else if (genome.NumChromosomes() == 0) break;
+
+        genomes.push_back(genome);
+    }
+
+    reader.Close();
+    DeleteFileA(path.c_str());
+
+    if (err.empty() && genomes.size() != 6) err = "Read " + to_string(genomes.size()) + " genomes, expected 6.";
+    if (err.empty() && (genomes[0].name != "base" || genomes[3].NumChromosomes() != 1 || genomes[1].circular[1] != 1))
+        err = "Genome contents wrong.";
+
+    for (uint32_t i = 0; i < 5 && err.empty(); i++)
+    {
+        DcjResult result;
+
+        if (DcjDistance(genomes[0], genomes[i], result) != OK) err = "Distance failed for " + genomes[i].name;
+        else if (result.distance != expected[i])
+            err = genomes[i].name + " distance " + to_string(result.distance) + ", expected " + to_string(expected[i]);
+    }
+
+    DcjResult result;
+    if (err.empty() && DcjDistance(genomes[0], genomes[5], result) != INVALID_INPUT) err = "Repeated gene not rejected.";
+
+    if (err.empty()) testResults.push_back({ "Dcj::Examples", PASS, "" });
+    else testResults.push_back({ "Dcj::Examples", FAIL, err });
+}
+
+/**
+ * TestReaderEdgeCases - '>' and '#' away from the first column are part of gene names, and a read
+ * error is reported instead of ending the genome early.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestReaderEdgeCases(vector<TestResult>& testResults)
+{
+    const string text =
+        ">marks\n"
+        "a#1 b>2 # |\n"
+        "#comment >notaname\n"
+        "c >d )\n";
+
+    const string path = GetTempFilePath("dcj_edge_cases.txt");
+    string err;
+
+    if (!WriteStringToFile(path, text)) err = "Failed to write test file.";
+
+    GeneOrderReader reader;
+    Genome genome;
+
+    if (err.empty() && (reader.Open(path.c_str(), 8) != OK || reader.Next(genome) != OK)) err = "Read failed.";
+
+    if (err.empty())
+    {
+        string names;
+        for (auto gene : genome.genes) names += string(reader.genes.Name((uint32_t)abs(gene))) + " ";
+
+        if (genome.name != "marks" || genome.NumChromosomes() != 2 || names != "a#1 b>2 # c >d ")
+            err = "Marks away from the first column misread: " + names;
+    }
+
+    // A handle that can't be read from stands in for a failing disk.
+
+    if (err.empty() && reader.Open(path.c_str(), 8) == OK)
+    {
+        CloseHandle(reader.file);
+        reader.file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (reader.Next(genome) != IO_ERROR) err = "Read error not reported.";
+    }
+
+    reader.Close();
+    DeleteFileA(path.c_str());
+
+    if (err.empty()) testResults.push_back({ "Dcj::ReaderEdgeCases", PASS, "" });
+    else testResults.push_back({ "Dcj::ReaderEdgeCases", FAIL, err });
+}
+
+/**
+ * TestRandomOperations - Apply k random DCJs to a linear genome and check the
+ * distance is at most k, symmetric, zero against itself, and exactly one after a single DCJ.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestRandomOperations(vector<TestResult>& testResults)
+{
+    Rng rng(101);
+    string err;
+
+    for (uint32_t trial = 0; trial < 200 && err.empty(); trial++)
+    {
+        const uint32_t numGenes = 2 + rng.NextBounded(300);
+        const uint32_t numOps   = trial < 100 ? 1 + rng.NextBounded(3) : rng.NextBounded(2 * numGenes);
+
+        // Start from one linear chromosome of consecutive genes.
+
+        vector<uint32_t> adj(2 * (size_t)numGenes);
+
+        for (uint32_t g = 0; g < numGenes; g++)
+        {
+            adj[2 * g]      = g == 0 ? DCJ_TELOMERE : 2 * g - 1;
+            adj[2 * g + 1]  = g + 1 == numGenes ? DCJ_TELOMERE : 2 * g + 2;
+        }
+
+        Genome a;
+        GenomeFromAdjacencies(adj, a);
+
+        for (uint32_t op = 0; op < numOps; op++) RandomDcj(adj, rng);
+
+        Genome b;
+        GenomeFromAdjacencies(adj, b);
+
+        DcjResult ab;
+        DcjResult ba;
+        DcjResult aa;
+
+        if (DcjDistance(a, b, ab) != OK || DcjDistance(b, a, ba) != OK || DcjDistance(a, a, aa) != OK) err = "Distance failed.";
+        else if (ab.distance > numOps) err = "Distance above operation count at trial " + to_string(trial);
+        else if (ab.distance != ba.distance) err = "Distance not symmetric at trial " + to_string(trial);
+        else if (aa.distance != 0) err = "Self distance not zero at trial " + to_string(trial);
+        else if (numOps == 1 && ab.distance != 1) err = "Single DCJ not detected at trial " + to_string(trial);
+    }
+
+    if (err.empty()) testResults.push_back({ "Dcj::RandomOperations", PASS, "" });
+    else testResults.push_back({ "Dcj::RandomOperations", FAIL, err });
+}
+
+/**
+ * TestThroughput - Write two genomes of 10^6 genes in 20 chromosomes, 10^5 DCJs apart, and time
+ * reading them back against computing their distance.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    const uint32_t numGenes = 1000000;
+    const uint32_t numChrom = 20;
+    const uint32_t numOps   = 100000;
+
+    Rng rng(102);
+
+    vector<uint32_t> adj(2 * (size_t)numGenes);
+
+    for (uint32_t g = 0; g < numGenes; g++)
+    {
+        const bool first    = g % (numGenes / numChrom) == 0;
+        const bool last     = (g + 1) % (numGenes / numChrom) == 0;
+
+        adj[2 * g]      = first ? DCJ_TELOMERE : 2 * g - 1;
+        adj[2 * g + 1]  = last ? DCJ_TELOMERE : 2 * g + 2;
+    }
+
+    Genome a;
+    GenomeFromAdjacencies(adj, a);
+    a.name = "a";
+
+    for (uint32_t op = 0; op < numOps; op++) RandomDcj(adj, rng);
+
+    Genome b;
+    GenomeFromAdjacencies(adj, b);
+    b.name = "b";
+
+    string text;
+    GenomeText(a, text);
+    GenomeText(b, text);
+
+    const string path = GetTempFilePath("dcj_throughput.txt");
+    string err;
+
+    if (!WriteStringToFile(path, text)) err = "Failed to write test file.";
+
+    Genome readA;
+    Genome readB;
+    DcjResult result;
+
+    long long t1 = GetMilliseconds();
+
+    GeneOrderReader reader;
+
+    if (err.empty() && (reader.Open(path.c_str()) != OK || reader.Next(readA) != OK || reader.Next(readB) != OK)) err = "Read failed.";
+
+    long long t2 = GetMilliseconds();
+
+    if (err.empty() && DcjDistance(readA, readB, result) != OK) err = "Distance failed.";
+
+    long long t3 = GetMilliseconds();
+
+    reader.Close();
+    DeleteFileA(path.c_str());
+
+    if (err.empty() && result.distance > numOps) err = "Distance above operation count.";
+
+    const float readSec = ((float)t2 - (float)t1) / 1000.0f;
+    const float distSec = ((float)t3 - (float)t2) / 1000.0f;
+
+    if (err.empty())
+    {
+        testResults.push_back({ "Dcj::Throughput", PASS,
+            "Distance " + to_string(result.distance) + ", read T = " + to_string(readSec) + " sec, distance T = " + to_string(distSec) + " sec." });
+    }
+    else testResults.push_back({ "Dcj::Throughput", FAIL, err });
+}
+
+/**
+ * DoubleCutJoin - Tests for DCJ distance and gene order reading.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void DoubleCutJoin(vector<TestResult>& testResults)
+{
+    TestExamples(testResults);
+    TestReaderEdgeCases(testResults);
+    TestRandomOperations(testResults);
+    TestThroughput(testResults);
+}
@@ -0,0 +1,535 @@
+#include "problems.h"
+#include "distmatrix.h"
+
+/*
+ * Pairs are computed in square tiles of permutations sized so a tile row's values and a tile
+ * column's positions stay in L2 together. Only tiles on or above the diagonal are scheduled, and
+ * threads take them from a shared counter since diagonal tiles hold half the pairs of the others.
+ */
+
+static const size_t DIST_TILE_BYTES             = 256 << 10;
+static const uint32_t DIST_MAX_TILE             = 256;
+static const uint64_t DIST_MATRIX_DATA_OFFSET   = 64;
+
+/**
+ * Add - Append a framed permutation of the batch's length.
+ *
+ * @param  perm [in] Framed permutation of n elements.
+ *
+ * @return      INVALID_INPUT if perm isn't a framed permutation of n elements. OK otherwise.
+ */
+
+ResultCode PermutationBatch::Add(const vector<uint32_t>& perm)
+{
+    if (perm.size() != Stride() || !IsFramedPermutation(perm)) return INVALID_INPUT;
+
+    const size_t base = (size_t)count * Stride();
+
+    values.insert(values.end(), perm.begin(), perm.end());
+    positions.resize(base + Stride());
+
+    for (uint32_t p = 0; p < Stride(); p++) positions[base + perm[p]] = p;
+
+    count++;
+    return OK;
+}
+
+DistMatrixFile::DistMatrixFile() :
+    file(INVALID_HANDLE_VALUE),
+    mapping(NULL),
+    view(nullptr),
+    fileSize(0),
+    count(0),
+    breakpoints(nullptr),
+    reversals(nullptr)
+{
+}
+
+DistMatrixFile::~DistMatrixFile()
+{
+    Close();
+}
+
+/**
+ * Create - Create a distance matrix file of the right size, write its header and map it for writing.
+ *
+ * @param  path     [in] Output file path. Overwritten if it exists.
+ * @param  count    [in] Number of permutations.
+ * @param  n        [in] Permutation length, recorded in the header.
+ *
+ * @return          IO_ERROR if the file can't be created or mapped. OK otherwise.
+ */
+
+ResultCode DistMatrixFile::Create(const char* path, const uint32_t count, const uint32_t n)
+{
+    Close();
+
+    const uint64_t matrixBytes = (uint64_t)count * count * sizeof(uint32_t);
+
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    fileSize = DIST_MATRIX_DATA_OFFSET + 2 * matrixBytes;
+    mapping  = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)fileSize, NULL);
+
+    if (mapping != NULL) view = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (size_t)fileSize);
+
+    if (view == nullptr)
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    DistMatrixFileHeader header = {};
+    memcpy(header.magic, DIST_MATRIX_MAGIC, 4);
+
+    header.version          = DIST_MATRIX_VERSION;
+    header.count            = count;
+    header.n                = n;
+    header.breakpointOffset = DIST_MATRIX_DATA_OFFSET;
+    header.reversalOffset   = DIST_MATRIX_DATA_OFFSET + matrixBytes;
+
+    memcpy(view, &header, sizeof(header));
+
+    this->count = count;
+    breakpoints = (uint32_t*)(view + header.breakpointOffset);
+    reversals   = (uint32_t*)(view + header.reversalOffset);
+
+    return OK;
+}
+
+/**
+ * Open - Map an existing distance matrix file read only. The matrix pointers must not be written.
+ *
+ * @param  path [in] File to read.
+ *
+ * @return      IO_ERROR if the file can't be opened or mapped. INVALID_INPUT if it isn't a distance
+ *              matrix file or is truncated. OK otherwise.
+ */
+
+ResultCode DistMatrixFile::Open(const char* path)
+{
+    Close();
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    fileSize = (uint64_t)size.QuadPart;
+
+    if (fileSize < sizeof(DistMatrixFileHeader))
+    {
+        Close();
+        return INVALID_INPUT;
+    }
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping != NULL) view = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (view == nullptr)
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    DistMatrixFileHeader header;
+    memcpy(&header, view, sizeof(header));
+
+    const uint64_t matrixBytes = (uint64_t)header.count * header.count * sizeof(uint32_t);
+
+    if (memcmp(header.magic, DIST_MATRIX_MAGIC, 4) != 0 ||
+        header.version != DIST_MATRIX_VERSION ||
+        header.breakpointOffset + matrixBytes > fileSize ||
+        header.reversalOffset + matrixBytes > fileSize)
+    {
+        Close();
+        return INVALID_INPUT;
+    }
+
+    count       = header.count;
+    breakpoints = (uint32_t*)(view + header.breakpointOffset);
+    reversals   = (uint32_t*)(view + header.reversalOffset);
+
+    return OK;
+}
+
+void DistMatrixFile::Close()
+{
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+    file        = INVALID_HANDLE_VALUE;
+    mapping     = NULL;
+    view        = nullptr;
+    fileSize    = 0;
+    count       = 0;
+    breakpoints = nullptr;
+    reversals   = nullptr;
+}
+
+/*
+ * Per-thread scratch: the relative permutation of the current pair and the sorter's buffers, reused
+ * for every pair the thread computes.
+ */
+
+struct DistScratch
+{
+    vector<uint32_t> relative;
+    ReversalScratch sorter;
+};
+
+/**
+ * ComputeTile - Distances for pairs i < j with i in the row tile and j in the column tile. The relative
+ * permutation of a pair writes i in j's coordinates, so its breakpoints are the adjacencies of i
+ * missing from j and sorting it turns i into j.
+ *
+ * @return UNABLE_TO_FIND_SOLUTION if a sort fails. OK otherwise.
+ */
+
+static ResultCode ComputeTile(
+    const PermutationBatch& batch,
+    const uint32_t rowBegin,
+    const uint32_t rowEnd,
+    const uint32_t colBegin,
+    const uint32_t colEnd,
+    DistScratch& scratch,
+    uint32_t* breakpoints,
+    uint32_t* reversals
+)
+{
+    const uint32_t stride   = batch.Stride();
+    const size_t count      = batch.count;
+
+    scratch.relative.resize(stride);
+    uint32_t* relative = scratch.relative.data();
+
+    for (uint32_t i = rowBegin; i < rowEnd; i++)
+    {
+        const uint32_t* values = batch.Values(i);
+
+        for (uint32_t j = max(colBegin, i + 1); j < colEnd; j++)
+        {
+            const uint32_t* positions = batch.Positions(j);
+
+            // Values differing by one give a difference plus one of 0 or 2 in unsigned arithmetic. The
+            // relative permutation is only stored when it will be sorted.
+
+            uint32_t prev   = 0;
+            uint32_t breaks = 0;
+
+            if (reversals == nullptr)
+            {
+                for (uint32_t p = 1; p < stride; p++)
+                {
+                    const uint32_t cur = positions[values[p]];
+                    breaks += ((cur - prev + 1) & ~2u) != 0 ? 1 : 0;
+                    prev   = cur;
+                }
+
+                breakpoints[i * count + j] = breaks;
+                breakpoints[j * count + i] = breaks;
+                continue;
+            }
+
+            relative[0] = 0;
+
+            for (uint32_t p = 1; p < stride; p++)
+            {
+                relative[p] = positions[values[p]];
+                breaks      += ((relative[p] - prev + 1) & ~2u) != 0 ? 1 : 0;
+                prev        = relative[p];
+            }
+
+            breakpoints[i * count + j] = breaks;
+            breakpoints[j * count + i] = breaks;
+
+            uint32_t numReversals = 0;
+
+            if (breaks > 0)
+            {
+                if (BreakPointReversal(scratch.relative, scratch.sorter) != OK) return UNABLE_TO_FIND_SOLUTION;
+                numReversals = (uint32_t)scratch.sorter.reversals.size();
+            }
+
+            reversals[i * count + j] = numReversals;
+            reversals[j * count + i] = numReversals;
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * ComputeDistanceMatrix - All-pairs breakpoint and greedy reversal distances in parallel.
+ *
+ * @param  batch        [in]        Permutations to compare.
+ * @param  breakpoints  [in/out]    count x count row-major breakpoint distances.
+ * @param  reversals    [in/out]    count x count row-major reversal distances, or nullptr to compute
+ *                                  breakpoint distances only.
+ *
+ * @return              INVALID_INPUT if breakpoints is null. UNABLE_TO_FIND_SOLUTION if a sort fails.
+ *                      OK otherwise.
+ */
+
+ResultCode ComputeDistanceMatrix(const PermutationBatch& batch, uint32_t* breakpoints, uint32_t* reversals)
+{
+    if (breakpoints == nullptr) return INVALID_INPUT;
+
+    const uint32_t count = batch.count;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        breakpoints[i * count + i] = 0;
+        if (reversals) reversals[i * count + i] = 0;
+    }
+
+    const size_t tileFit    = DIST_TILE_BYTES / (2 * (size_t)batch.Stride() * sizeof(uint32_t));
+    const uint32_t tileSize = (uint32_t)max((size_t)1, min((size_t)DIST_MAX_TILE, tileFit));
+    const uint32_t numTiles = (count + tileSize - 1) / tileSize;
+
+    vector<pair<uint32_t, uint32_t>> tiles;
+
+    for (uint32_t bi = 0; bi < numTiles; bi++)
+        for (uint32_t bj = bi; bj < numTiles; bj++) tiles.push_back({ bi, bj });
+
+    const uint32_t numThreads = GetWorkerCount();
+
+    vector<DistScratch> scratch(numThreads);
+    atomic<uint32_t> nextTile(0);
+    atomic<bool> ok(true);
+
+    ParallelFor(numThreads, [&](uint32_t, uint32_t, uint32_t threadIdx)
+    {
+        for (uint32_t t = nextTile++; t < tiles.size() && ok; t = nextTile++)
+        {
+            const uint32_t rowBegin = tiles[t].first * tileSize;
+            const uint32_t colBegin = tiles[t].second * tileSize;
+
+            ResultCode res = ComputeTile(
+                batch,
+                rowBegin,
+                min(rowBegin + tileSize, count),
+                colBegin,
+                min(colBegin + tileSize, count),
+                scratch[threadIdx],
+                breakpoints,
+                reversals
+            );
+
+            if (res != OK) ok = false;
+        }
+    });
+
+    return ok ? OK : UNABLE_TO_FIND_SOLUTION;
+}
+
+/**
+ * WriteDistanceMatrix - Compute all-pairs distances straight into a memory-mapped distance matrix file.
+ *
+ * @param  batch    [in] Permutations to compare.
+ * @param  path     [in] Output file path. Overwritten if it exists, deleted if the computation fails.
+ *
+ * @return          IO_ERROR if the file can't be created or mapped. UNABLE_TO_FIND_SOLUTION if a sort
+ *                  fails. OK otherwise.
+ */
+
+ResultCode WriteDistanceMatrix(const PermutationBatch& batch, const char* path)
+{
+    DistMatrixFile out;
+
+    ResultCode res = out.Create(path, batch.count, batch.n);
+    if (res != OK) return res;
+
+    res = ComputeDistanceMatrix(batch, out.breakpoints, out.reversals);
+
+    if (res == OK && !FlushViewOfFile(out.view, 0)) res = IO_ERROR;
+
+    out.Close();
+    if (res != OK) DeleteFileA(path);
+
+    return res;
+}
+
+/**
+ * RandomBatch - Test helper. count framed permutations of n elements. Each one after the first is
+ * either a fresh shuffle or an earlier one scrambled by a few reversals, so the batch mixes close and
+ * distant pairs.
+ */
+
+static void RandomBatch(const uint32_t count, const uint32_t n, Rng& rng, PermutationBatch& batch)
+{
+    vector<uint32_t> perm(n + 2);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i > 0 && rng.NextBounded(2) == 0)
+        {
+            const uint32_t* src = batch.Values(rng.NextBounded(i));
+            perm.assign(src, src + n + 2);
+
+            for (uint32_t r = rng.NextBounded(4); r > 0; r--)
+            {
+                uint32_t l = 1 + rng.NextBounded(n);
+                uint32_t e = 1 + rng.NextBounded(n);
+                if (l > e) swap(l, e);
+                reverse(perm.begin() + l, perm.begin() + e + 1);
+            }
+        }
+        else
+        {
+            for (uint32_t p = 0; p < n + 2; p++) perm[p] = p;
+            for (uint32_t p = n; p > 1; p--) swap(perm[p], perm[1 + rng.NextBounded(p)]);
+        }
+
+        batch.Add(perm);
+    }
+}
+
+/**
+ * TestReference - Write a matrix file, map it back and compare every entry with distances from the
+ * single permutation routines.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestReference(vector<TestResult>& testResults)
+{
+    const uint32_t count    = 60;
+    const uint32_t n        = 50;
+
+    Rng rng(81);
+    PermutationBatch batch(n);
+    RandomBatch(count, n, rng, batch);
+
+    const string path = GetTempFilePath("distmatrix_test.bin");
+
+    string err;
+    ResultCode res = WriteDistanceMatrix(batch, path.c_str());
+
+    DistMatrixFile in;
+    if (res == OK) res = in.Open(path.c_str());
+
+    if (res != OK) err = "Write or open failed with code " + to_string(res);
+    else if (in.count != count) err = "Wrong count in file.";
+
+    vector<uint32_t> relative(n + 2);
+
+    for (uint32_t i = 0; i < count && err.empty(); i++)
+    {
+        for (uint32_t j = 0; j < count && err.empty(); j++)
+        {
+            const uint32_t lo = min(i, j);
+            const uint32_t hi = max(i, j);
+
+            for (uint32_t p = 0; p < n + 2; p++) relative[p] = batch.Positions(hi)[batch.Values(lo)[p]];
+
+            vector<Reversal> reversals;
+            BreakPointReversal(relative, reversals, PERM_STORAGE_VECTOR);
+
+            for (uint32_t p = 0; p < n + 2; p++) relative[p] = batch.Positions(hi)[batch.Values(lo)[p]];
+
+            if (in.Breakpoints(i, j) != CountBreakpoints(relative))
+                err = "Breakpoint distance wrong at " + to_string(i) + ", " + to_string(j);
+            else if (in.Reversals(i, j) != reversals.size())
+                err = "Reversal distance wrong at " + to_string(i) + ", " + to_string(j);
+        }
+    }
+
+    in.Close();
+    DeleteFileA(path.c_str());
+
+    if (err.empty()) testResults.push_back({ "DistMatrix::Reference", PASS, "" });
+    else testResults.push_back({ "DistMatrix::Reference", FAIL, err });
+}
+
+/**
+ * TestThroughput - Time breakpoint-only and full matrices, the full one against a plain pair loop
+ * that sorts each pair with fresh buffers on one thread.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    Rng rng(82);
+
+    {
+        const uint32_t count = 2000;
+        const uint32_t n     = 500;
+
+        PermutationBatch batch(n);
+        RandomBatch(count, n, rng, batch);
+
+        vector<uint32_t> breakpoints((size_t)count * count);
+
+        long long t1    = GetMilliseconds();
+        ResultCode res  = ComputeDistanceMatrix(batch, breakpoints.data(), nullptr);
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const string name = "DistMatrix::Breakpoints[" + to_string(count) + "x" + to_string(n) + "]";
+
+        if (res == OK) testResults.push_back({ name, PASS, "T = " + to_string(sec) + " sec." });
+        else testResults.push_back({ name, FAIL, "Failed with code " + to_string(res) });
+    }
+
+    const uint32_t count = 300;
+    const uint32_t n     = 200;
+
+    PermutationBatch batch(n);
+    RandomBatch(count, n, rng, batch);
+
+    vector<uint32_t> breakpoints((size_t)count * count);
+    vector<uint32_t> reversals((size_t)count * count);
+
+    long long t1    = GetMilliseconds();
+    ResultCode res  = ComputeDistanceMatrix(batch, breakpoints.data(), reversals.data());
+    long long t2    = GetMilliseconds();
+
+    bool match = true;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        for (uint32_t j = i + 1; j < count; j++)
+        {
+            vector<uint32_t> relative(n + 2);
+            for (uint32_t p = 0; p < n + 2; p++) relative[p] = batch.Positions(j)[batch.Values(i)[p]];
+
+            vector<Reversal> pairReversals;
+            BreakPointReversal(relative, pairReversals, PERM_STORAGE_VECTOR);
+
+            match = match && reversals[(size_t)i * count + j] == pairReversals.size();
+        }
+    }
+
+    long long t3 = GetMilliseconds();
+
+    const float matrixSec   = ((float)t2 - (float)t1) / 1000.0f;
+    const float pairSec     = ((float)t3 - (float)t2) / 1000.0f;
+    const string name       = "DistMatrix::Full[" + to_string(count) + "x" + to_string(n) + "]";
+
+    if (res == OK && match)
+        testResults.push_back({ name, PASS, "Matrix T = " + to_string(matrixSec) + " sec, pair loop T = " + to_string(pairSec) + " sec." });
+    else
+        testResults.push_back({ name, FAIL, "Matrix and pair loop disagree." });
+}
+
+/**
+ * RearrangementMatrix - Tests for all-pairs rearrangement distances.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void RearrangementMatrix(vector<TestResult>& testResults)
+{
+    TestReference(testResults);
+    TestThroughput(testResults);
+}
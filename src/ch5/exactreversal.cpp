@@ -0,0 +1,574 @@
+#include "problems.h"
+#include "reversal.h"
+
+#include <memory>
+
+/*
+ * Exact unsigned reversal distance for small permutations. A framed permutation of n <= 14 elements
+ * packs into one 64-bit word, 4 bits per position, so a reversal is a nibble reverse of a masked
+ * segment and states hash and compare as integers.
+ */
+
+typedef uint64_t PackedPerm;
+
+static const uint32_t STATE_DEPTH_NONE      = 0xFF;
+static const uint32_t STATE_TABLE_MIN_BITS  = 16;
+
+/*
+ * Reversal of positions [l, r] on a packed permutation, precomputed per (l, r).
+ */
+
+struct PackedReversal
+{
+    uint64_t mask;          // Segment bits in place.
+    uint32_t shift;         // 4 * l.
+    uint32_t revShift;      // Shift that brings a fully nibble reversed segment back to bit 0.
+};
+
+static PackedPerm PackPermutation(const vector<uint32_t>& perm)
+{
+    PackedPerm x = 0;
+    for (size_t i = 0; i < perm.size(); i++) x |= (uint64_t)perm[i] << (4 * i);
+    return x;
+}
+
+static void UnpackPermutation(PackedPerm x, const uint32_t size, vector<uint32_t>& perm)
+{
+    perm.resize(size);
+    for (uint32_t i = 0; i < size; i++, x >>= 4) perm[i] = (uint32_t)(x & 15);
+}
+
+static inline uint64_t NibbleReverse(uint64_t v)
+{
+    v = _byteswap_uint64(v);
+    return ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+}
+
+static inline PackedPerm ApplyPackedReversal(const PackedPerm x, const PackedReversal& rev)
+{
+    const uint64_t seg = (x & rev.mask) >> rev.shift;
+    return (x & ~rev.mask) | ((NibbleReverse(seg) >> rev.revShift) << rev.shift);
+}
+
+/**
+ * GetPackedReversals - Every reversal of two or more elements inside the frame of an n element
+ * permutation. Single element reversals are no-ops for unsigned permutations.
+ */
+
+static void GetPackedReversals(const uint32_t n, vector<PackedReversal>& revs)
+{
+    revs.clear();
+
+    for (uint32_t l = 1; l <= n; l++)
+    {
+        for (uint32_t r = l + 1; r <= n; r++)
+        {
+            const uint32_t len = r - l + 1;
+            revs.push_back({ ((1ULL << (4 * len)) - 1) << (4 * l), 4 * l, 64 - 4 * len });
+        }
+    }
+}
+
+/*
+ * Open addressing set of packed states with the BFS depth each was reached at. Keys are claimed with
+ * a compare-and-swap so a level can be expanded by several threads at once; 0 marks an empty slot,
+ * which no framed permutation packs to since its last nibble is n + 1. Depths are written by the
+ * claiming thread and only read after the level's threads have joined.
+ */
+
+struct PackedStateTable
+{
+    unique_ptr<atomic<uint64_t>[]> keys;
+    unique_ptr<uint8_t[]> depths;
+    uint32_t bits;
+    atomic<size_t> size;
+
+    PackedStateTable() : bits(0), size(0) { Reset(STATE_TABLE_MIN_BITS); }
+
+    size_t Capacity() const { return (size_t)1 << bits; }
+    size_t Slot(const uint64_t key) const { return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits)); }
+
+    void Reset(const uint32_t newBits)
+    {
+        bits = newBits;
+        size = 0;
+        keys.reset(new atomic<uint64_t>[Capacity()]);
+        depths.reset(new uint8_t[Capacity()]);
+
+        for (size_t i = 0; i < Capacity(); i++) keys[i].store(0, memory_order_relaxed);
+    }
+
+    /**
+     * Insert - Add a state. Returns false if it was already present.
+     */
+
+    bool Insert(const uint64_t key, const uint8_t depth)
+    {
+        const size_t mask = Capacity() - 1;
+
+        for (size_t i = Slot(key); ; i = (i + 1) & mask)
+        {
+            uint64_t cur = keys[i].load(memory_order_relaxed);
+
+            if (cur == 0 && keys[i].compare_exchange_strong(cur, key, memory_order_relaxed))
+            {
+                depths[i] = depth;
+                size.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+
+            if (cur == key) return false;
+        }
+    }
+
+    /**
+     * Find - Depth a state was reached at, or STATE_DEPTH_NONE.
+     */
+
+    uint32_t Find(const uint64_t key) const
+    {
+        const size_t mask = Capacity() - 1;
+
+        for (size_t i = Slot(key); ; i = (i + 1) & mask)
+        {
+            const uint64_t cur = keys[i].load(memory_order_relaxed);
+
+            if (cur == key) return depths[i];
+            if (cur == 0) return STATE_DEPTH_NONE;
+        }
+    }
+
+    /**
+     * Reserve - Grow, single threaded, until count states fit at half load.
+     */
+
+    void Reserve(const size_t count)
+    {
+        uint32_t newBits = bits;
+        while (((size_t)1 << newBits) < 2 * count) newBits++;
+
+        if (newBits == bits) return;
+
+        unique_ptr<atomic<uint64_t>[]> oldKeys  = move(keys);
+        unique_ptr<uint8_t[]> oldDepths         = move(depths);
+        const size_t oldCapacity                = Capacity();
+
+        Reset(newBits);
+
+        for (size_t i = 0; i < oldCapacity; i++)
+        {
+            const uint64_t key = oldKeys[i].load(memory_order_relaxed);
+            if (key != 0) Insert(key, oldDepths[i]);
+        }
+    }
+};
+
+/*
+ * One side of the bidirectional search: the states reached so far and the last level's frontier.
+ */
+
+struct SearchSide
+{
+    PackedStateTable visited;
+    vector<PackedPerm> frontier;
+    uint32_t depth;
+};
+
+/**
+ * ExpandLevel - Expand one side's frontier by a level in parallel, checking each new state against
+ * the other side. The frontier is expanded in chunks no larger than the table already holds, so the
+ * table is grown between chunks rather than under the threads.
+ *
+ * @param  side     [in/out]    Side to expand.
+ * @param  other    [in]        Opposite side, read only.
+ * @param  revs     [in]        Reversals to apply.
+ * @param  best     [in/out]    Shortest meeting distance found, or UINT32_MAX.
+ */
+
+static void ExpandLevel(SearchSide& side, const SearchSide& other, const vector<PackedReversal>& revs, uint32_t& best)
+{
+    const uint32_t numThreads   = GetWorkerCount();
+    const uint8_t childDepth    = (uint8_t)(side.depth + 1);
+    const size_t numRevs        = revs.size();
+
+    vector<vector<PackedPerm>> next(numThreads);
+    atomic<uint32_t> meet(UINT32_MAX);
+
+    for (size_t start = 0; start < side.frontier.size(); )
+    {
+        const size_t chunk = min(side.frontier.size() - start, max((size_t)4096, side.visited.size.load() / numRevs));
+
+        side.visited.Reserve(side.visited.size.load() + chunk * numRevs);
+
+        ParallelFor((uint32_t)chunk, [&](uint32_t begin, uint32_t end, uint32_t threadIdx)
+        {
+            vector<PackedPerm>& out = next[threadIdx];
+            uint32_t localMeet      = UINT32_MAX;
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const PackedPerm x = side.frontier[start + i];
+
+                for (auto& rev : revs)
+                {
+                    const PackedPerm child = ApplyPackedReversal(x, rev);
+
+                    const uint32_t otherDepth = other.visited.Find(child);
+                    if (otherDepth != STATE_DEPTH_NONE) localMeet = min(localMeet, childDepth + otherDepth);
+
+                    if (side.visited.Insert(child, childDepth)) out.push_back(child);
+                }
+            }
+
+            uint32_t cur = meet.load();
+            while (localMeet < cur && !meet.compare_exchange_weak(cur, localMeet)) {}
+        });
+
+        start += chunk;
+    }
+
+    side.frontier.clear();
+    for (auto& out : next) side.frontier.insert(side.frontier.end(), out.begin(), out.end());
+
+    side.depth++;
+    best = min(best, meet.load());
+}
+
+/**
+ * ExactReversalDistance - Exact unsigned reversal distance by bidirectional breadth first search
+ * between the permutation and the identity, always expanding the smaller frontier. Once a level
+ * meets the other side the shortest meeting found that level is the distance, since the two sides
+ * were disjoint up to their previous depths.
+ *
+ * @param  perm     [in]    Framed permutation of at most EXACT_REVERSAL_MAX_N elements.
+ * @param  distance [out]   Reversal distance.
+ *
+ * @return          INVALID_INPUT if perm isn't a framed permutation or is too long. OK otherwise.
+ */
+
+ResultCode ExactReversalDistance(const vector<uint32_t>& perm, uint32_t& distance)
+{
+    if (!IsFramedPermutation(perm) || perm.size() > EXACT_REVERSAL_MAX_N + 2) return INVALID_INPUT;
+
+    const uint32_t n = (uint32_t)perm.size() - 2;
+
+    vector<uint32_t> identity(n + 2);
+    for (uint32_t i = 0; i < n + 2; i++) identity[i] = i;
+
+    const PackedPerm start  = PackPermutation(perm);
+    const PackedPerm target = PackPermutation(identity);
+
+    distance = 0;
+    if (start == target) return OK;
+
+    vector<PackedReversal> revs;
+    GetPackedReversals(n, revs);
+
+    SearchSide sides[2];
+    const PackedPerm roots[2] = { start, target };
+
+    for (uint32_t s = 0; s < 2; s++)
+    {
+        sides[s].visited.Insert(roots[s], 0);
+        sides[s].frontier.push_back(roots[s]);
+        sides[s].depth = 0;
+    }
+
+    uint32_t best = UINT32_MAX;
+
+    while (best == UINT32_MAX)
+    {
+        const uint32_t s = sides[0].frontier.size() <= sides[1].frontier.size() ? 0 : 1;
+        ExpandLevel(sides[s], sides[1 - s], revs, best);
+    }
+
+    distance = best;
+    return OK;
+}
+
+/**
+ * RankPermutation - Lexicographic rank (Lehmer code) of a framed permutation's interior among all
+ * permutations of 1..n. The table from ComputeReversalDistanceTable is indexed by this rank.
+ */
+
+uint64_t RankPermutation(const vector<uint32_t>& perm)
+{
+    const uint32_t n    = (uint32_t)perm.size() - 2;
+    uint64_t rank       = 0;
+    uint32_t unused     = (1u << (n + 1)) - 2;
+
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        const uint32_t smaller = __popcnt(unused & ((1u << perm[i]) - 1));
+
+        rank    = rank * (n - i + 1) + smaller;
+        unused  &= ~(1u << perm[i]);
+    }
+
+    return rank;
+}
+
+static uint64_t RankPacked(PackedPerm x, const uint32_t n)
+{
+    uint64_t rank   = 0;
+    uint32_t unused = (1u << (n + 1)) - 2;
+
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        const uint32_t val = (uint32_t)((x >> (4 * i)) & 15);
+
+        rank    = rank * (n - i + 1) + __popcnt(unused & ((1u << val) - 1));
+        unused  &= ~(1u << val);
+    }
+
+    return rank;
+}
+
+static PackedPerm UnrankPacked(uint64_t rank, const uint32_t n, const uint64_t* factorials)
+{
+    PackedPerm x    = (uint64_t)(n + 1) << (4 * (n + 1));
+    uint32_t unused = (1u << (n + 1)) - 2;
+
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        const uint64_t f    = factorials[n - i];
+        uint32_t k          = (uint32_t)(rank / f);
+        rank                %= f;
+
+        // Select the k-th smallest unused value.
+
+        uint32_t bits = unused;
+        while (k-- > 0) bits &= bits - 1;
+
+        unsigned long val = 0;
+        _BitScanForward64(&val, bits);
+
+        x       |= (uint64_t)val << (4 * i);
+        unused  &= ~(1u << val);
+    }
+
+    return x;
+}
+
+/**
+ * ComputeReversalDistanceTable - Reversal distance of every permutation of 1..n, indexed by
+ * RankPermutation. Distances from the identity equal distances to it, so this is one breadth first
+ * search from the identity, run a level at a time as parallel scans over the table.
+ *
+ * @param  n        [in]    Permutation length, at most REVERSAL_TABLE_MAX_N.
+ * @param  table    [out]   n! distances.
+ *
+ * @return          INVALID_INPUT if n is too large. OK otherwise.
+ */
+
+ResultCode ComputeReversalDistanceTable(const uint32_t n, vector<uint8_t>& table)
+{
+    if (n > REVERSAL_TABLE_MAX_N) return INVALID_INPUT;
+
+    uint64_t factorials[REVERSAL_TABLE_MAX_N + 1] = { 1 };
+    for (uint32_t i = 1; i <= n; i++) factorials[i] = factorials[i - 1] * i;
+
+    const uint64_t count = factorials[n];
+
+    unique_ptr<atomic<uint8_t>[]> dist(new atomic<uint8_t>[count]);
+    for (uint64_t r = 0; r < count; r++) dist[r].store(STATE_DEPTH_NONE, memory_order_relaxed);
+
+    vector<PackedReversal> revs;
+    GetPackedReversals(n, revs);
+
+    dist[0].store(0, memory_order_relaxed);
+
+    for (uint8_t depth = 0; ; depth++)
+    {
+        atomic<uint64_t> reached(0);
+
+        ParallelFor((uint32_t)count, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            uint64_t local = 0;
+
+            for (uint32_t r = begin; r < end; r++)
+            {
+                if (dist[r].load(memory_order_relaxed) != depth) continue;
+
+                const PackedPerm x = UnrankPacked(r, n, factorials);
+
+                for (auto& rev : revs)
+                {
+                    atomic<uint8_t>& d = dist[RankPacked(ApplyPackedReversal(x, rev), n)];
+
+                    if (d.load(memory_order_relaxed) == STATE_DEPTH_NONE)
+                    {
+                        d.store(depth + 1, memory_order_relaxed);
+                        local++;
+                    }
+                }
+            }
+
+            reached += local;
+        });
+
+        if (reached == 0) break;
+    }
+
+    table.resize(count);
+    for (uint64_t r = 0; r < count; r++) table[r] = dist[r].load(memory_order_relaxed);
+
+    return OK;
+}
+
+/**
+ * TestTables - Build distance tables for n up to 9, check the diameter is n - 1 and that the search
+ * agrees with the table on random permutations.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestTables(vector<TestResult>& testResults)
+{
+    string err;
+    vector<uint8_t> table;
+
+    uint64_t factorials[10] = { 1 };
+    for (uint32_t i = 1; i < 10; i++) factorials[i] = factorials[i - 1] * i;
+
+    long long t1 = GetMilliseconds();
+
+    for (uint32_t n = 1; n <= 9 && err.empty(); n++)
+    {
+        if (ComputeReversalDistanceTable(n, table) != OK) err = "Table failed for n = " + to_string(n);
+        else if (*max_element(table.begin(), table.end()) != n - 1) err = "Wrong diameter for n = " + to_string(n);
+    }
+
+    long long t2 = GetMilliseconds();
+
+    Rng rng(91);
+    vector<uint32_t> perm;
+
+    for (uint32_t trial = 0; trial < 200 && err.empty(); trial++)
+    {
+        UnpackPermutation(UnrankPacked(rng.Next() % table.size(), 9, factorials), 11, perm);
+
+        uint32_t distance = 0;
+        ExactReversalDistance(perm, distance);
+
+        if (distance != table[RankPermutation(perm)]) err = "Search and table differ at trial " + to_string(trial);
+    }
+
+    const float sec = ((float)t2 - (float)t1) / 1000.0f;
+
+    if (err.empty()) testResults.push_back({ "ExactReversal::Tables", PASS, "n <= 9 tables T = " + to_string(sec) + " sec." });
+    else testResults.push_back({ "ExactReversal::Tables", FAIL, err });
+}
+
+/**
+ * TestGreedyOracle - Use the n = 8 table as an oracle for BreakPointReversal over every permutation:
+ * the greedy count must lie between the exact distance and twice it.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestGreedyOracle(vector<TestResult>& testResults)
+{
+    const uint32_t n = 8;
+
+    uint64_t factorials[n + 1] = { 1 };
+    for (uint32_t i = 1; i <= n; i++) factorials[i] = factorials[i - 1] * i;
+
+    vector<uint8_t> table;
+    ComputeReversalDistanceTable(n, table);
+
+    string err;
+    uint64_t optimal    = 0;
+    uint64_t greedySum  = 0;
+    uint64_t exactSum   = 0;
+
+    vector<uint32_t> perm;
+    vector<Reversal> reversals;
+
+    for (uint64_t r = 0; r < table.size() && err.empty(); r++)
+    {
+        UnpackPermutation(UnrankPacked(r, n, factorials), n + 2, perm);
+
+        reversals.clear();
+        BreakPointReversal(perm, reversals, PERM_STORAGE_VECTOR);
+
+        const size_t exact = table[r];
+
+        if (reversals.size() < exact || reversals.size() > 2 * exact) err = "Greedy count out of range at rank " + to_string(r);
+
+        optimal     += reversals.size() == exact ? 1 : 0;
+        greedySum   += reversals.size();
+        exactSum    += exact;
+    }
+
+    if (err.empty())
+    {
+        testResults.push_back({ "ExactReversal::GreedyOracle", PASS,
+            to_string(optimal) + " of " + to_string(table.size()) + " optimal, greedy / exact = " + to_string((double)greedySum / (double)exactSum) + "." });
+    }
+    else testResults.push_back({ "ExactReversal::GreedyOracle", FAIL, err });
+}
+
+/**
+ * TestLarger - Exact distances of random permutations of 11 and 12 elements, checked against the
+ * breakpoint lower bound and the greedy upper bound.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestLarger(vector<TestResult>& testResults)
+{
+    const uint32_t sizes[]  = { 11, 12 };
+    const uint32_t trials   = 3;
+
+    Rng rng(92);
+
+    for (uint32_t n : sizes)
+    {
+        string err;
+        string dists;
+
+        long long t1 = GetMilliseconds();
+
+        for (uint32_t trial = 0; trial < trials && err.empty(); trial++)
+        {
+            vector<uint32_t> perm(n + 2);
+            for (uint32_t i = 0; i < n + 2; i++) perm[i] = i;
+            for (uint32_t i = n; i > 1; i--) swap(perm[i], perm[1 + rng.NextBounded(i)]);
+
+            uint32_t distance = 0;
+            ExactReversalDistance(perm, distance);
+
+            const uint32_t bp = CountBreakpoints(perm);
+
+            vector<uint32_t> sorted = perm;
+            vector<Reversal> reversals;
+            BreakPointReversal(sorted, reversals);
+
+            if (distance < (bp + 1) / 2 || distance > reversals.size()) err = "Distance outside bounds at trial " + to_string(trial);
+
+            dists += (trial ? ", " : "") + to_string(distance);
+        }
+
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const string name = "ExactReversal::Search[" + to_string(n) + "]";
+
+        if (err.empty()) testResults.push_back({ name, PASS, "Distances " + dists + ", T = " + to_string(sec) + " sec." });
+        else testResults.push_back({ name, FAIL, err });
+    }
+}
+
+/**
+ * ExactReversal - Tests for the exact reversal distance search and tables.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void ExactReversal(vector<TestResult>& testResults)
+{
+    TestTables(testResults);
+    TestGreedyOracle(testResults);
+    TestLarger(testResults);
+}
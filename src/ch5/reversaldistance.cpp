@@ -0,0 +1,520 @@
+#include "problems.h"
+#include "reversal.h"
+#include "permtree.h"
+
+static inline bool IsAdjacent(uint32_t a, uint32_t b) { return a == b + 1 || b == a + 1; }
+
+/**
+ * GetStrips - Split a framed permutation into strips, maximal runs of consecutive positions without a
+ * breakpoint between them. Runs of two or more are increasing or decreasing by their order. Singletons
+ * count as decreasing, except the frame elements 0 and n + 1 which count as increasing.
+ *
+ * @param  perm     [in]        Framed permutation.
+ * @param  strips   [in/out]    Strips in position order. Assumed empty on input.
+ *
+ * @return          OK.
+ */
+
+ResultCode GetStrips(const vector<uint32_t>& perm, vector<Strip>& strips)
+{
+    assert(strips.size() == 0);
+
+    const uint32_t last = (uint32_t)perm.size() - 1;
+    uint32_t l          = 0;
+
+    for (uint32_t r = 0; r <= last; r++)
+    {
+        if (r < last && IsAdjacent(perm[r], perm[r + 1])) continue;
+
+        bool decreasing = r > l ? perm[l] > perm[l + 1] : (perm[l] != 0 && perm[l] != last);
+        strips.push_back({ l, r, decreasing });
+        l = r + 1;
+    }
+
+    return OK;
+}
+
+/**
+ * IsFramedPermutation - Check perm is a permutation of 0..n+1 with 0 first and n + 1 last.
+ */
+
+bool IsFramedPermutation(const vector<uint32_t>& perm)
+{
+    if (perm.size() < 2) return false;
+
+    const uint32_t last = (uint32_t)perm.size() - 1;
+    if (perm[0] != 0 || perm[last] != last) return false;
+
+    vector<bool> seen(perm.size(), false);
+
+    for (auto val : perm)
+    {
+        if (val > last || seen[val]) return false;
+        seen[val] = true;
+    }
+
+    return true;
+}
+
+/**
+ * CountBreakpoints - Number of adjacent position pairs whose values don't differ by one.
+ */
+
+uint32_t CountBreakpoints(const vector<uint32_t>& perm)
+{
+    uint32_t count = 0;
+    for (size_t i = 0; i + 1 < perm.size(); i++) count += IsAdjacent(perm[i], perm[i + 1]) ? 0 : 1;
+    return count;
+}
+
+/**
+ * ApplyReversals - Apply a list of reversals to a permutation in order.
+ */
+
+void ApplyReversals(vector<uint32_t>& perm, const vector<Reversal>& reversals)
+{
+    for (auto& rev : reversals) reverse(perm.begin() + rev.begin, perm.begin() + rev.end + 1);
+}
+
+/*
+ * Sorters hold the permutation being sorted and answer the queries the greedy loop needs: the value at
+ * a position, the position of a value, and the smallest value lying in a decreasing strip. A reversal
+ * of [l, r] only changes the strip direction of values at positions l - 1..r + 1 and flips it for
+ * values inside longer strips, so neither sorter rescans the permutation.
+ *
+ * VectorSorter reverses in place with a position index and a bit per value in a decreasing strip,
+ * both held in a ReversalScratch, costing O(r - l) per reversal. TreeSorter keeps the permutation
+ * in a PermTree with a strip mark per value, costing O(log n) per reversal, and writes the
+ * permutation back on Finish.
+ */
+
+struct VectorSorter
+{
+    vector<uint32_t>& perm;
+    vector<uint32_t>& pos;
+    IndexBitset& decreasing;
+    uint32_t n;
+    uint32_t breakpoints;
+    uint64_t moved;             // Elements moved by reversals so far.
+
+    VectorSorter(vector<uint32_t>& perm, ReversalScratch& scratch) :
+        perm(perm),
+        pos(scratch.pos),
+        decreasing(scratch.decreasing),
+        n((uint32_t)perm.size() - 2),
+        breakpoints(0),
+        moved(0)
+    {
+        pos.resize(perm.size());
+        decreasing.Reset(perm.size());
+
+        for (uint32_t p = 0; p < perm.size(); p++) pos[perm[p]] = p;
+        for (uint32_t p = 0; p <= n; p++) breakpoints += IsBreakpoint(p);
+
+        Update(1, n);
+    }
+
+    uint32_t At(uint32_t p) const { return perm[p]; }
+    uint32_t PositionOf(uint32_t val) const { return pos[val]; }
+
+    uint32_t MinDecreasing() const
+    {
+        const size_t k = decreasing.FindNext(1);
+        return k == BITSET_NONE ? PERM_TREE_NONE : (uint32_t)k;
+    }
+
+    uint32_t IsBreakpoint(uint32_t p) const { return IsAdjacent(perm[p], perm[p + 1]) ? 0 : 1; }
+
+    bool IsDecreasing(uint32_t p) const
+    {
+        const uint32_t val = perm[p];
+        if (val == 0 || val == n + 1) return false;
+
+        return perm[p - 1] != val - 1 && perm[p + 1] != val + 1;
+    }
+
+    void Update(uint32_t l, uint32_t r)
+    {
+        for (uint32_t p = max(l - 1, 1u); p <= min(r + 1, n); p++) decreasing.Set(perm[p], IsDecreasing(p));
+    }
+
+    /**
+     * Reverse - Reverse perm[l..r]. Inside the segment every value keeps its neighbours, so singletons
+     * stay decreasing and values in longer strips swap direction; only the values at the segment
+     * ends and just outside it need their direction recomputed.
+     */
+
+    void Reverse(uint32_t l, uint32_t r)
+    {
+        breakpoints -= IsBreakpoint(l - 1) + IsBreakpoint(r);
+
+        reverse(perm.begin() + l, perm.begin() + r + 1);
+        for (uint32_t p = l; p <= r; p++) pos[perm[p]] = p;
+
+        breakpoints += IsBreakpoint(l - 1) + IsBreakpoint(r);
+        moved       += r - l + 1;
+
+        for (uint32_t p = l + 1; p < r; p++)
+        {
+            if (IsAdjacent(perm[p - 1], perm[p]) || IsAdjacent(perm[p], perm[p + 1])) decreasing.Flip(perm[p]);
+        }
+
+        Update(l, l);
+        Update(r, r);
+    }
+
+    void Finish() {}
+};
+
+struct TreeSorter
+{
+    vector<uint32_t>& perm;
+    PermTree tree;
+    uint32_t n;
+
+    TreeSorter(vector<uint32_t>& perm) :
+        perm(perm),
+        tree(perm),
+        n((uint32_t)perm.size() - 2)
+    {
+        vector<StripMark> marks(perm.size(), STRIP_NONE);
+        for (uint32_t p = 1; p <= n; p++) marks[perm[p]] = GetMark(perm[p - 1], perm[p], perm[p + 1]);
+
+        tree.SetMarks(marks);
+    }
+
+    uint32_t At(uint32_t p) { return tree.At(p); }
+    uint32_t PositionOf(uint32_t val) { return tree.PositionOf(val); }
+    uint32_t MinDecreasing() const { return min(tree.MinMarked(STRIP_SINGLE), tree.MinMarked(STRIP_BACKWARD)); }
+
+    /**
+     * GetMark - Strip mark of val from its neighbours. Singletons are decreasing, and a value in a
+     * longer strip is increasing when it follows val - 1 or precedes val + 1.
+     */
+
+    StripMark GetMark(uint32_t prev, uint32_t val, uint32_t next) const
+    {
+        if (val == 0 || val == n + 1) return STRIP_NONE;
+        if (prev == val - 1 || next == val + 1) return STRIP_FORWARD;
+        if (prev == val + 1 || next == val - 1) return STRIP_BACKWARD;
+
+        return STRIP_SINGLE;
+    }
+
+    void Update(uint32_t p)
+    {
+        if (p < 1 || p > n) return;
+        tree.SetMark(tree.At(p), GetMark(tree.At(p - 1), tree.At(p), tree.At(p + 1)));
+    }
+
+    /**
+     * Reverse - The tree swaps forward and backward marks of the values it moves, so only the
+     * segment ends and their outside neighbours need marking again.
+     */
+
+    void Reverse(uint32_t l, uint32_t r)
+    {
+        tree.Reverse(l, r);
+
+        Update(l - 1);
+        Update(l);
+        Update(r);
+        Update(r + 1);
+    }
+
+    void Finish() { tree.Flatten(perm); }
+};
+
+/**
+ * SortByBreakpoints - Greedy loop shared by both sorters. sortedPrefix is the largest m with 0..m in
+ * place; reversals never start inside it, so it only grows. The loop can pause once reversals reaches
+ * pauseAt and be resumed later, by the same or another sorter, from the permutation it left.
+ */
+
+template<typename Sorter>
+static ResultCode SortByBreakpoints(Sorter& sorter, vector<Reversal>& reversals, const size_t pauseAt = SIZE_MAX)
+{
+    const uint32_t n        = sorter.n;
+    const size_t maxSteps   = 2 * ((size_t)n + 1);
+    uint32_t sortedPrefix   = 0;
+
+    while (reversals.size() <= maxSteps)
+    {
+        if (reversals.size() == pauseAt) return OK;
+
+        uint32_t l = 0;
+        uint32_t r = 0;
+
+        const uint32_t k = sorter.MinDecreasing();
+
+        if (k != PERM_TREE_NONE)
+        {
+            const uint32_t i = sorter.PositionOf(k);
+            const uint32_t j = sorter.PositionOf(k - 1);
+
+            l = j < i ? j + 1 : i + 1;
+            r = j < i ? i : j;
+        }
+        else
+        {
+            // All strips increasing. The first breakpoint ends the sorted prefix; the strip after it
+            // can't hold a frame element, and another breakpoint must follow it or the permutation
+            // would already be sorted.
+
+            while (sortedPrefix <= n && sorter.PositionOf(sortedPrefix + 1) == sortedPrefix + 1) sortedPrefix++;
+
+            if (sortedPrefix == n + 1)
+            {
+                sorter.Finish();
+                return OK;
+            }
+
+            l = sortedPrefix + 1;
+            r = l;
+
+            uint32_t val = sorter.At(l);
+
+            while (r < n && sorter.At(r + 1) == val + 1)
+            {
+                r++;
+                val++;
+            }
+
+            if (r == l || sorter.At(r + 1) == val + 1) return UNABLE_TO_FIND_SOLUTION;
+        }
+
+        sorter.Reverse(l, r);
+        reversals.push_back({ l, r });
+    }
+
+    return UNABLE_TO_FIND_SOLUTION;
+}
+
+/**
+ * BreakPointReversal - Greedy breakpoint reversal sort (Kececioglu and Sankoff). While some strip is
+ * decreasing, take the smallest value k in a decreasing strip and reverse so k lands next to k - 1,
+ * removing at least one breakpoint. Otherwise reverse an increasing strip to make it decreasing. Uses
+ * at most twice the initial breakpoint count reversals.
+ *
+ * @param  perm         [in/out]    Framed permutation, sorted on return.
+ * @param  reversals    [in/out]    Reversals applied, in order. Assumed empty on input.
+ * @param  storage      [in]        Permutation representation. AUTO starts on the vector and moves
+ *                                  to the tree when reversals get long (see PermStorage).
+ *
+ * @return              INVALID_INPUT if perm isn't a framed permutation. UNABLE_TO_FIND_SOLUTION if the
+ *                      sort doesn't finish within its reversal bound. OK otherwise.
+ */
+
+ResultCode BreakPointReversal(vector<uint32_t>& perm, vector<Reversal>& reversals, const PermStorage storage)
+{
+    assert(reversals.size() == 0);
+
+    if (!IsFramedPermutation(perm)) return INVALID_INPUT;
+    if (perm.size() == 2) return OK;
+
+    if (storage == PERM_STORAGE_TREE)
+    {
+        TreeSorter sorter(perm);
+        return SortByBreakpoints(sorter, reversals);
+    }
+
+    ReversalScratch scratch;
+    VectorSorter sorter(perm, scratch);
+
+    if (storage == PERM_STORAGE_VECTOR) return SortByBreakpoints(sorter, reversals);
+
+    // Each window's average reversal length predicts the rest of the sort, which takes about one
+    // reversal per remaining breakpoint. Move to the tree once that work on the vector would cost more
+    // than building the tree and finishing on it.
+
+    while (true)
+    {
+        const size_t pauseAt    = reversals.size() + PERM_AUTO_WINDOW;
+        const uint64_t moved    = sorter.moved;
+
+        ResultCode res = SortByBreakpoints(sorter, reversals, pauseAt);
+        if (res != OK || reversals.size() < pauseAt) return res;
+
+        const uint64_t avgLen       = (sorter.moved - moved) / PERM_AUTO_WINDOW;
+        const uint64_t vectorCost   = sorter.breakpoints * avgLen;
+        const uint64_t treeCost     = sorter.breakpoints * PERM_TREE_REVERSAL_COST + perm.size() * PERM_TREE_SETUP_COST;
+
+        if (vectorCost > treeCost) break;
+    }
+
+    TreeSorter treeSorter(perm);
+    return SortByBreakpoints(treeSorter, reversals);
+}
+
+/**
+ * BreakPointReversal - Vector sort reusing caller scratch, for callers sorting many permutations.
+ * perm is only checked in debug builds.
+ *
+ * @param  perm     [in/out]    Framed permutation, sorted on return.
+ * @param  scratch  [in/out]    Sorter buffers. Reversals applied are left in scratch.reversals.
+ *
+ * @return          UNABLE_TO_FIND_SOLUTION if the sort doesn't finish within its reversal bound. OK
+ *                  otherwise.
+ */
+
+ResultCode BreakPointReversal(vector<uint32_t>& perm, ReversalScratch& scratch)
+{
+    assert(IsFramedPermutation(perm));
+
+    scratch.reversals.clear();
+    if (perm.size() == 2) return OK;
+
+    VectorSorter sorter(perm, scratch);
+    return SortByBreakpoints(sorter, scratch.reversals);
+}
+
+/**
+ * RandomPermutation - Test helper. Framed permutation of n elements, uniformly shuffled.
+ */
+
+static void RandomPermutation(const uint32_t n, Rng& rng, vector<uint32_t>& perm)
+{
+    perm.resize(n + 2);
+    for (uint32_t i = 0; i < n + 2; i++) perm[i] = i;
+    for (uint32_t i = n; i > 1; i--) swap(perm[i], perm[1 + rng.NextBounded(i)]);
+}
+
+/**
+ * CheckSort - Test helper. Run the sort on a copy of perm with the given storage and check the
+ * reversals sort the original, the sorter's output is the identity, and the count is within the
+ * breakpoint bounds.
+ *
+ * @return Empty string on success, otherwise a failure message.
+ */
+
+static string CheckSort(const vector<uint32_t>& perm, const PermStorage storage, size_t& numReversals)
+{
+    vector<uint32_t> sorted = perm;
+    vector<Reversal> reversals;
+
+    ResultCode res = BreakPointReversal(sorted, reversals, storage);
+    if (res != OK) return "Sort failed with code " + to_string(res);
+
+    numReversals = reversals.size();
+
+    vector<uint32_t> replay = perm;
+    ApplyReversals(replay, reversals);
+
+    for (uint32_t i = 0; i < perm.size(); i++)
+    {
+        if (sorted[i] != i) return "Sorter output not sorted at position " + to_string(i);
+        if (replay[i] != i) return "Reversal list doesn't sort input at position " + to_string(i);
+    }
+
+    const uint32_t bp = CountBreakpoints(perm);
+    if (reversals.size() < (bp + 1) / 2 || reversals.size() > 2 * (size_t)bp)
+        return to_string(reversals.size()) + " reversals outside bounds for " + to_string(bp) + " breakpoints.";
+
+    return "";
+}
+
+/**
+ * TestSmallPermutations - Sort the textbook example and many random small permutations with both
+ * sorters, also checking strip boundaries agree with the breakpoint count.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestSmallPermutations(vector<TestResult>& testResults)
+{
+    vector<uint32_t> example = { 0, 8, 2, 7, 6, 5, 1, 4, 3, 9 };
+    size_t numReversals = 0;
+
+    string err = CheckSort(example, PERM_STORAGE_VECTOR, numReversals);
+
+    if (err.empty()) testResults.push_back({ "Reversal::Example", PASS, to_string(numReversals) + " reversals." });
+    else testResults.push_back({ "Reversal::Example", FAIL, err });
+
+    Rng rng(51);
+    vector<uint32_t> perm;
+
+    for (uint32_t n = 1; n <= 64 && err.empty(); n++)
+    {
+        for (uint32_t trial = 0; trial < 100 && err.empty(); trial++)
+        {
+            RandomPermutation(n, rng, perm);
+
+            vector<Strip> strips;
+            GetStrips(perm, strips);
+
+            size_t numTree = 0;
+
+            if (strips.size() != CountBreakpoints(perm) + 1) err = "Strip count doesn't match breakpoints for n = " + to_string(n);
+            else err = CheckSort(perm, PERM_STORAGE_VECTOR, numReversals);
+
+            if (err.empty()) err = CheckSort(perm, PERM_STORAGE_TREE, numTree);
+            if (err.empty() && numTree != numReversals) err = "Vector and tree sorters differ for n = " + to_string(n);
+        }
+    }
+
+    if (err.empty()) testResults.push_back({ "Reversal::RandomSmall", PASS, "" });
+    else testResults.push_back({ "Reversal::RandomSmall", FAIL, err });
+}
+
+/**
+ * TestLargePermutations - Sort a shuffled permutation of 10^5 elements and a 10^6 element permutation
+ * scrambled by short random reversals, with both sorters and with AUTO, which should track the faster
+ * of the two.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestLargePermutations(vector<TestResult>& testResults)
+{
+    Rng rng(52);
+
+    vector<uint32_t> shuffled;
+    RandomPermutation(100000, rng, shuffled);
+
+    const uint32_t n = 1000000;
+    vector<uint32_t> scrambled(n + 2);
+    for (uint32_t i = 0; i < n + 2; i++) scrambled[i] = i;
+
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        const uint32_t l = 1 + rng.NextBounded(n - 1000);
+        const uint32_t r = l + rng.NextBounded(1000);
+        reverse(scrambled.begin() + l, scrambled.begin() + r + 1);
+    }
+
+    const vector<uint32_t>* perms[]    = { &shuffled, &scrambled };
+    const string names[]                = { "Reversal::Shuffled[100000]", "Reversal::Scrambled[1000000]" };
+
+    const PermStorage storages[]        = { PERM_STORAGE_VECTOR, PERM_STORAGE_TREE, PERM_STORAGE_AUTO };
+    const string storageNames[]         = { "::Vector", "::Tree", "::Auto" };
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        for (uint32_t s = 0; s < 3; s++)
+        {
+            size_t numReversals = 0;
+
+            long long t1    = GetMilliseconds();
+            string err      = CheckSort(*perms[i], storages[s], numReversals);
+            long long t2    = GetMilliseconds();
+            float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+            const string name = names[i] + storageNames[s];
+
+            if (err.empty()) testResults.push_back({ name, PASS, to_string(numReversals) + " reversals, T = " + to_string(sec) + " sec." });
+            else testResults.push_back({ name, FAIL, err });
+        }
+    }
+}
+
+/**
+ * ReversalDistance - Tests for breakpoint reversal sorting.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void ReversalDistance(vector<TestResult>& testResults)
+{
+    TestSmallPermutations(testResults);
+    TestLargePermutations(testResults);
+}
@@ -0,0 +1,995 @@
+#include "problems.h"
+#include "reversal.h"
+#include "permtree.h"
+
+#include <numeric>
+
+/*
+ * Exact signed reversal distance (Hannenhalli and Pevzner), computed in linear time along the lines
+ * of Bader, Moret and Yan: d = n + 1 - c + h + f, for c cycles in the breakpoint graph, h hurdles and
+ * f = 1 for a fortress.
+ *
+ * Each element x at position i becomes two nodes of the unsigned image, 2x - 1 then 2x when x is
+ * positive and the reverse when negative, framed by 0 and 2n + 1. Reality edges join image positions
+ * 2i and 2i + 1; desire edges join values 2k and 2k + 1, so desire edge k is the position interval
+ * between them. Two desire edges overlap when their intervals interleave, and a desire edge is
+ * oriented when its endpoints sit at positions of the same parity.
+ */
+
+static const uint32_t NO_COMPONENT = ~0u;
+
+struct SignedBreakpointGraph
+{
+    uint32_t n;
+    uint32_t numCycles;
+    uint32_t numComponents;
+    bool fortress;
+    vector<uint32_t> edgeCycle;         // Cycle of each reality edge 0..n.
+    vector<uint32_t> cycleComponent;    // Component of each cycle, NO_COMPONENT for trivial cycles.
+    vector<uint32_t> hurdles;           // Hurdle components in circular order.
+    vector<bool> superHurdle;
+
+    uint32_t Distance() const { return n + 1 - numCycles + (uint32_t)hurdles.size() + (fortress ? 1 : 0); }
+};
+
+static uint32_t FindRoot(vector<uint32_t>& parent, uint32_t x)
+{
+    while (parent[x] != x)
+    {
+        parent[x]   = parent[parent[x]];
+        x           = parent[x];
+    }
+
+    return x;
+}
+
+/**
+ * IsFramedSignedPermutation - Check perm holds 0, then each of 1..n once up to sign, then n + 1.
+ */
+
+bool IsFramedSignedPermutation(const vector<int32_t>& perm)
+{
+    if (perm.size() < 2) return false;
+
+    const int32_t last = (int32_t)perm.size() - 1;
+    if (perm[0] != 0 || perm[last] != last) return false;
+
+    vector<bool> seen(perm.size(), false);
+
+    for (int32_t i = 1; i < last; i++)
+    {
+        const int32_t val = abs(perm[i]);
+        if (val == 0 || val >= last || seen[val]) return false;
+        seen[val] = true;
+    }
+
+    return true;
+}
+
+static void ApplySignedReversal(vector<int32_t>& perm, const uint32_t l, const uint32_t r)
+{
+    reverse(perm.begin() + l, perm.begin() + r + 1);
+    for (uint32_t p = l; p <= r; p++) perm[p] = -perm[p];
+}
+
+/**
+ * ApplySignedReversals - Apply a list of signed reversals to a permutation in order.
+ */
+
+void ApplySignedReversals(vector<int32_t>& perm, const vector<Reversal>& reversals)
+{
+    for (auto& rev : reversals) ApplySignedReversal(perm, rev.begin, rev.end);
+}
+
+/**
+ * AnalyzeSignedPermutation - Build the breakpoint graph of a framed signed permutation and find its
+ * cycles, overlap components and hurdles.
+ *
+ * Components come from one sweep over image positions with a stack of open components. Components of
+ * an overlap graph are either disjoint or one lies between two consecutive endpoints of the other, so
+ * when the sweep reaches the right end of a desire edge, every component opened above that edge's
+ * component is still open only because it overlaps it, and is merged down.
+ *
+ * Hurdles are the unoriented components that appear as one contiguous run in the circular sequence of
+ * unoriented components along the image. A hurdle is super when removing it would leave its two
+ * neighbours as the only two runs of one component, making that component a hurdle.
+ *
+ * @param perm  [in]        Framed signed permutation.
+ * @param graph [in/out]    Analysis results.
+ */
+
+static void AnalyzeSignedPermutation(const vector<int32_t>& perm, SignedBreakpointGraph& graph)
+{
+    const uint32_t n = (uint32_t)perm.size() - 2;
+    const uint32_t m = 2 * n + 2;
+
+    vector<uint32_t> image(m);
+    vector<uint32_t> pos(m);
+
+    image[0]        = 0;
+    image[m - 1]    = m - 1;
+
+    for (uint32_t i = 1; i <= n; i++)
+    {
+        const uint32_t val  = (uint32_t)abs(perm[i]);
+        image[2 * i - 1]    = perm[i] > 0 ? 2 * val - 1 : 2 * val;
+        image[2 * i]        = perm[i] > 0 ? 2 * val : 2 * val - 1;
+    }
+
+    for (uint32_t p = 0; p < m; p++) pos[image[p]] = p;
+
+    // Cycles: cross a reality edge, then follow the desire edge from the node reached.
+
+    graph.n         = n;
+    graph.numCycles = 0;
+    graph.edgeCycle.assign(n + 1, NO_COMPONENT);
+
+    for (uint32_t i = 0; i <= n; i++)
+    {
+        if (graph.edgeCycle[i] != NO_COMPONENT) continue;
+
+        uint32_t p = 2 * i;
+
+        while (graph.edgeCycle[p >> 1] == NO_COMPONENT)
+        {
+            graph.edgeCycle[p >> 1] = graph.numCycles;
+            p = pos[image[p ^ 1] ^ 1];
+        }
+
+        graph.numCycles++;
+    }
+
+    // Overlap components of the non-trivial desire edges.
+
+    auto lowEnd     = [&](uint32_t k) { return min(pos[2 * k], pos[2 * k + 1]); };
+    auto highEnd    = [&](uint32_t k) { return max(pos[2 * k], pos[2 * k + 1]); };
+    auto isTrivial  = [&](uint32_t k) { return highEnd(k) - lowEnd(k) == 1; };
+
+    vector<uint32_t> parent(n + 1);
+    iota(parent.begin(), parent.end(), 0);
+
+    vector<pair<uint32_t, uint32_t>> open;
+
+    for (uint32_t p = 0; p < m; p++)
+    {
+        const uint32_t k = image[p] >> 1;
+        if (isTrivial(k)) continue;
+
+        if (p == lowEnd(k))
+        {
+            open.push_back({ k, highEnd(k) });
+            continue;
+        }
+
+        const uint32_t root = FindRoot(parent, k);
+
+        while (FindRoot(parent, open.back().first) != root)
+        {
+            const auto top = open.back();
+            open.pop_back();
+
+            parent[FindRoot(parent, top.first)] = FindRoot(parent, open.back().first);
+            open.back().second                  = max(open.back().second, top.second);
+        }
+
+        while (!open.empty() && open.back().second == p) open.pop_back();
+    }
+
+    vector<uint32_t> rootComponent(n + 1, NO_COMPONENT);
+    vector<bool> oriented;
+
+    graph.numComponents = 0;
+    graph.cycleComponent.assign(graph.numCycles, NO_COMPONENT);
+
+    for (uint32_t k = 0; k <= n; k++)
+    {
+        if (isTrivial(k)) continue;
+
+        const uint32_t root = FindRoot(parent, k);
+
+        if (rootComponent[root] == NO_COMPONENT)
+        {
+            rootComponent[root] = graph.numComponents++;
+            oriented.push_back(false);
+        }
+
+        const uint32_t comp = rootComponent[root];
+
+        if (((pos[2 * k] ^ pos[2 * k + 1]) & 1) == 0) oriented[comp] = true;
+        graph.cycleComponent[graph.edgeCycle[pos[2 * k] >> 1]] = comp;
+    }
+
+    // Hurdles from the circular run sequence of unoriented components.
+
+    vector<uint32_t> runs;
+
+    for (uint32_t p = 0; p < m; p++)
+    {
+        const uint32_t k = image[p] >> 1;
+        if (isTrivial(k)) continue;
+
+        const uint32_t comp = rootComponent[FindRoot(parent, k)];
+        if (!oriented[comp] && (runs.empty() || runs.back() != comp)) runs.push_back(comp);
+    }
+
+    if (runs.size() > 1 && runs.front() == runs.back()) runs.pop_back();
+
+    vector<uint32_t> numRuns(graph.numComponents, 0);
+    for (auto comp : runs) numRuns[comp]++;
+
+    graph.hurdles.clear();
+    graph.superHurdle.clear();
+
+    const size_t numRunsTotal = runs.size();
+
+    for (size_t j = 0; j < numRunsTotal; j++)
+    {
+        if (numRuns[runs[j]] != 1) continue;
+
+        const uint32_t prev = runs[(j + numRunsTotal - 1) % numRunsTotal];
+        const uint32_t next = runs[(j + 1) % numRunsTotal];
+
+        graph.hurdles.push_back(runs[j]);
+        graph.superHurdle.push_back(prev == next && numRuns[prev] == 2);
+    }
+
+    const size_t numHurdles = graph.hurdles.size();
+
+    graph.fortress = numHurdles >= 3 && (numHurdles & 1) == 1 &&
+        all_of(graph.superHurdle.begin(), graph.superHurdle.end(), [](bool super) { return super; });
+}
+
+/**
+ * FindOrientedReversal - Choose the oriented reversal of highest score (Bergeron): the one leaving the
+ * most oriented pairs. Such a reversal never creates an unoriented component, so it is always part of
+ * an optimal scenario.
+ *
+ * A pair is two elements of consecutive absolute value; it is oriented when their signs differ. A
+ * reversal toggles the orientation of exactly those pairs with one element inside it, so its score is
+ * T + E - 2B, where E sums +1 (unoriented) or -1 (oriented) over pair elements inside the reversal and
+ * B sums the same weights over pairs lying wholly inside it. B is counted for all candidates in one
+ * sweep with a Fenwick tree.
+ *
+ * @param  perm [in]        Framed signed permutation.
+ * @param  rev  [in/out]    Chosen reversal.
+ *
+ * @return      False if there are no oriented pairs.
+ */
+
+static bool FindOrientedReversal(const vector<int32_t>& perm, Reversal& rev)
+{
+    const uint32_t size = (uint32_t)perm.size();
+    const uint32_t n    = size - 2;
+
+    vector<uint32_t> posOf(size);
+    for (uint32_t p = 0; p < size; p++) posOf[abs(perm[p])] = p;
+
+    vector<int32_t> endpointWeight(size + 1, 0);
+    vector<int32_t> weight(n + 1);
+    vector<Reversal> candidates;
+    int32_t numOriented = 0;
+
+    for (uint32_t k = 0; k <= n; k++)
+    {
+        const uint32_t a    = min(posOf[k], posOf[k + 1]);
+        const uint32_t b    = max(posOf[k], posOf[k + 1]);
+        const bool isOriented = (perm[a] < 0) != (perm[b] < 0);
+
+        weight[k] = isOriented ? -1 : 1;
+        endpointWeight[a + 1] += weight[k];
+        endpointWeight[b + 1] += weight[k];
+
+        if (!isOriented) continue;
+
+        numOriented++;
+
+        if (perm[a] + perm[b] == 1) candidates.push_back({ a, b - 1 });
+        else candidates.push_back({ a + 1, b });
+    }
+
+    if (numOriented == 0) return false;
+
+    for (uint32_t p = 1; p <= size; p++) endpointWeight[p] += endpointWeight[p - 1];
+
+    // Counting sort pairs by right end and candidates by end, then sweep ends left to right.
+
+    auto sortByEnd = [&](uint32_t count, auto endOf, vector<uint32_t>& start, vector<uint32_t>& order)
+    {
+        start.assign(size + 1, 0);
+        order.resize(count);
+
+        for (uint32_t i = 0; i < count; i++) start[endOf(i) + 1]++;
+        for (uint32_t p = 0; p < size; p++) start[p + 1] += start[p];
+
+        vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (uint32_t i = 0; i < count; i++) order[fill[endOf(i)]++] = i;
+    };
+
+    vector<uint32_t> pairStart;
+    vector<uint32_t> pairOrder;
+    vector<uint32_t> candStart;
+    vector<uint32_t> candOrder;
+
+    sortByEnd(n + 1, [&](uint32_t k) { return max(posOf[k], posOf[k + 1]); }, pairStart, pairOrder);
+    sortByEnd((uint32_t)candidates.size(), [&](uint32_t c) { return candidates[c].end; }, candStart, candOrder);
+
+    vector<int32_t> fenwick(size + 1, 0);
+    int32_t added = 0;
+
+    auto prefix = [&](uint32_t p)
+    {
+        int32_t sum = 0;
+        for (uint32_t i = p; i > 0; i -= i & (0 - i)) sum += fenwick[i];
+        return sum;
+    };
+
+    int32_t bestScore = INT32_MIN;
+
+    for (uint32_t r = 0; r < size; r++)
+    {
+        for (uint32_t j = pairStart[r]; j < pairStart[r + 1]; j++)
+        {
+            const uint32_t k = pairOrder[j];
+            for (uint32_t i = min(posOf[k], posOf[k + 1]) + 1; i <= size; i += i & (0 - i)) fenwick[i] += weight[k];
+            added += weight[k];
+        }
+
+        for (uint32_t j = candStart[r]; j < candStart[r + 1]; j++)
+        {
+            const uint32_t c        = candOrder[j];
+            const uint32_t l        = candidates[c].begin;
+            const int32_t inside    = endpointWeight[r + 1] - endpointWeight[l];
+            const int32_t contained = added - prefix(l);
+            const int32_t score     = numOriented + inside - 2 * contained;
+
+            if (score > bestScore)
+            {
+                bestScore   = score;
+                rev         = candidates[c];
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * FindHurdleReversal - With no oriented pairs left, pick a reversal that merges two hurdles or cuts
+ * one, following Hannenhalli and Pevzner: cut a simple hurdle when the hurdle count is odd, otherwise
+ * merge two non-consecutive hurdles (the only two when there are two or three). Such a reversal is
+ * always safe, so the first candidate is taken in practice. Each one is still checked against the
+ * distance engine, and should the checks ever fail every reversal is tried in turn. One of them lowers
+ * the distance by definition, so the search only comes up empty when the distance is zero.
+ *
+ * @param  perm     [in]        Framed signed permutation with no oriented pairs.
+ * @param  distance [in]        Current distance.
+ * @param  rev      [in/out]    Chosen reversal.
+ *
+ * @return          False if no reversal lowers the distance.
+ */
+
+static bool FindHurdleReversal(const vector<int32_t>& perm, const uint32_t distance, Reversal& rev)
+{
+    SignedBreakpointGraph graph;
+    AnalyzeSignedPermutation(perm, graph);
+
+    const uint32_t n            = graph.n;
+    const uint32_t numHurdles   = (uint32_t)graph.hurdles.size();
+
+    vector<uint32_t> hurdleOf(graph.numComponents, NO_COMPONENT);
+    for (uint32_t h = 0; h < numHurdles; h++) hurdleOf[graph.hurdles[h]] = h;
+
+    // First two reality edges of the first cycle met in each hurdle. Cycles of an unoriented
+    // component are never trivial, so both exist.
+
+    vector<uint32_t> firstCycle(numHurdles, NO_COMPONENT);
+    vector<vector<uint32_t>> hurdleEdges(numHurdles);
+
+    for (uint32_t i = 0; i <= n; i++)
+    {
+        const uint32_t cycle    = graph.edgeCycle[i];
+        const uint32_t comp     = graph.cycleComponent[cycle];
+        if (comp == NO_COMPONENT || hurdleOf[comp] == NO_COMPONENT) continue;
+
+        const uint32_t h = hurdleOf[comp];
+        if (firstCycle[h] == NO_COMPONENT) firstCycle[h] = cycle;
+        if (cycle == firstCycle[h] && hurdleEdges[h].size() < 2) hurdleEdges[h].push_back(i);
+    }
+
+    vector<int32_t> trial;
+
+    auto tryReversal = [&](const uint32_t begin, const uint32_t end)
+    {
+        trial = perm;
+        ApplySignedReversal(trial, begin, end);
+
+        AnalyzeSignedPermutation(trial, graph);
+        if (graph.Distance() + 1 != distance) return false;
+
+        rev = { begin, end };
+        return true;
+    };
+
+    // Cutting acts on two edges of one cycle, merging on the first edges of two hurdles.
+
+    auto tryCut = [&](const uint32_t h)
+    {
+        return tryReversal(hurdleEdges[h][0] + 1, hurdleEdges[h][1]);
+    };
+
+    auto tryMerge = [&](const uint32_t a, const uint32_t b)
+    {
+        return tryReversal(min(hurdleEdges[a][0], hurdleEdges[b][0]) + 1, max(hurdleEdges[a][0], hurdleEdges[b][0]));
+    };
+
+    if (numHurdles & 1)
+    {
+        for (uint32_t h = 0; h < numHurdles; h++)
+            if ((!graph.superHurdle[h] || numHurdles == 1) && tryCut(h)) return true;
+    }
+
+    if (numHurdles >= 4 && tryMerge(0, 2)) return true;
+    if (numHurdles >= 2 && tryMerge(0, 1)) return true;
+
+    for (uint32_t begin = 1; begin <= n; begin++)
+    {
+        for (uint32_t end = begin; end <= n; end++)
+            if (tryReversal(begin, end)) return true;
+    }
+
+    return false;
+}
+
+/**
+ * PickOrientedReversal - Pick an oriented pair and return the reversal making it an adjacency (see
+ * FindOrientedReversal). A pair is oriented exactly when its signs differ, so oriented pairs remain
+ * while any value is negative, and the smallest negative value v forms one with v - 1. To spread picks
+ * over the permutation, values at random positions are tried first: a negative value forms an oriented
+ * pair with either neighbour in value that is positive.
+ *
+ * @param  tree [in]        Signed permutation.
+ * @param  rng  [in/out]    Random source.
+ * @param  rev  [in/out]    Chosen reversal.
+ *
+ * @return      False if no pair is oriented.
+ */
+
+static bool PickOrientedReversal(PermTree& tree, Rng& rng, Reversal& rev)
+{
+    const uint32_t maxPicks = 32;
+
+    // Pair k holds k and k + 1. The frame values 0 and n + 1 are positive, so both neighbours exist.
+
+    uint32_t k      = PERM_TREE_NONE;
+    uint32_t v      = 0;
+    uint32_t posV   = 0;
+
+    for (uint32_t pick = 0; pick < maxPicks && k == PERM_TREE_NONE; pick++)
+    {
+        posV    = rng.NextBounded(tree.Size());
+        v       = tree.At(posV);
+
+        if (!tree.IsNegative(v)) continue;
+
+        const bool below = !tree.IsNegative(v - 1);
+        const bool above = !tree.IsNegative(v + 1);
+
+        if (below && (!above || (rng.Next() & 1))) k = v - 1;
+        else if (above) k = v;
+    }
+
+    if (k == PERM_TREE_NONE)
+    {
+        v = tree.MinMarked(STRIP_BACKWARD);
+        if (v == PERM_TREE_NONE) return false;
+
+        k       = v - 1;
+        posV    = tree.PositionOf(v);
+    }
+
+    const uint32_t posOther = tree.PositionOf(k == v ? v + 1 : v - 1);
+    const uint32_t a        = min(posV, posOther);
+    const uint32_t b        = max(posV, posOther);
+
+    // -k and k + 1 sum to 1, k and -(k + 1) to -1.
+
+    if (k == v) rev = { a, b - 1 };
+    else rev = { a + 1, b };
+
+    return true;
+}
+
+/**
+ * ReduceSignedPermutation - Collapse each run of adjacencies into one element, numbered by the rank of
+ * its smallest value and negative if the run is. No reversal of an optimal scenario needs to break an
+ * adjacency, so the reduced permutation has the same distance.
+ *
+ * @param perm      [in]        Framed signed permutation.
+ * @param reduced   [in/out]    Framed reduced permutation.
+ * @param low       [in/out]    Smallest value of each reduced element's run.
+ * @param high      [in/out]    Largest value of each reduced element's run.
+ */
+
+static void ReduceSignedPermutation(const vector<int32_t>& perm, vector<int32_t>& reduced, vector<uint32_t>& low, vector<uint32_t>& high)
+{
+    const uint32_t size = (uint32_t)perm.size();
+
+    vector<uint32_t> runStart;
+    for (uint32_t p = 0; p < size; p++) if (p == 0 || perm[p] - perm[p - 1] != 1) runStart.push_back(p);
+    runStart.push_back(size);
+
+    const uint32_t numRuns = (uint32_t)runStart.size() - 1;
+
+    // Runs cover disjoint value ranges, so ranking them by smallest value is a counting pass.
+
+    vector<uint32_t> rankOf(size, NO_COMPONENT);
+
+    for (uint32_t r = 0; r < numRuns; r++)
+        rankOf[min(abs(perm[runStart[r]]), abs(perm[runStart[r + 1] - 1]))] = 0;
+
+    uint32_t numRanked = 0;
+    for (auto& rank : rankOf) if (rank != NO_COMPONENT) rank = numRanked++;
+
+    reduced.resize(numRuns);
+    low.resize(numRuns);
+    high.resize(numRuns);
+
+    for (uint32_t r = 0; r < numRuns; r++)
+    {
+        const int32_t first     = perm[runStart[r]];
+        const int32_t last      = perm[runStart[r + 1] - 1];
+        const uint32_t rank     = rankOf[min(abs(first), abs(last))];
+
+        low[rank]   = min(abs(first), abs(last));
+        high[rank]  = max(abs(first), abs(last));
+        reduced[r]  = first < 0 ? -(int32_t)rank : (int32_t)rank;
+    }
+}
+
+/**
+ * ExpandReducedScenario - Map a scenario of a reduced permutation back onto the full one. Both are
+ * replayed on trees. A run starts at its smallest value while its reduced element is positive and at
+ * its largest while negative.
+ *
+ * @param  perm     [in]        Framed signed permutation.
+ * @param  reduced  [in]        Its reduced permutation.
+ * @param  low      [in]        Smallest value of each reduced element's run.
+ * @param  high     [in]        Largest value of each reduced element's run.
+ * @param  steps    [in]        Scenario sorting reduced.
+ * @param  scenario [in/out]    Receives the matching reversals of perm.
+ *
+ * @return          False if the mapped scenario doesn't sort perm.
+ */
+
+static bool ExpandReducedScenario(const vector<int32_t>& perm, const vector<int32_t>& reduced, const vector<uint32_t>& low,
+    const vector<uint32_t>& high, const vector<Reversal>& steps, vector<Reversal>& scenario)
+{
+    PermTree full(perm);
+    PermTree runs(reduced);
+
+    for (auto& step : steps)
+    {
+        const uint32_t first    = runs.At(step.begin);
+        const uint32_t last     = runs.At(step.end);
+        const uint32_t begin    = full.PositionOf(runs.IsNegative(first) ? high[first] : low[first]);
+        const uint32_t end      = full.PositionOf(runs.IsNegative(last) ? low[last] : high[last]);
+
+        runs.Reverse(step.begin, step.end);
+        full.Reverse(begin, end);
+        scenario.push_back({ begin, end });
+    }
+
+    vector<int32_t> sorted;
+    full.Flatten(sorted);
+
+    for (int32_t i = 0; i < (int32_t)sorted.size(); i++)
+        if (sorted[i] != i) return false;
+
+    return true;
+}
+
+/**
+ * FindSignedScenario - Optimal sorting scenario for a framed signed permutation at a known distance.
+ *
+ * The permutation is held in a signed PermTree, so picking an oriented reversal and applying it cost
+ * O(log n). Nearly all oriented reversals are safe, lowering the distance by one, but not all, so they
+ * are applied in batches: after each batch the tree is flattened and the distance recomputed in
+ * linear time. A batch that lowered the distance by its length is kept and the next one is twice as
+ * long; otherwise the tree goes back to the last kept state and the batch size is halved. A single
+ * unsafe reversal is replaced by the best scoring one, which is always safe, and with no oriented pair
+ * left a hurdle is cleared.
+ *
+ * Unsafe reversals gather at the end of the sort, when few breakpoints are left, so once the runs of
+ * adjacencies are down to a quarter of the elements they are collapsed and the rest is solved on the
+ * smaller permutation. Batch sizes settle around the inverse of the unsafe rate, so random
+ * permutations take O(n log n) for the reversals plus a linear check per batch. Inputs where most
+ * oriented reversals are unsafe fall back to a scored reversal per step, O(n^2 log n) in all.
+ *
+ * @param  perm         [in]        Framed signed permutation.
+ * @param  distance     [in]        Its reversal distance.
+ * @param  batchSize    [in]        Reversals in the first batch.
+ * @param  scenario     [in/out]    Receives distance reversals sorting perm. Assumed empty.
+ *
+ * @return              UNABLE_TO_FIND_SOLUTION if the search gets stuck. OK otherwise.
+ */
+
+static ResultCode FindSignedScenario(const vector<int32_t>& perm, const uint32_t distance, uint32_t batchSize, vector<Reversal>& scenario)
+{
+    vector<int32_t> kept = perm;
+    vector<int32_t> next;
+    vector<Reversal> batch;
+    SignedBreakpointGraph graph;
+    Rng rng(perm.size());
+
+    PermTree tree(kept);
+
+    uint32_t remaining = distance;
+
+    while (remaining > 0)
+    {
+        // Once most breakpoints are gone, go on with the runs of adjacencies collapsed, so the linear
+        // checks shrink with the work left.
+
+        uint32_t numRuns = 1;
+        for (size_t p = 1; p < kept.size(); p++) if (kept[p] - kept[p - 1] != 1) numRuns++;
+
+        if (4 * numRuns <= kept.size())
+        {
+            vector<int32_t> reduced;
+            vector<uint32_t> low;
+            vector<uint32_t> high;
+            vector<Reversal> steps;
+
+            ReduceSignedPermutation(kept, reduced, low, high);
+
+            ResultCode res = FindSignedScenario(reduced, remaining, batchSize, steps);
+            if (res != OK) return res;
+
+            return ExpandReducedScenario(kept, reduced, low, high, steps, scenario) ? OK : UNABLE_TO_FIND_SOLUTION;
+        }
+
+        // Each reversal removes at least one run, so stop the batch where the runs may reach a quarter.
+
+        const uint32_t batchLimit = min(min(batchSize, remaining), numRuns - (uint32_t)kept.size() / 4);
+
+        Reversal rev;
+
+        batch.clear();
+
+        while (batch.size() < batchLimit && PickOrientedReversal(tree, rng, rev))
+        {
+            tree.Reverse(rev.begin, rev.end);
+            batch.push_back(rev);
+        }
+
+        if (batch.empty())
+        {
+            if (!FindHurdleReversal(kept, remaining, rev)) return UNABLE_TO_FIND_SOLUTION;
+
+            ApplySignedReversal(kept, rev.begin, rev.end);
+            scenario.push_back(rev);
+            remaining--;
+
+            tree = PermTree(kept);
+            continue;
+        }
+
+        tree.Flatten(next);
+        AnalyzeSignedPermutation(next, graph);
+
+        if (graph.Distance() + batch.size() == remaining)
+        {
+            kept.swap(next);
+            scenario.insert(scenario.end(), batch.begin(), batch.end());
+            remaining   -= (uint32_t)batch.size();
+            batchSize   = min(batchSize * 2, distance);
+            continue;
+        }
+
+        if (batchSize == 1)
+        {
+            if (!FindOrientedReversal(kept, rev)) return UNABLE_TO_FIND_SOLUTION;
+
+            ApplySignedReversal(kept, rev.begin, rev.end);
+            scenario.push_back(rev);
+            remaining--;
+        }
+
+        batchSize   = max(batchSize / 2, 1u);
+        tree        = PermTree(kept);
+    }
+
+    for (int32_t i = 0; i < (int32_t)kept.size(); i++)
+        if (kept[i] != i) return UNABLE_TO_FIND_SOLUTION;
+
+    return OK;
+}
+
+/**
+ * SignedReversalDistance - Exact reversal distance of a framed signed permutation from the identity,
+ * and optionally an optimal sorting scenario. The distance takes linear time. The scenario is built on
+ * a signed PermTree with checked batches of reversals (see FindSignedScenario), which handles random
+ * permutations of hundreds of thousands of elements.
+ *
+ * @param  perm     [in]        Framed signed permutation.
+ * @param  distance [in/out]    Reversal distance.
+ * @param  scenario [in/out]    If given, receives distance reversals sorting perm. Assumed empty.
+ *
+ * @return          INVALID_INPUT if perm isn't a framed signed permutation. UNABLE_TO_FIND_SOLUTION
+ *                  if the scenario search gets stuck. OK otherwise.
+ */
+
+ResultCode SignedReversalDistance(const vector<int32_t>& perm, uint32_t& distance, vector<Reversal>* scenario)
+{
+    if (!IsFramedSignedPermutation(perm)) return INVALID_INPUT;
+
+    SignedBreakpointGraph graph;
+    AnalyzeSignedPermutation(perm, graph);
+
+    distance = graph.Distance();
+
+    if (scenario == nullptr) return OK;
+
+    assert(scenario->size() == 0);
+
+    return FindSignedScenario(perm, distance, 1, *scenario);
+}
+
+/**
+ * EncodeSigned - Test helper. Pack a small framed signed permutation 4 bits per element.
+ */
+
+static uint32_t EncodeSigned(const vector<int32_t>& perm)
+{
+    uint32_t code = 0;
+    for (size_t i = 1; i + 1 < perm.size(); i++) code = (code << 4) | ((uint32_t)abs(perm[i]) << 1) | (perm[i] < 0 ? 1 : 0);
+    return code;
+}
+
+/**
+ * BruteForceDistances - Test helper. Breadth first search from the identity over all reversals gives
+ * the exact distance of every signed permutation of n elements, since reversals are their own inverses.
+ */
+
+static void BruteForceDistances(const uint32_t n, unordered_map<uint32_t, uint32_t>& dist, vector<vector<int32_t>>& perms)
+{
+    vector<int32_t> start(n + 2);
+    iota(start.begin(), start.end(), 0);
+
+    dist[EncodeSigned(start)] = 0;
+    perms.push_back(start);
+
+    for (size_t head = 0; head < perms.size(); head++)
+    {
+        const uint32_t d = dist[EncodeSigned(perms[head])];
+
+        for (uint32_t l = 1; l <= n; l++)
+        {
+            for (uint32_t r = l; r <= n; r++)
+            {
+                vector<int32_t> next = perms[head];
+                ApplySignedReversal(next, l, r);
+
+                if (dist.emplace(EncodeSigned(next), d + 1).second) perms.push_back(next);
+            }
+        }
+    }
+}
+
+/**
+ * CheckScenario - Test helper. Compute distance and scenario and check the scenario has distance
+ * reversals that sort perm.
+ *
+ * @return Empty string on success, otherwise a failure message.
+ */
+
+static string CheckScenario(const vector<int32_t>& perm, uint32_t& distance)
+{
+    vector<Reversal> scenario;
+
+    ResultCode res = SignedReversalDistance(perm, distance, &scenario);
+    if (res != OK) return "Scenario search failed with code " + to_string(res);
+
+    if (scenario.size() != distance)
+        return "Scenario has " + to_string(scenario.size()) + " reversals for distance " + to_string(distance);
+
+    vector<int32_t> replay = perm;
+    ApplySignedReversals(replay, scenario);
+
+    for (int32_t i = 0; i < (int32_t)replay.size(); i++)
+        if (replay[i] != i) return "Scenario doesn't sort input.";
+
+    return "";
+}
+
+static void RandomSignedPermutation(const uint32_t n, Rng& rng, vector<int32_t>& perm)
+{
+    perm.resize(n + 2);
+    iota(perm.begin(), perm.end(), 0);
+
+    for (uint32_t i = n; i > 1; i--) swap(perm[i], perm[1 + rng.NextBounded(i)]);
+    for (uint32_t i = 1; i <= n; i++) if (rng.Next() & 1) perm[i] = -perm[i];
+}
+
+/**
+ * TestBruteForce - Compare distance and scenario length with breadth first search over every signed
+ * permutation of up to 6 elements.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestBruteForce(vector<TestResult>& testResults)
+{
+    for (uint32_t n = 1; n <= 6; n++)
+    {
+        unordered_map<uint32_t, uint32_t> dist;
+        vector<vector<int32_t>> perms;
+        BruteForceDistances(n, dist, perms);
+
+        string err;
+
+        for (size_t i = 0; i < perms.size() && err.empty(); i++)
+        {
+            uint32_t distance = 0;
+            err = CheckScenario(perms[i], distance);
+
+            if (err.empty() && distance != dist[EncodeSigned(perms[i])])
+                err = "Distance " + to_string(distance) + ", expected " + to_string(dist[EncodeSigned(perms[i])]);
+        }
+
+        const string name = "SignedReversal::BruteForce[" + to_string(n) + "]";
+
+        if (err.empty()) testResults.push_back({ name, PASS, to_string(perms.size()) + " permutations." });
+        else testResults.push_back({ name, FAIL, err });
+    }
+}
+
+/**
+ * TestScenarios - Check scenarios on random permutations of a few hundred and a few thousand elements.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestScenarios(vector<TestResult>& testResults)
+{
+    Rng rng(61);
+    const uint32_t sizes[] = { 10, 100, 1000 };
+
+    for (uint32_t n : sizes)
+    {
+        string err;
+        uint32_t distance = 0;
+
+        long long t1 = GetMilliseconds();
+
+        for (uint32_t trial = 0; trial < 20 && err.empty(); trial++)
+        {
+            vector<int32_t> perm;
+            RandomSignedPermutation(n, rng, perm);
+
+            // All positive permutations are full of unoriented components, so hurdles get exercised.
+
+            if (trial & 1) for (uint32_t i = 1; i <= n; i++) perm[i] = abs(perm[i]);
+
+            err = CheckScenario(perm, distance);
+        }
+
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const string name = "SignedReversal::Scenario[" + to_string(n) + "]";
+
+        if (err.empty()) testResults.push_back({ name, PASS, "T = " + to_string(sec) + " sec." });
+        else testResults.push_back({ name, FAIL, err });
+    }
+}
+
+/**
+ * TestLargeScenarios - Scenarios for a random signed permutation of 10^5 elements and for an all
+ * positive one, which starts as one big hurdle. They are replayed on a signed PermTree, since a plain
+ * array would take O(n) per reversal.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestLargeScenarios(vector<TestResult>& testResults)
+{
+    Rng rng(63);
+
+    const uint32_t n        = 100000;
+    const string names[]    = { "SignedReversal::Scenario[100000]", "SignedReversal::PositiveScenario[100000]" };
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        vector<int32_t> perm;
+        RandomSignedPermutation(n, rng, perm);
+
+        if (i == 1) for (uint32_t p = 1; p <= n; p++) perm[p] = abs(perm[p]);
+
+        uint32_t distance = 0;
+        vector<Reversal> scenario;
+
+        long long t1    = GetMilliseconds();
+        ResultCode res  = SignedReversalDistance(perm, distance, &scenario);
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        PermTree replay(perm);
+        for (auto& rev : scenario) replay.Reverse(rev.begin, rev.end);
+
+        vector<int32_t> sorted;
+        replay.Flatten(sorted);
+
+        string err;
+
+        if (res != OK) err = "Scenario search failed with code " + to_string(res);
+        else if (scenario.size() != distance) err = "Scenario has " + to_string(scenario.size()) + " reversals for distance " + to_string(distance);
+
+        for (int32_t p = 0; p < (int32_t)sorted.size() && err.empty(); p++)
+            if (sorted[p] != p) err = "Scenario doesn't sort input.";
+
+        if (err.empty()) testResults.push_back({ names[i], PASS, "d = " + to_string(distance) + ", T = " + to_string(sec) + " sec." });
+        else testResults.push_back({ names[i], FAIL, err });
+    }
+}
+
+/**
+ * TestLargeDistance - Distance of permutations with hundreds of thousands of elements: one built from
+ * a known number of random reversals, whose distance can't exceed it, and one shuffled.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestLargeDistance(vector<TestResult>& testResults)
+{
+    Rng rng(62);
+
+    const uint32_t n            = 500000;
+    const uint32_t numPlanted   = 2000;
+
+    vector<int32_t> planted(n + 2);
+    iota(planted.begin(), planted.end(), 0);
+
+    for (uint32_t i = 0; i < numPlanted; i++)
+    {
+        const uint32_t l = 1 + rng.NextBounded(n);
+        const uint32_t r = l + rng.NextBounded(min(n - l + 1, 5000u));
+        ApplySignedReversal(planted, l, r);
+    }
+
+    uint32_t distance   = 0;
+    long long t1        = GetMilliseconds();
+    ResultCode res      = SignedReversalDistance(planted, distance);
+    long long t2        = GetMilliseconds();
+    float sec           = ((float)t2 - (float)t1) / 1000.0f;
+
+    if (res == OK && distance <= numPlanted && distance > 0)
+        testResults.push_back({ "SignedReversal::Planted[500000]", PASS, "d = " + to_string(distance) + ", T = " + to_string(sec) + " sec." });
+    else
+        testResults.push_back({ "SignedReversal::Planted[500000]", FAIL, "Distance " + to_string(distance) + " for " + to_string(numPlanted) + " planted reversals." });
+
+    vector<int32_t> shuffled;
+    RandomSignedPermutation(n, rng, shuffled);
+
+    t1  = GetMilliseconds();
+    res = SignedReversalDistance(shuffled, distance);
+    t2  = GetMilliseconds();
+    sec = ((float)t2 - (float)t1) / 1000.0f;
+
+    if (res == OK && distance <= n + 1) testResults.push_back({ "SignedReversal::Shuffled[500000]", PASS, "d = " + to_string(distance) + ", T = " + to_string(sec) + " sec." });
+    else testResults.push_back({ "SignedReversal::Shuffled[500000]", FAIL, "Distance " + to_string(distance) + " out of range." });
+}
+
+/**
+ * SignedReversalSorting - Tests for the signed reversal distance engine.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void SignedReversalSorting(vector<TestResult>& testResults)
+{
+    TestBruteForce(testResults);
+    TestScenarios(testResults);
+    TestLargeScenarios(testResults);
+    TestLargeDistance(testResults);
+}
@@ -0,0 +1,876 @@
+// Winsock has to come before Windows.h, which commoninc.h includes.
+
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+
+#include "problems.h"
+#include "daemon.h"
+#include "batch.h"
+
+#include <memory>
+
+#pragma comment(lib, "Ws2_32.lib")
+
+const uint32_t DAEMON_RECV_CHUNK        = 64 << 10;
+const int DAEMON_POLL_TIMEOUT_MS        = 100;
+const uint32_t DAEMON_CONNECT_RETRIES   = 50;
+const int DAEMON_STALL_POLL_MS          = 1;
+const size_t DAEMON_MAX_OUTBOUND        = 16 << 20;
+
+/*
+ * Winsock is reference counted per process; every user holds a session for as long as it needs
+ * sockets.
+ */
+
+struct WinsockSession
+{
+    bool ok;
+
+    WinsockSession()
+    {
+        WSADATA data;
+        ok = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+
+    ~WinsockSession() { if (ok) WSACleanup(); }
+};
+
+static bool SendAll(SOCKET sock, const char* data, size_t len)
+{
+    while (len > 0)
+    {
+        const int chunk = (int)min(len, (size_t)1 << 30);
+        const int sent  = send(sock, data, chunk, 0);
+        if (sent <= 0) return false;
+
+        data    += sent;
+        len     -= sent;
+    }
+
+    return true;
+}
+
+static bool RecvAll(SOCKET sock, char* data, size_t len)
+{
+    while (len > 0)
+    {
+        const int chunk = (int)min(len, (size_t)1 << 30);
+        const int got   = recv(sock, data, chunk, 0);
+        if (got <= 0) return false;
+
+        data    += got;
+        len     -= got;
+    }
+
+    return true;
+}
+
+static bool MakeSocketAddress(const string& path, sockaddr_un& addr)
+{
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    return true;
+}
+
+/*
+ * One client connection. The socket is non-blocking and only the I/O thread receives on it. Solvers
+ * append responses to the outbound buffer and send what the socket takes straight away; whatever it
+ * doesn't take is drained by the I/O thread when the socket polls writable. Nothing ever blocks on a
+ * client that isn't reading. Jobs hold a reference, so the socket stays open until the last response
+ * for it is queued even if the I/O thread has already dropped the connection.
+ */
+
+struct DaemonConnection
+{
+    SOCKET sock;
+    string inbuf;
+    bool eof;                   // Client finished sending. I/O thread only.
+    bool stalled;               // Buffered requests are waiting for queue space. I/O thread only.
+    atomic<uint32_t> pending;   // Requests queued or being solved.
+
+    mutex sendLock;             // Guards the fields below.
+    string outbuf;
+    size_t outpos;
+    bool broken;
+
+    DaemonConnection(SOCKET sock) : sock(sock), eof(false), stalled(false), pending(0), outpos(0), broken(false)
+    {
+        u_long nonBlocking = 1;
+        ioctlsocket(sock, FIONBIO, &nonBlocking);
+    }
+
+    ~DaemonConnection() { closesocket(sock); }
+
+    /**
+     * Flush - Send as much of the outbound buffer as the socket takes without blocking. Caller holds
+     * sendLock.
+     */
+
+    void Flush()
+    {
+        while (outpos < outbuf.size() && !broken)
+        {
+            const int chunk = (int)min(outbuf.size() - outpos, (size_t)1 << 30);
+            const int sent  = send(sock, outbuf.data() + outpos, chunk, 0);
+
+            if (sent > 0) outpos += sent;
+            else if (sent == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) break;
+            else broken = true;
+        }
+
+        if (outpos == outbuf.size() || broken)
+        {
+            outbuf.clear();
+            outpos = 0;
+        }
+    }
+
+    size_t GetOutboundBytes()
+    {
+        lock_guard<mutex> guard(sendLock);
+        return outbuf.size() - outpos;
+    }
+
+    bool IsBroken()
+    {
+        lock_guard<mutex> guard(sendLock);
+        return broken;
+    }
+
+    void QueueResponse(const uint64_t requestId, const ResultCode result, const string& payload)
+    {
+        DaemonResponseHeader header;
+        memcpy(header.magic, DAEMON_RESPONSE_MAGIC, 4);
+
+        header.result       = (int32_t)result;
+        header.payloadLen   = (uint32_t)payload.size();
+        header.reserved     = 0;
+        header.requestId    = requestId;
+
+        {
+            lock_guard<mutex> guard(sendLock);
+
+            if (!broken)
+            {
+                outbuf.append((const char*)&header, sizeof(header));
+                outbuf.append(payload);
+                Flush();
+            }
+        }
+
+        pending--;
+    }
+};
+
+struct DaemonJob
+{
+    shared_ptr<DaemonConnection> conn;
+    uint64_t requestId;
+    string name;
+    string payload;
+};
+
+/**
+ * TakeRequest - Cut the next complete request frame off the front of a connection's input.
+ *
+ * @param  inbuf    [in]        Received bytes.
+ * @param  pos      [in/out]    Start of the next frame in inbuf, advanced past it.
+ * @param  job      [out]       Request fields.
+ *
+ * @return          1 for a request, 0 if the frame isn't complete yet, -1 for a malformed frame.
+ */
+
+static int TakeRequest(const string& inbuf, size_t& pos, DaemonJob& job)
+{
+    if (inbuf.size() - pos < sizeof(DaemonRequestHeader)) return 0;
+
+    DaemonRequestHeader header;
+    memcpy(&header, inbuf.data() + pos, sizeof(header));
+
+    if (memcmp(header.magic, DAEMON_REQUEST_MAGIC, 4) != 0) return -1;
+    if (header.nameLen == 0 || header.nameLen > DAEMON_MAX_NAME_LEN || header.payloadLen > DAEMON_MAX_PAYLOAD_LEN) return -1;
+
+    const size_t frameLen = sizeof(header) + header.nameLen + header.payloadLen;
+    if (inbuf.size() - pos < frameLen) return 0;
+
+    const char* body = inbuf.data() + pos + sizeof(header);
+
+    job.requestId = header.requestId;
+    job.name.assign(body, header.nameLen);
+    job.payload.assign(body + header.nameLen, header.payloadLen);
+
+    pos += frameLen;
+    return 1;
+}
+
+/**
+ * AdmitRequests - Queue the complete requests buffered on a connection for the solvers, without
+ * waiting. When the queue is full the rest stay buffered and the connection is marked stalled, so the
+ * I/O thread stops reading from it until they fit.
+ *
+ * @param  conn     [in]    Connection to take requests from.
+ * @param  jobs     [in]    Solver queue.
+ *
+ * @return          False for a malformed frame.
+ */
+
+static bool AdmitRequests(const shared_ptr<DaemonConnection>& conn, BoundedQueue<DaemonJob>& jobs)
+{
+    size_t pos = 0;
+    DaemonJob job;
+    int status;
+
+    conn->stalled = false;
+
+    while (true)
+    {
+        size_t next = pos;
+        if ((status = TakeRequest(conn->inbuf, next, job)) != 1) break;
+
+        job.conn = conn;
+        conn->pending++;
+
+        if (!jobs.TryPush(job))
+        {
+            conn->pending--;
+            conn->stalled = true;
+            break;
+        }
+
+        pos = next;
+    }
+
+    conn->inbuf.erase(0, pos);
+    return status >= 0;
+}
+
+/*
+ * State shared by the daemon's I/O thread and solver pool.
+ */
+
+struct DaemonServer
+{
+    const DaemonOptions& options;
+    atomic<bool> stopRequested;
+    mutex selfTestLock;         // Self-tests share rand() and the allocation counters; run one at a time.
+
+    DaemonServer(const DaemonOptions& options) : options(options), stopRequested(false) {}
+
+    ResultCode Handle(DaemonJob& job, string& out);
+    ResultCode RunSelfTest(pfnProblem problem, string& out);
+};
+
+ResultCode DaemonServer::RunSelfTest(pfnProblem problem, string& out)
+{
+    vector<TestResult> results;
+
+    {
+        lock_guard<mutex> guard(selfTestLock);
+        problem(results);
+    }
+
+    uint32_t counts[3] = { 0, 0, 0 };
+    for (auto& res : results) counts[res.code]++;
+
+    out = "pass " + to_string(counts[PASS]) + " fail " + to_string(counts[FAIL]) + " error " + to_string(counts[EXECUTION_ERROR]);
+
+    for (auto& res : results)
+        if (res.code != PASS) out += "\n" + res.testName + ": " + res.testMsg;
+
+    return OK;
+}
+
+/**
+ * Handle - Run one request on a solver thread.
+ *
+ * @param  job  [in]        Request.
+ * @param  out  [in/out]    Response payload.
+ *
+ * @return      Response result code. INVALID_INPUT for unknown names.
+ */
+
+ResultCode DaemonServer::Handle(DaemonJob& job, string& out)
+{
+    BatchProblem batchProblem;
+
+    if (ParseBatchProblem(job.name.c_str(), batchProblem)) return SolveBatchInstance(batchProblem, job.payload, out);
+
+    if (options.problems != nullptr)
+    {
+        auto it = options.problems->find(job.name);
+        if (it != options.problems->end()) return RunSelfTest(it->second, out);
+    }
+
+    if (job.name == "ping")
+    {
+        out = "pong";
+        return OK;
+    }
+
+    if (job.name == "shutdown")
+    {
+        stopRequested = true;
+        out = "bye";
+        return OK;
+    }
+
+    out = "unknown request " + job.name;
+    return INVALID_INPUT;
+}
+
+/**
+ * RunDaemon - Serve requests until a shutdown request arrives or stop is set. One I/O thread polls the
+ * listening socket and every connection, cuts complete frames out of what arrives and queues them for
+ * a fixed pool of solver threads. Neither side ever blocks on a client:
+ *
+ *   - Admission doesn't wait for queue space. While the queue is full, a connection's remaining
+ *     requests stay buffered and the daemon stops reading from it, so a flood backs up into the
+ *     client's socket rather than into memory or the I/O thread.
+ *   - Responses go to a per-connection outbound buffer that the I/O thread drains as the socket
+ *     becomes writable. A connection whose outbound buffer passes DAEMON_MAX_OUTBOUND isn't read from
+ *     until the client catches up, so a client that sends everything before reading anything only
+ *     holds up itself.
+ *
+ * @param  options  [in]    Socket path and pool sizes.
+ * @param  stop     [in]    Optional flag to stop the daemon from another thread.
+ *
+ * @return          IO_ERROR if the socket can't be set up or another daemon is listening on it. OK
+ *                  after a clean shutdown.
+ */
+
+ResultCode RunDaemon(const DaemonOptions& options, const atomic<bool>* stop)
+{
+    WinsockSession winsock;
+    if (!winsock.ok) return IO_ERROR;
+
+    sockaddr_un addr;
+    if (!MakeSocketAddress(options.socketPath, addr)) return INVALID_INPUT;
+
+    // A socket file left behind by an earlier daemon would make bind fail, but one that a running daemon
+    // still accepts connections on belongs to it.
+
+    SOCKET probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe == INVALID_SOCKET) return IO_ERROR;
+
+    const bool inUse = connect(probe, (const sockaddr*)&addr, sizeof(addr)) == 0;
+    closesocket(probe);
+
+    if (inUse) return IO_ERROR;
+
+    DeleteFileA(options.socketPath.c_str());
+
+    SOCKET listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) return IO_ERROR;
+
+    if (bind(listener, (const sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(listener, SOMAXCONN) == SOCKET_ERROR)
+    {
+        closesocket(listener);
+        return IO_ERROR;
+    }
+
+    DaemonServer server(options);
+
+    const uint32_t numSolvers   = options.numSolvers ? options.numSolvers : GetWorkerCount();
+    const uint32_t maxQueued    = options.maxQueued ? options.maxQueued : 64 * numSolvers;
+
+    BoundedQueue<DaemonJob> jobs(maxQueued);
+    vector<thread> solvers;
+
+    for (uint32_t t = 0; t < numSolvers; t++)
+    {
+        solvers.push_back(thread([&]()
+        {
+            DaemonJob job;
+            string out;
+
+            while (jobs.Pop(job))
+            {
+                out.clear();
+                ResultCode res = server.Handle(job, out);
+
+                job.conn->QueueResponse(job.requestId, res, out);
+                job.conn.reset();
+            }
+        }));
+    }
+
+    vector<shared_ptr<DaemonConnection>> conns;
+    vector<WSAPOLLFD> fds;
+    vector<size_t> fdIndex;     // Each connection's entry in fds, or 0 when it isn't polled.
+    vector<char> chunk(DAEMON_RECV_CHUNK);
+
+    while (!server.stopRequested && !(stop != nullptr && *stop))
+    {
+        bool anyStalled = false;
+
+        fds.resize(1);
+        fdIndex.resize(conns.size());
+
+        fds[0].fd       = listener;
+        fds[0].events   = POLLRDNORM;
+        fds[0].revents  = 0;
+
+        // A connection that has stopped sending and has nothing to write is only waiting on its solvers,
+        // and polling it would just report the hang-up over and over.
+
+        for (size_t i = 0; i < conns.size(); i++)
+        {
+            DaemonConnection& conn  = *conns[i];
+            const size_t outbound   = conn.GetOutboundBytes();
+
+            WSAPOLLFD fd;
+            fd.fd       = conn.sock;
+            fd.events   = 0;
+            fd.revents  = 0;
+
+            if (!conn.eof && !conn.stalled && outbound < DAEMON_MAX_OUTBOUND) fd.events |= POLLRDNORM;
+            if (outbound > 0) fd.events |= POLLWRNORM;
+
+            if (conn.stalled) anyStalled = true;
+
+            fdIndex[i] = conn.eof && fd.events == 0 ? 0 : fds.size();
+            if (fdIndex[i] != 0) fds.push_back(fd);
+        }
+
+        if (WSAPoll(fds.data(), (ULONG)fds.size(), anyStalled ? DAEMON_STALL_POLL_MS : DAEMON_POLL_TIMEOUT_MS) == SOCKET_ERROR) break;
+
+        // Walk the connections back to front so dropping one doesn't disturb the indices still to visit.
+
+        for (size_t i = conns.size(); i > 0; i--)
+        {
+            DaemonConnection& conn  = *conns[i - 1];
+            const short events      = fdIndex[i - 1] != 0 ? fds[fdIndex[i - 1]].events : 0;
+            const short revents     = fdIndex[i - 1] != 0 ? fds[fdIndex[i - 1]].revents : 0;
+            bool drop               = (revents & POLLNVAL) != 0;
+            bool received           = false;
+
+            if (revents & POLLWRNORM)
+            {
+                lock_guard<mutex> guard(conn.sendLock);
+                conn.Flush();
+            }
+
+            if (!drop && (events & POLLRDNORM) && (revents & (POLLRDNORM | POLLHUP | POLLERR)))
+            {
+                const int got = recv(conn.sock, chunk.data(), (int)chunk.size(), 0);
+
+                if (got > 0) conn.inbuf.append(chunk.data(), got);
+                else if (got == 0) conn.eof = true;
+                else if (WSAGetLastError() != WSAEWOULDBLOCK) drop = true;
+
+                received = got > 0;
+            }
+
+            if (!drop && (received || conn.stalled)) drop = !AdmitRequests(conns[i - 1], jobs);
+
+            // A client that has finished sending keeps its connection until its last response is out.
+
+            if (!drop) drop = conn.IsBroken() || (conn.eof && !conn.stalled && conn.pending == 0 && conn.GetOutboundBytes() == 0);
+
+            if (drop) conns.erase(conns.begin() + (i - 1));
+        }
+
+        if (fds[0].revents != 0)
+        {
+            SOCKET client = accept(listener, NULL, NULL);
+            if (client != INVALID_SOCKET) conns.push_back(make_shared<DaemonConnection>(client));
+        }
+    }
+
+    jobs.Close();
+    for (auto& solver : solvers) solver.join();
+
+    conns.clear();
+    closesocket(listener);
+    DeleteFileA(options.socketPath.c_str());
+
+    return OK;
+}
+
+/*
+ * Blocking client side of the protocol, used by the load generator and the tests.
+ */
+
+struct DaemonClient
+{
+    SOCKET sock;
+
+    DaemonClient() : sock(INVALID_SOCKET) {}
+    ~DaemonClient() { Close(); }
+
+    /**
+     * Connect - Connect to a daemon, retrying for a while in case it is still starting up.
+     */
+
+    ResultCode Connect(const string& path)
+    {
+        sockaddr_un addr;
+        if (!MakeSocketAddress(path, addr)) return INVALID_INPUT;
+
+        for (uint32_t attempt = 0; attempt < DAEMON_CONNECT_RETRIES; attempt++)
+        {
+            sock = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (sock == INVALID_SOCKET) return IO_ERROR;
+
+            if (connect(sock, (const sockaddr*)&addr, sizeof(addr)) == 0) return OK;
+
+            Close();
+            this_thread::sleep_for(chrono::milliseconds(DAEMON_POLL_TIMEOUT_MS));
+        }
+
+        return IO_ERROR;
+    }
+
+    void Close()
+    {
+        if (sock != INVALID_SOCKET) closesocket(sock);
+        sock = INVALID_SOCKET;
+    }
+
+    bool Send(const uint64_t requestId, const string& name, const string& payload)
+    {
+        DaemonRequestHeader header;
+        memcpy(header.magic, DAEMON_REQUEST_MAGIC, 4);
+
+        header.nameLen      = (uint32_t)name.size();
+        header.payloadLen   = (uint32_t)payload.size();
+        header.reserved     = 0;
+        header.requestId    = requestId;
+
+        string frame((const char*)&header, sizeof(header));
+        frame += name;
+        frame += payload;
+
+        return SendAll(sock, frame.data(), frame.size());
+    }
+
+    bool Receive(uint64_t& requestId, ResultCode& result, string& payload)
+    {
+        DaemonResponseHeader header;
+
+        if (!RecvAll(sock, (char*)&header, sizeof(header))) return false;
+        if (memcmp(header.magic, DAEMON_RESPONSE_MAGIC, 4) != 0 || header.payloadLen > DAEMON_MAX_PAYLOAD_LEN) return false;
+
+        payload.resize(header.payloadLen);
+
+        requestId   = header.requestId;
+        result      = (ResultCode)header.result;
+
+        return header.payloadLen == 0 || RecvAll(sock, &payload[0], header.payloadLen);
+    }
+
+    /**
+     * Call - Send one request and wait for its response.
+     */
+
+    bool Call(const string& name, const string& payload, ResultCode& result, string& response)
+    {
+        uint64_t requestId = 0;
+        return Send(0, name, payload) && Receive(requestId, result, response);
+    }
+};
+
+static double Percentile(const vector<double>& sorted, const double fraction)
+{
+    if (sorted.empty()) return 0;
+
+    const size_t idx = (size_t)(fraction * (double)(sorted.size() - 1) + 0.5);
+    return sorted[min(idx, sorted.size() - 1)];
+}
+
+/**
+ * RunLoadGenerator - Drive a daemon from several client threads and report request latencies. Each
+ * client sends requests round robin over the instances, starting at its own offset, and keeps up to
+ * pipelineDepth of them outstanding.
+ *
+ * @param  options  [in]    Daemon socket, request name and instances, client count and load shape.
+ * @param  stats    [out]   Request and error counts, wall time and latency percentiles.
+ *
+ * @return          INVALID_INPUT without instances or clients. IO_ERROR if a client loses its
+ *                  connection. OK otherwise.
+ */
+
+ResultCode RunLoadGenerator(const LoadGenOptions& options, LoadGenStats& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    if (options.instances.empty() || options.numClients == 0 || options.pipelineDepth == 0) return INVALID_INPUT;
+
+    WinsockSession winsock;
+    if (!winsock.ok) return IO_ERROR;
+
+    vector<vector<double>> latencies(options.numClients);
+    atomic<uint64_t> errors(0);
+    atomic<bool> failed(false);
+
+    long long t1 = GetNanoseconds();
+
+    vector<thread> clients;
+
+    for (uint32_t c = 0; c < options.numClients; c++)
+    {
+        clients.push_back(thread([&, c]()
+        {
+            DaemonClient client;
+
+            if (client.Connect(options.socketPath) != OK)
+            {
+                failed = true;
+                return;
+            }
+
+            vector<double>& lat = latencies[c];
+            vector<long long> sendTimes(options.requestsPerClient);
+            lat.reserve(options.requestsPerClient);
+
+            uint32_t sent       = 0;
+            uint32_t received   = 0;
+            string payload;
+
+            while (received < options.requestsPerClient)
+            {
+                while (sent < options.requestsPerClient && sent - received < options.pipelineDepth)
+                {
+                    const string& instance = options.instances[(c + (size_t)sent * options.numClients) % options.instances.size()];
+                    sendTimes[sent] = GetNanoseconds();
+
+                    if (!client.Send(sent, options.name, instance))
+                    {
+                        failed = true;
+                        return;
+                    }
+
+                    sent++;
+                }
+
+                uint64_t requestId;
+                ResultCode result;
+
+                if (!client.Receive(requestId, result, payload) || requestId >= sent)
+                {
+                    failed = true;
+                    return;
+                }
+
+                lat.push_back((double)(GetNanoseconds() - sendTimes[requestId]) / 1000.0);
+                if (result != OK) errors++;
+
+                received++;
+            }
+        }));
+    }
+
+    for (auto& client : clients) client.join();
+
+    vector<double> all;
+    for (auto& lat : latencies) all.insert(all.end(), lat.begin(), lat.end());
+    sort(all.begin(), all.end());
+
+    stats.requests  = all.size();
+    stats.errors    = errors;
+    stats.seconds   = (double)(GetNanoseconds() - t1) / 1e9;
+    stats.p50Us     = Percentile(all, 0.5);
+    stats.p90Us     = Percentile(all, 0.9);
+    stats.p99Us     = Percentile(all, 0.99);
+    stats.p999Us    = Percentile(all, 0.999);
+    stats.maxUs     = all.empty() ? 0 : all.back();
+
+    return failed ? IO_ERROR : OK;
+}
+
+/**
+ * SolverDaemon - Daemon tests. Starts a daemon on a thread and checks pipelined requests come back
+ * matched to the right instances, then runs a self-test through the registry, checks a malformed
+ * frame drops the connection, runs the load generator, checks a client that doesn't read its responses
+ * doesn't stall other clients and a second daemon doesn't take over the socket, and shuts the daemon
+ * down with a request.
+ *
+ * @param testResults Result list to append results to.
+ */
+
+void SolverDaemon(vector<TestResult>& testResults)
+{
+    const uint32_t numInstances = 200;
+
+    map<string, pfnProblem> registry = { { "GetMinMax", GetMinMax } };
+
+    DaemonOptions options;
+    options.socketPath  = GetTempFilePath("bp_daemon_test.sock");
+    options.numSolvers  = 4;
+    options.problems    = &registry;
+
+    ResultCode daemonResult = OK;
+    atomic<bool> stop(false);
+    thread daemon([&]() { daemonResult = RunDaemon(options, &stop); });
+
+    WinsockSession winsock;
+    DaemonClient client;
+
+    if (client.Connect(options.socketPath) != OK)
+    {
+        testResults.push_back({ "Daemon::Connect", FAIL, "Unable to connect to the daemon." });
+
+        stop = true;
+        daemon.join();
+        return;
+    }
+
+    // Pipeline every request before reading any response.
+
+    vector<pair<uint32_t, uint32_t>> expected(numInstances);
+    bool sendOk = true;
+
+    for (uint32_t i = 0; i < numInstances && sendOk; i++)
+    {
+        const uint32_t len = 1 + rand() % 2000;
+        uint32_t lo = ~0u, hi = 0;
+        string line;
+
+        for (uint32_t j = 0; j < len; j++)
+        {
+            const uint32_t val = (uint32_t)rand() * (uint32_t)rand();
+            lo = min(lo, val);
+            hi = max(hi, val);
+
+            line += to_string(val) + " ";
+        }
+
+        expected[i]     = { lo, hi };
+        sendOk          = client.Send(i, "minmax", line);
+    }
+
+    uint32_t matched = 0;
+
+    for (uint32_t i = 0; i < numInstances && sendOk; i++)
+    {
+        uint64_t requestId;
+        ResultCode result;
+        string payload;
+
+        if (!client.Receive(requestId, result, payload) || requestId >= numInstances) break;
+
+        if (result == OK && payload == to_string(expected[requestId].first) + " " + to_string(expected[requestId].second)) matched++;
+    }
+
+    if (matched == numInstances) testResults.push_back({ "Daemon::Pipelined", PASS, "" });
+    else testResults.push_back({ "Daemon::Pipelined", FAIL, to_string(matched) + " of " + to_string(numInstances) + " responses correct." });
+
+    ResultCode result;
+    string response;
+
+    if (client.Call("GetMinMax", "", result, response) && result == OK && response.compare(0, 5, "pass ") == 0 && response.find(" fail 0 ") != string::npos)
+        testResults.push_back({ "Daemon::Registry", PASS, response });
+    else
+        testResults.push_back({ "Daemon::Registry", FAIL, "Self-test request failed: " + response });
+
+    bool unknownOk = client.Call("NoSuchProblem", "", result, response) && result == INVALID_INPUT;
+
+    if (unknownOk) testResults.push_back({ "Daemon::UnknownRequest", PASS, "" });
+    else testResults.push_back({ "Daemon::UnknownRequest", FAIL, "Unknown request name wasn't rejected." });
+
+    DaemonClient badClient;
+    uint64_t requestId;
+    bool dropped = false;
+
+    if (badClient.Connect(options.socketPath) == OK)
+    {
+        const string garbage(sizeof(DaemonRequestHeader) + 8, 'x');
+        dropped = SendAll(badClient.sock, garbage.data(), garbage.size()) && !badClient.Receive(requestId, result, response);
+    }
+
+    if (dropped) testResults.push_back({ "Daemon::MalformedFrame", PASS, "" });
+    else testResults.push_back({ "Daemon::MalformedFrame", FAIL, "Connection sending a malformed frame wasn't dropped." });
+
+    LoadGenOptions loadOptions;
+    loadOptions.socketPath          = options.socketPath;
+    loadOptions.name                = "reversal";
+    loadOptions.numClients          = 4;
+    loadOptions.requestsPerClient   = 500;
+    loadOptions.pipelineDepth       = 4;
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const uint32_t n = 10 + rand() % 200;
+        vector<uint32_t> perm(n);
+
+        for (uint32_t j = 0; j < n; j++) perm[j] = j + 1;
+        for (uint32_t j = n; j > 1; j--) swap(perm[j - 1], perm[rand() % j]);
+
+        string line;
+        for (auto val : perm) line += to_string(val) + " ";
+        loadOptions.instances.push_back(line);
+    }
+
+    LoadGenStats loadStats;
+    ResultCode loadResult = RunLoadGenerator(loadOptions, loadStats);
+
+    const uint64_t expectRequests = (uint64_t)loadOptions.numClients * loadOptions.requestsPerClient;
+
+    if (loadResult == OK && loadStats.requests == expectRequests && loadStats.errors == 0)
+    {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "%.0f req/sec, p50 = %.1f us, p99 = %.1f us.", loadStats.requests / loadStats.seconds, loadStats.p50Us, loadStats.p99Us);
+        testResults.push_back({ "Daemon::LoadGenerator", PASS, msg });
+    }
+    else
+    {
+        testResults.push_back({ "Daemon::LoadGenerator", FAIL, to_string(loadStats.requests) + " requests, " + to_string(loadStats.errors) + " errors." });
+    }
+
+    // A client that pipelines far more than a socket buffer of requests before reading any response must
+    // not hold up anyone else.
+
+    const uint32_t numUnread = 40000;
+    DaemonClient bulkClient;
+    DaemonClient otherClient;
+    bool otherServed    = false;
+    uint32_t bulkOk     = 0;
+
+    if (bulkClient.Connect(options.socketPath) == OK && otherClient.Connect(options.socketPath) == OK)
+    {
+        string frames;
+        for (uint32_t i = 0; i < numUnread; i++)
+        {
+            DaemonRequestHeader header = { { 'B', 'P', 'R', 'Q' }, 4, 0, 0, i };
+            frames.append((const char*)&header, sizeof(header));
+            frames += "ping";
+        }
+
+        if (SendAll(bulkClient.sock, frames.data(), frames.size()) && otherClient.Send(0, "ping", ""))
+        {
+            WSAPOLLFD fd = { otherClient.sock, POLLRDNORM, 0 };
+            otherServed = WSAPoll(&fd, 1, 5000) == 1 && otherClient.Receive(requestId, result, response) && response == "pong";
+        }
+
+        for (uint32_t i = 0; i < numUnread; i++)
+        {
+            if (!bulkClient.Receive(requestId, result, response)) break;
+            if (result == OK && response == "pong") bulkOk++;
+        }
+    }
+
+    if (otherServed && bulkOk == numUnread) testResults.push_back({ "Daemon::UnreadResponses", PASS, "" });
+    else testResults.push_back({ "Daemon::UnreadResponses", FAIL, string(otherServed ? "" : "Other client starved. ") +
+        to_string(bulkOk) + " of " + to_string(numUnread) + " pipelined responses received." });
+
+    // A second daemon must leave a live daemon's socket alone.
+
+    DaemonOptions secondOptions = options;
+    const ResultCode secondResult = RunDaemon(secondOptions);
+
+    if (secondResult == IO_ERROR && client.Call("ping", "", result, response) && response == "pong")
+        testResults.push_back({ "Daemon::SocketInUse", PASS, "" });
+    else
+        testResults.push_back({ "Daemon::SocketInUse", FAIL, "Second daemon took over or broke the running daemon's socket." });
+
+    const bool byeOk = client.Call("shutdown", "", result, response) && response == "bye";
+    daemon.join();
+
+    if (byeOk && daemonResult == OK) testResults.push_back({ "Daemon::Shutdown", PASS, "" });
+    else testResults.push_back({ "Daemon::Shutdown", FAIL, "Daemon didn't shut down cleanly." });
+}
@@ -0,0 +1,814 @@
+#include "problems.h"
+#include "kmercount.h"
+#include "utils.h"
+#include "reporter.h"
+
+#include <memory>
+#include <unordered_set>
+
+/*
+ * Table slot. Claimed by a CAS of key from KMER_EMPTY; the counters are only touched once claimed.
+ * stamp holds 1 + the index of the last long sequence that counted this k-mer.
+ */
+
+static const uint64_t KMER_EMPTY = ~0ULL;
+
+struct KmerSlot
+{
+    atomic<uint64_t> key;
+    atomic<uint64_t> total;
+    atomic<uint32_t> seqCount;
+    atomic<uint32_t> stamp;
+};
+
+/*
+ * Hash partition: the k-mers whose hash starts with the top `bits` bits of prefix.
+ */
+
+struct KmerPartition
+{
+    uint64_t prefix;
+    uint32_t bits;
+
+    bool Contains(uint64_t hash) const { return bits == 0 || (hash >> (64 - bits)) == prefix; }
+};
+
+/**
+ * HashKmer - splitmix64 finalizer. The low bits pick the slot and the high bits the partition, so
+ * the two stay independent.
+ */
+
+static inline uint64_t HashKmer(uint64_t kmer)
+{
+    kmer = (kmer ^ (kmer >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    kmer = (kmer ^ (kmer >> 27)) * 0x94D049BB133111EBULL;
+    return kmer ^ (kmer >> 31);
+}
+
+static inline uint8_t PackedBase(const PackedSeqRef& seq, uint64_t pos)
+{
+    return (uint8_t)((seq.words[pos >> 5] >> (62 - 2 * (pos & 31))) & 3);
+}
+
+/*
+ * Fixed size lock-free counting table. Once more than three quarters of the slots are claimed the
+ * table reports itself full and stops handing out new slots, so a probe always finds an empty one.
+ */
+
+struct KmerTable
+{
+    unique_ptr<KmerSlot[]> slots;
+    uint64_t capacity;
+    uint64_t limit;
+    atomic<uint64_t> used;
+    atomic<bool> full;
+
+    KmerTable(uint64_t numSlots) : slots(new KmerSlot[numSlots]), capacity(numSlots), limit(numSlots / 4 * 3), used(0), full(false) {}
+
+    void Reset()
+    {
+        const uint64_t blockSize    = 1 << 16;
+        const uint32_t numBlocks    = (uint32_t)((capacity + blockSize - 1) / blockSize);
+
+        ParallelFor(numBlocks, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            const uint64_t last = min(capacity, end * blockSize);
+
+            for (uint64_t i = begin * blockSize; i < last; i++)
+            {
+                slots[i].key.store(KMER_EMPTY, memory_order_relaxed);
+                slots[i].total.store(0, memory_order_relaxed);
+                slots[i].seqCount.store(0, memory_order_relaxed);
+                slots[i].stamp.store(0, memory_order_relaxed);
+            }
+        });
+
+        used    = 0;
+        full    = false;
+    }
+
+    /**
+     * Find - Slot for kmer, claiming an empty one if it isn't in the table yet.
+     *
+     * @return Slot, or nullptr once the table is full.
+     */
+
+    KmerSlot* Find(uint64_t kmer)
+    {
+        if (full.load(memory_order_relaxed)) return nullptr;
+
+        uint64_t idx = HashKmer(kmer) & (capacity - 1);
+
+        while (1)
+        {
+            KmerSlot& slot  = slots[idx];
+            uint64_t cur    = slot.key.load(memory_order_acquire);
+
+            if (cur == kmer) return &slot;
+
+            if (cur == KMER_EMPTY)
+            {
+                if (slot.key.compare_exchange_strong(cur, kmer, memory_order_acq_rel))
+                {
+                    if (used.fetch_add(1, memory_order_relaxed) + 1 >= limit) full = true;
+                    return &slot;
+                }
+
+                if (cur == kmer) return &slot;
+            }
+
+            idx = (idx + 1) & (capacity - 1);
+        }
+    }
+};
+
+/**
+ * GatherKmers - Append the k-mers starting at positions [begin, end) of a sequence that fall in a
+ * partition.
+ */
+
+static void GatherKmers(
+    const PackedSeqRef& seq,
+    const uint64_t begin,
+    const uint64_t end,
+    const uint32_t k,
+    const KmerPartition& part,
+    vector<uint64_t>& kmers
+)
+{
+    const uint64_t mask = KmerMask(k);
+    uint64_t kmer       = 0;
+
+    for (uint64_t pos = begin; pos < begin + k - 1; pos++) kmer = (kmer << 2) | PackedBase(seq, pos);
+
+    for (uint64_t pos = begin; pos < end; pos++)
+    {
+        kmer = ((kmer << 2) | PackedBase(seq, pos + k - 1)) & mask;
+        if (part.Contains(HashKmer(kmer))) kmers.push_back(kmer);
+    }
+}
+
+/**
+ * AddKmerRuns - Sort gathered k-mers and add each distinct one to the table once with its
+ * multiplicity. Presence comes from the stamp for long sequences (seqIdx != UINT32_MAX); for a whole
+ * short sequence every distinct k-mer is counted once directly.
+ *
+ * @return False if the table filled up.
+ */
+
+static bool AddKmerRuns(KmerTable& table, vector<uint64_t>& kmers, const uint32_t seqIdx)
+{
+    sort(kmers.begin(), kmers.end());
+
+    for (size_t i = 0; i < kmers.size();)
+    {
+        size_t j = i + 1;
+        while (j < kmers.size() && kmers[j] == kmers[i]) j++;
+
+        KmerSlot* slot = table.Find(kmers[i]);
+        if (!slot) return false;
+
+        slot->total.fetch_add(j - i, memory_order_relaxed);
+
+        if (seqIdx == UINT32_MAX || slot->stamp.exchange(seqIdx + 1, memory_order_relaxed) != seqIdx + 1)
+            slot->seqCount.fetch_add(1, memory_order_relaxed);
+
+        i = j;
+    }
+
+    return true;
+}
+
+/**
+ * CountPartition - One counting pass over the input for a single hash partition.
+ *
+ * @return False if the table filled up before the pass finished.
+ */
+
+static bool CountPartition(
+    KmerTable& table,
+    const vector<PackedSeqRef>& seqs,
+    const uint32_t k,
+    const KmerPartition& part,
+    vector<vector<uint64_t>>& scratch
+)
+{
+    table.Reset();
+
+    // Long sequences one at a time, their chunks spread over all threads.
+
+    for (uint32_t s = 0; s < seqs.size(); s++)
+    {
+        const uint64_t numKmers = seqs[s].len >= k ? seqs[s].len - k + 1 : 0;
+        if (numKmers <= KMER_CHUNK_LEN) continue;
+
+        const uint32_t numChunks = (uint32_t)((numKmers + KMER_CHUNK_LEN - 1) / KMER_CHUNK_LEN);
+
+        ParallelFor(numChunks, [&](uint32_t begin, uint32_t end, uint32_t t)
+        {
+            for (uint32_t c = begin; c < end && !table.full; c++)
+            {
+                scratch[t].clear();
+                GatherKmers(seqs[s], (uint64_t)c * KMER_CHUNK_LEN, min(numKmers, (uint64_t)(c + 1) * KMER_CHUNK_LEN), k, part, scratch[t]);
+                if (!AddKmerRuns(table, scratch[t], s)) break;
+            }
+        });
+
+        if (table.full) return false;
+    }
+
+    // Short sequences whole, handed out a few at a time.
+
+    const uint32_t batch = 16;
+    atomic<uint32_t> next(0);
+
+    ParallelFor(GetWorkerCount(), [&](uint32_t, uint32_t, uint32_t t)
+    {
+        while (!table.full)
+        {
+            const uint32_t first = next.fetch_add(batch);
+            if (first >= seqs.size()) break;
+
+            for (uint32_t s = first; s < min((uint32_t)seqs.size(), first + batch); s++)
+            {
+                const uint64_t numKmers = seqs[s].len >= k ? seqs[s].len - k + 1 : 0;
+                if (numKmers == 0 || numKmers > KMER_CHUNK_LEN) continue;
+
+                scratch[t].clear();
+                GatherKmers(seqs[s], 0, numKmers, k, part, scratch[t]);
+                if (!AddKmerRuns(table, scratch[t], UINT32_MAX)) break;
+            }
+        }
+    });
+
+    return !table.full;
+}
+
+/**
+ * GetPackedSeqRefs - Reference every sequence of a packed set.
+ */
+
+void GetPackedSeqRefs(const PackedSeqSet& set, vector<PackedSeqRef>& refs)
+{
+    refs.resize(set.nSeq);
+    for (uint32_t i = 0; i < set.nSeq; i++) refs[i] = { set.Seq(i), set.seqLen };
+}
+
+/**
+ * PackSequences - Pack ACGT strings 2 bits per base, each starting on a word boundary. Characters
+ * other than ACGT are packed as A.
+ *
+ * @param  seqs     [in]    Sequences to pack.
+ * @param  words    [out]   Packed words, owned by the caller for as long as refs are used.
+ * @param  refs     [out]   One reference per sequence into words.
+ */
+
+void PackSequences(const vector<string>& seqs, vector<uint64_t>& words, vector<PackedSeqRef>& refs)
+{
+    size_t numWords = 0;
+    for (auto& seq : seqs) numWords += (seq.length() + 31) / 32;
+
+    words.assign(numWords, 0);
+    refs.resize(seqs.size());
+
+    size_t pos = 0;
+
+    for (uint32_t i = 0; i < seqs.size(); i++)
+    {
+        const string& seq = seqs[i];
+
+        for (size_t j = 0; j < seq.length(); j++)
+        {
+            const uint8_t code = BaseToCode(seq[j]);
+            words[pos + j / 32] |= (uint64_t)(code == INVALID_BASE ? 0 : code) << (62 - 2 * (j & 31));
+        }
+
+        refs[i] = { words.data() + pos, seq.length() };
+        pos += (seq.length() + 31) / 32;
+    }
+}
+
+/**
+ * CountKmers - Count every k-mer of a set of packed sequences, with the number of sequences it occurs in.
+ *
+ * @param  seqs     [in]    Packed sequences.
+ * @param  k        [in]    K-mer length, 1 to MAX_COUNTED_KMER.
+ * @param  emit     [in]    Called on the calling thread with the counts of each finished pass. Every
+ *                          distinct k-mer is emitted exactly once, in no particular order.
+ * @param  maxSlots [in]    Upper bound on table slots (24 bytes each).
+ * @param  stats    [out]   Optional pass statistics.
+ *
+ * @return          INVALID_INPUT for a k out of range or a table under 1024 slots, UNABLE_TO_FIND_SOLUTION if
+ *                  a partition can't be split far enough to fit the table. OK otherwise.
+ */
+
+ResultCode CountKmers(
+    const vector<PackedSeqRef>& seqs,
+    const uint32_t k,
+    const function<void(const KmerCount*, const size_t)>& emit,
+    const uint64_t maxSlots,
+    KmerCountStats* stats
+)
+{
+    if (k == 0 || k > MAX_COUNTED_KMER || maxSlots < 1024) return INVALID_INPUT;
+
+    uint64_t totalKmers = 0;
+    for (auto& seq : seqs) if (seq.len >= k) totalKmers += seq.len - k + 1;
+
+    // Size the table for the most distinct k-mers there could be, then start with enough partitions
+    // that each is expected to fit.
+
+    const uint64_t maxDistinct  = k < 32 ? min(totalKmers, (uint64_t)1 << (2 * k)) : totalKmers;
+    uint64_t capacity           = 1024;
+
+    while (capacity < maxSlots && capacity / 4 * 3 < maxDistinct) capacity <<= 1;
+    if (capacity > maxSlots) capacity >>= 1;
+
+    KmerTable table(capacity);
+
+    uint32_t startBits = 0;
+    while (startBits < 32 && (maxDistinct >> startBits) > table.limit) startBits++;
+
+    vector<KmerPartition> pending;
+    for (uint64_t p = (1ULL << startBits); p > 0; p--) pending.push_back({ p - 1, startBits });
+
+    const uint32_t numThreads = GetWorkerCount();
+    vector<vector<uint64_t>> scratch(numThreads);
+    vector<vector<KmerCount>> found(numThreads);
+    vector<KmerCount> counts;
+
+    KmerCountStats localStats = { totalKmers, 0, 0, 0, capacity };
+
+    while (!pending.empty())
+    {
+        const KmerPartition part = pending.back();
+        pending.pop_back();
+
+        localStats.passes++;
+
+        if (!CountPartition(table, seqs, k, part, scratch))
+        {
+            if (part.bits >= 48) return UNABLE_TO_FIND_SOLUTION;
+
+            pending.push_back({ part.prefix * 2 + 1, part.bits + 1 });
+            pending.push_back({ part.prefix * 2, part.bits + 1 });
+            localStats.splits++;
+            continue;
+        }
+
+        // Collect the claimed slots.
+
+        const uint64_t blockSize    = 1 << 16;
+        const uint32_t numBlocks    = (uint32_t)((capacity + blockSize - 1) / blockSize);
+
+        ParallelFor(numBlocks, [&](uint32_t begin, uint32_t end, uint32_t t)
+        {
+            found[t].clear();
+
+            for (uint64_t i = begin * blockSize; i < min(capacity, end * blockSize); i++)
+            {
+                const KmerSlot& slot = table.slots[i];
+                const uint64_t kmer = slot.key.load(memory_order_relaxed);
+
+                if (kmer != KMER_EMPTY)
+                    found[t].push_back({ kmer, slot.total.load(memory_order_relaxed), slot.seqCount.load(memory_order_relaxed) });
+            }
+        });
+
+        counts.clear();
+        for (auto& f : found)
+        {
+            counts.insert(counts.end(), f.begin(), f.end());
+            f.clear();
+        }
+
+        localStats.distinctKmers += counts.size();
+        if (!counts.empty()) emit(&counts[0], counts.size());
+    }
+
+    if (stats) *stats = localStats;
+
+    return OK;
+}
+
+/**
+ * BetterCandidate - Candidate order: found in more sequences, then more occurrences, then lower k-mer.
+ */
+
+static bool BetterCandidate(const KmerCount& a, const KmerCount& b)
+{
+    if (a.seqCount != b.seqCount) return a.seqCount > b.seqCount;
+    if (a.total != b.total) return a.total > b.total;
+    return a.kmer < b.kmer;
+}
+
+/**
+ * GetTopKmers - The k-mers present in the most sequences, ties broken by total count.
+ *
+ * @param  seqs     [in]    Packed sequences.
+ * @param  k        [in]    K-mer length, 1 to MAX_COUNTED_KMER.
+ * @param  numTop   [in]    Number of candidates wanted.
+ * @param  top      [out]   Up to numTop candidates, best first.
+ * @param  maxSlots [in]    Upper bound on counting table slots.
+ *
+ * @return          CountKmers's result.
+ */
+
+ResultCode GetTopKmers(
+    const vector<PackedSeqRef>& seqs,
+    const uint32_t k,
+    const uint32_t numTop,
+    vector<KmerCount>& top,
+    const uint64_t maxSlots
+)
+{
+    top.clear();
+
+    auto keepTop = [&]()
+    {
+        if (top.size() <= numTop) return;
+
+        nth_element(top.begin(), top.begin() + numTop, top.end(), BetterCandidate);
+        top.resize(numTop);
+    };
+
+    ResultCode res = CountKmers(seqs, k, [&](const KmerCount* counts, const size_t n)
+    {
+        top.insert(top.end(), counts, counts + n);
+        keepTop();
+    }, maxSlots);
+
+    if (res != OK)
+    {
+        top.clear();
+        return res;
+    }
+
+    keepTop();
+    sort(top.begin(), top.end(), BetterCandidate);
+
+    return OK;
+}
+
+/**
+ * GetKmerSeedOffsets - Starting solutions for the motif engines from the top candidate k-mers. Each
+ * candidate gives one offset set: the first closest match (by Hamming distance) in every sequence.
+ *
+ * @param  seqs         [in]    Sequences to search for a motif.
+ * @param  motifLen     [in]    Motif length, 1 to MAX_COUNTED_KMER.
+ * @param  numSeeds     [in]    Number of candidates to turn into offset sets.
+ * @param  seedOffsets  [out]   Up to numSeeds offset sets, from the best candidate down.
+ *
+ * @return              INVALID_INPUT for a motif length out of range or a sequence shorter than the motif.
+ *                      OK otherwise.
+ */
+
+ResultCode GetKmerSeedOffsets(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numSeeds,
+    vector<vector<uint32_t>>& seedOffsets
+)
+{
+    seedOffsets.clear();
+
+    if (motifLen == 0 || motifLen > MAX_COUNTED_KMER) return INVALID_INPUT;
+    for (auto& seq : seqs) if (seq.length() < motifLen) return INVALID_INPUT;
+
+    vector<uint64_t> words;
+    vector<PackedSeqRef> refs;
+    vector<KmerCount> top;
+
+    PackSequences(seqs, words, refs);
+
+    ResultCode res = GetTopKmers(refs, motifLen, numSeeds, top);
+    if (res != OK) return res;
+
+    const uint64_t mask = KmerMask(motifLen);
+    seedOffsets.resize(top.size(), vector<uint32_t>(seqs.size(), 0));
+
+    for (uint32_t i = 0; i < refs.size(); i++)
+    {
+        vector<uint32_t> bestDist(top.size(), UINT32_MAX);
+        uint64_t kmer = 0;
+
+        for (uint64_t pos = 0; pos < refs[i].len; pos++)
+        {
+            kmer = ((kmer << 2) | PackedBase(refs[i], pos)) & mask;
+            if (pos + 1 < motifLen) continue;
+
+            const uint32_t offset = (uint32_t)(pos + 1 - motifLen);
+
+            for (uint32_t c = 0; c < top.size(); c++)
+            {
+                const uint32_t dist = PackedMismatches(kmer, top[c].kmer);
+
+                if (dist < bestDist[c])
+                {
+                    bestDist[c]         = dist;
+                    seedOffsets[c][i]   = offset;
+                }
+            }
+        }
+    }
+
+    return OK;
+}
+
+/**
+ * FindMotifSeeded - Exact FindMotif started from the best of the top candidate k-mers' offset sets,
+ * so the search prunes against a near-optimal score from the first branch. Motif lengths above
+ * MAX_COUNTED_KMER fall back to an unseeded search.
+ *
+ * @param  seqs             [in]    Sequences to search for a motif.
+ * @param  motifLen         [in]    Length of desired motif.
+ * @param  numCandidates    [in]    Number of candidate k-mers to score as incumbents.
+ * @param  offsets          [out]   A set of offsets into each input sequence that produces the best motif match.
+ *
+ * @return                  FindMotif's result.
+ */
+
+ResultCode FindMotifSeeded(
+    const vector<string>& seqs,
+    const uint32_t motifLen,
+    const uint32_t numCandidates,
+    vector<uint32_t>& offsets
+)
+{
+    vector<vector<uint32_t>> seeds;
+
+    if (motifLen > seqs[0].length() || GetKmerSeedOffsets(seqs, motifLen, numCandidates, seeds) != OK || seeds.empty())
+        return FindMotif(seqs, motifLen, offsets);
+
+    uint32_t best       = 0;
+    uint32_t bestScore  = 0;
+
+    for (uint32_t i = 0; i < seeds.size(); i++)
+    {
+        const uint32_t score = GetConsensus(seqs, (uint32_t)seqs.size(), seeds[i], motifLen);
+
+        if (score > bestScore)
+        {
+            bestScore   = score;
+            best        = i;
+        }
+    }
+
+    return FindMotif(seqs, motifLen, offsets, &seeds[best]);
+}
+
+/**
+ * RandomSequence - Random ACGT string for the counting tests.
+ */
+
+static string RandomSequence(Rng& rng, const size_t len)
+{
+    string seq(len, 'A');
+    for (size_t i = 0; i < len; i++) seq[i] = CodeToBase((uint8_t)rng.NextBounded(4));
+    return seq;
+}
+
+/**
+ * TestAgainstMap - Compare every emitted count with a plain map over the same input. The input mixes
+ * short sequences, a duplicated one and a sequence long enough to be split into chunks, and the table
+ * is kept small so the larger k are counted over several partitions.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestAgainstMap(vector<TestResult>& testResults)
+{
+    const uint32_t kValues[]    = { 3, 12, 31 };
+    const uint64_t maxSlots     = 4096;
+
+    Rng rng(((uint64_t)rand() << 32) ^ (uint64_t)rand());
+
+    vector<string> seqs;
+    for (uint32_t i = 0; i < 40; i++) seqs.push_back(RandomSequence(rng, 20 + rng.NextBounded(400)));
+
+    seqs.push_back(seqs[7]);
+    seqs.push_back(RandomSequence(rng, 3 * KMER_CHUNK_LEN + 123));
+    seqs.push_back("ACG");
+
+    vector<uint64_t> words;
+    vector<PackedSeqRef> refs;
+    PackSequences(seqs, words, refs);
+
+    for (uint32_t ki = 0; ki < sizeof(kValues) / sizeof(kValues[0]); ki++)
+    {
+        const uint32_t k = kValues[ki];
+        const string name = "KmerCount::AgainstMap[k=" + to_string(k) + "]";
+
+        unordered_map<uint64_t, pair<uint64_t, uint32_t>> expected;
+
+        for (auto& seq : seqs)
+        {
+            unordered_set<uint64_t> seen;
+
+            for (size_t pos = 0; pos + k <= seq.length(); pos++)
+            {
+                uint64_t kmer;
+                PackKmer(&seq[pos], k, kmer);
+
+                auto& e = expected[kmer];
+                e.first++;
+                if (seen.insert(kmer).second) e.second++;
+            }
+        }
+
+        uint64_t numEmitted = 0;
+        uint64_t numWrong   = 0;
+
+        KmerCountStats stats;
+
+        ResultCode res = CountKmers(refs, k, [&](const KmerCount* counts, const size_t n)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                auto it = expected.find(counts[i].kmer);
+
+                if (it == expected.end() || it->second.first != counts[i].total || it->second.second != counts[i].seqCount)
+                    numWrong++;
+                else
+                    it->second.second = UINT32_MAX;     // Catch a k-mer emitted twice.
+
+                numEmitted++;
+            }
+        }, maxSlots, &stats);
+
+        const string msg = to_string(stats.distinctKmers) + " distinct in " + to_string(stats.passes) + " passes (" +
+                           to_string(stats.splits) + " splits).";
+
+        if (res != OK)
+            testResults.push_back({ name, EXECUTION_ERROR, "CountKmers failed." });
+        else if (numEmitted != expected.size() || numWrong != 0)
+            testResults.push_back({ name, FAIL, to_string(numWrong) + " wrong of " + to_string(numEmitted) + ", expected " +
+                                    to_string(expected.size()) + ". " + msg });
+        else
+            testResults.push_back({ name, PASS, msg });
+    }
+}
+
+/**
+ * TestTopCandidates - The planted motif of a set without mismatches is the top candidate and is present
+ * in every sequence.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestTopCandidates(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 5;
+    const uint32_t nSeq     = 20;
+    const uint32_t seqLen   = 600;
+    const uint32_t motifLen = 10;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
+
+        vector<uint64_t> words;
+        vector<PackedSeqRef> refs;
+        vector<KmerCount> top;
+
+        PackSequences(seqs, words, refs);
+        GetTopKmers(refs, motifLen, 4, top);
+
+        uint64_t motifKmer;
+        PackKmer(&motif[0], motifLen, motifKmer);
+
+        if (!top.empty() && top[0].kmer == motifKmer && top[0].seqCount == nSeq)
+            ReportTestCase(testResults, "KmerCount::TopCandidate", i, PASS);
+        else
+            ReportTestCase(testResults, "KmerCount::TopCandidate", i, FAIL,
+                           "Top candidate " + (top.empty() ? string("none") : UnpackKmer(top[0].kmer, motifLen)) + ", planted " + motif);
+    }
+}
+
+/**
+ * TestSeededSearch - Seeded FindMotif must reach the same score as a cold search, and seeded heuristics
+ * must reach the planted score from a single start. Times of both exact searches are reported.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestSeededSearch(vector<TestResult>& testResults)
+{
+    const uint32_t numIters = 5;
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(6, 24, 7, seqs, motif, planted, 1);
+
+        vector<uint32_t> coldOffsets;
+        vector<uint32_t> seededOffsets;
+
+        long long t1 = GetNanoseconds();
+        FindMotif(seqs, 7, coldOffsets);
+        long long t2 = GetNanoseconds();
+        FindMotifSeeded(seqs, 7, 8, seededOffsets);
+        long long t3 = GetNanoseconds();
+
+        const uint32_t coldScore    = GetConsensus(seqs, 6, coldOffsets, 7);
+        const uint32_t seededScore  = GetConsensus(seqs, 6, seededOffsets, 7);
+        const string msg            = "cold " + to_string((t2 - t1) / 1000) + "us, seeded " + to_string((t3 - t2) / 1000) + "us.";
+
+        if (seededScore == coldScore)
+            ReportTestCase(testResults, "KmerCount::SeededFindMotif", i, PASS, msg);
+        else
+            ReportTestCase(testResults, "KmerCount::SeededFindMotif", i, FAIL,
+                           "Score " + to_string(seededScore) + ", cold " + to_string(coldScore) + ". " + msg);
+    }
+
+    for (uint32_t i = 0; i < numIters; i++)
+    {
+        const uint32_t nSeq     = 20;
+        const uint32_t motifLen = 12;
+
+        vector<string> seqs;
+        string motif;
+        vector<uint32_t> planted;
+
+        GenerateMotifSequences(nSeq, 300, motifLen, seqs, motif, planted);
+
+        vector<vector<uint32_t>> seeds;
+        vector<uint32_t> randOffsets;
+        vector<uint32_t> gibbsOffsets;
+
+        GetKmerSeedOffsets(seqs, motifLen, 1, seeds);
+        RandomizedMotifSearch(seqs, motifLen, 1, randOffsets, &seeds);
+        GibbsSampler(seqs, motifLen, 1, 100, gibbsOffsets, &seeds);
+
+        const uint32_t randScore    = GetConsensus(seqs, nSeq, randOffsets, motifLen);
+        const uint32_t gibbsScore   = GetConsensus(seqs, nSeq, gibbsOffsets, motifLen);
+
+        if (randScore == nSeq * motifLen && gibbsScore == nSeq * motifLen)
+            ReportTestCase(testResults, "KmerCount::SeededHeuristics", i, PASS);
+        else
+            ReportTestCase(testResults, "KmerCount::SeededHeuristics", i, FAIL,
+                           "randomized = " + to_string(randScore) + ", gibbs = " + to_string(gibbsScore));
+    }
+}
+
+/**
+ * TestThroughput - Count 31-mers over a generated packed set and check the totals add up. Rate is
+ * reported in the message.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    const SeqGenParams params = { 4000, 5000, 0, 0, (uint64_t)rand() };
+
+    PackedSeqSet set;
+    if (GeneratePackedSequenceSet(params, set) != OK)
+    {
+        testResults.push_back({ "KmerCount::Throughput", EXECUTION_ERROR, "Unable to generate sequences." });
+        return;
+    }
+
+    vector<PackedSeqRef> refs;
+    GetPackedSeqRefs(set, refs);
+
+    uint64_t sumTotals = 0;
+    KmerCountStats stats;
+
+    long long t1 = GetMilliseconds();
+    ResultCode res = CountKmers(refs, 31, [&](const KmerCount* counts, const size_t n)
+    {
+        for (size_t i = 0; i < n; i++) sumTotals += counts[i].total;
+    }, 1 << 22, &stats);
+    long long t2 = GetMilliseconds();
+
+    const double sec    = max((double)(t2 - t1), 1.0) / 1000.0;
+    const string msg    = to_string(stats.totalKmers) + " 31-mers, " + to_string(stats.distinctKmers) + " distinct, " +
+                          to_string(stats.passes) + " passes, " + to_string((uint64_t)(stats.totalKmers / sec / 1e6)) + " M/s.";
+
+    if (res == OK && sumTotals == stats.totalKmers)
+        testResults.push_back({ "KmerCount::Throughput", PASS, msg });
+    else
+        testResults.push_back({ "KmerCount::Throughput", FAIL, "Totals add up to " + to_string(sumTotals) + ". " + msg });
+}
+
+/**
+ * KmerCounting - Tests for k-mer counting and candidate seeding of the motif engines.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void KmerCounting(vector<TestResult>& testResults)
+{
+    TestAgainstMap(testResults);
+    TestTopCandidates(testResults);
+    TestSeededSearch(testResults);
+    TestThroughput(testResults);
+}
@@ -1,17 +1,51 @@
 #include "problems.h"
 #include "commoninc.h"
+#include "arena.h"
+#include "batch.h"
+#include "daemon.h"
+#include "resultcache.h"
+#include "reporter.h"
 
 using namespace std;
 
-typedef void (*pfnProblem)(vector<TestResult>& testResults);
-
 map<string, pfnProblem> problems =
 {
     { "GetMinMax", GetMinMax },
     { "HonestProfessors", HonestProfessors },
     { "RestrictionMapping", RestrictionMapping },
     { "MotifFinding", MotifFinding },
+    { "RandomizedMotifFinding", RandomizedMotifFinding },
+    { "PlantedMotifFinding", PlantedMotifFinding },
+    { "SequenceGeneration", SequenceGeneration },
+    { "SequenceFileReading", SequenceFileReading },
+    { "PwmScanning", PwmScanning },
     { "ReversalDistance", ReversalDistance },
+    { "SignedReversalSorting", SignedReversalSorting },
+    { "PermutationTree", PermutationTree },
+    { "RearrangementMatrix", RearrangementMatrix },
+    { "ExactReversal", ExactReversal },
+    { "DoubleCutJoin", DoubleCutJoin },
+    { "BatchMode", BatchMode },
+    { "SolverDaemon", SolverDaemon },
+    { "ResultCaching", ResultCaching },
+    { "DoubleDigest", DoubleDigest },
+    { "TestReporting", TestReporting },
+    { "KmerCounting", KmerCounting },
+    { "IncrementalMotif", IncrementalMotif },
+};
+
+/*
+ * Problems that deal their randomized cases out across shards themselves (see ShardOwnsCase). Every
+ * other problem runs whole on one shard.
+ */
+
+set<string> caseShardedProblems =
+{
+    "GetMinMax",
+    "HonestProfessors",
+    "MotifFinding",
+    "RandomizedMotifFinding",
+    "PlantedMotifFinding",
 };
 
 /**
@@ -22,58 +56,229 @@ void DisplayTestsAndExit()
 {
     printf("Available Problems:\n\n");
     for (auto& p : problems) printf("%s\n", p.first.c_str());
+
+    printf("\nBatch mode:\n\n");
+    printf("--batch <type> <input> <output> [--threads N] [--window N]\n");
+    printf("Types:");
+    for (uint32_t i = 0; i < BATCH_PROBLEM_COUNT; i++) printf(" %s", GetBatchProblemName((BatchProblem)i));
+    printf("\n");
+
+    printf("\nDaemon mode:\n\n");
+    printf("--daemon <socket> [--threads N]\n");
+    printf("--loadgen <socket> <type> <instances> [--clients N] [--requests N] [--depth N]\n");
+
+    printf("\nAny mode: --cache <file> reuses restmap and motif results stored in a shared cache file.\n");
+    printf("Tests: --report <file> streams failures and per-problem counts as JSON lines.\n");
+    printf("Tests: --seed <n> fixes the generated cases; --shard <i>/<N> runs only slice i of N (needs --seed).\n");
+
+    printf("\nMerging shards:\n\n");
+    printf("--merge <report> <report> ... [--report <file>]\n");
+
     exit(0);
 }
 
 /**
- * ReportTestResults - Report pass/fail statistics from list of test results and
- * print error logs.
+ * RunBatchCommand - Batch mode driver. Solves every instance in an input file instead of running the
+ * self-tests; see batch.h for the file formats.
  *
- * @param results [in] List of test results from test execution.
+ * @param  args [in] Command line arguments, starting with --batch.
+ * @return      Zero on success.
  */
 
-void ReportTestResults(const vector<TestResult>& results)
+int RunBatchCommand(const vector<string>& args)
 {
-    uint32_t passCnt    = 0;
-    uint32_t failCnt    = 0;
-    uint32_t execErrCnt = 0;
-    uint32_t testCnt    = (uint32_t)results.size();
+    BatchProblem problem;
+
+    if (args.size() < 4 || !ParseBatchProblem(args[1].c_str(), problem))
+    {
+        printf("Please specify a batch type, input file and output file.\n\n");
+        DisplayTestsAndExit();
+    }
+
+    BatchOptions options(problem);
+
+    for (size_t i = 4; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "--threads") options.numSolvers = (uint32_t)strtoul(args[i + 1].c_str(), nullptr, 10);
+        else if (args[i] == "--window") options.maxInFlight = (uint32_t)strtoul(args[i + 1].c_str(), nullptr, 10);
+        else printf("Unknown batch option: %s\n", args[i].c_str());
+    }
+
+    BatchStats stats;
 
-    for (auto& res : results)
+    long long t1    = GetMilliseconds();
+    ResultCode res  = RunBatch(args[2].c_str(), args[3].c_str(), options, stats);
+    long long t2    = GetMilliseconds();
+
+    if (res != OK)
     {
-        if (res.code == PASS) passCnt++;
-        if (res.code == FAIL) failCnt++;
-        if (res.code == EXECUTION_ERROR) execErrCnt++;
+        printf("Batch failed, result code %d.\n", (int)res);
+        return 1;
     }
 
     printf(
-        "Test Statistics: Pass(%u/%u), Fail(%u/%u), ExecutionError(%u/%u)\n",
-        passCnt,
-        testCnt,
-        failCnt,
-        testCnt,
-        execErrCnt,
-        testCnt
+        "Batch %s: %llu instances, %llu failed, T = %f sec.\n",
+        GetBatchProblemName(problem),
+        (unsigned long long)stats.instances,
+        (unsigned long long)stats.failed,
+        ((float)t2 - (float)t1) / 1000.0f
     );
 
-    if (failCnt > 0)
+    return 0;
+}
+
+/**
+ * RunDaemonCommand - Serve batch instances and self-test runs over a Unix domain socket until a client
+ * sends shutdown; see daemon.h for the protocol.
+ *
+ * @param  args [in] Command line arguments, starting with --daemon.
+ * @return      Zero on success.
+ */
+
+int RunDaemonCommand(const vector<string>& args)
+{
+    if (args.size() < 2)
+    {
+        printf("Please specify a socket path.\n\n");
+        DisplayTestsAndExit();
+    }
+
+    DaemonOptions options;
+    options.socketPath  = args[1];
+    options.problems    = &problems;
+
+    for (size_t i = 2; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "--threads") options.numSolvers = (uint32_t)strtoul(args[i + 1].c_str(), nullptr, 10);
+        else printf("Unknown daemon option: %s\n", args[i].c_str());
+    }
+
+    printf("Listening on %s\n", options.socketPath.c_str());
+
+    ResultCode res = RunDaemon(options);
+
+    if (res != OK)
+    {
+        printf("Daemon failed, result code %d.\n", (int)res);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * RunLoadGenCommand - Replay the instances in a batch input file against a running daemon and report
+ * throughput and latency percentiles.
+ *
+ * @param  args [in] Command line arguments, starting with --loadgen.
+ * @return      Zero on success.
+ */
+
+int RunLoadGenCommand(const vector<string>& args)
+{
+    BatchProblem problem;
+
+    if (args.size() < 4 || !ParseBatchProblem(args[2].c_str(), problem))
+    {
+        printf("Please specify a socket path, batch type and instance file.\n\n");
+        DisplayTestsAndExit();
+    }
+
+    LoadGenOptions options;
+    options.socketPath  = args[1];
+    options.name        = args[2];
+
+    for (size_t i = 4; i + 1 < args.size(); i += 2)
+    {
+        const uint32_t val = (uint32_t)strtoul(args[i + 1].c_str(), nullptr, 10);
+
+        if (args[i] == "--clients") options.numClients = val;
+        else if (args[i] == "--requests") options.requestsPerClient = val;
+        else if (args[i] == "--depth") options.pipelineDepth = val;
+        else printf("Unknown load generator option: %s\n", args[i].c_str());
+    }
+
+    if (ReadBatchInstances(args[3].c_str(), options.instances) != OK)
     {
-        printf("Failure Log:\n\n");
+        printf("Unable to read %s\n", args[3].c_str());
+        return 1;
+    }
 
-        for (auto& res : results)
-            if (res.code == FAIL)
-                printf("FAILED - %s, Message: %s\n", res.testName.c_str(), res.testMsg.c_str());
+    LoadGenStats stats;
+    ResultCode res = RunLoadGenerator(options, stats);
+
+    if (res != OK)
+    {
+        printf("Load generator failed, result code %d.\n", (int)res);
+        return 1;
     }
 
+    printf(
+        "%llu requests, %llu errors, %.0f req/sec, T = %f sec.\n"
+        "Latency (us): p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+        (unsigned long long)stats.requests,
+        (unsigned long long)stats.errors,
+        stats.requests / stats.seconds,
+        stats.seconds,
+        stats.p50Us,
+        stats.p90Us,
+        stats.p99Us,
+        stats.p999Us,
+        stats.maxUs
+    );
+
+    return 0;
+}
+
+/**
+ * RunMergeCommand - Combine the --report files of every shard of a run and print the same summary a
+ * single process run would.
+ *
+ * @param  args     [in]        Command line arguments, starting with --merge.
+ * @param  reporter [in/out]    Reporter to merge into; writes a merged report if --report opened one.
+ * @return          Zero if the reports merged and no test failed.
+ */
 
-    if (execErrCnt > 0)
+int RunMergeCommand(const vector<string>& args, TestReporter& reporter)
+{
+    if (args.size() < 2)
     {
-        printf("Execution Error Log:\n\n");
+        printf("Please specify the shard reports to merge.\n\n");
+        DisplayTestsAndExit();
+    }
+
+    string error;
+    ResultCode res = MergeTestReports(vector<string>(args.begin() + 1, args.end()), reporter, error);
 
-        for (auto& res : results)
-            if (res.code == EXECUTION_ERROR)
-                printf("EXECUTION ERROR - %s, Message: %s\n", res.testName.c_str(), res.testMsg.c_str());
+    if (res != OK)
+    {
+        printf("Merge failed: %s\n", error.c_str());
+        return 1;
     }
+
+    printf("Merged %zu shard reports.\n", args.size() - 1);
+    reporter.PrintSummary();
+
+    if (reporter.Close() != OK) printf("Unable to write the report file.\n");
+
+    return reporter.GetCount(FAIL) + reporter.GetCount(EXECUTION_ERROR) > 0 ? 1 : 0;
+}
+
+/**
+ * ReportResultCache - Print result cache hit and miss counts if --cache opened one.
+ */
+
+void ReportResultCache()
+{
+    ResultCache& cache = GetProcessResultCache();
+    if (!cache.IsOpen()) return;
+
+    printf(
+        "Result cache: %llu hits, %llu misses, %llu entries.\n",
+        (unsigned long long)cache.hits,
+        (unsigned long long)cache.misses,
+        (unsigned long long)cache.GetEntryCount()
+    );
 }
 
 /**
@@ -95,16 +300,134 @@ int main(int argc, char** argv)
 
     vector<string> args(argv + 1, argv + argc);
     vector<TestResult> results;
+    TestReporter reporter;
+    TestShard shard     = { 0, 1, (uint64_t)time(NULL) };
+    bool seedGiven      = false;
+
+    // --cache <file>, --report <file>, --seed <n> and --shard <i>/<N> can go anywhere on the command line.
+
+    for (size_t i = 0; i + 1 < args.size();)
+    {
+        if (args[i] == "--cache")
+        {
+            if (GetProcessResultCache().Open(args[i + 1].c_str()) != OK)
+            {
+                printf("Unable to open result cache %s\n", args[i + 1].c_str());
+                return 1;
+            }
+        }
+        else if (args[i] == "--report")
+        {
+            if (reporter.Open(args[i + 1].c_str()) != OK)
+            {
+                printf("Unable to create report %s\n", args[i + 1].c_str());
+                return 1;
+            }
+        }
+        else if (args[i] == "--seed")
+        {
+            shard.seed  = strtoull(args[i + 1].c_str(), nullptr, 10);
+            seedGiven   = true;
+        }
+        else if (args[i] == "--shard")
+        {
+            char* end   = nullptr;
+            shard.index = (uint32_t)strtoul(args[i + 1].c_str(), &end, 10);
+            shard.count = *end == '/' ? (uint32_t)strtoul(end + 1, nullptr, 10) : 0;
+
+            if (shard.count == 0 || shard.index >= shard.count)
+            {
+                printf("Invalid shard %s, expected <i>/<N> with i < N.\n", args[i + 1].c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            i++;
+            continue;
+        }
+
+        args.erase(args.begin() + i, args.begin() + i + 2);
+    }
+
+    if (shard.count > 1 && !seedGiven)
+    {
+        printf("Sharded runs need --seed so every shard generates the same cases.\n");
+        return 1;
+    }
+
+    if (args.empty()) DisplayTestsAndExit();
+
+    int ret = -1;
+
+    if (args[0] == "--batch") ret = RunBatchCommand(args);
+    else if (args[0] == "--daemon") ret = RunDaemonCommand(args);
+    else if (args[0] == "--loadgen") ret = RunLoadGenCommand(args);
+    else if (args[0] == "--merge") return RunMergeCommand(args, reporter);
+
+    if (ret >= 0)
+    {
+        ReportResultCache();
+        return ret;
+    }
+
+    // Every problem starts from a seed derived from the run seed and its name, so its cases come out
+    // the same in any shard layout and --seed reproduces a run.
+
+    SetTestShard(shard);
+    printf("Seed: %llu, shard %u/%u.\n", (unsigned long long)shard.seed, shard.index, shard.count);
 
-    srand((uint32_t)time(NULL));
+    // Results go to the reporter as each problem finishes, and numbered cases reported through
+    // ReportTestCase skip the result list altogether.
+
+    SetActiveReporter(&reporter);
+    reporter.BeginRun(shard.seed, shard.index, shard.count);
 
     for (auto& prob : args)
     {
-        if (problems.count(prob) == 0) printf("Unknown problem specified: %s\n\n", prob.c_str());
-        problems[prob](results);
+        if (problems.count(prob) == 0)
+        {
+            printf("Unknown problem specified: %s\n\n", prob.c_str());
+            continue;
+        }
+
+        bool owned = true;
+
+        if (caseShardedProblems.count(prob)) srand((uint32_t)GetCaseSeed(prob.c_str(), TEST_NO_INDEX));
+        else owned = ShardOwnsCase(prob.c_str(), TEST_NO_INDEX);
+
+        ResetAllocStats();
+        reporter.BeginProblem(prob);
+        if (owned) problems[prob](results);
+
+        for (auto& res : results) reporter.Add(res);
+        results.clear();
+        reporter.EndProblem();
+
+        if (!owned)
+        {
+            printf("%s: runs on another shard.\n", prob.c_str());
+            continue;
+        }
+
+        const AllocStats stats = GetAllocStats();
+
+        printf(
+            "%s: %llu allocations, %llu bytes, peak %llu bytes.\n",
+            prob.c_str(),
+            (unsigned long long)stats.allocations,
+            (unsigned long long)stats.bytes,
+            (unsigned long long)stats.peakBytes
+        );
     }
 
-    ReportTestResults(results);
+    SetActiveReporter(nullptr);
+
+    reporter.EndRun();
+    reporter.PrintSummary();
+    ReportResultCache();
+
+    if (reporter.Close() != OK) printf("Unable to write the report file.\n");
 
     return 0;
-}
\ No newline at end of file
+}
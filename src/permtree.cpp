@@ -0,0 +1,608 @@
+#include "problems.h"
+#include "permtree.h"
+
+#include <numeric>
+
+/**
+ * PermTree - Build a tree holding an unsigned permutation of 0..n-1.
+ *
+ * @param perm [in] Permutation values in position order.
+ */
+
+PermTree::PermTree(const vector<uint32_t>& perm) : root(PERM_TREE_NONE)
+{
+    Build(perm.data(), (uint32_t)perm.size());
+}
+
+/**
+ * PermTree - Build a tree holding a signed permutation whose absolute values are 0..n-1, with each
+ * sign kept as a forward or backward mark.
+ *
+ * @param perm [in] Signed permutation values in position order.
+ */
+
+PermTree::PermTree(const vector<int32_t>& perm) : root(PERM_TREE_NONE)
+{
+    vector<uint32_t> values(perm.size());
+    vector<StripMark> marks(perm.size());
+
+    for (size_t i = 0; i < perm.size(); i++)
+    {
+        values[i]           = (uint32_t)abs(perm[i]);
+        marks[values[i]]    = perm[i] < 0 ? STRIP_BACKWARD : STRIP_FORWARD;
+    }
+
+    Build(values.data(), (uint32_t)values.size());
+    SetMarks(marks);
+}
+
+/**
+ * Build - Build the treap in linear time. Nodes arrive in position order, so the tree is a Cartesian
+ * tree on random priorities built with a stack of the rightmost path; sizes and mark minimums are then
+ * pulled up by PullAll.
+ *
+ * @param values    [in] Values in position order.
+ * @param count     [in] Number of values.
+ */
+
+void PermTree::Build(const uint32_t* values, const uint32_t count)
+{
+    nodes.assign(count, { PERM_TREE_NONE, PERM_TREE_NONE, PERM_TREE_NONE, 1, 0, { PERM_TREE_NONE, PERM_TREE_NONE, PERM_TREE_NONE }, 0, STRIP_NONE });
+    if (count == 0) return;
+
+    Rng rng(count);
+    vector<uint32_t> rightPath;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t x    = values[i];
+        nodes[x].priority   = (uint32_t)rng.Next();
+
+        uint32_t last = PERM_TREE_NONE;
+
+        while (!rightPath.empty() && nodes[rightPath.back()].priority < nodes[x].priority)
+        {
+            last = rightPath.back();
+            rightPath.pop_back();
+        }
+
+        nodes[x].left = last;
+        if (!rightPath.empty()) nodes[rightPath.back()].right = x;
+
+        rightPath.push_back(x);
+    }
+
+    root = rightPath[0];
+    PullAll();
+}
+
+/**
+ * PullAll - Recompute every node's size and mark minimums in linear time: push flips down in breadth
+ * first order, then pull in reverse.
+ */
+
+void PermTree::PullAll()
+{
+    if (root == PERM_TREE_NONE) return;
+
+    path.assign(1, root);
+
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        Push(path[i]);
+
+        if (nodes[path[i]].left != PERM_TREE_NONE) path.push_back(nodes[path[i]].left);
+        if (nodes[path[i]].right != PERM_TREE_NONE) path.push_back(nodes[path[i]].right);
+    }
+
+    for (size_t i = path.size(); i > 0; i--) Pull(path[i - 1]);
+    nodes[root].parent = PERM_TREE_NONE;
+}
+
+/**
+ * Apply - Flip a subtree: swap the node's children and its forward and backward marks,
+ * and leave the flip pending for its children.
+ */
+
+void PermTree::Apply(const uint32_t x)
+{
+    if (x == PERM_TREE_NONE) return;
+
+    PermTreeNode& node = nodes[x];
+
+    swap(node.left, node.right);
+    swap(node.minMarked[STRIP_FORWARD - 1], node.minMarked[STRIP_BACKWARD - 1]);
+
+    if (node.mark == STRIP_FORWARD) node.mark = STRIP_BACKWARD;
+    else if (node.mark == STRIP_BACKWARD) node.mark = STRIP_FORWARD;
+
+    node.flip ^= 1;
+}
+
+void PermTree::Push(const uint32_t x)
+{
+    if (!nodes[x].flip) return;
+
+    Apply(nodes[x].left);
+    Apply(nodes[x].right);
+    nodes[x].flip = 0;
+}
+
+/**
+ * Pull - Recompute a node's size and mark minimums from its children and reattach their parent links.
+ * The node must have no pending flip, or its children's minimums would be stale.
+ */
+
+void PermTree::Pull(const uint32_t x)
+{
+    PermTreeNode& node = nodes[x];
+
+    node.size = 1;
+
+    for (uint32_t m = 0; m < 3; m++) node.minMarked[m] = node.mark == m + 1 ? x : PERM_TREE_NONE;
+
+    const uint32_t children[2] = { node.left, node.right };
+
+    for (auto child : children)
+    {
+        if (child == PERM_TREE_NONE) continue;
+
+        const PermTreeNode& c = nodes[child];
+
+        nodes[child].parent = x;
+        node.size           += c.size;
+
+        for (uint32_t m = 0; m < 3; m++) node.minMarked[m] = min(node.minMarked[m], c.minMarked[m]);
+    }
+}
+
+/**
+ * PushPath - Push pending flips down from the root to x, so x's fields and children are current.
+ */
+
+void PermTree::PushPath(const uint32_t x)
+{
+    path.clear();
+    for (uint32_t cur = nodes[x].parent; cur != PERM_TREE_NONE; cur = nodes[cur].parent) path.push_back(cur);
+    for (size_t i = path.size(); i > 0; i--) Push(path[i - 1]);
+}
+
+/**
+ * Split - Split tree t into a, holding its first k positions, and b, holding the rest.
+ */
+
+void PermTree::Split(const uint32_t t, const uint32_t k, uint32_t& a, uint32_t& b)
+{
+    if (t == PERM_TREE_NONE)
+    {
+        a = b = PERM_TREE_NONE;
+        return;
+    }
+
+    Push(t);
+
+    const uint32_t leftSize = nodes[t].left == PERM_TREE_NONE ? 0 : nodes[nodes[t].left].size;
+
+    if (k <= leftSize)
+    {
+        uint32_t leftPart;
+        Split(nodes[t].left, k, a, leftPart);
+        nodes[t].left = leftPart;
+        b = t;
+    }
+    else
+    {
+        uint32_t rightPart;
+        Split(nodes[t].right, k - leftSize - 1, rightPart, b);
+        nodes[t].right = rightPart;
+        a = t;
+    }
+
+    Pull(t);
+
+    if (a != PERM_TREE_NONE) nodes[a].parent = PERM_TREE_NONE;
+    if (b != PERM_TREE_NONE) nodes[b].parent = PERM_TREE_NONE;
+}
+
+/**
+ * Merge - Concatenate trees a and b, every position of a before every position of b.
+ *
+ * @return Root of the merged tree.
+ */
+
+uint32_t PermTree::Merge(const uint32_t a, const uint32_t b)
+{
+    if (a == PERM_TREE_NONE) return b;
+    if (b == PERM_TREE_NONE) return a;
+
+    if (nodes[a].priority > nodes[b].priority)
+    {
+        Push(a);
+        nodes[a].right = Merge(nodes[a].right, b);
+        Pull(a);
+        return a;
+    }
+
+    Push(b);
+    nodes[b].left = Merge(a, nodes[b].left);
+    Pull(b);
+    return b;
+}
+
+/**
+ * Reverse - Reverse positions begin..end inclusive.
+ */
+
+void PermTree::Reverse(const uint32_t begin, const uint32_t end)
+{
+    assert(begin <= end && end < Size());
+
+    uint32_t before;
+    uint32_t rest;
+    uint32_t middle;
+    uint32_t after;
+
+    Split(root, begin, before, rest);
+    Split(rest, end - begin + 1, middle, after);
+    Apply(middle);
+
+    root = Merge(Merge(before, middle), after);
+    nodes[root].parent = PERM_TREE_NONE;
+}
+
+/**
+ * PositionOf - Current position of a value: its left subtree size plus, for every ancestor reached
+ * from the right, that ancestor's left subtree and the ancestor itself.
+ *
+ * Lookups leave pending flips in place. Each pending flip above a node swaps its children once more,
+ * so the walk goes down the root path tracking the parity of the flips passed.
+ */
+
+uint32_t PermTree::PositionOf(const uint32_t value)
+{
+    path.clear();
+    for (uint32_t cur = value; cur != PERM_TREE_NONE; cur = nodes[cur].parent) path.push_back(cur);
+
+    auto sizeOf = [&](uint32_t x) { return x == PERM_TREE_NONE ? 0 : nodes[x].size; };
+
+    uint32_t pos        = 0;
+    uint8_t flipped     = 0;
+
+    for (size_t i = path.size(); i > 0; i--)
+    {
+        const PermTreeNode& node    = nodes[path[i - 1]];
+        const uint32_t left         = flipped ? node.right : node.left;
+
+        if (i == 1) pos += sizeOf(left);
+        else if (path[i - 2] != left) pos += sizeOf(left) + 1;
+
+        flipped ^= node.flip;
+    }
+
+    return pos;
+}
+
+/**
+ * At - Value at a position, walking down with the parity of pending flips as in PositionOf.
+ */
+
+uint32_t PermTree::At(const uint32_t pos)
+{
+    assert(pos < Size());
+
+    uint32_t cur        = root;
+    uint32_t k          = pos;
+    uint8_t flipped     = 0;
+
+    while (true)
+    {
+        const PermTreeNode& node    = nodes[cur];
+        const uint32_t left         = flipped ? node.right : node.left;
+        const uint32_t right        = flipped ? node.left : node.right;
+        const uint32_t leftSize     = left == PERM_TREE_NONE ? 0 : nodes[left].size;
+
+        if (k == leftSize) return cur;
+
+        flipped ^= node.flip;
+
+        if (k < leftSize) cur = left;
+        else
+        {
+            k   -= leftSize + 1;
+            cur = right;
+        }
+    }
+}
+
+/**
+ * IsNegative - Current sign of a value in a signed tree: its mark, swapped once per pending flip above
+ * it.
+ */
+
+bool PermTree::IsNegative(const uint32_t value)
+{
+    uint8_t flipped = 0;
+    for (uint32_t up = nodes[value].parent; up != PERM_TREE_NONE; up = nodes[up].parent) flipped ^= nodes[up].flip;
+
+    return (nodes[value].mark == STRIP_BACKWARD) != (flipped != 0);
+}
+
+/**
+ * SetMark - Set a value's strip mark, in its current orientation, and update minimums up to the root.
+ */
+
+void PermTree::SetMark(const uint32_t value, const StripMark mark)
+{
+    PushPath(value);
+    Push(value);
+
+    nodes[value].mark = mark;
+    for (uint32_t cur = value; cur != PERM_TREE_NONE; cur = nodes[cur].parent) Pull(cur);
+}
+
+/**
+ * SetMarks - Set every value's strip mark at once, in linear time rather than a root walk per value.
+ *
+ * @param marks [in] Mark per value, in current orientation.
+ */
+
+void PermTree::SetMarks(const vector<StripMark>& marks)
+{
+    assert(marks.size() == nodes.size());
+
+    for (uint32_t x = 0; x < nodes.size(); x++) nodes[x].mark = marks[x];
+    PullAll();
+}
+
+/**
+ * Flatten - Write values out in position order with an iterative in-order walk.
+ */
+
+void PermTree::Flatten(vector<uint32_t>& perm)
+{
+    perm.resize(Size());
+
+    path.clear();
+
+    uint32_t cur = root;
+    uint32_t pos = 0;
+
+    while (cur != PERM_TREE_NONE || !path.empty())
+    {
+        while (cur != PERM_TREE_NONE)
+        {
+            Push(cur);
+            path.push_back(cur);
+            cur = nodes[cur].left;
+        }
+
+        cur = path.back();
+        path.pop_back();
+
+        perm[pos++] = cur;
+        cur = nodes[cur].right;
+    }
+}
+
+/**
+ * Flatten - Write signed values out in position order, negative where the mark is backward.
+ */
+
+void PermTree::Flatten(vector<int32_t>& perm)
+{
+    vector<uint32_t> values;
+    Flatten(values);
+
+    perm.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) perm[i] = nodes[values[i]].mark == STRIP_BACKWARD ? -(int32_t)values[i] : (int32_t)values[i];
+}
+
+/**
+ * TestAgainstVector - Apply random reversals, mark updates and queries to a tree and to a plain
+ * vector with marks tracked by hand, and compare.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestAgainstVector(vector<TestResult>& testResults)
+{
+    const uint32_t n        = 1000;
+    const uint32_t numOps   = 20000;
+
+    Rng rng(71);
+
+    vector<uint32_t> ref(n);
+    iota(ref.begin(), ref.end(), 0);
+    for (uint32_t i = n - 1; i > 0; i--) swap(ref[i], ref[rng.NextBounded(i + 1)]);
+
+    vector<uint8_t> marks(n, STRIP_NONE);
+    PermTree tree(ref);
+
+    string err;
+
+    for (uint32_t op = 0; op < numOps && err.empty(); op++)
+    {
+        uint32_t l = rng.NextBounded(n);
+        uint32_t r = rng.NextBounded(n);
+        if (l > r) swap(l, r);
+
+        tree.Reverse(l, r);
+        reverse(ref.begin() + l, ref.begin() + r + 1);
+
+        for (uint32_t p = l; p <= r; p++)
+        {
+            uint8_t& mark = marks[ref[p]];
+            if (mark == STRIP_FORWARD) mark = STRIP_BACKWARD;
+            else if (mark == STRIP_BACKWARD) mark = STRIP_FORWARD;
+        }
+
+        const uint32_t value    = rng.NextBounded(n);
+        const StripMark mark    = (StripMark)rng.NextBounded(4);
+
+        tree.SetMark(value, mark);
+        marks[value] = mark;
+
+        const uint32_t query    = rng.NextBounded(n);
+        const uint32_t pos      = tree.PositionOf(query);
+
+        if (ref[pos] != query) err = "PositionOf wrong at op " + to_string(op);
+        else if (tree.At(l) != ref[l]) err = "At wrong at op " + to_string(op);
+
+        for (uint32_t m = STRIP_SINGLE; m <= STRIP_BACKWARD && err.empty(); m++)
+        {
+            uint32_t expected = PERM_TREE_NONE;
+            for (uint32_t v = 0; v < n && expected == PERM_TREE_NONE; v++) if (marks[v] == m) expected = v;
+
+            if (tree.MinMarked((StripMark)m) != expected) err = "MinMarked wrong at op " + to_string(op);
+        }
+
+        if (err.empty() && op % 1000 == 0)
+        {
+            vector<uint32_t> flat;
+            tree.Flatten(flat);
+            if (flat != ref) err = "Flatten differs at op " + to_string(op);
+        }
+    }
+
+    if (err.empty()) testResults.push_back({ "PermTree::AgainstVector", PASS, "" });
+    else testResults.push_back({ "PermTree::AgainstVector", FAIL, err });
+}
+
+/**
+ * TestSigned - Apply random reversals to a signed tree and to a plain signed vector and compare signs,
+ * the smallest negative value and the flattened permutation. 0 stays in front, as in framed
+ * permutations, since the vector can't hold its sign.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestSigned(vector<TestResult>& testResults)
+{
+    const uint32_t n        = 1000;
+    const uint32_t numOps   = 20000;
+
+    Rng rng(72);
+
+    vector<int32_t> ref(n);
+    iota(ref.begin(), ref.end(), 0);
+    for (uint32_t i = n - 1; i > 1; i--) swap(ref[i], ref[1 + rng.NextBounded(i)]);
+    for (auto& val : ref) if (rng.Next() & 1) val = -val;
+
+    PermTree tree(ref);
+
+    string err;
+
+    for (uint32_t op = 0; op < numOps && err.empty(); op++)
+    {
+        uint32_t l = 1 + rng.NextBounded(n - 1);
+        uint32_t r = 1 + rng.NextBounded(n - 1);
+        if (l > r) swap(l, r);
+
+        tree.Reverse(l, r);
+        reverse(ref.begin() + l, ref.begin() + r + 1);
+        for (uint32_t p = l; p <= r; p++) ref[p] = -ref[p];
+
+        const uint32_t query    = 1 + rng.NextBounded(n - 1);
+        const uint32_t pos      = tree.PositionOf(query);
+
+        uint32_t minNegative = PERM_TREE_NONE;
+        for (auto val : ref) if (val < 0) minNegative = min(minNegative, (uint32_t)-val);
+
+        if (abs(ref[pos]) != (int32_t)query) err = "PositionOf wrong at op " + to_string(op);
+        else if (tree.IsNegative(query) != (ref[pos] < 0)) err = "Sign wrong at op " + to_string(op);
+        else if (tree.MinMarked(STRIP_BACKWARD) != minNegative) err = "Smallest negative wrong at op " + to_string(op);
+
+        if (err.empty() && op % 1000 == 0)
+        {
+            vector<int32_t> flat;
+            tree.Flatten(flat);
+            if (flat != ref) err = "Flatten differs at op " + to_string(op);
+        }
+    }
+
+    if (err.empty()) testResults.push_back({ "PermTree::Signed", PASS, "" });
+    else testResults.push_back({ "PermTree::Signed", FAIL, err });
+}
+
+/**
+ * TestBenchmark - Time random reversals and position lookups on a tree and on a vector with a
+ * position index, for n up to 10^6, and check both end in the same state.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestBenchmark(vector<TestResult>& testResults)
+{
+    const uint32_t sizes[]  = { 10000, 100000, 1000000 };
+    const uint32_t numOps   = 5000;
+
+    for (uint32_t n : sizes)
+    {
+        Rng rng(n);
+
+        vector<uint32_t> perm(n);
+        iota(perm.begin(), perm.end(), 0);
+
+        vector<pair<uint32_t, uint32_t>> ops(numOps);
+        vector<uint32_t> queries(numOps);
+
+        for (uint32_t i = 0; i < numOps; i++)
+        {
+            uint32_t l = rng.NextBounded(n);
+            uint32_t r = rng.NextBounded(n);
+            ops[i]      = { min(l, r), max(l, r) };
+            queries[i]  = rng.NextBounded(n);
+        }
+
+        vector<uint32_t> vec = perm;
+        vector<uint32_t> pos = perm;
+        uint64_t vecSum      = 0;
+
+        long long t1 = GetMilliseconds();
+
+        for (uint32_t i = 0; i < numOps; i++)
+        {
+            reverse(vec.begin() + ops[i].first, vec.begin() + ops[i].second + 1);
+            for (uint32_t p = ops[i].first; p <= ops[i].second; p++) pos[vec[p]] = p;
+            vecSum += pos[queries[i]];
+        }
+
+        long long t2 = GetMilliseconds();
+
+        PermTree tree(perm);
+        uint64_t treeSum = 0;
+
+        for (uint32_t i = 0; i < numOps; i++)
+        {
+            tree.Reverse(ops[i].first, ops[i].second);
+            treeSum += tree.PositionOf(queries[i]);
+        }
+
+        vector<uint32_t> flat;
+        tree.Flatten(flat);
+
+        long long t3 = GetMilliseconds();
+
+        const float vecSec      = ((float)t2 - (float)t1) / 1000.0f;
+        const float treeSec     = ((float)t3 - (float)t2) / 1000.0f;
+        const string name       = "PermTree::Benchmark[" + to_string(n) + "]";
+
+        if (flat == vec && treeSum == vecSum)
+            testResults.push_back({ name, PASS, "Vector T = " + to_string(vecSec) + " sec, tree T = " + to_string(treeSec) + " sec." });
+        else
+            testResults.push_back({ name, FAIL, "Tree and vector disagree." });
+    }
+}
+
+/**
+ * PermutationTree - Tests for the implicit treap permutation.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void PermutationTree(vector<TestResult>& testResults)
+{
+    TestAgainstVector(testResults);
+    TestSigned(testResults);
+    TestBenchmark(testResults);
+}
@@ -0,0 +1,1060 @@
+#include "problems.h"
+#include "reporter.h"
+#include "arena.h"
+
+const size_t REPORTER_FLUSH_BYTES = 64 << 10;
+
+static const char* testCodeNames[3] = { "PASS", "FAIL", "EXECUTION_ERROR" };
+
+static thread_local TestReporter* activeReporter = nullptr;
+
+/**
+ * SetActiveReporter - Route ReportTestCase calls made on this thread to a reporter, or back to the
+ * caller's result list with nullptr.
+ */
+
+void SetActiveReporter(TestReporter* reporter)
+{
+    activeReporter = reporter;
+}
+
+TestReporter* GetActiveReporter()
+{
+    return activeReporter;
+}
+
+/**
+ * ReportTestCase - Record one numbered test case. When the calling thread has an active reporter the
+ * case goes straight to it, and a pass costs a counter increment with no strings built. Otherwise a
+ * TestResult named name[caseIndex] is appended to the list as usual.
+ *
+ * @param  testResults  [in/out]    Result list used without an active reporter.
+ * @param  name         [in]        Test name, a string literal.
+ * @param  caseIndex    [in]        Case number, or TEST_NO_INDEX.
+ * @param  code         [in]        Result.
+ * @param  msg          [in]        Detail for failures.
+ */
+
+void ReportTestCase(
+    vector<TestResult>& testResults,
+    const char* name,
+    const uint32_t caseIndex,
+    const TestResultCode code,
+    const string& msg
+)
+{
+    TestReporter* reporter = activeReporter;
+
+    if (reporter == nullptr)
+    {
+        string testName(name);
+        if (caseIndex != TEST_NO_INDEX) testName += "[" + to_string(caseIndex) + "]";
+
+        testResults.push_back({ testName, code, msg });
+        return;
+    }
+
+    const uint32_t nameId = reporter->InternLiteral(name);
+
+    if (code == PASS) reporter->AddPass(nameId);
+    else reporter->Add(nameId, caseIndex, code, msg);
+}
+
+/**
+ * AppendJsonString - Append a string as a quoted, escaped JSON string.
+ */
+
+void AppendJsonString(string& out, const string& str)
+{
+    out += '"';
+
+    for (const char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)(unsigned char)c);
+            out += esc;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+
+    out += '"';
+}
+
+TestReporter::TestReporter() : problemStart(0), file(INVALID_HANDLE_VALUE), writeError(false), problemsEnded(0)
+{
+    memset(totals, 0, sizeof(totals));
+    memset(problemCounts, 0, sizeof(problemCounts));
+}
+
+TestReporter::~TestReporter()
+{
+    Close();
+}
+
+/**
+ * Open - Start streaming JSON lines to a file, replacing it.
+ *
+ * @param  path [in] Report file.
+ *
+ * @return      IO_ERROR if the file can't be created.
+ */
+
+ResultCode TestReporter::Open(const char* path)
+{
+    Close();
+
+    file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    writeError = false;
+    return OK;
+}
+
+static bool FlushReport(HANDLE file, string& outBuf)
+{
+    DWORD written   = 0;
+    bool ok         = outBuf.empty() || (WriteFile(file, outBuf.data(), (DWORD)outBuf.size(), &written, NULL) && written == outBuf.size());
+
+    outBuf.clear();
+    return ok;
+}
+
+/**
+ * Close - Flush and close the report file.
+ *
+ * @return      IO_ERROR if any write failed.
+ */
+
+ResultCode TestReporter::Close()
+{
+    if (file == INVALID_HANDLE_VALUE) return OK;
+
+    if (!FlushReport(file, outBuf)) writeError = true;
+
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+
+    return writeError ? IO_ERROR : OK;
+}
+
+uint32_t TestReporter::Intern(const string& name)
+{
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+
+    const uint32_t nameId = (uint32_t)names.size();
+
+    names.push_back(name);
+    nameIds[name] = nameId;
+    nameCounts.push_back({ { 0, 0, 0 } });
+
+    return nameId;
+}
+
+/**
+ * InternLiteral - Intern a name given as a string literal. Literals are looked up by address first, so
+ * repeated cases don't even hash the name.
+ */
+
+uint32_t TestReporter::InternLiteral(const char* name)
+{
+    auto it = literalIds.find(name);
+    if (it != literalIds.end()) return it->second;
+
+    const uint32_t nameId = Intern(name);
+    literalIds[name] = nameId;
+
+    return nameId;
+}
+
+string TestReporter::GetTestName(const uint32_t nameId, const uint32_t caseIndex) const
+{
+    if (caseIndex == TEST_NO_INDEX) return names[nameId];
+    return names[nameId] + "[" + to_string(caseIndex) + "]";
+}
+
+/**
+ * BeginRun - Write the run line identifying the seed and shard this report comes from.
+ */
+
+void TestReporter::BeginRun(const uint64_t seed, const uint32_t shardIndex, const uint32_t shardCount)
+{
+    problemsEnded = 0;
+
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    char line[128];
+    snprintf(line, sizeof(line), "{\"seed\":%llu,\"shard\":%u,\"shards\":%u}\n", (unsigned long long)seed, shardIndex, shardCount);
+
+    outBuf += line;
+}
+
+/**
+ * EndRun - Write the end line with the number of problems reported, marking the report complete.
+ */
+
+void TestReporter::EndRun()
+{
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    char line[64];
+    snprintf(line, sizeof(line), "{\"end\":%u}\n", problemsEnded);
+
+    outBuf += line;
+    if (!FlushReport(file, outBuf)) writeError = true;
+}
+
+/**
+ * BeginProblem - Start counting results for a problem.
+ */
+
+void TestReporter::BeginProblem(const string& name)
+{
+    problem         = name;
+    problemStart    = GetMilliseconds();
+    memset(problemCounts, 0, sizeof(problemCounts));
+}
+
+/**
+ * EndProblem - Write the current problem's summary line and flush the report file.
+ *
+ * @param  elapsedMs [in] Time to report for the problem, or -1 for the time since BeginProblem.
+ */
+
+void TestReporter::EndProblem(const long long elapsedMs)
+{
+    problemsEnded++;
+
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    char counts[160];
+    snprintf(
+        counts,
+        sizeof(counts),
+        ",\"pass\":%llu,\"fail\":%llu,\"error\":%llu,\"ms\":%lld}\n",
+        (unsigned long long)problemCounts[PASS],
+        (unsigned long long)problemCounts[FAIL],
+        (unsigned long long)problemCounts[EXECUTION_ERROR],
+        elapsedMs >= 0 ? elapsedMs : GetMilliseconds() - problemStart
+    );
+
+    outBuf += "{\"problem\":";
+    AppendJsonString(outBuf, problem);
+    outBuf += counts;
+
+    if (!FlushReport(file, outBuf)) writeError = true;
+}
+
+/**
+ * AddPass - Count a pass against its test name. Passes are counters only, so there is no case index:
+ * which case passed is never reported.
+ *
+ * @param  nameId [in] Interned test name.
+ */
+
+void TestReporter::AddPass(const uint32_t nameId)
+{
+    nameCounts[nameId].counts[PASS]++;
+    problemCounts[PASS]++;
+    totals[PASS]++;
+}
+
+/**
+ * AddPassCount - Count passes for the current problem without names, e.g. from a merged report.
+ */
+
+void TestReporter::AddPassCount(const uint64_t count)
+{
+    problemCounts[PASS] += count;
+    totals[PASS]        += count;
+}
+
+/**
+ * Add - Record a result. Failures are kept with their message and streamed to the report file.
+ *
+ * @param  nameId       [in] Interned test name.
+ * @param  caseIndex    [in] Case number, or TEST_NO_INDEX.
+ * @param  code         [in] Result.
+ * @param  msg          [in] Detail, dropped for passes.
+ */
+
+void TestReporter::Add(const uint32_t nameId, const uint32_t caseIndex, const TestResultCode code, const string& msg)
+{
+    if (code == PASS)
+    {
+        AddPass(nameId);
+        return;
+    }
+
+    nameCounts[nameId].counts[code]++;
+    problemCounts[code]++;
+    totals[code]++;
+
+    failures.push_back({ nameId, caseIndex, (uint32_t)messages.size(), (uint32_t)code });
+    messages.push_back(msg);
+
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    outBuf += "{\"problem\":";
+    AppendJsonString(outBuf, problem);
+    outBuf += ",\"test\":";
+    AppendJsonString(outBuf, GetTestName(nameId, caseIndex));
+    outBuf += ",\"code\":\"";
+    outBuf += testCodeNames[code];
+    outBuf += "\",\"msg\":";
+    AppendJsonString(outBuf, msg);
+    outBuf += "}\n";
+
+    if (outBuf.size() >= REPORTER_FLUSH_BYTES && !FlushReport(file, outBuf)) writeError = true;
+}
+
+/**
+ * Add - Record a result from a problem's result list. A trailing "[n]" on the name is split off as
+ * the case index, so numbered cases share one interned name.
+ */
+
+void TestReporter::Add(const TestResult& result)
+{
+    const string& name  = result.testName;
+    uint32_t caseIndex  = TEST_NO_INDEX;
+    size_t nameLen      = name.size();
+
+    const size_t open = name.rfind('[');
+
+    if (open != string::npos && name.back() == ']' && open + 2 < name.size() && name.size() - open - 2 <= 9)
+    {
+        uint32_t val = 0;
+        size_t pos   = open + 1;
+
+        for (; pos + 1 < name.size() && name[pos] >= '0' && name[pos] <= '9'; pos++) val = val * 10 + (name[pos] - '0');
+
+        if (pos + 1 == name.size())
+        {
+            caseIndex   = val;
+            nameLen     = open;
+        }
+    }
+
+    const uint32_t nameId = nameLen == name.size() ? Intern(name) : Intern(name.substr(0, nameLen));
+    Add(nameId, caseIndex, result.code, result.testMsg);
+}
+
+/**
+ * PrintSummary - Print pass/fail statistics and the failure and execution error logs.
+ */
+
+void TestReporter::PrintSummary() const
+{
+    const uint64_t testCnt = totals[PASS] + totals[FAIL] + totals[EXECUTION_ERROR];
+
+    printf(
+        "Test Statistics: Pass(%llu/%llu), Fail(%llu/%llu), ExecutionError(%llu/%llu)\n",
+        (unsigned long long)totals[PASS],
+        (unsigned long long)testCnt,
+        (unsigned long long)totals[FAIL],
+        (unsigned long long)testCnt,
+        (unsigned long long)totals[EXECUTION_ERROR],
+        (unsigned long long)testCnt
+    );
+
+    if (totals[FAIL] > 0)
+    {
+        printf("Failure Log:\n\n");
+
+        for (auto& rec : failures)
+            if (rec.code == FAIL)
+                printf("FAILED - %s, Message: %s\n", GetTestName(rec.nameId, rec.caseIndex).c_str(), messages[rec.msgId].c_str());
+    }
+
+    if (totals[EXECUTION_ERROR] > 0)
+    {
+        printf("%sExecution Error Log:\n\n", totals[FAIL] > 0 ? "\n" : "");
+
+        for (auto& rec : failures)
+            if (rec.code == EXECUTION_ERROR)
+                printf("EXECUTION ERROR - %s, Message: %s\n", GetTestName(rec.nameId, rec.caseIndex).c_str(), messages[rec.msgId].c_str());
+    }
+}
+
+/*
+ * Shard of this process. Set once by the driver before any problem runs.
+ */
+
+static TestShard testShard = { 0, 1, 0 };
+
+void SetTestShard(const TestShard& shard)
+{
+    testShard = shard;
+}
+
+const TestShard& GetTestShard()
+{
+    return testShard;
+}
+
+static uint64_t HashName(const char* name)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (; *name; name++)
+    {
+        hash ^= (uint8_t)*name;
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * GetCaseSeed - Seed for one case (or a whole problem with TEST_NO_INDEX), from the run seed, the case
+ * name and its index only.
+ */
+
+uint64_t GetCaseSeed(const char* name, const uint32_t caseIndex)
+{
+    uint64_t z = testShard.seed ^ HashName(name) ^ ((uint64_t)caseIndex * 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * ShardOwnsCase - Whether this process runs a case. Cases of one name are dealt out round robin,
+ * starting from a shard picked by the name, so small suites don't all land on shard 0. An owned case
+ * reseeds rand() with its case seed before returning.
+ *
+ * @param  name         [in] Case name.
+ * @param  caseIndex    [in] Case number, or TEST_NO_INDEX for an unnumbered test or a whole problem.
+ *
+ * @return              True if this shard should run the case.
+ */
+
+bool ShardOwnsCase(const char* name, const uint32_t caseIndex)
+{
+    if ((HashName(name) + caseIndex) % testShard.count != testShard.index) return false;
+
+    srand((uint32_t)GetCaseSeed(name, caseIndex));
+    return true;
+}
+
+/**
+ * ParseJsonLine - Parse one flat JSON object of string and number fields, as written by the reporter.
+ * Numbers are returned as their text.
+ */
+
+static bool ParseJsonLine(const string& line, unordered_map<string, string>& fields)
+{
+    size_t pos = 0;
+
+    auto skipSpace = [&]() { while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) pos++; };
+
+    auto parseString = [&](string& out)
+    {
+        if (pos >= line.size() || line[pos] != '"') return false;
+
+        for (pos++; pos < line.size() && line[pos] != '"'; pos++)
+        {
+            if (line[pos] != '\\')
+            {
+                out += line[pos];
+                continue;
+            }
+
+            if (++pos >= line.size()) return false;
+
+            switch (line[pos])
+            {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+
+            case 'u':
+
+                if (pos + 4 >= line.size()) return false;
+                out += (char)strtoul(line.substr(pos + 1, 4).c_str(), nullptr, 16);
+                pos += 4;
+                break;
+
+            default:
+                out += line[pos];
+                break;
+            }
+        }
+
+        if (pos >= line.size()) return false;
+
+        pos++;
+        return true;
+    };
+
+    fields.clear();
+    skipSpace();
+    if (pos >= line.size() || line[pos++] != '{') return false;
+
+    while (1)
+    {
+        string key;
+        string val;
+
+        skipSpace();
+        if (!parseString(key)) return false;
+
+        skipSpace();
+        if (pos >= line.size() || line[pos++] != ':') return false;
+
+        skipSpace();
+
+        if (pos < line.size() && line[pos] == '"')
+        {
+            if (!parseString(val)) return false;
+        }
+        else
+        {
+            while (pos < line.size() && line[pos] != ',' && line[pos] != '}') val += line[pos++];
+            while (!val.empty() && val.back() == ' ') val.pop_back();
+        }
+
+        fields[key] = val;
+
+        skipSpace();
+        if (pos >= line.size()) return false;
+        if (line[pos] == '}') return true;
+        if (line[pos++] != ',') return false;
+    }
+}
+
+/*
+ * One problem of a shard's report.
+ */
+
+struct ShardProblem
+{
+    string name;
+    uint64_t counts[3];
+    long long ms;
+    vector<TestResult> failures;
+};
+
+struct ShardReport
+{
+    uint64_t seed;
+    uint32_t index;
+    uint32_t count;
+    vector<ShardProblem> problems;
+};
+
+/**
+ * ReadShardReport - Read and check one shard's report: a run line, per problem its failure lines and
+ * a summary line that agrees with them, and an end line. A report cut short has no end line.
+ */
+
+static ResultCode ReadShardReport(const string& path, ShardReport& report, string& error)
+{
+    string text;
+
+    if (!ReadFileToString(path, text))
+    {
+        error = "Unable to read " + path;
+        return IO_ERROR;
+    }
+
+    unordered_map<string, string> fields;
+    vector<TestResult> pending;
+    bool started    = false;
+    bool ended      = false;
+    size_t lineNum  = 0;
+
+    auto fail = [&](const string& why)
+    {
+        error = path + ":" + to_string(lineNum) + ": " + why;
+        return INVALID_INPUT;
+    };
+
+    for (size_t pos = 0; pos < text.size();)
+    {
+        size_t end = text.find('\n', pos);
+        if (end == string::npos) end = text.size();
+
+        const string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        lineNum++;
+
+        if (line.empty() || line == "\r") continue;
+        if (ended) return fail("Data after the end line.");
+        if (!ParseJsonLine(line, fields)) return fail("Malformed line.");
+
+        if (!started)
+        {
+            if (fields.count("seed") == 0 || fields.count("shard") == 0 || fields.count("shards") == 0)
+                return fail("Missing run line; was the report written by a --shard aware run?");
+
+            report.seed     = strtoull(fields["seed"].c_str(), nullptr, 10);
+            report.index    = (uint32_t)strtoul(fields["shard"].c_str(), nullptr, 10);
+            report.count    = (uint32_t)strtoul(fields["shards"].c_str(), nullptr, 10);
+            started         = true;
+
+            if (report.count == 0 || report.index >= report.count) return fail("Bad shard numbers.");
+        }
+        else if (fields.count("end"))
+        {
+            if (!pending.empty()) return fail("Failures after the last problem summary.");
+            if (strtoul(fields["end"].c_str(), nullptr, 10) != report.problems.size()) return fail("Problem count mismatch.");
+
+            ended = true;
+        }
+        else if (fields.count("test"))
+        {
+            const string& code = fields["code"];
+
+            if (code == "FAIL") pending.push_back({ fields["test"], FAIL, fields["msg"] });
+            else if (code == "EXECUTION_ERROR") pending.push_back({ fields["test"], EXECUTION_ERROR, fields["msg"] });
+            else return fail("Unknown result code " + code + ".");
+        }
+        else if (fields.count("pass"))
+        {
+            ShardProblem prob;
+
+            prob.name                       = fields["problem"];
+            prob.counts[PASS]               = strtoull(fields["pass"].c_str(), nullptr, 10);
+            prob.counts[FAIL]               = strtoull(fields["fail"].c_str(), nullptr, 10);
+            prob.counts[EXECUTION_ERROR]    = strtoull(fields["error"].c_str(), nullptr, 10);
+            prob.ms                         = strtoll(fields["ms"].c_str(), nullptr, 10);
+
+            uint64_t numFail = 0;
+            for (auto& res : pending) if (res.code == FAIL) numFail++;
+
+            if (numFail != prob.counts[FAIL] || pending.size() - numFail != prob.counts[EXECUTION_ERROR])
+                return fail("Summary for " + prob.name + " doesn't match its failure lines.");
+
+            prob.failures.swap(pending);
+            report.problems.push_back(move(prob));
+        }
+        else
+        {
+            return fail("Unknown line.");
+        }
+    }
+
+    if (!ended)
+    {
+        error = path + ": No end line; the shard didn't finish.";
+        return INVALID_INPUT;
+    }
+
+    return OK;
+}
+
+/**
+ * MergeTestReports - Combine the reports of every shard of one run. The reports must come from the same
+ * seed and shard count, cover each shard exactly once and list the same problems. Problems are added to
+ * merged in run order, each with its failures in shard order and the summed counts and times.
+ *
+ * @param  paths    [in]        One report file per shard, in any order.
+ * @param  merged   [in/out]    Reporter to fold the results into, with its report file open if a merged
+ *                              report should be written.
+ * @param  error    [out]       Why the merge failed.
+ *
+ * @return          IO_ERROR if a report can't be read, INVALID_INPUT if a report is malformed or incomplete
+ *                  or the set isn't one whole run. OK otherwise.
+ */
+
+ResultCode MergeTestReports(const vector<string>& paths, TestReporter& merged, string& error)
+{
+    if (paths.empty())
+    {
+        error = "No reports to merge.";
+        return INVALID_INPUT;
+    }
+
+    vector<ShardReport> reports(paths.size());
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        ResultCode res = ReadShardReport(paths[i], reports[i], error);
+        if (res != OK) return res;
+    }
+
+    sort(reports.begin(), reports.end(), [](const ShardReport& a, const ShardReport& b) { return a.index < b.index; });
+
+    const ShardReport& first = reports[0];
+
+    if (first.count != reports.size())
+    {
+        error = "Expected " + to_string(first.count) + " shard reports, got " + to_string(reports.size()) + ".";
+        return INVALID_INPUT;
+    }
+
+    for (uint32_t i = 0; i < reports.size(); i++)
+    {
+        bool sameProblems = reports[i].problems.size() == first.problems.size();
+
+        for (size_t p = 0; sameProblems && p < first.problems.size(); p++)
+            sameProblems = reports[i].problems[p].name == first.problems[p].name;
+
+        if (reports[i].index != i || reports[i].seed != first.seed || reports[i].count != first.count || !sameProblems)
+        {
+            error = "Shard " + to_string(reports[i].index) + "/" + to_string(reports[i].count) + " doesn't belong with shard 0/" +
+                    to_string(first.count) + " (seed, shard numbers or problem list differ).";
+            return INVALID_INPUT;
+        }
+    }
+
+    merged.BeginRun(first.seed, 0, 1);
+
+    for (size_t p = 0; p < first.problems.size(); p++)
+    {
+        uint64_t passes = 0;
+        long long ms    = 0;
+
+        merged.BeginProblem(first.problems[p].name);
+
+        for (auto& report : reports)
+        {
+            const ShardProblem& prob = report.problems[p];
+
+            for (auto& res : prob.failures) merged.Add(res);
+
+            passes  += prob.counts[PASS];
+            ms      += prob.ms;
+        }
+
+        merged.AddPassCount(passes);
+        merged.EndProblem(ms);
+    }
+
+    merged.EndRun();
+
+    return OK;
+}
+
+/**
+ * TestAggregation - A million passing cases through ReportTestCase are counters only: nothing is
+ * appended to the result list and nothing is allocated once the name is interned.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestAggregation(vector<TestResult>& testResults)
+{
+    const uint32_t numCases = 1000000;
+
+    TestReporter reporter;
+    TestReporter* prev = GetActiveReporter();
+    vector<TestResult> local;
+
+    SetActiveReporter(&reporter);
+    ReportTestCase(local, "Reporter::Case", 0, PASS);
+
+    const uint64_t allocsBefore = GetAllocStats().allocations;
+
+    long long t1 = GetNanoseconds();
+    for (uint32_t i = 1; i < numCases; i++) ReportTestCase(local, "Reporter::Case", i, PASS);
+    long long t2 = GetNanoseconds();
+
+    const uint64_t allocs = GetAllocStats().allocations - allocsBefore;
+
+    ReportTestCase(local, "Reporter::Case", numCases, FAIL, "Expected failure.");
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%.1f ns per pass, %llu allocations.", (double)(t2 - t1) / numCases, (unsigned long long)allocs);
+
+    const bool ok =
+        local.empty() && allocs == 0 && reporter.names.size() == 1 && reporter.GetCount(PASS) == numCases &&
+        reporter.GetCount(FAIL) == 1 && reporter.failures.size() == 1 &&
+        reporter.GetTestName(reporter.failures[0].nameId, reporter.failures[0].caseIndex) == "Reporter::Case[" + to_string(numCases) + "]";
+
+    if (ok) testResults.push_back({ "Reporter::Aggregation", PASS, msg });
+    else testResults.push_back({ "Reporter::Aggregation", FAIL, msg });
+
+    // Without an active reporter, cases land in the result list with their usual names.
+
+    SetActiveReporter(nullptr);
+    ReportTestCase(local, "Reporter::Case", 7, PASS);
+    ReportTestCase(local, "Reporter::Plain", TEST_NO_INDEX, FAIL, "Detail.");
+    SetActiveReporter(prev);
+
+    const bool legacyOk =
+        local.size() == 2 && local[0].testName == "Reporter::Case[7]" && local[0].code == PASS &&
+        local[1].testName == "Reporter::Plain" && local[1].code == FAIL && local[1].testMsg == "Detail.";
+
+    if (legacyOk) testResults.push_back({ "Reporter::Fallback", PASS, "" });
+    else testResults.push_back({ "Reporter::Fallback", FAIL, "Cases without an active reporter weren't appended." });
+}
+
+/**
+ * TestNameSplitting - Names from result lists share an interned name only when they end in a plain
+ * "[n]" case index.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestNameSplitting(vector<TestResult>& testResults)
+{
+    TestReporter reporter;
+
+    reporter.Add({ "A::B[12]", FAIL, "x" });
+    reporter.Add({ "A::B[3]", PASS, "" });
+    reporter.Add({ "A::B", EXECUTION_ERROR, "y" });
+    reporter.Add({ "A::B[x1]", FAIL, "" });
+    reporter.Add({ "A::B[]", FAIL, "" });
+    reporter.Add({ "A::B[12345678901]", FAIL, "" });
+
+    const bool ok =
+        reporter.names.size() == 4 && reporter.names[0] == "A::B" && reporter.nameCounts[0].counts[FAIL] == 1 &&
+        reporter.nameCounts[0].counts[PASS] == 1 && reporter.nameCounts[0].counts[EXECUTION_ERROR] == 1 &&
+        reporter.failures[0].caseIndex == 12 && reporter.failures[1].caseIndex == TEST_NO_INDEX &&
+        reporter.GetTestName(reporter.failures[2].nameId, reporter.failures[2].caseIndex) == "A::B[x1]" &&
+        reporter.GetTestName(reporter.failures[3].nameId, reporter.failures[3].caseIndex) == "A::B[]" &&
+        reporter.GetTestName(reporter.failures[4].nameId, reporter.failures[4].caseIndex) == "A::B[12345678901]";
+
+    if (ok) testResults.push_back({ "Reporter::NameSplitting", PASS, "" });
+    else testResults.push_back({ "Reporter::NameSplitting", FAIL, "Case indexes split incorrectly." });
+}
+
+/**
+ * TestJsonLines - Failures stream out as they arrive, escaped, followed by one summary line per
+ * problem.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestJsonLines(vector<TestResult>& testResults)
+{
+    const string path = GetTempFilePath("bp_reporter_test.jsonl");
+
+    TestReporter reporter;
+
+    if (reporter.Open(path.c_str()) != OK)
+    {
+        testResults.push_back({ "Reporter::JsonLines", FAIL, "Unable to create the report file." });
+        return;
+    }
+
+    reporter.BeginProblem("First");
+    for (uint32_t i = 0; i < 5; i++) reporter.Add({ "Case[" + to_string(i) + "]", PASS, "" });
+    reporter.Add({ "Case[5]", FAIL, "Quote \" and\ttab" });
+    reporter.EndProblem();
+
+    reporter.BeginProblem("Second");
+    reporter.Add({ "Other", EXECUTION_ERROR, "Threw." });
+    reporter.EndProblem();
+
+    const bool closed = reporter.Close() == OK;
+
+    string text;
+    const bool read = ReadFileToString(path, text);
+    DeleteFileA(path.c_str());
+
+    // Strip the timings, which vary from run to run.
+
+    string stripped;
+
+    for (size_t pos = 0; pos < text.size();)
+    {
+        const size_t ms = text.find(",\"ms\":", pos);
+        if (ms == string::npos)
+        {
+            stripped += text.substr(pos);
+            break;
+        }
+
+        stripped += text.substr(pos, ms - pos);
+        pos = text.find('}', ms);
+    }
+
+    const string expected =
+        "{\"problem\":\"First\",\"test\":\"Case[5]\",\"code\":\"FAIL\",\"msg\":\"Quote \\\" and\\u0009tab\"}\n"
+        "{\"problem\":\"First\",\"pass\":5,\"fail\":1,\"error\":0}\n"
+        "{\"problem\":\"Second\",\"test\":\"Other\",\"code\":\"EXECUTION_ERROR\",\"msg\":\"Threw.\"}\n"
+        "{\"problem\":\"Second\",\"pass\":0,\"fail\":0,\"error\":1}\n";
+
+    if (closed && read && stripped == expected) testResults.push_back({ "Reporter::JsonLines", PASS, "" });
+    else testResults.push_back({ "Reporter::JsonLines", FAIL, "Unexpected report: " + text });
+}
+
+/**
+ * TestShardOwnership - Every case belongs to exactly one shard, and an owned case sees the same rand()
+ * stream whatever the shard layout.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestShardOwnership(vector<TestResult>& testResults)
+{
+    const TestShard prev        = GetTestShard();
+    const uint32_t numCases     = 200;
+    const uint32_t layouts[]    = { 1, 3, 7 };
+
+    vector<int> reference(numCases);
+    bool ok = true;
+
+    for (uint32_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++)
+    {
+        for (uint32_t i = 0; i < numCases; i++)
+        {
+            uint32_t owners = 0;
+
+            for (uint32_t s = 0; s < layouts[l]; s++)
+            {
+                SetTestShard({ s, layouts[l], 1234 });
+                if (!ShardOwnsCase("Shard::Case", i)) continue;
+
+                owners++;
+
+                const int val = rand();
+                if (l == 0) reference[i] = val;
+                else if (val != reference[i]) ok = false;
+            }
+
+            if (owners != 1) ok = false;
+        }
+    }
+
+    SetTestShard(prev);
+
+    if (ok) testResults.push_back({ "Reporter::ShardOwnership", PASS, "" });
+    else testResults.push_back({ "Reporter::ShardOwnership", FAIL, "A case had no single owner or saw a different rand() stream." });
+}
+
+/**
+ * WriteShardRun - Test helper. Report a small two-problem run as one shard would.
+ */
+
+static bool WriteShardRun(const string& path, const TestShard& shard, TestReporter& reporter)
+{
+    if (!path.empty() && reporter.Open(path.c_str()) != OK) return false;
+
+    const TestShard prev = GetTestShard();
+    SetTestShard(shard);
+
+    reporter.BeginRun(shard.seed, shard.index, shard.count);
+
+    reporter.BeginProblem("Cases");
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        if (!ShardOwnsCase("Shard::Case", i)) continue;
+
+        const uint32_t nameId = reporter.InternLiteral("Shard::Case");
+
+        if (i % 7 == 3) reporter.Add(nameId, i, FAIL, "Case " + to_string(i) + " \"failed\".");
+        else reporter.AddPass(nameId);
+    }
+    reporter.EndProblem();
+
+    reporter.BeginProblem("Whole");
+    if (ShardOwnsCase("Whole", TEST_NO_INDEX)) reporter.Add({ "Whole::Test", EXECUTION_ERROR, "Threw." });
+    reporter.EndProblem();
+
+    reporter.EndRun();
+    SetTestShard(prev);
+
+    return reporter.Close() == OK;
+}
+
+static set<string> GetFailureSet(const TestReporter& reporter)
+{
+    set<string> failures;
+
+    for (auto& rec : reporter.failures)
+        failures.insert(reporter.GetTestName(rec.nameId, rec.caseIndex) + "|" + to_string(rec.code) + "|" + reporter.messages[rec.msgId]);
+
+    return failures;
+}
+
+/**
+ * TestShardMerge - Merging the reports of a three shard run gives the same counts and failures as the
+ * run in one process, and incomplete or mismatched report sets are rejected.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestShardMerge(vector<TestResult>& testResults)
+{
+    const uint32_t numShards = 3;
+
+    TestReporter single;
+    WriteShardRun("", { 0, 1, 99 }, single);
+
+    vector<string> paths;
+    bool written = true;
+
+    for (uint32_t s = 0; s < numShards; s++)
+    {
+        TestReporter shardReporter;
+        paths.push_back(GetTempFilePath("bp_reporter_test.jsonl") + ".shard" + to_string(s));
+        written = WriteShardRun(paths.back(), { s, numShards, 99 }, shardReporter) && written;
+    }
+
+    if (!written)
+    {
+        testResults.push_back({ "Reporter::ShardMerge", EXECUTION_ERROR, "Unable to write the shard reports." });
+        return;
+    }
+
+    TestReporter merged;
+    string error;
+
+    ResultCode res  = MergeTestReports(paths, merged, error);
+    bool match      = res == OK && GetFailureSet(merged) == GetFailureSet(single);
+
+    for (uint32_t c = 0; c < 3; c++) match = match && merged.GetCount((TestResultCode)c) == single.GetCount((TestResultCode)c);
+
+    if (match) testResults.push_back({ "Reporter::ShardMerge", PASS, "" });
+    else testResults.push_back({ "Reporter::ShardMerge", FAIL, "Merged report differs from a single process run. " + error });
+
+    // A missing shard, a shard from another run and a shard cut short must all be rejected.
+
+    TestReporter partial;
+    TestReporter mixed;
+    TestReporter truncated;
+    TestReporter otherRun;
+    string text;
+
+    const bool rejectPartial = MergeTestReports({ paths[0], paths[2] }, partial, error) == INVALID_INPUT;
+
+    WriteShardRun(paths[1], { 1, numShards, 100 }, otherRun);
+    const bool rejectMixed = MergeTestReports(paths, mixed, error) == INVALID_INPUT;
+
+    TestReporter rewriter;
+    WriteShardRun(paths[1], { 1, numShards, 99 }, rewriter);
+    ReadFileToString(paths[1], text);
+    WriteStringToFile(paths[1], text.substr(0, text.rfind("{\"end\"")));
+
+    const bool rejectTruncated = MergeTestReports(paths, truncated, error) == INVALID_INPUT;
+
+    for (auto& path : paths) DeleteFileA(path.c_str());
+
+    if (rejectPartial && rejectMixed && rejectTruncated)
+        testResults.push_back({ "Reporter::ShardMergeChecks", PASS, "" });
+    else
+        testResults.push_back({ "Reporter::ShardMergeChecks", FAIL, "Accepted an incomplete or mismatched shard set." });
+}
+
+/**
+ * TestReporting - Streaming reporter tests: pass aggregation and allocation-free passes, the fallback
+ * to result lists, case index splitting, the JSON lines output, and shard ownership and merging.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+void TestReporting(vector<TestResult>& testResults)
+{
+    TestAggregation(testResults);
+    TestNameSplitting(testResults);
+    TestJsonLines(testResults);
+    TestShardOwnership(testResults);
+    TestShardMerge(testResults);
+}
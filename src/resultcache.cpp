@@ -0,0 +1,934 @@
+#include "problems.h"
+#include "resultcache.h"
+#include "restmap.h"
+#include "motif.h"
+
+const char RESULT_CACHE_MAGIC[4]            = { 'B', 'P', 'R', 'C' };
+const uint64_t RESULT_CACHE_HEADER_BYTES    = 4096;
+
+// Writers lock one byte far past any real file size, so the lock never overlaps the mapped range.
+
+const DWORD RESULT_CACHE_LOCK_OFFSET_HIGH   = 0x7FFFFFFF;
+
+static_assert(atomic<uint64_t>::is_always_lock_free, "Shared index needs address-free 64-bit atomics.");
+
+struct ResultCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t slotCount;             // Power of two.
+    uint32_t reserved;
+    uint64_t dataOffset;            // File offset of the data area.
+    uint64_t dataBytes;
+    atomic<uint64_t> dataUsed;
+    atomic<uint64_t> entries;
+};
+
+struct ResultCacheSlot
+{
+    uint8_t hash[32];
+    uint32_t kind;
+    uint32_t count;                 // Values stored.
+    atomic<uint64_t> offset;        // File offset of the values. Zero while the slot is empty.
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(ResultCacheHeader) <= RESULT_CACHE_HEADER_BYTES, "Header doesn't fit.");
+static_assert(sizeof(ResultCacheSlot) == 64, "Slots should be one cache line.");
+
+/*
+ * SHA-256 (FIPS 180-4), used for cache keys.
+ */
+
+static const uint32_t sha256Rounds[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t RotateRight(const uint32_t x, const uint32_t n) { return (x >> n) | (x << (32 - n)); }
+
+struct Sha256
+{
+    uint32_t state[8];
+    uint8_t block[64];
+    uint32_t blockLen;
+    uint64_t totalLen;
+
+    Sha256() : blockLen(0), totalLen(0)
+    {
+        static const uint32_t init[8] =
+        {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+
+        memcpy(state, init, sizeof(state));
+    }
+
+    void Compress(const uint8_t* data)
+    {
+        uint32_t w[64];
+
+        for (uint32_t i = 0; i < 16; i++)
+            w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 | (uint32_t)data[4 * i + 2] << 8 | data[4 * i + 3];
+
+        for (uint32_t i = 16; i < 64; i++)
+        {
+            const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            const uint32_t t1 = h + (RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25)) + ((e & f) ^ (~e & g)) + sha256Rounds[i] + w[i];
+            const uint32_t t2 = (RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    void Update(const void* data, size_t len)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        totalLen += len;
+
+        if (blockLen > 0)
+        {
+            const size_t take = min(len, (size_t)(64 - blockLen));
+            memcpy(block + blockLen, bytes, take);
+
+            blockLen    += (uint32_t)take;
+            bytes       += take;
+            len         -= take;
+
+            if (blockLen < 64) return;
+
+            Compress(block);
+            blockLen = 0;
+        }
+
+        for (; len >= 64; bytes += 64, len -= 64) Compress(bytes);
+
+        memcpy(block, bytes, len);
+        blockLen = (uint32_t)len;
+    }
+
+    void UpdateUint(const uint32_t val) { Update(&val, sizeof(val)); }
+
+    void Final(uint8_t* hash)
+    {
+        const uint64_t bitLen = totalLen * 8;
+
+        block[blockLen++] = 0x80;
+
+        if (blockLen > 56)
+        {
+            memset(block + blockLen, 0, 64 - blockLen);
+            Compress(block);
+            blockLen = 0;
+        }
+
+        memset(block + blockLen, 0, 56 - blockLen);
+        for (uint32_t i = 0; i < 8; i++) block[56 + i] = (uint8_t)(bitLen >> (56 - 8 * i));
+        Compress(block);
+
+        for (uint32_t i = 0; i < 32; i++) hash[i] = (uint8_t)(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+};
+
+static bool LockWriters(HANDLE file)
+{
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.OffsetHigh = RESULT_CACHE_LOCK_OFFSET_HIGH;
+
+    return LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov) != FALSE;
+}
+
+static void UnlockWriters(HANDLE file)
+{
+    OVERLAPPED ov;
+    memset(&ov, 0, sizeof(ov));
+    ov.OffsetHigh = RESULT_CACHE_LOCK_OFFSET_HIGH;
+
+    UnlockFileEx(file, 0, 1, 0, &ov);
+}
+
+static inline uint64_t GetDataOffset(const uint32_t slotCount)
+{
+    return RESULT_CACHE_HEADER_BYTES + (uint64_t)slotCount * sizeof(ResultCacheSlot);
+}
+
+/**
+ * GetMapBytes - Size of the mapped file for a geometry.
+ *
+ * @return False if the size overflows or can't be mapped into the address space.
+ */
+
+static inline bool GetMapBytes(const uint32_t slotCount, const uint64_t dataBytes, uint64_t& mapBytes)
+{
+    const uint64_t dataOffset = GetDataOffset(slotCount);
+
+    if (dataBytes > UINT64_MAX - dataOffset || dataOffset + dataBytes > (uint64_t)SIZE_MAX) return false;
+
+    mapBytes = dataOffset + dataBytes;
+    return true;
+}
+
+static inline bool IsPowerOfTwo(const uint32_t val) { return val != 0 && (val & (val - 1)) == 0; }
+
+ResultCache::ResultCache() :
+    file(INVALID_HANDLE_VALUE),
+    mapping(NULL),
+    view(nullptr),
+    header(nullptr),
+    slots(nullptr),
+    mapBytes(0),
+    hits(0),
+    misses(0)
+{
+}
+
+ResultCache::~ResultCache()
+{
+    Close();
+}
+
+/**
+ * Open - Open a cache file, creating and sizing it if it doesn't exist. An existing file keeps the
+ * geometry it was created with and the size arguments are ignored. Safe to race with other processes
+ * opening the same file.
+ *
+ * @param  path         [in] Cache file.
+ * @param  slotCount    [in] Index slots for a new file, a power of two. At most three quarters are used.
+ * @param  dataBytes    [in] Data area size for a new file.
+ *
+ * @return              INVALID_INPUT for a bad geometry, a file that isn't a cache or a header whose data
+ *                      area doesn't fit the file. IO_ERROR if the file can't be opened or mapped.
+ */
+
+ResultCode ResultCache::Open(const char* path, const uint32_t slotCount, const uint64_t dataBytes)
+{
+    Close();
+
+    if (!IsPowerOfTwo(slotCount)) return INVALID_INPUT;
+
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    // Hold the writer lock so two processes can't both initialize a new file.
+
+    if (!LockWriters(file))
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    ResultCode res = OK;
+    LARGE_INTEGER fileSize;
+    ResultCacheHeader existing;
+    bool create = false;
+
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        res = IO_ERROR;
+    }
+    else if (fileSize.QuadPart == 0)
+    {
+        create = true;
+        if (!GetMapBytes(slotCount, dataBytes, mapBytes)) res = INVALID_INPUT;
+    }
+    else
+    {
+        DWORD bytesRead = 0;
+
+        if (!ReadFile(file, &existing, sizeof(existing), &bytesRead, NULL) || bytesRead != sizeof(existing) ||
+            memcmp(existing.magic, RESULT_CACHE_MAGIC, 4) != 0 || existing.version != RESULT_CACHE_VERSION ||
+            !IsPowerOfTwo(existing.slotCount))
+        {
+            res = INVALID_INPUT;
+        }
+        else if (existing.dataOffset != GetDataOffset(existing.slotCount) || existing.dataUsed.load() > existing.dataBytes ||
+            !GetMapBytes(existing.slotCount, existing.dataBytes, mapBytes) || (uint64_t)fileSize.QuadPart < mapBytes)
+        {
+            // Store writes at dataOffset + dataUsed, so a header whose data area doesn't lie inside the
+            // mapping is refused rather than trusted.
+
+            res = INVALID_INPUT;
+        }
+    }
+
+    if (res == OK)
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(mapBytes >> 32), (DWORD)mapBytes, NULL);
+        if (mapping != NULL) view = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (size_t)mapBytes);
+
+        if (view == nullptr) res = IO_ERROR;
+    }
+
+    if (res == OK)
+    {
+        header  = (ResultCacheHeader*)view;
+        slots   = (ResultCacheSlot*)(view + RESULT_CACHE_HEADER_BYTES);
+
+        // A new file is zero filled, which is an empty index and an empty data area.
+
+        if (create)
+        {
+            header->version     = RESULT_CACHE_VERSION;
+            header->slotCount   = slotCount;
+            header->dataOffset  = GetDataOffset(slotCount);
+            header->dataBytes   = dataBytes;
+            memcpy(header->magic, RESULT_CACHE_MAGIC, 4);
+        }
+    }
+
+    UnlockWriters(file);
+
+    if (res != OK) Close();
+    return res;
+}
+
+void ResultCache::Close()
+{
+    if (view != nullptr) UnmapViewOfFile(view);
+    if (mapping != NULL) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+    file        = INVALID_HANDLE_VALUE;
+    mapping     = NULL;
+    view        = nullptr;
+    header      = nullptr;
+    slots       = nullptr;
+    mapBytes    = 0;
+}
+
+static inline bool SlotMatches(const ResultCacheSlot& slot, const ResultKey& key)
+{
+    return slot.kind == key.kind && memcmp(slot.hash, key.hash, sizeof(key.hash)) == 0;
+}
+
+static inline uint32_t GetHomeSlot(const ResultKey& key, const uint32_t slotCount)
+{
+    uint32_t h;
+    memcpy(&h, key.hash, sizeof(h));
+    return h & (slotCount - 1);
+}
+
+/**
+ * Lookup - Find a stored result. Lock free; counts a hit or a miss.
+ *
+ * @param  key      [in]    Instance key.
+ * @param  values   [out]   Stored values on a hit.
+ *
+ * @return          true on a hit.
+ */
+
+bool ResultCache::Lookup(const ResultKey& key, vector<uint32_t>& values)
+{
+    if (!IsOpen()) return false;
+
+    const uint32_t slotCount    = header->slotCount;
+    uint32_t idx                = GetHomeSlot(key, slotCount);
+
+    for (uint32_t probe = 0; probe < slotCount; probe++, idx = (idx + 1) & (slotCount - 1))
+    {
+        const ResultCacheSlot& slot = slots[idx];
+        const uint64_t offset       = slot.offset.load(memory_order_acquire);
+
+        if (offset == 0) break;
+        if (!SlotMatches(slot, key)) continue;
+
+        // Don't trust a damaged file to stay inside the mapping.
+
+        if (offset + (uint64_t)slot.count * sizeof(uint32_t) > mapBytes) break;
+
+        const uint32_t* stored = (const uint32_t*)(view + offset);
+        values.assign(stored, stored + slot.count);
+
+        hits++;
+        return true;
+    }
+
+    misses++;
+    return false;
+}
+
+/**
+ * Store - Append a result and publish it in the index. Storing a key that is already present is a
+ * no-op, whichever process stored it first.
+ *
+ * @param  key      [in] Instance key.
+ * @param  values   [in] Result values.
+ *
+ * @return          IO_ERROR if the cache isn't open, can't be locked or is full.
+ */
+
+ResultCode ResultCache::Store(const ResultKey& key, const vector<uint32_t>& values)
+{
+    if (!IsOpen()) return IO_ERROR;
+
+    lock_guard<mutex> guard(writeLock);
+    if (!LockWriters(file)) return IO_ERROR;
+
+    const uint32_t slotCount    = header->slotCount;
+    const uint64_t bytes        = (uint64_t)values.size() * sizeof(uint32_t);
+    uint32_t idx                = GetHomeSlot(key, slotCount);
+    ResultCacheSlot* empty      = nullptr;
+
+    for (uint32_t probe = 0; probe < slotCount; probe++, idx = (idx + 1) & (slotCount - 1))
+    {
+        ResultCacheSlot& slot = slots[idx];
+
+        if (slot.offset.load(memory_order_acquire) == 0)
+        {
+            empty = &slot;
+            break;
+        }
+
+        if (SlotMatches(slot, key))
+        {
+            UnlockWriters(file);
+            return OK;
+        }
+    }
+
+    const uint64_t used     = header->dataUsed.load();
+    const uint64_t entries  = header->entries.load();
+    ResultCode res          = OK;
+
+    if (empty == nullptr || entries + 1 > slotCount - slotCount / 4 || used + bytes > header->dataBytes)
+    {
+        res = IO_ERROR;
+    }
+    else
+    {
+        const uint64_t offset = header->dataOffset + used;
+        if (bytes > 0) memcpy(view + offset, values.data(), (size_t)bytes);
+
+        // Reserve the payload before the slot points at it: a writer that dies in between leaks the
+        // bytes, rather than leaving a visible entry the next append overwrites.
+
+        header->dataUsed.store(used + bytes, memory_order_release);
+
+        memcpy(empty->hash, key.hash, sizeof(key.hash));
+        empty->kind     = key.kind;
+        empty->count    = (uint32_t)values.size();
+        empty->offset.store(offset, memory_order_release);
+
+        header->entries.store(entries + 1);
+    }
+
+    UnlockWriters(file);
+    return res;
+}
+
+uint64_t ResultCache::GetEntryCount() const
+{
+    return IsOpen() ? header->entries.load() : 0;
+}
+
+/**
+ * GetProcessResultCache - The cache the driver opens with --cache. Closed unless opened.
+ */
+
+ResultCache& GetProcessResultCache()
+{
+    static ResultCache cache;
+    return cache;
+}
+
+/**
+ * GetPartialDigestKey - Key for a partial digest instance.
+ *
+ * @param  distList [in]    Distance multiset, sorted ascending.
+ * @param  key      [out]   Instance key.
+ */
+
+void GetPartialDigestKey(const vector<uint32_t>& distList, ResultKey& key)
+{
+    Sha256 sha;
+
+    key.kind = RESULT_KIND_PARTIAL_DIGEST;
+
+    sha.UpdateUint(key.kind);
+    sha.UpdateUint((uint32_t)distList.size());
+    sha.Update(distList.data(), distList.size() * sizeof(uint32_t));
+    sha.Final(key.hash);
+}
+
+/**
+ * GetMotifKey - Key for a motif instance. The sequences are hashed in sorted order, so the key doesn't
+ * depend on the order they were given in.
+ *
+ * @param  seqs         [in]    Sequences.
+ * @param  motifLen     [in]    Motif length.
+ * @param  key          [out]   Instance key.
+ * @param  order        [out]   Index into seqs of each sequence in sorted order.
+ */
+
+void GetMotifKey(const vector<string>& seqs, const uint32_t motifLen, ResultKey& key, vector<uint32_t>& order)
+{
+    order.resize(seqs.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+
+    stable_sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return seqs[a] < seqs[b]; });
+
+    Sha256 sha;
+
+    key.kind = RESULT_KIND_MOTIF;
+
+    sha.UpdateUint(key.kind);
+    sha.UpdateUint(motifLen);
+    sha.UpdateUint((uint32_t)seqs.size());
+
+    // Length prefixes keep sequence boundaries part of the key.
+
+    for (auto idx : order)
+    {
+        sha.UpdateUint((uint32_t)seqs[idx].size());
+        sha.Update(seqs[idx].data(), seqs[idx].size());
+    }
+
+    sha.Final(key.hash);
+}
+
+/**
+ * CachedComputePDBacktracking - ComputePDBacktracking through a result cache. The distances may be in
+ * any order.
+ *
+ * @param  cache    [in]        Result cache.
+ * @param  distList [in]        Distance multiset.
+ * @param  pd       [in/out]    Point set, expected empty.
+ *
+ * @return          ComputePDBacktracking's result; OK on a hit.
+ */
+
+ResultCode CachedComputePDBacktracking(ResultCache& cache, const vector<uint32_t>& distList, vector<uint32_t>& pd)
+{
+    vector<uint32_t> sortedCopy;
+    const vector<uint32_t>* sorted = &distList;
+
+    if (!is_sorted(distList.begin(), distList.end()))
+    {
+        sortedCopy = distList;
+        sort(sortedCopy.begin(), sortedCopy.end());
+        sorted = &sortedCopy;
+    }
+
+    if (!cache.IsOpen()) return ComputePDBacktracking(*sorted, pd);
+
+    ResultKey key;
+    GetPartialDigestKey(*sorted, key);
+
+    if (cache.Lookup(key, pd)) return OK;
+
+    ResultCode res = ComputePDBacktracking(*sorted, pd);
+    if (res == OK) cache.Store(key, pd);
+
+    return res;
+}
+
+/**
+ * CachedFindMotif - FindMotif through a result cache. A hit on the same sequences in another order
+ * returns each sequence's stored offset.
+ *
+ * @param  cache        [in]    Result cache.
+ * @param  seqs         [in]    Sequences.
+ * @param  motifLen     [in]    Motif length.
+ * @param  offsets      [out]   Motif offset in each sequence.
+ *
+ * @return              FindMotif's result; OK on a hit.
+ */
+
+ResultCode CachedFindMotif(ResultCache& cache, const vector<string>& seqs, const uint32_t motifLen, vector<uint32_t>& offsets)
+{
+    if (!cache.IsOpen()) return FindMotif(seqs, motifLen, offsets);
+
+    ResultKey key;
+    vector<uint32_t> order;
+    vector<uint32_t> canonical;
+
+    GetMotifKey(seqs, motifLen, key, order);
+
+    if (cache.Lookup(key, canonical) && canonical.size() == seqs.size())
+    {
+        offsets.resize(seqs.size());
+        for (uint32_t i = 0; i < order.size(); i++) offsets[order[i]] = canonical[i];
+
+        return OK;
+    }
+
+    ResultCode res = FindMotif(seqs, motifLen, offsets);
+
+    if (res == OK && offsets.size() == seqs.size())
+    {
+        canonical.resize(seqs.size());
+        for (uint32_t i = 0; i < order.size(); i++) canonical[i] = offsets[order[i]];
+
+        cache.Store(key, canonical);
+    }
+
+    return res;
+}
+
+/**
+ * TestSha256 - Check the key hash against the FIPS 180-4 example digests.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestSha256(vector<TestResult>& testResults)
+{
+    static const char* inputs[3] = { "", "abc", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq" };
+    static const char* digests[3] =
+    {
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    };
+
+    bool ok = true;
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        uint8_t hash[32];
+        char hex[65];
+
+        Sha256 sha;
+        sha.Update(inputs[i], strlen(inputs[i]));
+        sha.Final(hash);
+
+        for (uint32_t j = 0; j < 32; j++) snprintf(hex + 2 * j, 3, "%02x", hash[j]);
+        ok = ok && strcmp(hex, digests[i]) == 0;
+    }
+
+    // Feeding the same bytes in odd sized pieces must give the same digest as one call.
+
+    string text(1000, 'x');
+    for (uint32_t i = 0; i < text.size(); i++) text[i] = (char)rand();
+
+    uint8_t whole[32], pieces[32];
+
+    Sha256 shaWhole;
+    shaWhole.Update(text.data(), text.size());
+    shaWhole.Final(whole);
+
+    Sha256 shaPieces;
+    for (size_t pos = 0, step = 1; pos < text.size(); pos += step, step = step * 3 % 97 + 1)
+        shaPieces.Update(text.data() + pos, min(step, text.size() - pos));
+    shaPieces.Final(pieces);
+
+    ok = ok && memcmp(whole, pieces, sizeof(whole)) == 0;
+
+    if (ok) testResults.push_back({ "ResultCache::Sha256", PASS, "" });
+    else testResults.push_back({ "ResultCache::Sha256", FAIL, "Digest mismatch." });
+}
+
+/**
+ * TestPartialDigest - A repeated digest, given in a different order, is served from the cache with the
+ * same points, and the hit takes microseconds.
+ *
+ * @param testResults   List of test results to append to.
+ * @param cache         Open, empty cache.
+ */
+
+static void TestPartialDigest(vector<TestResult>& testResults, ResultCache& cache)
+{
+    const uint32_t numPoints    = 40;
+    const uint32_t numLookups   = 1000;
+
+    set<uint32_t> pointSet = { 0 };
+    while (pointSet.size() < numPoints) pointSet.insert(1 + rand() % 100000);
+
+    vector<uint32_t> points(pointSet.begin(), pointSet.end());
+    vector<uint32_t> dists;
+    GetPairwiseDistances(points, dists);
+
+    vector<uint32_t> cold, warm;
+
+    const uint64_t hits = cache.hits;
+
+    long long t1        = GetNanoseconds();
+    ResultCode coldRes  = CachedComputePDBacktracking(cache, dists, cold);
+    long long t2        = GetNanoseconds();
+
+    for (uint32_t i = (uint32_t)dists.size(); i > 1; i--) swap(dists[i - 1], dists[rand() % i]);
+
+    long long t3 = GetNanoseconds();
+
+    for (uint32_t i = 0; i < numLookups; i++)
+    {
+        warm.clear();
+        CachedComputePDBacktracking(cache, dists, warm);
+    }
+
+    long long t4 = GetNanoseconds();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Miss = %.1f us, hit = %.1f us.", (t2 - t1) / 1000.0, (t4 - t3) / 1000.0 / numLookups);
+
+    vector<uint32_t> check;
+    GetPairwiseDistances(cold, check);
+    sort(dists.begin(), dists.end());
+
+    if (coldRes == OK && check == dists && warm == cold && cache.hits - hits == numLookups)
+        testResults.push_back({ "ResultCache::PartialDigest", PASS, msg });
+    else
+        testResults.push_back({ "ResultCache::PartialDigest", FAIL, "Cached points don't match the solve." });
+}
+
+/**
+ * TestMotif - The same sequence set in reverse order hits the entry stored for the original order and
+ * gets each sequence's offset back.
+ *
+ * @param testResults   List of test results to append to.
+ * @param cache         Open cache.
+ */
+
+static void TestMotif(vector<TestResult>& testResults, ResultCache& cache)
+{
+    const uint32_t nSeq     = 5;
+    const uint32_t seqLen   = 16;
+    const uint32_t motifLen = 5;
+
+    vector<string> seqs;
+    string motif;
+    vector<uint32_t> planted;
+
+    GenerateMotifSequences(nSeq, seqLen, motifLen, seqs, motif, planted);
+
+    vector<uint32_t> cold, warm;
+    CachedFindMotif(cache, seqs, motifLen, cold);
+
+    vector<string> reversed(seqs.rbegin(), seqs.rend());
+
+    const uint64_t hits = cache.hits;
+    CachedFindMotif(cache, reversed, motifLen, warm);
+
+    bool ok = cache.hits - hits == 1 && cold.size() == nSeq && warm.size() == nSeq;
+
+    for (uint32_t i = 0; i < nSeq && ok; i++)
+        ok = warm[i] == cold[nSeq - 1 - i] || seqs[nSeq - 1 - i] == seqs[i];
+
+    ok = ok && GetConsensus(reversed, nSeq, warm, motifLen) == GetConsensus(seqs, nSeq, cold, motifLen);
+
+    if (ok) testResults.push_back({ "ResultCache::Motif", PASS, "" });
+    else testResults.push_back({ "ResultCache::Motif", FAIL, "Reordered sequences didn't get their offsets back." });
+}
+
+/**
+ * TestSharedWriters - Threads store distinct entries through two independent opens of the file, as
+ * separate processes would, and each open then sees every entry.
+ *
+ * @param testResults   List of test results to append to.
+ * @param path          Cache file, open in cache.
+ * @param cache         Open cache.
+ */
+
+static void TestSharedWriters(vector<TestResult>& testResults, const string& path, ResultCache& cache)
+{
+    const uint32_t numThreads       = 4;
+    const uint32_t entriesPerThread = 500;
+
+    ResultCache other;
+
+    if (other.Open(path.c_str()) != OK)
+    {
+        testResults.push_back({ "ResultCache::SharedWriters", FAIL, "Unable to open the cache file a second time." });
+        return;
+    }
+
+    const uint64_t entriesBefore = cache.GetEntryCount();
+    atomic<uint32_t> storeErrors(0);
+    vector<thread> writers;
+
+    for (uint32_t t = 0; t < numThreads; t++)
+    {
+        writers.push_back(thread([&, t]()
+        {
+            ResultCache& handle = t % 2 ? other : cache;
+
+            for (uint32_t i = 0; i < entriesPerThread; i++)
+            {
+                const vector<uint32_t> values = { t, i, t * entriesPerThread + i };
+                ResultKey key;
+
+                GetPartialDigestKey(values, key);
+                if (handle.Store(key, values) != OK) storeErrors++;
+            }
+        }));
+    }
+
+    for (auto& writer : writers) writer.join();
+
+    uint32_t found = 0;
+
+    for (uint32_t t = 0; t < numThreads; t++)
+    {
+        for (uint32_t i = 0; i < entriesPerThread; i++)
+        {
+            const vector<uint32_t> values = { t, i, t * entriesPerThread + i };
+            vector<uint32_t> fromCache, fromOther;
+            ResultKey key;
+
+            GetPartialDigestKey(values, key);
+
+            if (cache.Lookup(key, fromCache) && other.Lookup(key, fromOther) && fromCache == values && fromOther == values) found++;
+        }
+    }
+
+    const uint32_t expected = numThreads * entriesPerThread;
+
+    if (storeErrors == 0 && found == expected && cache.GetEntryCount() == entriesBefore + expected)
+        testResults.push_back({ "ResultCache::SharedWriters", PASS, "" });
+    else
+        testResults.push_back({ "ResultCache::SharedWriters", FAIL, to_string(found) + " of " + to_string(expected) + " entries visible to both opens." });
+}
+
+/**
+ * TestFull - Once a small cache fills up, stores fail, earlier entries still hit and the cached solver
+ * still answers correctly.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+static void TestFull(vector<TestResult>& testResults)
+{
+    const string path = GetTempFilePath("bp_result_cache_full.bin");
+    DeleteFileA(path.c_str());
+
+    ResultCache cache;
+
+    if (cache.Open(path.c_str(), 16, 256) != OK)
+    {
+        testResults.push_back({ "ResultCache::Full", FAIL, "Unable to create the cache file." });
+        return;
+    }
+
+    const vector<uint32_t> first = { 1, 2, 3 };
+    ResultKey firstKey;
+    GetPartialDigestKey(first, firstKey);
+
+    bool ok = cache.Store(firstKey, first) == OK;
+
+    uint32_t stored = 1;
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const vector<uint32_t> values(1 + i % 4, i);
+        ResultKey key;
+
+        GetPartialDigestKey(values, key);
+        if (cache.Store(key, values) == OK) stored++;
+    }
+
+    vector<uint32_t> values;
+    ok = ok && stored <= 12 && cache.Lookup(firstKey, values) && values == first;
+
+    vector<uint32_t> pd;
+    const vector<uint32_t> dists = { 2, 3, 5 };
+    ok = ok && CachedComputePDBacktracking(cache, dists, pd) == OK;
+    ok = ok && (pd == vector<uint32_t>({ 0, 2, 5 }) || pd == vector<uint32_t>({ 0, 3, 5 }));
+
+    cache.Close();
+    DeleteFileA(path.c_str());
+
+    if (ok) testResults.push_back({ "ResultCache::Full", PASS, to_string(stored) + " entries stored." });
+    else testResults.push_back({ "ResultCache::Full", FAIL, "Full cache misbehaved." });
+}
+
+/**
+ * ResultCaching - Result cache tests: the key hash, partial digest and motif round trips through the
+ * cache, concurrent writers on two opens of one file, persistence across a reopen, a full cache and a
+ * file that isn't a cache.
+ *
+ * @param testResults List of test results to append to.
+ */
+
+void ResultCaching(vector<TestResult>& testResults)
+{
+    TestSha256(testResults);
+
+    const string path = GetTempFilePath("bp_result_cache_test.bin");
+    DeleteFileA(path.c_str());
+
+    ResultCache cache;
+
+    if (cache.Open(path.c_str(), 1 << 12, 1 << 20) != OK)
+    {
+        testResults.push_back({ "ResultCache::Open", FAIL, "Unable to create the cache file." });
+        return;
+    }
+
+    TestPartialDigest(testResults, cache);
+    TestMotif(testResults, cache);
+    TestSharedWriters(testResults, path, cache);
+
+    const uint64_t entries = cache.GetEntryCount();
+    cache.Close();
+
+    bool persisted = cache.Open(path.c_str()) == OK && cache.GetEntryCount() == entries;
+    cache.Close();
+
+    if (persisted) testResults.push_back({ "ResultCache::Reopen", PASS, to_string(entries) + " entries." });
+    else testResults.push_back({ "ResultCache::Reopen", FAIL, "Entries lost across a reopen." });
+
+    TestFull(testResults);
+
+    // A file that isn't a cache must be refused rather than mapped and trusted.
+
+    bool refused = WriteStringToFile(path, string(8192, '#')) && cache.Open(path.c_str()) == INVALID_INPUT;
+
+    // Nor may a cache whose header puts the data area anywhere but after the index: a moved data area,
+    // more data in use than allocated, a data size that overflows the mapping size, and a data area
+    // over the header.
+
+    for (uint32_t c = 0; c < 4 && refused; c++)
+    {
+        DeleteFileA(path.c_str());
+
+        refused = cache.Open(path.c_str(), 1 << 4, 1 << 12) == OK;
+        cache.Close();
+
+        string contents;
+        refused = refused && ReadFileToString(path, contents) && contents.size() >= sizeof(ResultCacheHeader);
+        if (!refused) break;
+
+        ResultCacheHeader* header = (ResultCacheHeader*)&contents[0];
+
+        if (c == 0) header->dataOffset += 64;
+        else if (c == 1) header->dataUsed.store(header->dataBytes + 1);
+        else if (c == 2) header->dataBytes = UINT64_MAX - 64;
+        else header->dataOffset = 0;
+
+        refused = WriteStringToFile(path, contents) && cache.Open(path.c_str()) == INVALID_INPUT;
+    }
+
+    if (refused)
+        testResults.push_back({ "ResultCache::NotACache", PASS, "" });
+    else
+        testResults.push_back({ "ResultCache::NotACache", FAIL, "A file that isn't a cache, or has a corrupt header, was accepted." });
+
+    DeleteFileA(path.c_str());
+}
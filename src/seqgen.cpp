@@ -0,0 +1,574 @@
+#include "problems.h"
+#include "seqgen.h"
+
+/*
+ * Approximate size of one streamed batch. Workers format a batch into per-thread buffers while the
+ * previous batch is being written out, so memory stays at about twice this regardless of output size.
+ */
+
+static const size_t SEQGEN_BATCH_BYTES = 64 << 20;
+
+/*
+ * Lookup table expanding one byte of packed bases into four ACGT characters.
+ */
+
+struct BaseExpandTable
+{
+    uint32_t chars[256];
+
+    BaseExpandTable()
+    {
+        for (uint32_t b = 0; b < 256; b++)
+        {
+            char* out = (char*)&chars[b];
+            for (uint32_t i = 0; i < 4; i++) out[i] = CodeToBase((uint8_t)(b >> (6 - 2 * i)));
+        }
+    }
+};
+
+static const BaseExpandTable expandTable;
+
+/*
+ * Per-thread scratch, sized once and reused across sequences.
+ */
+
+struct SeqGenScratch
+{
+    vector<uint64_t> words;
+    vector<uint32_t> positions;
+    vector<char> bases;
+};
+
+static ResultCode ValidateParams(const SeqGenParams& params)
+{
+    if (params.nSeq == 0 || params.seqLen == 0) return INVALID_INPUT;
+    if (params.motifLen > params.seqLen) return INVALID_INPUT;
+    if (params.numMismatches > params.motifLen) return INVALID_INPUT;
+
+    return OK;
+}
+
+static uint32_t WordsPerSeq(uint32_t seqLen) { return (seqLen + 31) / 32; }
+
+static void PrepareScratch(const SeqGenParams& params, SeqGenScratch& scratch)
+{
+    scratch.words.resize(WordsPerSeq(params.seqLen));
+    scratch.positions.resize(params.motifLen);
+    scratch.bases.resize(params.seqLen);
+}
+
+/**
+ * GenerateMotif - Draw the planted motif from the seed's own stream.
+ */
+
+static void GenerateMotif(const SeqGenParams& params, vector<uint8_t>& codes, string& motif)
+{
+    Rng rng(params.seed);
+
+    codes.resize(params.motifLen);
+    motif.resize(params.motifLen);
+
+    for (uint32_t i = 0; i < params.motifLen; i++)
+    {
+        codes[i] = (uint8_t)(rng.Next() >> 62);
+        motif[i] = CodeToBase(codes[i]);
+    }
+}
+
+static inline void SetPackedBase(uint64_t* words, uint32_t pos, uint64_t code)
+{
+    const uint32_t shift = 62 - 2 * (pos & 31);
+    words[pos >> 5] = (words[pos >> 5] & ~(3ULL << shift)) | (code << shift);
+}
+
+static inline uint64_t GetPackedBase(const uint64_t* words, uint32_t pos)
+{
+    return (words[pos >> 5] >> (62 - 2 * (pos & 31))) & 3;
+}
+
+/**
+ * GeneratePackedSequence - Generate sequence i directly in packed form. Each generator call fills a
+ * whole word (32 bases); padding bases past the end of the sequence are zeroed. If a motif is
+ * given it's written at a random offset and numMismatches distinct positions of the copy are
+ * changed to a different base.
+ *
+ * @param  params       [in]        Generator parameters.
+ * @param  motifCodes   [in]        Planted motif codes.
+ * @param  seqIdx       [in]        Sequence index, selects the generator stream.
+ * @param  words        [in/out]    WordsPerSeq(seqLen) packed words.
+ * @param  positions    [in/out]    Scratch of motifLen entries.
+ *
+ * @return              Offset of the planted motif, zero if none.
+ */
+
+static uint32_t GeneratePackedSequence(
+    const SeqGenParams& params,
+    const vector<uint8_t>& motifCodes,
+    const uint32_t seqIdx,
+    uint64_t* words,
+    vector<uint32_t>& positions
+)
+{
+    Rng rng(params.seed + 1 + seqIdx);
+
+    const uint32_t numWords = WordsPerSeq(params.seqLen);
+    const uint32_t tail     = params.seqLen & 31;
+
+    for (uint32_t w = 0; w < numWords; w++) words[w] = rng.Next();
+    if (tail != 0) words[numWords - 1] &= ~0ULL << (64 - 2 * tail);
+
+    if (params.motifLen == 0) return 0;
+
+    const uint32_t offset = rng.NextBounded(params.seqLen - params.motifLen + 1);
+
+    for (uint32_t j = 0; j < params.motifLen; j++) SetPackedBase(words, offset + j, motifCodes[j]);
+
+    for (uint32_t j = 0; j < params.motifLen; j++) positions[j] = j;
+
+    for (uint32_t j = 0; j < params.numMismatches; j++)
+    {
+        swap(positions[j], positions[j + rng.NextBounded(params.motifLen - j)]);
+
+        const uint32_t pos = offset + positions[j];
+        SetPackedBase(words, pos, GetPackedBase(words, pos) ^ (1 + rng.NextBounded(3)));
+    }
+
+    return offset;
+}
+
+/**
+ * ExpandBases - Convert packed words to ACGT characters, four bases per table lookup.
+ */
+
+static void ExpandBases(const uint64_t* words, const uint32_t seqLen, char* out)
+{
+    const uint32_t fullWords = seqLen / 32;
+
+    for (uint32_t w = 0; w < fullWords; w++)
+    {
+        const uint64_t word = words[w];
+        for (uint32_t b = 0; b < 8; b++)
+            memcpy(out + 32 * w + 4 * b, &expandTable.chars[(word >> (56 - 8 * b)) & 0xFF], 4);
+    }
+
+    const uint32_t tail = seqLen & 31;
+
+    if (tail != 0)
+    {
+        char last[32];
+        const uint64_t word = words[fullWords];
+
+        for (uint32_t b = 0; b < 8; b++)
+            memcpy(last + 4 * b, &expandTable.chars[(word >> (56 - 8 * b)) & 0xFF], 4);
+
+        memcpy(out + 32 * fullWords, last, tail);
+    }
+}
+
+/**
+ * GenerateSequenceSet - Generate a set of random ACGT sequences into one flat, preallocated buffer,
+ * optionally with a planted (L, D) motif. Sequences are split across worker threads.
+ *
+ * @param  params   [in]        Generator parameters.
+ * @param  seqSet   [in/out]    Generated sequences, planted motif and offsets.
+ *
+ * @return          INVALID_INPUT for empty sets, motifs longer than the sequences or more mismatches than
+ *                  motif bases. OK otherwise.
+ */
+
+ResultCode GenerateSequenceSet(const SeqGenParams& params, SeqSet& seqSet)
+{
+    if (ValidateParams(params) != OK) return INVALID_INPUT;
+
+    vector<uint8_t> motifCodes;
+    GenerateMotif(params, motifCodes, seqSet.motif);
+
+    seqSet.nSeq     = params.nSeq;
+    seqSet.seqLen   = params.seqLen;
+    seqSet.bases.resize((size_t)params.nSeq * params.seqLen);
+    seqSet.offsets.resize(params.nSeq);
+
+    ParallelFor(params.nSeq, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        SeqGenScratch scratch;
+        PrepareScratch(params, scratch);
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            seqSet.offsets[i] = GeneratePackedSequence(params, motifCodes, i, &scratch.words[0], scratch.positions);
+            ExpandBases(&scratch.words[0], params.seqLen, &seqSet.bases[(size_t)i * params.seqLen]);
+        }
+    });
+
+    return OK;
+}
+
+/**
+ * GeneratePackedSequenceSet - Same sequences as GenerateSequenceSet for equal parameters, generated
+ * straight into 2-bit packed words.
+ *
+ * @param  params   [in]        Generator parameters.
+ * @param  seqSet   [in/out]    Generated packed sequences, planted motif and offsets.
+ *
+ * @return          INVALID_INPUT for invalid parameters, see GenerateSequenceSet. OK otherwise.
+ */
+
+ResultCode GeneratePackedSequenceSet(const SeqGenParams& params, PackedSeqSet& seqSet)
+{
+    if (ValidateParams(params) != OK) return INVALID_INPUT;
+
+    vector<uint8_t> motifCodes;
+    GenerateMotif(params, motifCodes, seqSet.motif);
+
+    seqSet.nSeq         = params.nSeq;
+    seqSet.seqLen       = params.seqLen;
+    seqSet.wordsPerSeq  = WordsPerSeq(params.seqLen);
+    seqSet.words.resize((size_t)params.nSeq * seqSet.wordsPerSeq);
+    seqSet.offsets.resize(params.nSeq);
+
+    ParallelFor(params.nSeq, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        vector<uint32_t> positions(params.motifLen);
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint64_t* words     = &seqSet.words[(size_t)i * seqSet.wordsPerSeq];
+            seqSet.offsets[i]   = GeneratePackedSequence(params, motifCodes, i, words, positions);
+        }
+    });
+
+    return OK;
+}
+
+/**
+ * AppendFastaRecord - Format one generated sequence as a FASTA record, wrapping bases at lineWidth
+ * (zero for a single line).
+ */
+
+static void AppendFastaRecord(
+    const uint32_t seqIdx,
+    const uint32_t offset,
+    const bool planted,
+    const char* bases,
+    const uint32_t seqLen,
+    const uint32_t lineWidth,
+    vector<char>& out
+)
+{
+    char header[64];
+    int headerLen = planted ?
+        snprintf(header, sizeof(header), ">seq%u offset=%u\n", seqIdx, offset) :
+        snprintf(header, sizeof(header), ">seq%u\n", seqIdx);
+
+    out.insert(out.end(), header, header + headerLen);
+
+    const uint32_t width = lineWidth == 0 ? seqLen : lineWidth;
+
+    for (uint32_t pos = 0; pos < seqLen; pos += width)
+    {
+        const uint32_t len = seqLen - pos < width ? seqLen - pos : width;
+        out.insert(out.end(), bases + pos, bases + pos + len);
+        out.push_back('\n');
+    }
+}
+
+/**
+ * WriteSequenceFile - Stream a generated sequence set straight to a FASTA or packed binary file without
+ * holding the whole set in memory. Sequences are produced in batches: worker threads format the
+ * next batch into per-thread buffers while a writer thread flushes the previous one in order.
+ * Output matches GenerateSequenceSet/GeneratePackedSequenceSet for the same parameters.
+ *
+ * @param  params       [in]    Generator parameters.
+ * @param  path         [in]    Output file path. Overwritten if it exists.
+ * @param  format       [in]    SEQ_FILE_FASTA or SEQ_FILE_PACKED (see PackedSeqFileHeader).
+ * @param  lineWidth    [in]    FASTA line width, zero for unwrapped sequences. Defaults to 80.
+ *
+ * @return              INVALID_INPUT for invalid parameters. IO_ERROR if the file can't be created or
+ *                      written. OK otherwise.
+ */
+
+ResultCode WriteSequenceFile(
+    const SeqGenParams& params,
+    const char* path,
+    const SeqFileFormat format,
+    const uint32_t lineWidth
+)
+{
+    if (ValidateParams(params) != OK) return INVALID_INPUT;
+
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    vector<uint8_t> motifCodes;
+    string motif;
+    GenerateMotif(params, motifCodes, motif);
+
+    const uint32_t wordsPerSeq = WordsPerSeq(params.seqLen);
+    bool writeOk = true;
+
+    if (format == SEQ_FILE_PACKED)
+    {
+        PackedSeqFileHeader header = {};
+        memcpy(header.magic, PACKED_SEQ_MAGIC, 4);
+
+        header.version      = PACKED_SEQ_VERSION;
+        header.nSeq         = params.nSeq;
+        header.seqLen       = params.seqLen;
+        header.wordsPerSeq  = wordsPerSeq;
+        header.motifLen     = params.motifLen;
+
+        if (params.motifLen <= MAX_PACKED_KMER)
+            for (auto code : motifCodes) header.motif = (header.motif << 2) | code;
+
+        writeOk = WriteAll(file, (const char*)&header, sizeof(header));
+    }
+
+    const size_t recordBytes = format == SEQ_FILE_PACKED ?
+        8 + (size_t)wordsPerSeq * 8 :
+        32 + params.seqLen + (lineWidth == 0 ? 1 : params.seqLen / lineWidth + 1);
+
+    const uint32_t batchSize    = (uint32_t)max((size_t)1, SEQGEN_BATCH_BYTES / recordBytes);
+    const uint32_t numThreads   = GetWorkerCount();
+
+    vector<vector<char>> buffers[2] = { vector<vector<char>>(numThreads), vector<vector<char>>(numThreads) };
+    vector<SeqGenScratch> scratch(numThreads);
+    for (auto& s : scratch) PrepareScratch(params, s);
+
+    thread writer;
+    atomic<bool> writerOk(true);
+    uint32_t cur = 0;
+
+    for (uint32_t batchStart = 0; batchStart < params.nSeq && writeOk; batchStart += batchSize, cur ^= 1)
+    {
+        const uint32_t batchEnd = params.nSeq - batchStart < batchSize ? params.nSeq : batchStart + batchSize;
+        auto& bufs = buffers[cur];
+
+        for (auto& buf : bufs) buf.clear();
+
+        ParallelFor(batchEnd - batchStart, [&](uint32_t begin, uint32_t end, uint32_t t)
+        {
+            SeqGenScratch& s    = scratch[t];
+            vector<char>& out   = bufs[t];
+
+            out.reserve((end - begin) * recordBytes);
+
+            for (uint32_t i = batchStart + begin; i < batchStart + end; i++)
+            {
+                uint32_t offset = GeneratePackedSequence(params, motifCodes, i, &s.words[0], s.positions);
+
+                if (format == SEQ_FILE_PACKED)
+                {
+                    uint32_t prefix[2] = { offset, 0 };
+                    out.insert(out.end(), (const char*)prefix, (const char*)(prefix + 2));
+                    out.insert(out.end(), (const char*)&s.words[0], (const char*)(&s.words[0] + wordsPerSeq));
+                }
+                else
+                {
+                    ExpandBases(&s.words[0], params.seqLen, &s.bases[0]);
+                    AppendFastaRecord(i, offset, params.motifLen > 0, &s.bases[0], params.seqLen, lineWidth, out);
+                }
+            }
+        });
+
+        if (writer.joinable()) writer.join();
+        writeOk = writeOk && writerOk;
+
+        writer = thread([&, cur]()
+        {
+            for (auto& buf : buffers[cur])
+                if (buf.size() > 0 && !WriteAll(file, &buf[0], buf.size())) writerOk = false;
+        });
+    }
+
+    if (writer.joinable()) writer.join();
+    writeOk = writeOk && writerOk;
+
+    CloseHandle(file);
+
+    return writeOk ? OK : IO_ERROR;
+}
+
+/**
+ * TestGeneratorConsistency - Flat and packed generation must agree, be repeatable for a seed, and
+ * plant the motif with exactly the requested number of mismatches, including when motif and
+ * sequence lengths are equal.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestGeneratorConsistency(vector<TestResult>& testResults)
+{
+    const SeqGenParams configs[] =
+    {
+        { 1000, 100, 10, 2, 1 },
+        { 500, 77, 15, 4, 2 },
+        { 100, 12, 12, 3, 3 },
+        { 100, 33, 0, 0, 4 },
+    };
+
+    for (uint32_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+    {
+        const SeqGenParams& params  = configs[c];
+        const string name           = "SeqGen::Consistency[" + to_string(c) + "]";
+
+        SeqSet flat;
+        SeqSet flatAgain;
+        PackedSeqSet packed;
+
+        if (GenerateSequenceSet(params, flat) != OK ||
+            GenerateSequenceSet(params, flatAgain) != OK ||
+            GeneratePackedSequenceSet(params, packed) != OK)
+        {
+            testResults.push_back({ name, EXECUTION_ERROR, "Generator rejected valid parameters." });
+            continue;
+        }
+
+        string err;
+
+        if (flat.bases != flatAgain.bases || flat.offsets != flatAgain.offsets) err = "Same seed produced different sequences.";
+        if (flat.offsets != packed.offsets || flat.motif != packed.motif) err = "Flat and packed generators disagree on planting.";
+
+        for (uint32_t i = 0; i < params.nSeq && err.empty(); i++)
+        {
+            const char* seq = flat.Seq(i);
+
+            for (uint32_t j = 0; j < params.seqLen; j++)
+            {
+                if (BaseToCode(seq[j]) != packed.Base(i, j))
+                {
+                    err = "Flat and packed bases differ in sequence " + to_string(i) + ".";
+                    break;
+                }
+            }
+
+            uint32_t mismatches = 0;
+            for (uint32_t j = 0; j < params.motifLen; j++)
+                if (seq[flat.offsets[i] + j] != flat.motif[j]) mismatches++;
+
+            if (mismatches != params.numMismatches)
+                err = "Sequence " + to_string(i) + " has " + to_string(mismatches) + " mismatches in its planted copy.";
+        }
+
+        if (err.empty()) testResults.push_back({ name, PASS, "" });
+        else testResults.push_back({ name, FAIL, err });
+    }
+
+    vector<string> seqs;
+    string motif;
+    vector<uint32_t> offsets;
+
+    if (GenerateMotifSequences(10, 8, 8, seqs, motif, offsets) == OK && seqs[0] == motif)
+        testResults.push_back({ "SeqGen::MotifLenEqualsSeqLen", PASS, "" });
+    else
+        testResults.push_back({ "SeqGen::MotifLenEqualsSeqLen", FAIL, "GenerateMotifSequences failed with motif length equal to sequence length." });
+}
+
+/**
+ * TestFileRoundTrip - Stream sets to FASTA and packed files and check they read back identical to
+ * the in-memory generators.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestFileRoundTrip(vector<TestResult>& testResults)
+{
+    const SeqGenParams params = { 2000, 250, 12, 3, 42 };
+
+    SeqSet flat;
+    PackedSeqSet packed;
+    GenerateSequenceSet(params, flat);
+    GeneratePackedSequenceSet(params, packed);
+
+    const string fastaPath  = GetTempFilePath("seqgen_test.fa");
+    const string packedPath = GetTempFilePath("seqgen_test.bin");
+
+    string fasta;
+    string binary;
+
+    if (WriteSequenceFile(params, fastaPath.c_str(), SEQ_FILE_FASTA, 60) != OK || !ReadFileToString(fastaPath, fasta))
+    {
+        testResults.push_back({ "SeqGen::FastaRoundTrip", EXECUTION_ERROR, "Unable to write/read " + fastaPath });
+    }
+    else
+    {
+        string expected;
+
+        for (uint32_t i = 0; i < params.nSeq; i++)
+        {
+            expected += ">seq" + to_string(i) + " offset=" + to_string(flat.offsets[i]) + "\n";
+            for (uint32_t pos = 0; pos < params.seqLen; pos += 60)
+                expected += string(flat.Seq(i) + pos, min(60u, params.seqLen - pos)) + "\n";
+        }
+
+        if (fasta == expected) testResults.push_back({ "SeqGen::FastaRoundTrip", PASS, "" });
+        else testResults.push_back({ "SeqGen::FastaRoundTrip", FAIL, "FASTA output differs from generated set." });
+    }
+
+    if (WriteSequenceFile(params, packedPath.c_str(), SEQ_FILE_PACKED) != OK || !ReadFileToString(packedPath, binary))
+    {
+        testResults.push_back({ "SeqGen::PackedRoundTrip", EXECUTION_ERROR, "Unable to write/read " + packedPath });
+    }
+    else
+    {
+        const size_t recordBytes = 8 + (size_t)packed.wordsPerSeq * 8;
+        bool match = binary.size() == sizeof(PackedSeqFileHeader) + params.nSeq * recordBytes;
+
+        for (uint32_t i = 0; i < params.nSeq && match; i++)
+        {
+            const char* rec = &binary[sizeof(PackedSeqFileHeader) + i * recordBytes];
+            uint32_t offset;
+            memcpy(&offset, rec, 4);
+
+            match = offset == packed.offsets[i] && memcmp(rec + 8, packed.Seq(i), packed.wordsPerSeq * 8) == 0;
+        }
+
+        if (match) testResults.push_back({ "SeqGen::PackedRoundTrip", PASS, "" });
+        else testResults.push_back({ "SeqGen::PackedRoundTrip", FAIL, "Packed output differs from generated set." });
+    }
+
+    DeleteFileA(fastaPath.c_str());
+    DeleteFileA(packedPath.c_str());
+}
+
+/**
+ * TestThroughput - Report generation rate for flat and packed sets.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    const SeqGenParams params = { 1 << 18, 256, 15, 4, 7 };
+    const float mbases = (float)params.nSeq * params.seqLen / 1e6f;
+
+    for (uint32_t packed = 0; packed < 2; packed++)
+    {
+        SeqSet flat;
+        PackedSeqSet words;
+
+        long long t1    = GetMilliseconds();
+        ResultCode res  = packed ? GeneratePackedSequenceSet(params, words) : GenerateSequenceSet(params, flat);
+        long long t2    = GetMilliseconds();
+        float sec       = ((float)t2 - (float)t1) / 1000.0f;
+
+        const string name = packed ? "SeqGen::PackedThroughput" : "SeqGen::FlatThroughput";
+
+        if (res == OK)
+            testResults.push_back({ name, PASS, to_string(mbases) + " Mbases, T = " + to_string(sec) + "sec." });
+        else
+            testResults.push_back({ name, EXECUTION_ERROR, "Generation failed." });
+    }
+}
+
+/**
+ * SequenceGeneration - Tests for the synthetic sequence workload generator.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void SequenceGeneration(vector<TestResult>& testResults)
+{
+    TestGeneratorConsistency(testResults);
+    TestFileRoundTrip(testResults);
+    TestThroughput(testResults);
+}
@@ -0,0 +1,897 @@
+#include "problems.h"
+#include "seqio.h"
+#include "seqgen.h"
+
+/*
+ * Record boundaries in a window are indexed in a fixed number of chunks per worker, so chunk
+ * stitching is exercised the same way no matter how many threads run.
+ */
+
+static const uint32_t SEQIO_CHUNKS_PER_WORKER = 4;
+
+enum FastqParseStatus
+{
+    FASTQ_PARSE_OK,
+    FASTQ_PARSE_INCOMPLETE,
+    FASTQ_PARSE_MALFORMED
+};
+
+/*
+ * Character classes for sequence data. 0-3 are base codes, 4 is any other residue (N, IUPAC codes),
+ * and SEQ_CHAR_SKIP marks line breaks and blanks that aren't part of the sequence.
+ */
+
+static const uint8_t SEQ_CHAR_OTHER = 4;
+static const uint8_t SEQ_CHAR_SKIP  = 0xFF;
+
+struct SeqCharTable
+{
+    uint8_t cls[256];
+
+    SeqCharTable()
+    {
+        for (uint32_t c = 0; c < 256; c++)
+        {
+            uint8_t code = BaseToCode((char)c);
+            cls[c] = code != INVALID_BASE ? code : SEQ_CHAR_OTHER;
+        }
+
+        cls['\n'] = cls['\r'] = cls[' '] = cls['\t'] = SEQ_CHAR_SKIP;
+    }
+};
+
+static const SeqCharTable seqChars;
+
+static inline string_view TrimCR(const char* begin, const char* end)
+{
+    if (end > begin && end[-1] == '\r') end--;
+    return string_view(begin, end - begin);
+}
+
+SeqFileReader::SeqFileReader() :
+    file(INVALID_HANDLE_VALUE),
+    mapping(NULL),
+    view(nullptr),
+    fileSize(0),
+    fileOffset(0),
+    windowBytes(0),
+    granularity(1 << 16),
+    type(SEQ_TYPE_UNKNOWN)
+{
+}
+
+SeqFileReader::~SeqFileReader()
+{
+    Close();
+}
+
+/**
+ * Open - Open and map a FASTA or FASTQ file. The format is detected from the first record.
+ *
+ * @param  path         [in] File to read.
+ * @param  windowBytes  [in] Bytes mapped per window. Grows automatically for records larger than this.
+ *
+ * @return              IO_ERROR if the file can't be opened or mapped. OK otherwise.
+ */
+
+ResultCode SeqFileReader::Open(const char* path, const size_t windowBytes)
+{
+    Close();
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return IO_ERROR;
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+
+    fileSize            = (uint64_t)size.QuadPart;
+    fileOffset          = 0;
+    granularity         = sysInfo.dwAllocationGranularity;
+    this->windowBytes   = windowBytes < granularity ? granularity : windowBytes;
+    type                = SEQ_TYPE_UNKNOWN;
+
+    if (fileSize == 0) return OK;
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mapping == NULL)
+    {
+        Close();
+        return IO_ERROR;
+    }
+
+    const uint32_t numChunks = GetWorkerCount() * SEQIO_CHUNKS_PER_WORKER;
+
+    chunkStarts.resize(numChunks);
+    chunkRecords.resize(numChunks);
+    chunkNext.resize(numChunks);
+    chunkStatus.resize(numChunks);
+
+    return OK;
+}
+
+void SeqFileReader::Close()
+{
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+    view    = nullptr;
+    mapping = NULL;
+    file    = INVALID_HANDLE_VALUE;
+}
+
+/**
+ * IndexFasta - Find complete FASTA records in a window. Each chunk collects the offsets of '>'
+ * characters that start a line, then the merged start list is turned into record views in parallel.
+ *
+ * @param  reader   [in/out]    Reader whose chunk scratch is used.
+ * @param  data     [in]        Window contents.
+ * @param  len      [in]        Window length.
+ * @param  atEof    [in]        Whether the window runs to the end of the file.
+ * @param  records  [in/out]    Complete records found.
+ *
+ * @return          Bytes of the window consumed, i.e. the start of the trailing incomplete record.
+ */
+
+static size_t IndexFasta(SeqFileReader& reader, const char* data, const size_t len, const bool atEof, vector<SeqRecordView>& records)
+{
+    const uint32_t numChunks    = (uint32_t)reader.chunkStarts.size();
+    const size_t chunkLen       = (len + numChunks - 1) / numChunks;
+
+    ParallelFor(numChunks, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t c = begin; c < end; c++)
+        {
+            vector<size_t>& starts = reader.chunkStarts[c];
+            starts.clear();
+
+            size_t pos          = (size_t)c * chunkLen;
+            const size_t stop   = pos + chunkLen < len ? pos + chunkLen : len;
+
+            while (pos < stop)
+            {
+                const char* hit = (const char*)memchr(data + pos, '>', stop - pos);
+                if (!hit) break;
+
+                pos = hit - data;
+                if (pos == 0 || data[pos - 1] == '\n') starts.push_back(pos);
+                pos++;
+            }
+        }
+    });
+
+    vector<size_t>& starts = reader.chunkStarts[0];
+    for (uint32_t c = 1; c < numChunks; c++) starts.insert(starts.end(), reader.chunkStarts[c].begin(), reader.chunkStarts[c].end());
+
+    if (starts.size() == 0) return len;
+
+    const size_t numComplete = atEof ? starts.size() : starts.size() - 1;
+    records.resize(numComplete);
+
+    ParallelFor((uint32_t)numComplete, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const char* recBegin    = data + starts[i];
+            const char* recEnd      = data + (i + 1 < starts.size() ? starts[i + 1] : len);
+            const char* nameEnd     = (const char*)memchr(recBegin, '\n', recEnd - recBegin);
+
+            if (!nameEnd) nameEnd = recEnd;
+
+            records[i].name = TrimCR(recBegin + 1, nameEnd);
+            records[i].seq  = string_view(nameEnd == recEnd ? recEnd : nameEnd + 1, recEnd - (nameEnd == recEnd ? recEnd : nameEnd + 1));
+            records[i].qual = string_view();
+        }
+    });
+
+    return atEof ? len : starts.back();
+}
+
+/**
+ * FindLines - Locate the ends of the n lines starting at pos. At end of file the last line may be
+ * unterminated.
+ *
+ * @return False if the window ends before all n lines do.
+ */
+
+static bool FindLines(const char* data, const size_t len, const bool atEof, size_t pos, const uint32_t n, size_t* lineEnds)
+{
+    for (uint32_t l = 0; l < n; l++)
+    {
+        if (pos >= len && !(atEof && l == n - 1 && pos == len)) return false;
+
+        const char* nl = (const char*)memchr(data + pos, '\n', len - pos);
+
+        if (!nl)
+        {
+            if (!atEof || l != n - 1) return false;
+            lineEnds[l] = len;
+        }
+        else
+        {
+            lineEnds[l] = nl - data;
+        }
+
+        pos = lineEnds[l] + 1;
+    }
+
+    return true;
+}
+
+/**
+ * IsFastqRecordStart - Check whether a line start begins a 4-line FASTQ record: '@' header, sequence,
+ * '+' separator and a quality line as long as the sequence. A quality line that happens to start
+ * with '@' fails this check since the line two below it is a sequence, not a '+' separator.
+ */
+
+static bool IsFastqRecordStart(const char* data, const size_t len, const bool atEof, const size_t pos)
+{
+    if (data[pos] != '@') return false;
+
+    size_t ends[4];
+    if (!FindLines(data, len, atEof, pos, 4, ends)) return false;
+    if (data[ends[1] + 1] != '+') return false;
+
+    const size_t seqLen     = TrimCR(data + ends[0] + 1, data + ends[1]).size();
+    const size_t qualLen    = TrimCR(data + ends[2] + 1, data + ends[3]).size();
+
+    return seqLen == qualLen;
+}
+
+/**
+ * ParseFastqRange - Parse consecutive FASTQ records starting at pos until a record starts at or past
+ * stopBefore. Blank lines between records are skipped.
+ *
+ * @param  starts   [in/out]    Start offset of each parsed record.
+ * @param  records  [in/out]    Parsed records.
+ * @param  next     [out]       Offset just past the last parsed record, or the start of the incomplete one.
+ *
+ * @return          FASTQ_PARSE_INCOMPLETE if a record runs past the window, FASTQ_PARSE_MALFORMED
+ *                  on a line that doesn't start a record, FASTQ_PARSE_OK otherwise.
+ */
+
+static FastqParseStatus ParseFastqRange(
+    const char* data,
+    const size_t len,
+    const bool atEof,
+    size_t pos,
+    const size_t stopBefore,
+    vector<size_t>& starts,
+    vector<SeqRecordView>& records,
+    size_t& next
+)
+{
+    while (pos < stopBefore)
+    {
+        if (data[pos] == '\n' || data[pos] == '\r')
+        {
+            pos++;
+            continue;
+        }
+
+        next = pos;
+
+        if (data[pos] != '@') return FASTQ_PARSE_MALFORMED;
+
+        size_t ends[4];
+        if (!FindLines(data, len, atEof, pos, 4, ends)) return atEof ? FASTQ_PARSE_MALFORMED : FASTQ_PARSE_INCOMPLETE;
+        if (data[ends[1] + 1] != '+') return FASTQ_PARSE_MALFORMED;
+
+        SeqRecordView rec;
+        rec.name    = TrimCR(data + pos + 1, data + ends[0]);
+        rec.seq     = TrimCR(data + ends[0] + 1, data + ends[1]);
+        rec.qual    = TrimCR(data + ends[2] + 1, data + ends[3]);
+
+        starts.push_back(pos);
+        records.push_back(rec);
+
+        pos = ends[3] + 1;
+    }
+
+    next = pos < len ? pos : len;
+    return FASTQ_PARSE_OK;
+}
+
+static bool IsBlankRange(const char* data, size_t begin, const size_t end)
+{
+    for (; begin < end; begin++) if (data[begin] != '\n' && data[begin] != '\r') return false;
+    return true;
+}
+
+/**
+ * IndexFastq - Find complete FASTQ records in a window. Each chunk resynchronizes on the first line
+ * that passes IsFastqRecordStart and parses forward. Chunks are then stitched in order; if any
+ * chunk's first record doesn't start exactly where the previous chunk stopped, the window is
+ * re-parsed sequentially, so the result never depends on the resync heuristic being right.
+ *
+ * @return Bytes of the window consumed, or zero with an empty record list if it can't be parsed.
+ */
+
+static size_t IndexFastq(SeqFileReader& reader, const char* data, const size_t len, const bool atEof, vector<SeqRecordView>& records, bool& malformed)
+{
+    const uint32_t numChunks    = (uint32_t)reader.chunkStarts.size();
+    const size_t chunkLen       = (len + numChunks - 1) / numChunks;
+
+    malformed = false;
+
+    ParallelFor(numChunks, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t c = begin; c < end; c++)
+        {
+            reader.chunkStarts[c].clear();
+            reader.chunkRecords[c].clear();
+
+            const size_t chunkBegin = (size_t)c * chunkLen;
+            const size_t chunkEnd   = chunkBegin + chunkLen < len ? chunkBegin + chunkLen : len;
+
+            size_t pos = chunkBegin;
+
+            if (c > 0)
+            {
+                if (pos < len && data[pos - 1] != '\n')
+                {
+                    const char* nl = (const char*)memchr(data + pos, '\n', len - pos);
+                    pos = nl ? nl - data + 1 : len;
+                }
+
+                while (pos < chunkEnd && !IsFastqRecordStart(data, len, atEof, pos))
+                {
+                    const char* nl = (const char*)memchr(data + pos, '\n', len - pos);
+                    pos = nl ? nl - data + 1 : len;
+                }
+            }
+
+            reader.chunkNext[c]     = pos;
+            reader.chunkStatus[c]   = (uint8_t)ParseFastqRange(data, len, atEof, pos, chunkEnd, reader.chunkStarts[c], reader.chunkRecords[c], reader.chunkNext[c]);
+        }
+    });
+
+    size_t expected         = 0;
+    bool stitched           = true;
+    FastqParseStatus status = FASTQ_PARSE_OK;
+
+    records.clear();
+
+    for (uint32_t c = 0; c < numChunks && status == FASTQ_PARSE_OK; c++)
+    {
+        const size_t chunkEnd = (size_t)(c + 1) * chunkLen < len ? (size_t)(c + 1) * chunkLen : len;
+
+        if (reader.chunkRecords[c].empty() && reader.chunkStatus[c] == FASTQ_PARSE_OK)
+        {
+            // Nothing starts in this chunk. Fine only if the previous record already covers it.
+
+            if (expected < chunkEnd)
+            {
+                stitched = false;
+                break;
+            }
+
+            continue;
+        }
+
+        const size_t first = reader.chunkStarts[c].empty() ? reader.chunkNext[c] : reader.chunkStarts[c][0];
+
+        if (first != expected && !(c > 0 && first > expected && IsBlankRange(data, expected, first)))
+        {
+            stitched = false;
+            break;
+        }
+
+        records.insert(records.end(), reader.chunkRecords[c].begin(), reader.chunkRecords[c].end());
+        expected    = reader.chunkNext[c];
+        status      = (FastqParseStatus)reader.chunkStatus[c];
+    }
+
+    if (!stitched)
+    {
+        vector<size_t>& starts = reader.chunkStarts[0];
+        starts.clear();
+        records.clear();
+
+        status = ParseFastqRange(data, len, atEof, 0, len, starts, records, expected);
+    }
+
+    if (status == FASTQ_PARSE_MALFORMED)
+    {
+        malformed = true;
+        return 0;
+    }
+
+    return status == FASTQ_PARSE_INCOMPLETE ? expected : len;
+}
+
+/**
+ * NextWindow - Map the next window of the file and index its complete records. Views stay valid until
+ * the next call to NextWindow or Close.
+ *
+ * @param  records [in/out] Records in the window. Empty once the file is exhausted.
+ *
+ * @return         IO_ERROR if mapping fails, INVALID_INPUT for input that isn't FASTA/FASTQ. OK otherwise.
+ */
+
+ResultCode SeqFileReader::NextWindow(vector<SeqRecordView>& records)
+{
+    records.clear();
+
+    while (records.empty())
+    {
+        if (view)
+        {
+            UnmapViewOfFile(view);
+            view = nullptr;
+        }
+
+        if (mapping == NULL || fileOffset >= fileSize) return OK;
+
+        const uint64_t mapStart = fileOffset - fileOffset % granularity;
+        const size_t delta      = (size_t)(fileOffset - mapStart);
+        const uint64_t mapLen   = fileSize - mapStart < windowBytes + delta ? fileSize - mapStart : windowBytes + delta;
+
+        view = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(mapStart >> 32), (DWORD)mapStart, (size_t)mapLen);
+        if (!view) return IO_ERROR;
+
+        const char* data    = view + delta;
+        size_t len          = (size_t)mapLen - delta;
+        const bool atEof    = mapStart + mapLen == fileSize;
+
+        if (type == SEQ_TYPE_UNKNOWN)
+        {
+            size_t lead = 0;
+            while (lead < len && seqChars.cls[(uint8_t)data[lead]] == SEQ_CHAR_SKIP) lead++;
+
+            if (lead == len)
+            {
+                fileOffset += len;
+                continue;
+            }
+
+            if (data[lead] == '>') type = SEQ_TYPE_FASTA;
+            else if (data[lead] == '@') type = SEQ_TYPE_FASTQ;
+            else return INVALID_INPUT;
+
+            fileOffset  += lead;
+            data        += lead;
+            len         -= lead;
+        }
+
+        size_t consumed = 0;
+
+        if (type == SEQ_TYPE_FASTA)
+        {
+            consumed = IndexFasta(*this, data, len, atEof, records);
+        }
+        else
+        {
+            bool malformed = false;
+            consumed = IndexFastq(*this, data, len, atEof, records, malformed);
+            if (malformed) return INVALID_INPUT;
+        }
+
+        // A single record didn't fit. Retry the same offset with a larger window.
+
+        if (consumed == 0 && records.empty() && !atEof)
+        {
+            windowBytes *= 2;
+            continue;
+        }
+
+        fileOffset += consumed;
+    }
+
+    return OK;
+}
+
+/**
+ * CountBases - Number of sequence characters in a record, excluding line breaks.
+ */
+
+size_t CountBases(const SeqRecordView& rec)
+{
+    size_t cnt = 0;
+    for (char c : rec.seq) if (seqChars.cls[(uint8_t)c] != SEQ_CHAR_SKIP) cnt++;
+    return cnt;
+}
+
+/**
+ * CopyBases - Copy a record's sequence characters to a contiguous buffer, dropping line breaks. Whole
+ * lines are copied at a time.
+ *
+ * @param  rec  [in]        Record to copy.
+ * @param  out  [in/out]    Destination, at least rec.seq.size() bytes.
+ *
+ * @return      Number of characters written.
+ */
+
+size_t CopyBases(const SeqRecordView& rec, char* out)
+{
+    const char* pos = rec.seq.data();
+    const char* end = pos + rec.seq.size();
+    size_t cnt      = 0;
+
+    while (pos < end)
+    {
+        const char* nl          = (const char*)memchr(pos, '\n', end - pos);
+        const char* lineEnd     = nl ? nl : end;
+        const string_view line  = TrimCR(pos, lineEnd);
+
+        memcpy(out + cnt, line.data(), line.size());
+        cnt += line.size();
+        pos = lineEnd + 1;
+    }
+
+    return cnt;
+}
+
+/**
+ * PackBases - Convert a record's sequence straight from the mapping into 2-bit packed words (layout as
+ * in PackedSeqSet). Residues other than ACGT are packed as A.
+ *
+ * @param  rec      [in]        Record to pack.
+ * @param  words    [in/out]    Destination, at least rec.seq.size() / 32 + 1 words.
+ *
+ * @return          Number of bases packed.
+ */
+
+size_t PackBases(const SeqRecordView& rec, uint64_t* words)
+{
+    uint64_t cur    = 0;
+    size_t cnt      = 0;
+
+    for (char c : rec.seq)
+    {
+        const uint8_t cls = seqChars.cls[(uint8_t)c];
+        if (cls == SEQ_CHAR_SKIP) continue;
+
+        cur = (cur << 2) | (cls & 3);
+
+        if ((++cnt & 31) == 0)
+        {
+            words[(cnt >> 5) - 1] = cur;
+            cur = 0;
+        }
+    }
+
+    if (cnt & 31) words[cnt >> 5] = cur << (64 - 2 * (cnt & 31));
+
+    return cnt;
+}
+
+/**
+ * LoadSequenceFile - Read every record of a FASTA/FASTQ file into strings, e.g. as FindMotif input.
+ *
+ * @param  path     [in]        File to read.
+ * @param  seqs     [in/out]    Sequences, appended in file order.
+ * @param  names    [in/out]    Optional record names, appended in file order.
+ *
+ * @return          See SeqFileReader::Open and SeqFileReader::NextWindow.
+ */
+
+ResultCode LoadSequenceFile(const char* path, vector<string>& seqs, vector<string>* names)
+{
+    SeqFileReader reader;
+    ResultCode res = reader.Open(path);
+    if (res != OK) return res;
+
+    vector<SeqRecordView> records;
+
+    while ((res = reader.NextWindow(records)) == OK && records.size() > 0)
+    {
+        for (auto& rec : records)
+        {
+            seqs.emplace_back(rec.seq.size(), '\0');
+            seqs.back().resize(CopyBases(rec, &seqs.back()[0]));
+
+            if (names) names->emplace_back(rec.name);
+        }
+    }
+
+    return res;
+}
+
+/**
+ * ReadAllRecords - Test helper. Read a file window by window with a small window size, copying out
+ * names, bases and qualities.
+ */
+
+static ResultCode ReadAllRecords(
+    const string& path,
+    const size_t windowBytes,
+    vector<string>& names,
+    vector<string>& seqs,
+    vector<string>& quals,
+    uint32_t& numWindows
+)
+{
+    SeqFileReader reader;
+    ResultCode res = reader.Open(path.c_str(), windowBytes);
+    if (res != OK) return res;
+
+    vector<SeqRecordView> records;
+    numWindows = 0;
+
+    while ((res = reader.NextWindow(records)) == OK && records.size() > 0)
+    {
+        numWindows++;
+
+        for (auto& rec : records)
+        {
+            string bases(rec.seq.size(), '\0');
+            bases.resize(CopyBases(rec, &bases[0]));
+
+            names.emplace_back(rec.name);
+            seqs.push_back(bases);
+            quals.emplace_back(rec.qual);
+        }
+    }
+
+    return res;
+}
+
+/**
+ * TestFastaWindows - Stream a generated set to a wrapped FASTA file and read it back through small
+ * windows, so most windows cut a record and chunk boundaries land everywhere.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestFastaWindows(vector<TestResult>& testResults)
+{
+    const SeqGenParams params   = { 3000, 300, 10, 2, 11 };
+    const string path           = GetTempFilePath("seqio_test.fa");
+
+    SeqSet expected;
+    GenerateSequenceSet(params, expected);
+
+    vector<string> names, seqs, quals;
+    uint32_t numWindows = 0;
+
+    if (WriteSequenceFile(params, path.c_str(), SEQ_FILE_FASTA, 60) != OK ||
+        ReadAllRecords(path, 64 << 10, names, seqs, quals, numWindows) != OK)
+    {
+        testResults.push_back({ "SeqIO::FastaWindows", EXECUTION_ERROR, "Unable to write/read " + path });
+        DeleteFileA(path.c_str());
+        return;
+    }
+
+    string err = seqs.size() == params.nSeq ? "" : "Read " + to_string(seqs.size()) + " records.";
+
+    for (uint32_t i = 0; i < params.nSeq && err.empty(); i++)
+    {
+        const string name = "seq" + to_string(i) + " offset=" + to_string(expected.offsets[i]);
+
+        if (seqs[i] != string(expected.Seq(i), params.seqLen) || names[i] != name)
+            err = "Record " + to_string(i) + " differs.";
+    }
+
+    if (err.empty()) testResults.push_back({ "SeqIO::FastaWindows", PASS, to_string(numWindows) + " windows." });
+    else testResults.push_back({ "SeqIO::FastaWindows", FAIL, err });
+
+    DeleteFileA(path.c_str());
+}
+
+/**
+ * TestFastqWindows - Read back a FASTQ file with CRLF line endings, blank lines between some
+ * records and quality lines starting with '@', which chunk resync has to tell apart from headers.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestFastqWindows(vector<TestResult>& testResults)
+{
+    const SeqGenParams params   = { 2000, 150, 0, 0, 12 };
+    const string path           = GetTempFilePath("seqio_test.fq");
+
+    SeqSet set;
+    GenerateSequenceSet(params, set);
+
+    Rng rng(12);
+    vector<string> expectedQuals;
+    string contents;
+
+    for (uint32_t i = 0; i < params.nSeq; i++)
+    {
+        string qual(params.seqLen, '!');
+        for (auto& q : qual) q = (char)('!' + rng.NextBounded(41));
+        if (i % 3 == 0) qual[0] = '@';
+
+        expectedQuals.push_back(qual);
+
+        const char* eol = i % 2 == 0 ? "\r\n" : "\n";
+        contents += "@read" + to_string(i) + eol + string(set.Seq(i), params.seqLen) + eol + "+" + eol + qual + eol;
+        if (i % 7 == 0) contents += eol;
+    }
+
+    vector<string> names, seqs, quals;
+    uint32_t numWindows = 0;
+
+    if (!WriteStringToFile(path, contents) || ReadAllRecords(path, 64 << 10, names, seqs, quals, numWindows) != OK)
+    {
+        testResults.push_back({ "SeqIO::FastqWindows", EXECUTION_ERROR, "Unable to write/read " + path });
+        DeleteFileA(path.c_str());
+        return;
+    }
+
+    string err = seqs.size() == params.nSeq ? "" : "Read " + to_string(seqs.size()) + " records.";
+
+    for (uint32_t i = 0; i < params.nSeq && err.empty(); i++)
+    {
+        if (names[i] != "read" + to_string(i) || seqs[i] != string(set.Seq(i), params.seqLen) || quals[i] != expectedQuals[i])
+            err = "Record " + to_string(i) + " differs.";
+    }
+
+    if (err.empty()) testResults.push_back({ "SeqIO::FastqWindows", PASS, to_string(numWindows) + " windows." });
+    else testResults.push_back({ "SeqIO::FastqWindows", FAIL, err });
+
+    DeleteFileA(path.c_str());
+}
+
+/**
+ * TestLargeRecord - A record much larger than the window forces the window to grow. Also checks
+ * PackBases against the generator's packed output.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestLargeRecord(vector<TestResult>& testResults)
+{
+    const SeqGenParams params   = { 3, 1000003, 0, 0, 13 };
+    const string path           = GetTempFilePath("seqio_large.fa");
+
+    PackedSeqSet expected;
+    GeneratePackedSequenceSet(params, expected);
+
+    SeqFileReader reader;
+    vector<SeqRecordView> records;
+    vector<uint64_t> words(expected.wordsPerSeq);
+
+    if (WriteSequenceFile(params, path.c_str(), SEQ_FILE_FASTA, 70) != OK || reader.Open(path.c_str(), 64 << 10) != OK)
+    {
+        testResults.push_back({ "SeqIO::LargeRecord", EXECUTION_ERROR, "Unable to write/read " + path });
+        DeleteFileA(path.c_str());
+        return;
+    }
+
+    uint32_t seqIdx = 0;
+    string err;
+
+    while (reader.NextWindow(records) == OK && records.size() > 0 && err.empty())
+    {
+        for (auto& rec : records)
+        {
+            size_t numBases = PackBases(rec, &words[0]);
+
+            if (seqIdx >= params.nSeq || numBases != params.seqLen ||
+                memcmp(&words[0], expected.Seq(seqIdx), expected.wordsPerSeq * sizeof(uint64_t)) != 0)
+            {
+                err = "Packed record " + to_string(seqIdx) + " differs.";
+                break;
+            }
+
+            seqIdx++;
+        }
+    }
+
+    reader.Close();
+
+    if (err.empty() && seqIdx != params.nSeq) err = "Read " + to_string(seqIdx) + " records.";
+
+    if (err.empty()) testResults.push_back({ "SeqIO::LargeRecord", PASS, "" });
+    else testResults.push_back({ "SeqIO::LargeRecord", FAIL, err });
+
+    DeleteFileA(path.c_str());
+}
+
+/**
+ * TestFindMotifFromFile - Load a planted motif set from FASTA and run FindMotif on it.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestFindMotifFromFile(vector<TestResult>& testResults)
+{
+    const SeqGenParams params   = { 5, 16, 5, 0, 14 };
+    const string path           = GetTempFilePath("seqio_motif.fa");
+
+    vector<string> seqs;
+    vector<uint32_t> offsets;
+
+    if (WriteSequenceFile(params, path.c_str(), SEQ_FILE_FASTA) != OK || LoadSequenceFile(path.c_str(), seqs) != OK)
+    {
+        testResults.push_back({ "SeqIO::FindMotifFromFile", EXECUTION_ERROR, "Unable to write/read " + path });
+        DeleteFileA(path.c_str());
+        return;
+    }
+
+    FindMotif(seqs, params.motifLen, offsets);
+
+    const uint32_t score = GetConsensus(seqs, (uint32_t)seqs.size(), offsets, params.motifLen);
+
+    if (seqs.size() == params.nSeq && score == params.nSeq * params.motifLen)
+        testResults.push_back({ "SeqIO::FindMotifFromFile", PASS, "" });
+    else
+        testResults.push_back({ "SeqIO::FindMotifFromFile", FAIL, "Planted motif not found. Score = " + to_string(score) });
+
+    DeleteFileA(path.c_str());
+}
+
+/**
+ * TestThroughput - Time mapping, indexing and packing a FASTA file.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+static void TestThroughput(vector<TestResult>& testResults)
+{
+    const SeqGenParams params   = { 1 << 18, 256, 0, 0, 15 };
+    const string path           = GetTempFilePath("seqio_bench.fa");
+
+    if (WriteSequenceFile(params, path.c_str(), SEQ_FILE_FASTA) != OK)
+    {
+        testResults.push_back({ "SeqIO::Throughput", EXECUTION_ERROR, "Unable to write " + path });
+        return;
+    }
+
+    SeqFileReader reader;
+    vector<SeqRecordView> records;
+    vector<uint64_t> words(params.seqLen / 32 + 1);
+
+    long long t1        = GetMilliseconds();
+    uint64_t numBases   = 0;
+    uint64_t numRecords = 0;
+
+    reader.Open(path.c_str());
+
+    while (reader.NextWindow(records) == OK && records.size() > 0)
+    {
+        atomic<uint64_t> windowBases(0);
+
+        ParallelFor((uint32_t)records.size(), [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            vector<uint64_t> local(params.seqLen / 32 + 1);
+            uint64_t cnt = 0;
+            for (uint32_t i = begin; i < end; i++) cnt += PackBases(records[i], &local[0]);
+            windowBases += cnt;
+        });
+
+        numBases    += windowBases;
+        numRecords  += records.size();
+    }
+
+    const uint64_t fileBytes = reader.fileSize;
+    reader.Close();
+
+    long long t2    = GetMilliseconds();
+    float sec       = ((float)t2 - (float)t1) / 1000.0f;
+    float mbps      = sec > 0.0f ? (float)fileBytes / 1e6f / sec : 0.0f;
+
+    if (numRecords == params.nSeq && numBases == (uint64_t)params.nSeq * params.seqLen)
+        testResults.push_back({ "SeqIO::Throughput", PASS, to_string(mbps) + " MB/sec, T = " + to_string(sec) + "sec." });
+    else
+        testResults.push_back({ "SeqIO::Throughput", FAIL, "Read " + to_string(numRecords) + " records." });
+
+    DeleteFileA(path.c_str());
+}
+
+/**
+ * SequenceFileReading - Tests for the memory-mapped FASTA/FASTQ reader.
+ *
+ * @param testResults [in/out] Test result list to append to.
+ */
+
+void SequenceFileReading(vector<TestResult>& testResults)
+{
+    TestFastaWindows(testResults);
+    TestFastqWindows(testResults);
+    TestLargeRecord(testResults);
+    TestFindMotifFromFile(testResults);
+    TestThroughput(testResults);
+}
@@ -1,4 +1,7 @@
 #include "commoninc.h"
+#include "utils.h"
+
+#include <intrin.h>
 
 /**
  * GetMilliseconds Get timestamp in milliseconds since beginning of clock epoch.
@@ -21,4 +24,171 @@ long long GetMilliseconds()
     {
         return GetTickCount64();
     }
-}
\ No newline at end of file
+}
+
+/**
+ * GetNanoseconds - High resolution timestamp for timing short kernels. Splits the counter into whole
+ * seconds and remainder so the conversion can't overflow.
+ *
+ * @return Timestamp in nanoseconds.
+ */
+
+long long GetNanoseconds()
+{
+    static LARGE_INTEGER frequency;
+    static BOOL useQpc = QueryPerformanceFrequency(&frequency);
+
+    if (useQpc)
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+
+        const long long sec = now.QuadPart / frequency.QuadPart;
+        const long long rem = now.QuadPart % frequency.QuadPart;
+
+        return sec * 1000000000LL + (rem * 1000000000LL) / frequency.QuadPart;
+    }
+    else
+    {
+        return (long long)GetTickCount64() * 1000000LL;
+    }
+}
+
+/**
+ * GetWorkerCount - Number of worker threads parallel solvers should spin up.
+ *
+ * @return Hardware thread count, or one if it can't be determined.
+ */
+
+uint32_t GetWorkerCount()
+{
+    uint32_t cnt = std::thread::hardware_concurrency();
+    return cnt == 0 ? 1 : cnt;
+}
+
+/**
+ * HasAvx2 - Check the CPU and OS both support AVX2, so kernels can pick a vector or scalar path.
+ *
+ * @return True if AVX2 instructions can be used.
+ */
+
+bool HasAvx2()
+{
+    static const bool hasAvx2 = []()
+    {
+        int info[4];
+
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx     = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+
+    return hasAvx2;
+}
+
+/**
+ * GetTempFilePath - Path for a scratch file in the user's temp directory.
+ *
+ * @param name [in] File name.
+ *
+ * @return Full path to the file.
+ */
+
+std::string GetTempFilePath(const char* name)
+{
+    char tempDir[MAX_PATH];
+    GetTempPathA(MAX_PATH, tempDir);
+    return std::string(tempDir) + name;
+}
+
+/**
+ * ReadFileToString - Read a whole file into a string, in chunks so files over 4GB still work.
+ *
+ * @param path     [in]  File to read.
+ * @param contents [out] File contents.
+ *
+ * @return True if the whole file was read.
+ */
+
+bool ReadFileToString(const std::string& path, std::string& contents)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    const size_t maxChunk = 1 << 30;
+
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(file, &size) != FALSE && (unsigned long long)size.QuadPart <= SIZE_MAX;
+
+    if (ok)
+    {
+        contents.resize((size_t)size.QuadPart);
+
+        for (size_t pos = 0; ok && pos < contents.size();)
+        {
+            DWORD bytesRead = 0;
+            DWORD chunk     = (DWORD)(contents.size() - pos < maxChunk ? contents.size() - pos : maxChunk);
+
+            ok  = ReadFile(file, &contents[pos], chunk, &bytesRead, NULL) && bytesRead == chunk;
+            pos += chunk;
+        }
+    }
+
+    CloseHandle(file);
+    return ok;
+}
+
+/**
+ * WriteAll - Write a buffer to an open file, in chunks so writes over 4GB still work.
+ *
+ * @param file [in] File to write to.
+ * @param data [in] Bytes to write.
+ * @param len  [in] Number of bytes.
+ *
+ * @return True if every byte was written.
+ */
+
+bool WriteAll(HANDLE file, const char* data, size_t len)
+{
+    const size_t maxChunk = 1 << 30;
+
+    while (len > 0)
+    {
+        DWORD written   = 0;
+        DWORD chunk     = (DWORD)(len < maxChunk ? len : maxChunk);
+
+        if (!WriteFile(file, data, chunk, &written, NULL) || written != chunk) return false;
+
+        data    += chunk;
+        len     -= chunk;
+    }
+
+    return true;
+}
+
+/**
+ * WriteStringToFile - Replace a file's contents with a string.
+ *
+ * @param path     [in] File to write, created or truncated.
+ * @param contents [in] Bytes to write.
+ *
+ * @return True if the file was created and every byte written.
+ */
+
+bool WriteStringToFile(const std::string& path, const std::string& contents)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    bool ok = WriteAll(file, contents.data(), contents.size());
+    CloseHandle(file);
+
+    return ok;
+}